@@ -3,8 +3,10 @@
 
 #include <eepp/network/ftp.hpp>
 #include <eepp/network/http.hpp>
+#include <eepp/network/httpeventloop.hpp>
 #include <eepp/network/ipaddress.hpp>
 #include <eepp/network/packet.hpp>
+#include <eepp/network/packetbufferpool.hpp>
 #include <eepp/network/socket.hpp>
 #include <eepp/network/sockethandle.hpp>
 #include <eepp/network/socketselector.hpp>
@@ -23,6 +23,12 @@ using namespace EE::System;
 
 namespace EE { namespace Network {
 
+class HttpEventLoop;
+
+namespace Private {
+class HttpResponseParser;
+} // namespace Private
+
 /** @brief A HTTP client */
 class EE_API Http : NonCopyable {
   public:
@@ -136,6 +142,8 @@ class EE_API Http : NonCopyable {
 
 	  private:
 		friend class Http;
+		friend class HttpEventLoop;
+		friend class Private::HttpResponseParser;
 
 		/** @brief Construct the header from a response string
 		**  This function is used by Http to build the response
@@ -143,11 +151,17 @@ class EE_API Http : NonCopyable {
 		**  @param data Content of the response to parse */
 		void parse( const std::string& data );
 
+		/** @brief Construct the header from a response buffer, without copying it
+		**  @param data Content of the response to parse
+		**  @param size Size of the response header */
+		void parse( const char* data, size_t size );
+
 		/** @brief Read values passed in the answer header
 		**  This function is used by Http to extract values passed
 		**  in the response.
-		**  @param in String stream containing the header values */
-		void parseFields( std::istream& in );
+		**  @param data Buffer containing the header values
+		**  @param size Size of the buffer */
+		void parseFields( const char* data, size_t size );
 
 		// Member data
 		FieldTable mFields;			///< Fields of the header
@@ -343,6 +357,7 @@ class EE_API Http : NonCopyable {
 
 	  private:
 		friend class Http;
+		friend class HttpEventLoop;
 
 		/** @brief Prepare the final request to send to the server
 		**  This is used internally by Http before sending the
@@ -457,6 +472,21 @@ class EE_API Http : NonCopyable {
 	Response downloadRequest( const Request& request, std::string writePath,
 							  Time timeout = Time::Zero );
 
+	/** Receives the decoded response body chunks as they arrive. The data is only valid during the
+	 * call. Returning false cancels the request. */
+	typedef std::function<bool( const char* data, size_t size )> BodyCallback;
+
+	/** @brief Send a HTTP request and streams the server's response body to a callback.
+	**  The body is never accumulated: it's dechunked and decompressed ( gzip / deflate ) on the fly
+	**  and every received chunk is passed to the callback, so downloads of any size use constant
+	**  memory.
+	**  @param request Request to send
+	**  @param onBody The callback that receives the body chunks
+	**  @param timeout Maximum time to wait
+	**  @return Server's response ( without body ) */
+	Response downloadRequest( const Request& request, const BodyCallback& onBody,
+							  Time timeout = Time::Zero );
+
 	/** Definition of the async callback response */
 	typedef std::function<void( const Http&, Http::Request&, Http::Response& )>
 		AsyncResponseCallback;
@@ -620,7 +650,9 @@ class EE_API Http : NonCopyable {
 		  const Request::FieldTable& headers = Request::FieldTable(), const std::string& body = "",
 		  const bool& validateCertificate = true, const URI& proxy = URI() );
 
-	/** Creates an async HTTP Request using the global HTTP Client Pool */
+	/** Creates an async HTTP Request using the global HttpEventLoop
+	 * The requests share the connections and the loop thread instead of creating a thread per
+	 * request. */
 	static void
 	requestAsync( const Http::AsyncResponseCallback& cb, const URI& uri,
 				  const Time& timeout = Time::Zero, Request::Method method = Request::Method::Get,
@@ -713,6 +745,7 @@ class EE_API Http : NonCopyable {
 	};
 
 	friend class AsyncRequest;
+	friend class HttpEventLoop;
 	ThreadLocalPtr<HttpConnection> mConnection; ///< Connection to the host
 	IpAddress mHost;							///< Web host address
 	std::string mHostName;						///< Web host name
@@ -0,0 +1,211 @@
+#ifndef EE_NETWORK_HTTPEVENTLOOP_HPP
+#define EE_NETWORK_HTTPEVENTLOOP_HPP
+
+#include <atomic>
+#include <deque>
+#include <eepp/network/http.hpp>
+#include <eepp/network/udpsocket.hpp>
+#include <eepp/system/clock.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace EE { namespace Network {
+
+namespace Private {
+class HttpBodySink;
+class HttpResponseParser;
+} // namespace Private
+
+/** @brief Asynchronous HTTP/1.1 client that runs all the requests on a single event loop.
+ * Instead of creating a thread per request, the plain HTTP requests are multiplexed over
+ * non-blocking sockets and polled for readiness from one thread. Connections are kept alive and
+ * reused between requests to the same host, the number of concurrent connections per host is
+ * bounded (the rest of the requests are queued) and idempotent requests can be pipelined.
+ * HTTPS and proxied requests need a blocking handshake, they are run with the blocking Http
+ * client in a small thread pool owned by the loop.
+ * The loop can run in its own thread or be driven by the caller with update. The callbacks are
+ * always called from the thread that runs the loop. */
+class EE_API HttpEventLoop : NonCopyable {
+  public:
+	/** @return The shared event loop used by Http::requestAsync. */
+	static HttpEventLoop& getGlobal();
+
+	/** @param runThread Runs the loop in its own thread. Otherwise update must be called.
+	 * @param maxConnectionsPerHost Maximum concurrent connections to the same host.
+	 * @param pipelineDepth Maximum requests in flight per connection ( 1 disables pipelining ). */
+	explicit HttpEventLoop( bool runThread = true, Uint32 maxConnectionsPerHost = 6,
+							Uint32 pipelineDepth = 1 );
+
+	~HttpEventLoop();
+
+	/** Queues a request. Can be called from any thread.
+	 * @param uri The scheme + hostname + port of the host, the path is taken from the request.
+	 * @param cb The callback that receives the response.
+	 * @param timeout Maximum time to wait for the response since it starts being processed (
+	 * Time::Zero means no timeout ).
+	 * @return The request id, that can be used to cancel it. */
+	Uint64 request( const URI& uri, const Http::Request& request,
+					const Http::AsyncResponseCallback& cb, const Time& timeout = Time::Zero,
+					const URI& proxy = URI() );
+
+	/** Queues a request that streams the response body to a callback instead of accumulating it
+	 * in the response. The body is dechunked and decompressed as it arrives, so the memory used
+	 * doesn't depend on the body size. The body callback is called from the loop thread ( or from
+	 * the thread pool for HTTPS and proxied requests ), returning false cancels the request.
+	 * @see request */
+	Uint64 download( const URI& uri, const Http::Request& request,
+					 const Http::BodyCallback& onBody, const Http::AsyncResponseCallback& cb,
+					 const Time& timeout = Time::Zero, const URI& proxy = URI() );
+
+	/** Queues a request that writes the response body to a stream as it arrives. The stream must
+	 * be valid until the response callback is called.
+	 * @see download */
+	Uint64 download( const URI& uri, const Http::Request& request, IOStream& writeTo,
+					 const Http::AsyncResponseCallback& cb, const Time& timeout = Time::Zero,
+					 const URI& proxy = URI() );
+
+	/** Cancels a queued or running request, its callback won't be called. */
+	void cancel( const Uint64& requestId );
+
+	/** Runs one iteration of the loop: dispatches the queued requests and waits until any
+	 * connection is ready or the timeout expires ( Time::Zero doesn't wait ). Only needed if the
+	 * loop doesn't run its own thread. */
+	void update( const Time& timeout = Time::Zero );
+
+	/** @return The number of requests queued or running. */
+	size_t getPendingCount() const;
+
+	void setMaxConnectionsPerHost( Uint32 maxConnectionsPerHost );
+
+	Uint32 getMaxConnectionsPerHost() const;
+
+	void setPipelineDepth( Uint32 pipelineDepth );
+
+	Uint32 getPipelineDepth() const;
+
+	/** Sets the time an unused connection is kept alive. */
+	void setIdleTimeout( const Time& idleTimeout );
+
+	const Time& getIdleTimeout() const;
+
+  protected:
+	struct Host;
+	struct Connection;
+
+	struct Transaction {
+		Uint64 id{ 0 };
+		Http::Request request;
+		Http::Response response;
+		Http::AsyncResponseCallback cb;
+		Http::BodyCallback onBody;
+		URI uri;
+		URI proxy;
+		Time timeout;
+		Clock clock;
+		std::string requestData;
+		Host* host{ nullptr };
+		bool retried{ false };
+		bool cancelled{ false };
+	};
+
+	struct Host {
+		std::string key;
+		std::unique_ptr<Http> http;
+		IpAddress address;
+		bool resolved{ false };
+		bool resolving{ false };
+		bool blocking{ false };
+		std::deque<Transaction*> queue;
+		std::vector<Connection*> connections;
+	};
+
+	struct Connection {
+		enum State { Connecting, Open, Closed };
+
+		Host* host{ nullptr };
+		std::unique_ptr<TcpSocket> socket;
+		State state{ Connecting };
+		std::string output;
+		size_t outputSent{ 0 };
+		std::deque<Transaction*> inFlight;
+		std::unique_ptr<Private::HttpResponseParser> parser;
+		std::unique_ptr<Private::HttpBodySink> body;
+		Uint32 responses{ 0 };
+		Clock idleClock;
+	};
+
+	bool mRunThread;
+	std::atomic<Uint32> mMaxConnectionsPerHost;
+	std::atomic<Uint32> mPipelineDepth;
+	Time mIdleTimeout{ Seconds( 30 ) };
+	std::atomic<bool> mRunning{ true };
+	std::atomic<Uint64> mLastId{ 0 };
+	std::atomic<size_t> mPending{ 0 };
+	mutable Mutex mIncomingMutex;
+	std::vector<Transaction*> mIncoming;
+	std::vector<Transaction*> mCompleted;
+	std::vector<Uint64> mCancelled;
+	std::vector<std::pair<Host*, IpAddress>> mResolved;
+	std::vector<Connection*> mClosed;
+	std::unordered_map<std::string, std::unique_ptr<Host>> mHosts;
+	std::unordered_map<Uint64, Transaction*> mTransactions;
+	std::unique_ptr<ThreadPool> mBlockingPool;
+	UdpSocket mWakeSocket;
+	unsigned short mWakePort{ 0 };
+	std::unique_ptr<Thread> mThread;
+	char mBuffer[16384];
+
+	void run();
+
+	void wake();
+
+	Uint64 enqueue( Transaction* transaction );
+
+	void processIncoming();
+
+	void dispatch( Host* host );
+
+	void dispatchBlocking( Transaction* transaction );
+
+	void resolve( Host* host );
+
+	ThreadPool* getBlockingPool();
+
+	Connection* openConnection( Host* host );
+
+	void startTransaction( Connection* connection, Transaction* transaction );
+
+	void onWritable( Connection* connection );
+
+	void onReadable( Connection* connection );
+
+	bool onResponseReceived( Connection* connection );
+
+	void beginResponse( Connection* connection );
+
+	bool progress( Connection* connection, const Http::Request::Status& status );
+
+	void cancelTransaction( const Uint64& requestId );
+
+	void closeConnection( Connection* connection, bool requeue );
+
+	void finish( Transaction* transaction, bool notify );
+
+	void fail( Transaction* transaction, const Http::Response::Status& status );
+
+	bool isRedirect( const Transaction* transaction ) const;
+
+	bool followRedirect( Transaction* transaction );
+
+	void checkTimeouts();
+
+	bool isPipelineable( const Transaction* transaction ) const;
+
+	Host* getHost( const URI& uri, const URI& proxy );
+};
+
+}} // namespace EE::Network
+
+#endif // EE_NETWORK_HTTPEVENTLOOP_HPP
@@ -3,10 +3,12 @@
 
 #include <eepp/core.hpp>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace EE { namespace Network {
 
+class PacketBufferPool;
 class TcpSocket;
 class UdpSocket;
 
@@ -20,9 +22,21 @@ class EE_API Packet {
 	**  Creates an empty packet. */
 	Packet();
 
+	/** @brief Creates an empty packet with memory reserved for its data
+	**  @param reserveSize Number of bytes to reserve, a hint of the packet final size
+	**  @param pool If set the data buffer is taken from the pool and returned to it when the
+	**  packet is destroyed */
+	explicit Packet( std::size_t reserveSize, PacketBufferPool* pool = NULL );
+
 	/** @brief Virtual destructor */
 	virtual ~Packet();
 
+	/** @brief Reserve memory for the data of the packet
+	**  Writing into the packet doesn't reallocate its data until it grows beyond the reserved
+	**  size.
+	**  @param sizeInBytes Total number of bytes to reserve */
+	void reserve( std::size_t sizeInBytes );
+
 	/** @brief Append data to the end of the packet
 	**  @param data		Pointer to the sequence of bytes to append
 	**  @param sizeInBytes Number of bytes to append
@@ -103,6 +117,9 @@ class EE_API Packet {
 	Packet& operator>>( double& data );
 	Packet& operator>>( char* data );
 	Packet& operator>>( std::string& data );
+	/** Extracts a string without copying it: the view points to the packet data, and it's valid
+	 * until the packet is modified or destroyed. */
+	Packet& operator>>( std::string_view& data );
 #ifndef EE_NO_WIDECHAR
 	Packet& operator>>( wchar_t* data );
 	Packet& operator>>( std::wstring& data );
@@ -121,6 +138,7 @@ class EE_API Packet {
 	Packet& operator<<( double data );
 	Packet& operator<<( const char* data );
 	Packet& operator<<( const std::string& data );
+	Packet& operator<<( const std::string_view& data );
 #ifndef EE_NO_WIDECHAR
 	Packet& operator<<( const wchar_t* data );
 	Packet& operator<<( const std::wstring& data );
@@ -173,6 +191,7 @@ class EE_API Packet {
 	std::size_t mReadPos;	 ///< Current reading position in the packet
 	std::size_t mSendPos;	 ///< Current send position in the packet (for handling partial sends)
 	bool mIsValid;			 ///< Reading state of the packet
+	PacketBufferPool* mPool; ///< Pool that owns the data buffer
 };
 
 }} // namespace EE::Network
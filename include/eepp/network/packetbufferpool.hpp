@@ -0,0 +1,48 @@
+#ifndef EE_NETWORK_PACKETBUFFERPOOL_HPP
+#define EE_NETWORK_PACKETBUFFERPOOL_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/core/noncopyable.hpp>
+#include <eepp/system/mutex.hpp>
+#include <vector>
+
+using namespace EE::System;
+
+namespace EE { namespace Network {
+
+/** @brief Recycles the data buffers of the packets.
+ * A packet created with a pool takes a buffer from it and gives it back when destroyed, so
+ * servers that build many packets per tick stop allocating once the pool is warm. The pool can be
+ * shared between threads. */
+class EE_API PacketBufferPool : NonCopyable {
+  public:
+	/** @return The pool shared by default by the application */
+	static PacketBufferPool& getGlobal();
+
+	/** @param maxBuffers Maximum number of free buffers kept
+	 * @param maxBufferCapacity Buffers bigger than this are freed instead of kept */
+	explicit PacketBufferPool( std::size_t maxBuffers = 256,
+							   std::size_t maxBufferCapacity = 256 * 1024 );
+
+	/** @return An empty buffer with at least the requested capacity */
+	std::vector<char> acquire( std::size_t capacity = 0 );
+
+	/** Takes the memory of the buffer back to the pool, the buffer is left empty. */
+	void release( std::vector<char>& buffer );
+
+	/** @return The number of free buffers in the pool */
+	std::size_t getCount() const;
+
+	/** Frees all the buffers in the pool. */
+	void clear();
+
+  protected:
+	std::size_t mMaxBuffers;
+	std::size_t mMaxBufferCapacity;
+	mutable Mutex mMutex;
+	std::vector<std::vector<char>> mBuffers;
+};
+
+}} // namespace EE::Network
+
+#endif // EE_NETWORK_PACKETBUFFERPOOL_HPP
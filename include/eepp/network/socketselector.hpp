@@ -3,6 +3,7 @@
 
 #include <eepp/core.hpp>
 #include <eepp/system/time.hpp>
+#include <vector>
 using namespace EE::System;
 
 namespace EE { namespace Network {
@@ -12,6 +13,33 @@ class Socket;
 /** Multiplexer that allows to read from multiple sockets */
 class EE_API SocketSelector {
   public:
+	/** Readiness events that a socket can be watched for */
+	enum Event : Uint32 {
+		Read = 1 << 0,	///< Data available to receive ( or a connection to accept )
+		Write = 1 << 1, ///< The socket can send without blocking
+		Error = 1 << 2	///< The socket failed or was closed by the peer ( always reported )
+	};
+
+	/** How the readiness of a socket is reported */
+	enum class Trigger {
+		/** Reported on every wait while the socket is ready */
+		Level,
+		/** Reported once each time the socket becomes ready, the socket must be read ( or
+		 * written ) until it returns Socket::NotReady. The poll backend reports it as level
+		 * triggered. */
+		Edge
+	};
+
+	/** A socket reported by wait */
+	struct Ready {
+		Socket* socket;
+		void* userData;
+		Uint32 events; ///< Combination of Event flags
+	};
+
+	/** @return The name of the readiness backend: "epoll" or "poll" */
+	static const char* getBackendName();
+
 	/** @brief Default constructor */
 	SocketSelector();
 
@@ -31,6 +59,21 @@ class EE_API SocketSelector {
 	**  @see Remove, Clear */
 	void add( Socket& socket );
 
+	/** @brief Add a new socket to the selector, or update it if it was already added
+	**  Same as add but the socket can be watched for any Event and it's reported with its user
+	**  data in the ready list.
+	**  @param socket Reference to the socket to add
+	**  @param events Combination of Event flags to watch
+	**  @param userData Pointer returned in the ready list with the socket
+	**  @param trigger How the readiness is reported
+	**  @return False if the socket is not valid or it can't be watched */
+	bool add( Socket& socket, Uint32 events, void* userData = NULL,
+			  Trigger trigger = Trigger::Level );
+
+	/** @brief Change the events watched for a socket already added, keeping its user data
+	**  @return False if the socket wasn't added */
+	bool modify( Socket& socket, Uint32 events, Trigger trigger = Trigger::Level );
+
 	/** @brief Remove a socket from the selector
 	**  This function doesn't destroy the socket, it simply
 	**  removes the reference that the selector has to it.
@@ -56,6 +99,15 @@ class EE_API SocketSelector {
 	**  @see IsReady */
 	bool wait( Time timeout = Time::Zero );
 
+	/** @brief Get the sockets that were ready in the last wait
+	**  Only the ready sockets are listed, so it scales to any number of sockets in the selector
+	**  unlike testing each of them with isReady.
+	**  @return The ready list, valid until the next wait, remove or clear */
+	const std::vector<Ready>& getReadyList() const;
+
+	/** @return The number of sockets in the selector */
+	size_t getSocketCount() const;
+
 	/** @brief Test a socket to know if it is ready to receive data
 	**  This function must be used after a call to Wait, to know
 	**  which sockets are ready to receive data. If a socket is
@@ -68,6 +120,9 @@ class EE_API SocketSelector {
 	**  @see IsReady */
 	bool isReady( Socket& socket ) const;
 
+	/** @return The events reported for the socket in the last wait ( 0 if it wasn't ready ) */
+	Uint32 getReadyEvents( Socket& socket ) const;
+
 	/** @brief Overload of assignment operator
 	**  @param right Instance to assign
 	**  @return Reference to self */
@@ -164,5 +219,32 @@ while (running) {
 }
 @endcode
 
+For many sockets the ready list avoids testing every socket after
+each wait. The sockets can also be watched for writing and carry a
+user data pointer that is returned with the events:
+@code
+selector.add(listener, SocketSelector::Read);
+
+while (running) {
+	if (selector.wait()) {
+		for (const SocketSelector::Ready& ready : selector.getReadyList()) {
+			if (ready.socket == &listener) {
+				TcpSocket* client = new TcpSocket;
+				if (listener.accept(*client) == Socket::Done)
+					selector.add(*client, SocketSelector::Read, client);
+				else
+					delete client;
+			} else {
+				TcpSocket* client = static_cast<TcpSocket*>(ready.userData);
+				...
+			}
+		}
+	}
+}
+@endcode
+
+On Linux the selector is backed by epoll, on the other platforms
+by poll, so the number of sockets is not limited by FD_SETSIZE.
+
 @see EE::Network::Socket
 */
@@ -47,6 +47,9 @@ class EE_API SSLSocket : public TcpSocket {
 
 	Status receive( Packet& packet );
 
+	/** The buffers are joined and encrypted together, TLS can't write them separately. */
+	Status sendBuffers( const Buffer* buffers, std::size_t count, std::size_t& sent );
+
 	Status sslConnect( const IpAddress& remoteAddress, unsigned short remotePort,
 					   Time timeout = Time::Zero );
 
@@ -94,6 +94,21 @@ class EE_API TcpSocket : public Socket {
 	**  @see Send */
 	virtual Status receive( void* data, std::size_t size, std::size_t& received );
 
+	/** @brief A block of data to send with sendBuffers */
+	struct Buffer {
+		const void* data;
+		std::size_t size;
+	};
+
+	/** @brief Send several blocks of raw data in order, as a single stream of bytes
+	**  The blocks are written with vectored I/O ( sendmsg / WSASend ), so they don't need to be
+	**  concatenated before sending and many small blocks are sent with a single system call.
+	**  @param buffers The blocks of data to send
+	**  @param count Number of blocks
+	**  @param sent The number of bytes actually sent
+	**  @return Status code, Partial if only part of the data could be sent */
+	virtual Status sendBuffers( const Buffer* buffers, std::size_t count, std::size_t& sent );
+
 	/** @brief Send a formatted packet of data to the remote peer
 	 *
 	 **  In non-blocking mode, if this function returns sf::Socket::Partial,
@@ -107,6 +122,18 @@ class EE_API TcpSocket : public Socket {
 	 **  @see Receive */
 	virtual Status send( Packet& packet );
 
+	/** @brief Send several formatted packets with as few system calls as possible
+	**  The result is the same as sending each packet, but the sizes and the data of the packets
+	**  are written together with sendBuffers, without copying them.
+	**  In non-blocking mode, if this function returns Socket::Partial, you \em must retry
+	**  sending the same unmodified packets before sending anything else ( the packets that were
+	**  completely sent are skipped ).
+	**  @param packets The packets to send
+	**  @param count Number of packets
+	**  @return Status code
+	**  @see send */
+	Status sendBatch( Packet* const* packets, std::size_t count );
+
 	/** @brief Receive a formatted packet of data from the remote peer
 	**  In blocking mode, this function will wait until the whole packet
 	**  has been received.
@@ -138,6 +165,7 @@ class EE_API TcpSocket : public Socket {
 
 		Uint32 Size;			  ///< Data of packet size
 		std::size_t SizeReceived; ///< Number of size bytes received so far
+		std::size_t DataReceived; ///< Number of data bytes received so far
 		std::vector<char> Data;	  ///< Data of the packet
 	};
 
@@ -8,8 +8,10 @@
 #include <eepp/system/compression.hpp>
 #include <eepp/system/condition.hpp>
 #include <eepp/system/directorypack.hpp>
+#include <eepp/system/directorywalker.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/functionstring.hpp>
+#include <eepp/system/future.hpp>
 #include <eepp/system/inifile.hpp>
 #include <eepp/system/iostream.hpp>
 #include <eepp/system/iostreamdeflate.hpp>
@@ -21,6 +23,7 @@
 #include <eepp/system/lock.hpp>
 #include <eepp/system/log.hpp>
 #include <eepp/system/luapattern.hpp>
+#include <eepp/system/memorymappedfile.hpp>
 #include <eepp/system/md5.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/pack.hpp>
@@ -0,0 +1,63 @@
+#ifndef EE_SYSTEM_DIRECTORYWALKER_HPP
+#define EE_SYSTEM_DIRECTORYWALKER_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace EE { namespace System {
+
+/** @brief Lists and walks directories without querying every file.
+ * The entry types are taken from the directory listing ( d_type on POSIX systems, the find data
+ * attributes on Windows ), so the files are only queried when the file system doesn't report
+ * their type or they are links.
+ * Directory trees are walked in parallel: every directory found is queued and the pool workers
+ * and the calling thread take directories from the queue, so big subtrees are walked by several
+ * threads at once. */
+class EE_API DirectoryWalker {
+  public:
+	struct Entry {
+		std::string name;
+		/** True if the entry is a directory or a link to a directory. */
+		bool isDirectory{ false };
+		bool isLink{ false };
+	};
+
+	struct Directory {
+		/** The directory path, with a trailing slash. */
+		std::string path;
+		/** The directory entries, without "." and "..". */
+		std::vector<Entry> entries;
+		/** Depth of the directory, the walked path is 0. */
+		size_t depth{ 0 };
+		/** User data of the directory. It's inherited by its subdirectories, the callback can
+		 * replace it before they are walked. */
+		std::shared_ptr<void> data;
+	};
+
+	/** Called for every directory walked, from any thread. The entries erased by the callback
+	 * are not walked. */
+	typedef std::function<void( Directory& directory )> DirectoryCb;
+
+	/** Lists the entries of a directory.
+	 * @return False if the directory can't be opened. */
+	static bool list( const std::string& path, std::vector<Entry>& entries );
+
+	/** Walks the directory tree, the callback receives the entries of each directory as soon as
+	 * it's listed. The linked directories are reported but not walked, so link loops can't be
+	 * followed. Returns once the whole tree was walked or the token is cancelled.
+	 * @param pool The pool where the directories are walked. If null, or it has no threads, the
+	 * tree is walked by the calling thread.
+	 * @param data The user data of the walked directory. */
+	static void walk( ThreadPool* pool, const std::string& path, const DirectoryCb& cb,
+					  std::shared_ptr<void> data = nullptr,
+					  const CancellationToken& token = CancellationToken(),
+					  const ThreadPool::Priority& priority = ThreadPool::Priority::Normal );
+};
+
+}} // namespace EE::System
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef EE_SYSTEM_FUTURE_HPP
+#define EE_SYSTEM_FUTURE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <eepp/config.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace EE { namespace System {
+
+/** An executor decides where a continuation runs: a thread pool, the main thread loop, etc.
+ * It receives the work to run and must run it exactly once. */
+typedef std::function<void( std::function<void()> )> Executor;
+
+template <typename T> class Future;
+
+template <typename T> class Promise;
+
+namespace Private {
+
+/** Shared state between a promise and its futures. The continuations are called once, by the
+ * thread that sets the value, or immediately if the value was already set. */
+template <typename T> class FutureState {
+  public:
+	using ValueType = std::conditional_t<std::is_void<T>::value, bool, T>;
+
+	template <typename V> void setValue( V&& value ) {
+		std::vector<std::function<void()>> continuations;
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			if ( mValue )
+				return;
+			mValue.emplace( std::forward<V>( value ) );
+			continuations.swap( mContinuations );
+		}
+		mReady.store( true, std::memory_order_release );
+		mCond.notify_all();
+		for ( auto& continuation : continuations )
+			continuation();
+	}
+
+	void onReady( std::function<void()> continuation ) {
+		{
+			std::lock_guard<std::mutex> lock( mMutex );
+			if ( !mValue ) {
+				mContinuations.emplace_back( std::move( continuation ) );
+				return;
+			}
+		}
+		continuation();
+	}
+
+	bool isReady() const { return mReady.load( std::memory_order_acquire ); }
+
+	void wait() const {
+		if ( isReady() )
+			return;
+		std::unique_lock<std::mutex> lock( mMutex );
+		mCond.wait( lock, [this] { return mValue.has_value(); } );
+	}
+
+	/** The value is immutable once it's set, so it can be read without the lock after that. */
+	const ValueType& get() const {
+		wait();
+		return *mValue;
+	}
+
+  protected:
+	mutable std::mutex mMutex;
+	mutable std::condition_variable mCond;
+	std::atomic<bool> mReady{ false };
+	std::optional<ValueType> mValue;
+	std::vector<std::function<void()>> mContinuations;
+};
+
+template <typename F, typename T> struct ContinuationResult {
+	using Type = std::invoke_result_t<F, const T&>;
+};
+
+template <typename F> struct ContinuationResult<F, void> {
+	using Type = std::invoke_result_t<F>;
+};
+
+/** Calls `func` and stores its result in the promise, `void` results included. */
+template <typename R, typename F, typename... Args>
+void fulfill( Promise<R>& promise, F& func, Args&&... args ) {
+	if constexpr ( std::is_void<R>::value ) {
+		func( std::forward<Args>( args )... );
+		promise.setValue();
+	} else {
+		promise.setValue( func( std::forward<Args>( args )... ) );
+	}
+}
+
+} // namespace Private
+
+/** The producer side of a Future. */
+template <typename T> class Promise {
+  public:
+	Promise() : mState( std::make_shared<Private::FutureState<T>>() ) {}
+
+	template <typename U = T, typename V>
+	std::enable_if_t<!std::is_void<U>::value> setValue( V&& value ) const {
+		mState->setValue( std::forward<V>( value ) );
+	}
+
+	template <typename U = T> std::enable_if_t<std::is_void<U>::value> setValue() const {
+		mState->setValue( true );
+	}
+
+	Future<T> getFuture() const { return Future<T>( mState ); }
+
+  protected:
+	std::shared_ptr<Private::FutureState<T>> mState;
+};
+
+/** The result of an asynchronous operation. Continuations can be chained with then(), they
+ * receive the value of the future (nothing for `Future<void>`) and their result is a new
+ * future. A continuation runs:
+ * - In the given executor (for example the main thread loop or a thread pool).
+ * - Without executor, in the thread that sets the value, or immediately if it's already set. */
+template <typename T> class Future {
+  public:
+	Future() {}
+
+	bool isValid() const { return mState != nullptr; }
+
+	bool isReady() const { return mState && mState->isReady(); }
+
+	/** Blocks until the value is set. Never call it from the thread that needs to set it. */
+	void wait() const {
+		if ( mState )
+			mState->wait();
+	}
+
+	/** Waits for and returns the value. */
+	template <typename U = T> std::enable_if_t<!std::is_void<U>::value, const U&> get() const {
+		return mState->get();
+	}
+
+	template <typename F>
+	auto then( F&& func ) const -> Future<typename Private::ContinuationResult<F, T>::Type> {
+		return then( Executor(), std::forward<F>( func ) );
+	}
+
+	template <typename F>
+	auto then( const Executor& executor, F&& func ) const
+		-> Future<typename Private::ContinuationResult<F, T>::Type> {
+		using R = typename Private::ContinuationResult<F, T>::Type;
+		Promise<R> promise;
+		Future<R> future( promise.getFuture() );
+		auto state = mState;
+		auto run = [state, promise, func = std::forward<F>( func )]() mutable {
+			if constexpr ( std::is_void<T>::value ) {
+				Private::fulfill( promise, func );
+			} else {
+				Private::fulfill( promise, func, state->get() );
+			}
+		};
+		if ( executor ) {
+			mState->onReady( [executor, run = std::move( run )]() mutable {
+				executor( std::move( run ) );
+			} );
+		} else {
+			mState->onReady( std::move( run ) );
+		}
+		return future;
+	}
+
+	/** @return A future that is already set with the value. */
+	template <typename U = T, typename V>
+	static std::enable_if_t<!std::is_void<U>::value, Future<T>> fromValue( V&& value ) {
+		Promise<T> promise;
+		promise.setValue( std::forward<V>( value ) );
+		return promise.getFuture();
+	}
+
+  protected:
+	friend class Promise<T>;
+
+	explicit Future( std::shared_ptr<Private::FutureState<T>> state ) :
+		mState( std::move( state ) ) {}
+
+	std::shared_ptr<Private::FutureState<T>> mState;
+};
+
+/** @return A future set when all the futures are set, with their values in the same order. */
+template <typename T>
+std::enable_if_t<!std::is_void<T>::value, Future<std::vector<T>>>
+whenAll( const std::vector<Future<T>>& futures ) {
+	struct State {
+		Promise<std::vector<T>> promise;
+		std::vector<T> values;
+		std::atomic<size_t> remaining;
+	};
+	auto state = std::make_shared<State>();
+	Future<std::vector<T>> result( state->promise.getFuture() );
+	if ( futures.empty() ) {
+		state->promise.setValue( std::vector<T>() );
+		return result;
+	}
+	state->values.resize( futures.size() );
+	state->remaining = futures.size();
+	for ( size_t i = 0; i < futures.size(); ++i ) {
+		// Every continuation writes its own slot, the last one publishes the vector.
+		futures[i].then( [state, i]( const T& value ) {
+			state->values[i] = value;
+			if ( state->remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+				state->promise.setValue( std::move( state->values ) );
+		} );
+	}
+	return result;
+}
+
+/** @return A future set when all the futures are set. */
+inline Future<void> whenAll( const std::vector<Future<void>>& futures ) {
+	struct State {
+		Promise<void> promise;
+		std::atomic<size_t> remaining;
+	};
+	auto state = std::make_shared<State>();
+	Future<void> result( state->promise.getFuture() );
+	state->remaining = futures.size();
+	if ( futures.empty() ) {
+		state->promise.setValue();
+		return result;
+	}
+	for ( const auto& future : futures ) {
+		future.then( [state] {
+			if ( state->remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+				state->promise.setValue();
+		} );
+	}
+	return result;
+}
+
+}} // namespace EE::System
+
+#endif
@@ -142,6 +142,42 @@ class EE_API LuaPattern {
 	mutable size_t mMatchNum;
 };
 
+/** A pattern processed once to be matched many times. Keeps the pattern length, the set of bytes
+ * that can start a match and its literal prefix, so most of the failed match attempts are rejected
+ * without running the matcher. It does not keep any match state, so it can be shared between
+ * threads. */
+class EE_API LuaCompiledPattern {
+  public:
+	LuaCompiledPattern() {}
+
+	LuaCompiledPattern( const std::string& pattern );
+
+	/** @return The number of matches (0 if not matched). matchList must be able to hold all the
+	 * captures of the pattern plus the full match. */
+	size_t matches( const char* stringSearch, int stringStartOffset, LuaPattern::Range* matchList,
+					size_t stringLength ) const;
+
+	size_t matches( const std::string& str, LuaPattern::Range* matchList,
+					int stringStartOffset = 0 ) const;
+
+	bool find( const std::string& str, int& startMatch, int& endMatch, int offset = 0 ) const;
+
+	const std::string& getPatern() const { return mPattern; }
+
+	bool isAnchored() const { return mAnchored; }
+
+	bool isEmpty() const { return mPattern.empty(); }
+
+	const std::string& getLiteralPrefix() const { return mLiteralPrefix; }
+
+  protected:
+	std::string mPattern;
+	std::string mLiteralPrefix;
+	bool mAnchored{ false };
+	bool mHasFirstSet{ false };
+	unsigned char mFirstSet[32]{};
+};
+
 }} // namespace EE::System
 
 #endif // EE_SYSTEM_LUAPATTERNMATCHER_HPP
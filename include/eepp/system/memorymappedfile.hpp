@@ -0,0 +1,53 @@
+#ifndef EE_SYSTEM_MEMORYMAPPEDFILE_HPP
+#define EE_SYSTEM_MEMORYMAPPEDFILE_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/core/noncopyable.hpp>
+#include <string>
+
+namespace EE { namespace System {
+
+/** @brief A read-only view of a file system file mapped into memory.
+ * The file contents are paged in by the operating system when they are accessed, so mapping a
+ * file is immediate regardless of its size.
+ * Note that the mapping reflects the file in the disk, truncating the file while it is mapped
+ * makes the truncated region invalid. */
+class EE_API MemoryMappedFile : NonCopyable {
+  public:
+	/** @brief Maps the file in read-only mode.
+	**	@param path File to map from path */
+	explicit MemoryMappedFile( const std::string& path );
+
+	~MemoryMappedFile();
+
+	/** @return True if the file was mapped. Empty files are valid mappings without data. */
+	bool isOpen() const;
+
+	/** @return The mapped file contents. */
+	const char* getData() const;
+
+	/** @return The mapped size in bytes. */
+	size_t getSize() const;
+
+	/** @return The mapped file path. */
+	const std::string& getPath() const;
+
+	/** @brief Hints the operating system that the file will be read sequentially. */
+	void adviseSequential();
+
+	void close();
+
+  protected:
+	std::string mPath;
+	char* mData{ nullptr };
+	size_t mSize{ 0 };
+	bool mOpen{ false };
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	void* mFile{ nullptr };
+	void* mMapping{ nullptr };
+#endif
+};
+
+}} // namespace EE::System
+
+#endif // EE_SYSTEM_MEMORYMAPPEDFILE_HPP
@@ -5,6 +5,7 @@
 #include <condition_variable>
 #include <deque>
 #include <eepp/core/noncopyable.hpp>
+#include <eepp/system/future.hpp>
 #include <eepp/system/lock.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/thread.hpp>
@@ -14,8 +15,47 @@
 
 namespace EE { namespace System {
 
+class TaskGroup;
+class ThreadPool;
+
+/** Cooperative cancellation flag shared between the code that schedules a job and the job.
+ * Copies of a token share the same flag. A queued job whose token is cancelled is discarded
+ * without running it. A running job can poll isCancelled() to stop early. */
+class EE_API CancellationToken {
+  public:
+	CancellationToken() : mCancelled( std::make_shared<std::atomic<bool>>( false ) ) {}
+
+	void cancel() {
+		if ( mCancelled )
+			mCancelled->store( true, std::memory_order_release );
+	}
+
+	bool isCancelled() const {
+		return mCancelled && mCancelled->load( std::memory_order_acquire );
+	}
+
+  protected:
+	friend class TaskGroup;
+	friend class ThreadPool;
+
+	explicit CancellationToken( std::nullptr_t ) {}
+
+	std::shared_ptr<std::atomic<bool>> mCancelled;
+};
+
 class EE_API ThreadPool : NonCopyable {
   public:
+	/** Priority lanes of the pool. Workers always pick the pending work of the highest
+	 * priority first. */
+	enum class Priority : Uint8 {
+		/// Work that the user is waiting for (UI-critical)
+		High,
+		Normal,
+		/// Bulk background work (indexing, precaching)
+		Low,
+		Count
+	};
+
 	static std::shared_ptr<ThreadPool> createShared( Uint32 numThreads,
 													 bool terminateOnClose = false );
 
@@ -28,10 +68,33 @@ class EE_API ThreadPool : NonCopyable {
 
 	virtual ~ThreadPool();
 
-	Uint64 run(
-		const std::function<void()>& func,
-		const std::function<void( const Uint64& )>& doneCallback = []( const Uint64& ) {},
-		const Uint64& tag = 0 );
+	Uint64 run( std::function<void()> func,
+				std::function<void( const Uint64& )> doneCallback = nullptr,
+				const Uint64& tag = 0, const Priority& priority = Priority::Normal );
+
+	/** Runs the job with a priority. If the token is cancelled before the job starts the job and
+	 * its done callback are discarded. */
+	Uint64 run( std::function<void()> func, const Priority& priority,
+				const CancellationToken& token = CancellationToken( nullptr ),
+				std::function<void( const Uint64& )> doneCallback = nullptr );
+
+	/** Splits [begin, end) in ranges and calls `func( rangeBegin, rangeEnd )` for each range in
+	 * the pool. The calling thread runs ranges too, and returns once all the ranges are done.
+	 * @param grainSize Minimum number of elements per range. 0 picks one automatically. */
+	void parallelFor( size_t begin, size_t end,
+					  const std::function<void( size_t, size_t )>& func,
+					  const Priority& priority = Priority::Normal, size_t grainSize = 0 );
+
+	/** Runs the function in the pool.
+	 * @return A future set with the function result once it's done. If the pool is shutting
+	 * down the function doesn't run and the future is never set. */
+	template <typename F>
+	auto async( F&& func, const Priority& priority = Priority::Normal )
+		-> Future<std::invoke_result_t<std::decay_t<F>&>>;
+
+	/** @return An executor that runs the continuations in the pool. The pool must outlive the
+	 * futures that use it. */
+	Executor getExecutor( const Priority& priority = Priority::Normal );
 
 	Uint32 numThreads() const;
 
@@ -43,29 +106,103 @@ class EE_API ThreadPool : NonCopyable {
 
 	bool existsTagInQueue( const Uint64& tag );
 
+	/** Removes a job that didn't start yet. Prefer cancellation tokens for work that can be
+	 * cancelled frequently, since this needs to look up every queue. */
 	bool removeId( const Uint64& id );
 
 	bool removeWithTag( const Uint64& tag );
 
   private:
+	friend class TaskGroup;
+
 	struct Work {
 		Uint64 id{ 0 };
-		const std::function<void()> func;
-		const std::function<void( const Uint64& )> callback;
+		std::function<void()> func;
+		std::function<void( const Uint64& )> callback;
 		Uint64 tag{ 0 };
+		CancellationToken token{ nullptr };
 	};
 
-	void threadFunc();
+	typedef std::deque<std::unique_ptr<Work>> WorkQueue;
+
+	/** Every worker owns a queue per priority for the work scheduled from the worker itself
+	 * (task groups, parallel loops). Idle workers steal the oldest work of the other queues. */
+	struct WorkerQueue {
+		std::mutex mutex;
+		WorkQueue work[static_cast<size_t>( Priority::Count )];
+	};
+
+	void threadFunc( size_t index );
+
+	bool push( std::unique_ptr<Work>&& work, const Priority& priority );
+
+	std::unique_ptr<Work> pop( size_t worker );
+
+	bool runPendingWork();
+
+	void execute( std::unique_ptr<Work>&& work );
+
+	template <typename F> bool forEachQueue( F func );
 
 	std::vector<std::unique_ptr<Thread>> mThreads;
-	std::deque<std::unique_ptr<Work>> mWork;
-	std::atomic<Uint64> mLastWorkId;
-	bool mShuttingDown = false;
+	std::vector<std::unique_ptr<WorkerQueue>> mWorkerQueues;
+	/// Work scheduled from outside the pool. It starts in FIFO order, as callers expect.
+	WorkerQueue mSharedQueue;
+	std::atomic<Uint64> mLastWorkId{ 0 };
+	std::atomic<size_t> mPendingWork{ 0 };
+	std::atomic<bool> mShuttingDown{ false };
 	bool mTerminateOnClose = false;
 	mutable std::mutex mMutex;
 	std::condition_variable mWorkAvailable;
 };
 
+/** Group of jobs that can be waited and cancelled together. When called from a pool worker,
+ * wait() helps running the pending work of the pool, so it can be safely called from a worker. */
+class EE_API TaskGroup : NonCopyable {
+  public:
+	explicit TaskGroup( ThreadPool* pool,
+						const ThreadPool::Priority& priority = ThreadPool::Priority::Normal );
+
+	/** Waits for the remaining jobs. */
+	~TaskGroup();
+
+	void run( std::function<void()> func );
+
+	/** Waits for the jobs to finish. Once the group is cancelled it only waits for the jobs
+	 * already running, the queued ones are skipped whenever the pool reaches them. */
+	void wait();
+
+	/** Discards the jobs that didn't start yet. */
+	void cancel();
+
+	const CancellationToken& getToken() const { return mToken; }
+
+  protected:
+	/* Shared with the jobs, so the jobs that didn't start can outlive the group. */
+	struct State {
+		std::mutex mutex;
+		std::condition_variable done;
+		size_t pending{ 0 }; ///< Jobs not finished or skipped yet
+		size_t running{ 0 };
+	};
+
+	ThreadPool* mPool;
+	ThreadPool::Priority mPriority;
+	CancellationToken mToken;
+	std::shared_ptr<State> mState;
+};
+
+template <typename F>
+auto ThreadPool::async( F&& func, const Priority& priority )
+	-> Future<std::invoke_result_t<std::decay_t<F>&>> {
+	using R = std::invoke_result_t<std::decay_t<F>&>;
+	Promise<R> promise;
+	Future<R> future( promise.getFuture() );
+	run( [promise, func = std::forward<F>( func )]() mutable { Private::fulfill( promise, func ); },
+		 priority );
+	return future;
+}
+
 }} // namespace EE::System
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef EE_UI_CSS_STYLESHEET_HPP
 #define EE_UI_CSS_STYLESHEET_HPP
 
+#include <eepp/system/mutex.hpp>
 #include <eepp/ui/css/elementdefinition.hpp>
 #include <eepp/ui/css/keyframesdefinition.hpp>
 #include <eepp/ui/css/mediaquery.hpp>
@@ -14,6 +15,10 @@ class EE_API StyleSheet {
   public:
 	StyleSheet();
 
+	StyleSheet( const StyleSheet& other );
+
+	StyleSheet& operator=( const StyleSheet& other );
+
 	void addStyle( std::shared_ptr<StyleSheetStyle> node );
 
 	bool isEmpty() const;
@@ -47,6 +52,8 @@ class EE_API StyleSheet {
 
 	static size_t nodeHash( const std::string& tag, const std::string& id );
 
+	static size_t classNodeHash( const std::string& cls );
+
 	void invalidateCache();
 
 	const Uint32& getMarker() const;
@@ -63,13 +70,21 @@ class EE_API StyleSheet {
 	bool refreshCacheFromStyles( const std::vector<std::shared_ptr<StyleSheetStyle>>& styles );
 
   protected:
+	struct IndexedStyle {
+		StyleSheetStyle* style;
+		/// Insertion order, breaks the ties between styles with the same specificity.
+		Uint64 order;
+	};
+
 	Uint32 mMarker{ 0 };
+	Uint64 mStyleOrder{ 0 };
 	std::vector<std::shared_ptr<StyleSheetStyle>> mNodes;
-	std::unordered_map<size_t, StyleSheetStyleVector> mNodeIndex;
+	std::unordered_map<size_t, std::vector<IndexedStyle>> mNodeIndex;
 	MediaQueryList::vector mMediaQueryList;
 	KeyframesDefinitionMap mKeyframesMap;
 	using ElementDefinitionCache = std::unordered_map<size_t, std::shared_ptr<ElementDefinition>>;
 	mutable ElementDefinitionCache mNodeCache;
+	mutable Mutex mNodeCacheMutex;
 
 	void addMediaQueryList( MediaQueryList::ptr list );
 
@@ -0,0 +1,91 @@
+#ifndef EE_UI_CSS_STYLESHEETANCESTORFILTER_HPP
+#define EE_UI_CSS_STYLESHEETANCESTORFILTER_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/core/noncopyable.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace EE { namespace UI {
+class UIWidget;
+}} // namespace EE::UI
+
+namespace EE { namespace UI { namespace CSS {
+
+/** Counting Bloom filter of the tags, ids and classes of the ancestors of an element.
+ * A selector with descendant or child combinators can only match an element if every tag, id
+ * and class required by its ancestor rules is present in the ancestors. The filter answers that
+ * without walking the ancestors, so most selectors that can't match are rejected before
+ * evaluating them.
+ * The filter can be kept during a tree traversal: pushing an element when the traversal enters
+ * its children and popping it when it leaves them. */
+class EE_API StyleSheetAncestorFilter {
+  public:
+	/** Keeps the filter of the current thread while the children of an element are styled.
+	 * If the filter of the enclosing scope belongs to the parent of the element the element is
+	 * pushed into it, otherwise a new filter is built from the element ancestors. */
+	class EE_API Scope : NonCopyable {
+	  public:
+		explicit Scope( UIWidget* element );
+
+		~Scope();
+
+	  protected:
+		StyleSheetAncestorFilter* mPrevious{ nullptr };
+		std::unique_ptr<StyleSheetAncestorFilter> mFilter;
+	};
+
+	static Uint32 tagHash( const std::string& tag );
+
+	static Uint32 idHash( const std::string& id );
+
+	static Uint32 classHash( const std::string& cls );
+
+	/** @return The filter of the current traversal if it's valid for the element (it contains
+	 * exactly the element ancestors), nullptr otherwise. */
+	static const StyleSheetAncestorFilter* getActive( UIWidget* element );
+
+	/** Sets the filter used by the style matching of the current thread.
+	 * @return The previous active filter. */
+	static StyleSheetAncestorFilter* setActive( StyleSheetAncestorFilter* filter );
+
+	StyleSheetAncestorFilter() {}
+
+	/** Builds the filter of all the ancestors of the element. */
+	explicit StyleSheetAncestorFilter( UIWidget* element );
+
+	void pushElement( UIWidget* element );
+
+	void popElement();
+
+	/** Updates the filter to contain exactly the element and its ancestors, keeping the ancestors
+	 * that are already pushed. Useful to visit a list of elements in tree order.
+	 * @param element The new top, nullptr clears the filter. */
+	void moveTo( UIWidget* element );
+
+	/** @return The last pushed element. */
+	UIWidget* getTop() const;
+
+	bool mayContain( const Uint32& hash ) const;
+
+	bool mayContainAll( const std::vector<Uint32>& hashes ) const;
+
+  protected:
+	static constexpr size_t COUNTERS = 1024;
+	static constexpr size_t COUNTERS_MASK = COUNTERS - 1;
+	static constexpr Uint8 COUNTER_MAX = 255;
+
+	Uint8 mCounters[COUNTERS]{};
+	std::vector<UIWidget*> mElements;
+	std::vector<size_t> mFrames;
+	std::vector<Uint32> mHashes;
+
+	void add( const Uint32& hash );
+
+	void remove( const Uint32& hash );
+};
+
+}}} // namespace EE::UI::CSS
+
+#endif
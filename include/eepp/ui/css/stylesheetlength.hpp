@@ -66,6 +66,10 @@ class EE_API StyleSheetLength {
 
 	static StyleSheetLength fromString( std::string str, const Float& defaultValue = 0 );
 
+	/** Parses the length string.
+	 * @return False if the string doesn't contain a number, in that case `length` is unchanged. */
+	static bool parse( std::string str, StyleSheetLength& length );
+
 	std::string toString() const;
 
   protected:
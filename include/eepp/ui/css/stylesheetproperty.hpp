@@ -33,6 +33,10 @@ struct VariableFunctionCache {
 
 class EE_API StyleSheetProperty {
   public:
+	/** Type of the value pre-parsed when the property is created. Properties with a typed value
+	 * don't parse their string value again every time they are applied. */
+	enum class ValueType : Uint8 { None, Color, Length };
+
 	StyleSheetProperty();
 
 	explicit StyleSheetProperty( const PropertyDefinition* definition, const std::string& value,
@@ -46,6 +50,10 @@ class EE_API StyleSheetProperty {
 								 const Uint32& specificity, const bool& isVolatile = false,
 								 const Uint32& index = 0 );
 
+	/** Creates a color property from an already parsed color. */
+	explicit StyleSheetProperty( const PropertyDefinition* definition, const Color& color,
+								 const Uint32& index = 0 );
+
 	Uint32 getId() const;
 
 	const std::string& getName() const;
@@ -178,6 +186,8 @@ class EE_API StyleSheetProperty {
 
 	const std::vector<VariableFunctionCache>& getVarCache() const;
 
+	const ValueType& getValueType() const;
+
   protected:
 	std::string mName;
 	String::HashType mNameHash;
@@ -192,6 +202,9 @@ class EE_API StyleSheetProperty {
 	const ShorthandDefinition* mShorthandDefinition;
 	std::vector<StyleSheetProperty> mIndexedProperty;
 	std::vector<VariableFunctionCache> mVarCache;
+	ValueType mValueType{ ValueType::None };
+	Color mColor;
+	StyleSheetLength mLength;
 
 	explicit StyleSheetProperty( const bool& isVolatile, const PropertyDefinition* definition,
 								 const std::string& value, const Uint32& specificity = 0,
@@ -202,6 +215,7 @@ class EE_API StyleSheetProperty {
 	void createIndexed();
 	void checkVars();
 	std::vector<VariableFunctionCache> checkVars( const std::string& value );
+	void parseValue();
 };
 
 typedef std::map<Uint32, StyleSheetProperty> StyleSheetProperties;
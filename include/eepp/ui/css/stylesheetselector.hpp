@@ -30,18 +30,23 @@ class EE_API StyleSheetSelector {
 
 	const bool& isStructurallyVolatile() const;
 
-	const StyleSheetSelectorRule& getRule( const Uint32& index );
+	const StyleSheetSelectorRule& getRule( const Uint32& index ) const;
 
 	const std::string& getSelectorId() const;
 
 	const std::string& getSelectorTagName() const;
 
+	/** @return The StyleSheetAncestorFilter hashes of the tags, ids and classes that the
+	 * ancestors of an element must have for the selector to match it. */
+	const std::vector<Uint32>& getAncestorHashes() const;
+
   protected:
 	std::string mName;
 	Uint32 mSpecificity;
 	std::vector<StyleSheetSelectorRule> mSelectorRules;
 	bool mCacheable;
 	bool mStructurallyVolatile;
+	std::vector<Uint32> mAncestorHashes;
 
 	void addSelectorRule( std::string& buffer,
 						  StyleSheetSelectorRule::PatternMatch& curPatternMatch,
@@ -4,6 +4,7 @@
 #include <eepp/system/color.hpp>
 #include <eepp/system/iostream.hpp>
 #include <eepp/system/pack.hpp>
+#include <eepp/ui/doc/syntaxstyletype.hpp>
 #include <unordered_map>
 #include <vector>
 
@@ -55,8 +56,12 @@ class EE_API SyntaxColorScheme {
 					   const std::unordered_map<std::string, Style>& syntaxColors,
 					   const std::unordered_map<std::string, Style>& editorColors );
 
+	const Style& getSyntaxStyle( const SyntaxStyleType& type ) const;
+
 	const Style& getSyntaxStyle( const std::string& type ) const;
 
+	bool hasSyntaxStyle( const SyntaxStyleType& type ) const;
+
 	bool hasSyntaxStyle( const std::string& type ) const;
 
 	void setSyntaxStyles( const std::unordered_map<std::string, Style>& styles );
@@ -79,7 +84,9 @@ class EE_API SyntaxColorScheme {
 	std::string mName;
 	std::unordered_map<std::string, Style> mSyntaxColors;
 	std::unordered_map<std::string, Style> mEditorColors;
-	mutable std::unordered_map<std::string, Style> mStyleCache;
+	mutable std::unordered_map<SyntaxStyleType, Style> mStyleCache;
+
+	const Style& cacheSyntaxStyle( const SyntaxStyleType& type, const std::string& name ) const;
 };
 
 }}} // namespace EE::UI::Doc
@@ -3,6 +3,8 @@
 
 #include <eepp/config.hpp>
 #include <eepp/core/string.hpp>
+#include <eepp/system/luapattern.hpp>
+#include <eepp/ui/doc/syntaxstyletype.hpp>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,15 +14,22 @@ namespace EE { namespace UI { namespace Doc {
 struct EE_API SyntaxPattern {
 	std::vector<std::string> patterns;
 	std::vector<std::string> types;
+	std::vector<SyntaxStyleType> typesIds;
 	std::string syntax{ "" };
+	/** Pre-processed patterns used by the tokenizer: the anchored start pattern, the end pattern
+	 * and the anchored end pattern (used to leave a sub-syntax). */
+	System::LuaCompiledPattern startPattern;
+	System::LuaCompiledPattern endPattern;
+	System::LuaCompiledPattern endAnchoredPattern;
 
 	SyntaxPattern( std::vector<std::string> _patterns, std::string _type,
-				   std::string _syntax = "" ) :
-		patterns( _patterns ), types( { _type } ), syntax( _syntax ) {}
+				   std::string _syntax = "" );
 
 	SyntaxPattern( std::vector<std::string> _patterns, std::vector<std::string> _types,
-				   std::string _syntax = "" ) :
-		patterns( _patterns ), types( _types ), syntax( _syntax ) {}
+				   std::string _syntax = "" );
+
+	/** Pre-processes the patterns. Must be called if the patterns are modified. */
+	void compile();
 };
 
 class EE_API SyntaxDefinition {
@@ -50,6 +59,9 @@ class EE_API SyntaxDefinition {
 
 	std::string getSymbol( const std::string& symbol ) const;
 
+	/** @return The interned style type of the symbol, SyntaxStyleTypes::None if not a symbol. */
+	SyntaxStyleType getSymbolType( const std::string& symbol ) const;
+
 	/** Accepts lua patterns and file extensions. */
 	SyntaxDefinition& addFileType( const std::string& fileType );
 
@@ -95,6 +107,7 @@ class EE_API SyntaxDefinition {
 	std::vector<std::string> mFiles;
 	std::vector<SyntaxPattern> mPatterns;
 	std::unordered_map<std::string, std::string> mSymbols;
+	std::unordered_map<std::string, SyntaxStyleType> mSymbolTypes;
 	std::string mComment;
 	std::vector<std::string> mHeaders;
 	std::string mLSPName;
@@ -2,7 +2,12 @@
 #define EE_UI_DOC_SYNTAXHIGHLIGHTER_HPP
 
 #include <eepp/ui/doc/syntaxtokenizer.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <eepp/system/threadpool.hpp>
 #include <eepp/ui/doc/textdocument.hpp>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 namespace EE { namespace UI { namespace Doc {
@@ -23,6 +28,8 @@ class EE_API SyntaxHighlighter {
   public:
 	explicit SyntaxHighlighter( TextDocument* doc );
 
+	~SyntaxHighlighter();
+
 	void changeDoc( TextDocument* doc );
 
 	void reset();
@@ -39,7 +46,7 @@ class EE_API SyntaxHighlighter {
 
 	const SyntaxDefinition& getSyntaxDefinitionFromTextPosition( const TextPosition& position );
 
-	std::string getTokenTypeAt( const TextPosition& pos );
+	SyntaxStyleType getTokenTypeAt( const TextPosition& pos );
 
 	SyntaxTokenPosition getTokenPositionAt( const TextPosition& pos );
 
@@ -56,13 +63,44 @@ class EE_API SyntaxHighlighter {
 
 	Uint64 getTokenizedLineSignature( const size_t& index );
 
+	/** Enables tokenizing ahead of the visible lines in a thread of the pool. The document lines
+	 * are snapshotted in chunks from the main thread (during updateDirty), the propagation stops
+	 * as soon as a line end state matches its cached state and the results are only merged if
+	 * the document didn't change since the snapshot. A nullptr pool disables it. */
+	void setThreadPool( const std::shared_ptr<ThreadPool>& pool );
+
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
+	bool isTokenizingAsync() const;
+
   protected:
+	struct AsyncSnapshot;
+
 	TextDocument* mDoc;
 	std::unordered_map<size_t, TokenizedLine> mLines;
 	std::unordered_map<size_t, TokenizedLine> mTokenizerLines;
 	Mutex mLinesMutex;
 	Int64 mFirstInvalidLine;
 	Int64 mMaxWantedLine;
+	std::shared_ptr<ThreadPool> mThreadPool;
+	std::shared_ptr<SyntaxDefinition> mAsyncSyntaxDefinition;
+	std::atomic<Uint64> mVersion{ 0 };
+	Int64 mAsyncFirstInvalidLine{ 0 };
+	/** Lines before it were already tokenized in the background. */
+	Int64 mAsyncTokenizedLine{ 0 };
+	/** Last line invalidated since the background tokenizer passed it, the propagation can only
+	 * stop after it. */
+	Int64 mAsyncLastInvalidLine{ -1 };
+	Uint64 mAsyncJobId{ 0 };
+	std::atomic<bool> mTokenizingAsync{ false };
+	std::atomic<bool> mAsyncStop{ false };
+	std::atomic<bool> mAsyncChanged{ false };
+	std::mutex mAsyncMutex;
+	std::condition_variable mAsyncDone;
+
+	void tokenizeAsync();
+
+	void cancelAsync();
 };
 
 }}} // namespace EE::UI::Doc
@@ -0,0 +1,45 @@
+#ifndef EE_UI_DOC_SYNTAXSTYLETYPE_HPP
+#define EE_UI_DOC_SYNTAXSTYLETYPE_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/core/string.hpp>
+#include <string>
+
+namespace EE { namespace UI { namespace Doc {
+
+/** The syntax style type is the interned id of a token type name (the hash of the name).
+ * Tokens, the highlighter cache and the color scheme lookups work directly with this id. */
+using SyntaxStyleType = String::HashType;
+
+namespace SyntaxStyleTypes {
+
+static constexpr SyntaxStyleType None = 0;
+static constexpr SyntaxStyleType Normal = EE::String::hash( "normal" );
+static constexpr SyntaxStyleType Symbol = EE::String::hash( "symbol" );
+static constexpr SyntaxStyleType Comment = EE::String::hash( "comment" );
+static constexpr SyntaxStyleType Keyword = EE::String::hash( "keyword" );
+static constexpr SyntaxStyleType Keyword2 = EE::String::hash( "keyword2" );
+static constexpr SyntaxStyleType Keyword3 = EE::String::hash( "keyword3" );
+static constexpr SyntaxStyleType Number = EE::String::hash( "number" );
+static constexpr SyntaxStyleType Literal = EE::String::hash( "literal" );
+static constexpr SyntaxStyleType String = EE::String::hash( "string" );
+static constexpr SyntaxStyleType Operator = EE::String::hash( "operator" );
+static constexpr SyntaxStyleType Function = EE::String::hash( "function" );
+static constexpr SyntaxStyleType Link = EE::String::hash( "link" );
+static constexpr SyntaxStyleType LinkHover = EE::String::hash( "link_hover" );
+
+} // namespace SyntaxStyleTypes
+
+/** Keeps the reverse mapping from the interned style type id to its name. */
+class EE_API SyntaxStyleTypeCache {
+  public:
+	/** Interns the type name and returns its id. */
+	static SyntaxStyleType intern( const std::string& name );
+
+	/** @return The type name of an interned type id. "normal" if the id is unknown. */
+	static std::string getName( const SyntaxStyleType& type );
+};
+
+}}} // namespace EE::UI::Doc
+
+#endif // EE_UI_DOC_SYNTAXSTYLETYPE_HPP
@@ -14,18 +14,18 @@ using namespace EE::Graphics;
 namespace EE { namespace UI { namespace Doc {
 
 struct EE_API SyntaxToken {
-	std::string type;
+	SyntaxStyleType type;
 	size_t len{ 0 };
 };
 
 struct EE_API SyntaxTokenPosition {
-	std::string type;
+	SyntaxStyleType type;
 	Int64 pos{ 0 };
 	size_t len{ 0 };
 };
 
 struct EE_API SyntaxTokenComplete {
-	std::string type;
+	SyntaxStyleType type;
 	std::string text;
 	size_t len{ 0 };
 };
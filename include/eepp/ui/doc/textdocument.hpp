@@ -12,6 +12,7 @@
 #include <eepp/system/threadpool.hpp>
 #include <eepp/system/time.hpp>
 #include <eepp/ui/doc/syntaxdefinition.hpp>
+#include <eepp/ui/doc/textdocumentbuffer.hpp>
 #include <eepp/ui/doc/textdocumentline.hpp>
 #include <eepp/ui/doc/textposition.hpp>
 #include <eepp/ui/doc/textrange.hpp>
@@ -569,6 +570,7 @@ class EE_API TextDocument {
 	URI mFileURI;
 	URI mLoadingFileURI;
 	FileInfo mFileRealPath;
+	std::shared_ptr<TextDocumentBuffer> mBuffer;
 	std::vector<TextDocumentLine> mLines;
 	TextRanges mSelection;
 	std::unordered_set<Client*> mClients;
@@ -577,6 +579,7 @@ class EE_API TextDocument {
 	std::atomic<bool> mLoading{ false };
 	std::atomic<bool> mRunningTransaction{ false };
 	std::atomic<bool> mLoadingAsync{ false };
+	size_t mIndexingOffset{ 0 };
 	bool mIsBOM{ false };
 	bool mAutoDetectIndentType{ true };
 	bool mForceNewLineAtEndOfFile{ false };
@@ -656,6 +659,16 @@ class EE_API TextDocument {
 
 	LoadStatus loadFromStream( IOStream& file, std::string path, bool callReset );
 
+	LoadStatus loadFromMappedFile( const std::string& path );
+
+	void initBufferIndexing();
+
+	bool indexBufferLines( size_t maxBytes );
+
+	/** Copies a memory mapped buffer to memory and releases the mapping, so the file can be
+	 * overwritten while the lines still reference the original text. */
+	void releaseMappedBuffer();
+
 	TextRange findText( String text, TextPosition from = { 0, 0 }, bool caseSensitive = true,
 						bool wholeWord = false,
 						const FindReplaceType& type = FindReplaceType::Normal,
@@ -0,0 +1,37 @@
+#ifndef EE_UI_DOC_TEXTDOCUMENTBUFFER_HPP
+#define EE_UI_DOC_TEXTDOCUMENTBUFFER_HPP
+
+#include <eepp/config.hpp>
+#include <eepp/system/memorymappedfile.hpp>
+#include <memory>
+#include <string>
+
+using namespace EE::System;
+
+namespace EE { namespace UI { namespace Doc {
+
+/** Read-only UTF-8 buffer with the original contents of a loaded document.
+ * The document lines that were not modified since the document was loaded reference this buffer
+ * instead of keeping their own decoded copy of the text (see TextDocumentLine).
+ * The buffer either owns the file contents or it is a memory mapped file. */
+class EE_API TextDocumentBuffer {
+  public:
+	explicit TextDocumentBuffer( std::string&& data );
+
+	explicit TextDocumentBuffer( std::shared_ptr<MemoryMappedFile> mappedFile );
+
+	const char* getData() const;
+
+	size_t getSize() const;
+
+	/** @return True if the buffer is a memory mapped file. */
+	bool isMapped() const;
+
+  protected:
+	std::string mData;
+	std::shared_ptr<MemoryMappedFile> mMappedFile;
+};
+
+}}} // namespace EE::UI::Doc
+
+#endif // EE_UI_DOC_TEXTDOCUMENTBUFFER_HPP
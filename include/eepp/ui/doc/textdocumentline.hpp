@@ -1,67 +1,121 @@
 #ifndef EE_UI_DOC_TEXTDOCUMENTLINE_HPP
 #define EE_UI_DOC_TEXTDOCUMENTLINE_HPP
 
+#include <atomic>
 #include <eepp/core/string.hpp>
 
 namespace EE { namespace UI { namespace Doc {
 
+/** A document line can be stored in two different ways:
+ * - As a piece of the original UTF-8 buffer of the document (see TextDocumentBuffer). The line
+ * only keeps a pointer to its bytes, and it's decoded the first time its text is requested.
+ * - As its own UTF-32 String. Any modification of the line converts it to this representation.
+ * The line hash does not depend on the representation, so it can be computed without decoding
+ * the line. */
 class EE_API TextDocumentLine {
   public:
-	TextDocumentLine( const String& text ) : mText( text ) { updateHash(); }
+	TextDocumentLine( const String& text ) : mText( text ), mData( nullptr ) { updateHash(); }
+
+	/** Creates a line that references the UTF-8 text of a document buffer.
+	 * @param data The start of the line in the buffer.
+	 * @param size The size in bytes of the line, without the line terminator.
+	 * The buffer must outlive the line or the line must be converted before the buffer is
+	 * released. */
+	TextDocumentLine( const char* data, const size_t& size );
+
+	/** Same as above, when the caller already knows if the line only contains ASCII characters. */
+	TextDocumentLine( const char* data, const size_t& size, bool ascii );
+
+	TextDocumentLine( const TextDocumentLine& other );
+
+	TextDocumentLine( TextDocumentLine&& other ) noexcept;
+
+	TextDocumentLine& operator=( const TextDocumentLine& other );
+
+	TextDocumentLine& operator=( TextDocumentLine&& other ) noexcept;
 
 	void setText( const String& text ) {
 		mText = text;
+		mData.store( nullptr, std::memory_order_release );
 		updateHash();
 	}
 
-	const String& getText() const { return mText; }
+	const String& getText() const {
+		materialize();
+		return mText;
+	}
+
+	/** @return The line text without loading the line: if it's still a piece of the document
+	 * buffer it's decoded into the buffer received, which can be reused between lines. */
+	const String& getText( String& buffer ) const;
 
-	String getTextWithoutNewLine() const { return mText.substr( 0, mText.size() - 1 ); }
+	String getTextWithoutNewLine() const { return substr( 0, size() - 1 ); }
 
 	void operator=( const std::string& right ) { setText( right ); }
 
-	String::StringBaseType operator[]( std::size_t index ) const { return mText[index]; }
+	String::StringBaseType operator[]( std::size_t index ) const { return getText()[index]; }
 
 	void insertChar( const unsigned int& pos, const String::StringBaseType& tchar ) {
+		materialize();
 		mText.insert( mText.begin() + pos, tchar );
 		updateHash();
 	}
 
 	void append( const String& text ) {
+		materialize();
 		mText.append( text );
 		updateHash();
 	}
 
 	void append( const String::StringBaseType& code ) {
+		materialize();
 		mText.append( code );
 		updateHash();
 	}
 
 	String substr( std::size_t pos = 0, std::size_t n = String::StringType::npos ) const {
-		return mText.substr( pos, n );
+		return getText().substr( pos, n );
 	}
 
 	String::Iterator insert( String::Iterator p, const String::StringBaseType& c ) {
+		materialize();
 		auto it = mText.insert( p, c );
 		updateHash();
 		return it;
 	}
 
-	bool empty() const { return mText.empty(); }
+	bool empty() const { return size() == 0; }
+
+	size_t size() const { return isMaterialized() ? mText.size() : mLength; }
 
-	size_t size() const { return mText.size(); }
+	size_t length() const { return size(); }
 
-	size_t length() const { return mText.length(); }
+	/** @return The number of occurrences of an ASCII character in the line. It does not decode
+	 * the line. */
+	size_t count( const char& ch ) const;
 
-	const String::HashType& getHash() const { return mHash; }
+	String::HashType getHash() const;
 
-	std::string toUtf8() const { return mText.toUtf8(); }
+	std::string toUtf8() const;
+
+	/** Moves a line that references a document buffer to the same position of a copy of the
+	 * buffer. */
+	void moveBuffer( const char* buffer, const char* newBuffer );
+
+	/** @return True if the line holds its own decoded text. */
+	bool isMaterialized() const { return mData.load( std::memory_order_acquire ) == nullptr; }
 
   protected:
-	String mText;
-	String::HashType mHash;
+	mutable String mText;
+	mutable std::atomic<const char*> mData;
+	size_t mSize{ 0 };
+	size_t mLength{ 0 };
+	mutable std::atomic<String::HashType> mHash{ 0 };
+	bool mAscii{ true };
+
+	void materialize() const;
 
-	void updateHash() { mHash = mText.getHash(); }
+	void updateHash();
 };
 
 }}} // namespace EE::UI::Doc
@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <eepp/system/fileinfo.hpp>
+#include <eepp/system/threadpool.hpp>
 #include <eepp/ui/models/model.hpp>
 #include <eepp/ui/uiicon.hpp>
 #include <memory>
@@ -143,9 +144,12 @@ class EE_API FileSystemModel : public Model {
 		void updateMimeType();
 	};
 
+	/** @param threadPool If set, the information of the files of big directories is read in
+	 * parallel in the pool. */
 	static std::shared_ptr<FileSystemModel>
 	New( const std::string& rootPath, const Mode& mode = Mode::FilesAndDirectories,
-		 const DisplayConfig& displayConfig = DisplayConfig() );
+		 const DisplayConfig& displayConfig = DisplayConfig(),
+		 std::shared_ptr<ThreadPool> threadPool = nullptr );
 
 	const Mode& getMode() const { return mMode; }
 
@@ -177,6 +181,8 @@ class EE_API FileSystemModel : public Model {
 
 	const DisplayConfig& getDisplayConfig() const;
 
+	const std::shared_ptr<ThreadPool>& getThreadPool() const;
+
 	void setDisplayConfig( const DisplayConfig& displayConfig );
 
 	const ModelIndex& getPreviouslySelectedIndex() const;
@@ -194,13 +200,14 @@ class EE_API FileSystemModel : public Model {
 	std::unique_ptr<Node> mRoot{ nullptr };
 	Mode mMode{ Mode::FilesAndDirectories };
 	DisplayConfig mDisplayConfig;
+	std::shared_ptr<ThreadPool> mThreadPool;
 
 	ModelIndex mPreviouslySelectedIndex{};
 
 	Node& nodeRef( const ModelIndex& index ) const;
 
 	FileSystemModel( const std::string& rootPath, const Mode& mode,
-					 const DisplayConfig& displayConfig );
+					 const DisplayConfig& displayConfig, std::shared_ptr<ThreadPool> threadPool );
 
 	size_t getFileIndex( Node* parent, const FileInfo& file );
 
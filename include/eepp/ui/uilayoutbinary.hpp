@@ -0,0 +1,86 @@
+#ifndef EE_UI_UILAYOUTBINARY_HPP
+#define EE_UI_UILAYOUTBINARY_HPP
+
+#include <eepp/config.hpp>
+#include <string>
+#include <vector>
+
+namespace pugi {
+class xml_node;
+}
+
+namespace EE { namespace UI {
+
+/** @brief Compiles XML layouts into a compact binary layout that UISceneNode can instantiate
+ * without parsing XML.
+ * The binary layout interns every tag, attribute name and value in a string table, so the loader
+ * resolves each widget factory and builds each distinct attribute property only once, and can
+ * read the layout straight from a memory mapped file.
+ * Format (all integers are little endian Uint32):
+ * - Header: "EEUL" magic, version, string count, root node count.
+ * - String table: for each string its length, its bytes and a NUL terminator.
+ * - Nodes, depth first. Every node starts with its type (Uint8) and a string id:
+ *   - Widget: the lowercase tag, the attribute count, the attribute name and value string ids
+ *     and the child node count.
+ *   - Style: the CSS of a `<style>` element.
+ *   - Xml: the raw XML of a widget subtree that needs the XML to load: widgets that read their
+ *     own XML node (see UIWidgetCreator::isXmlNodeWidget) or with child elements that are not
+ *     widgets. */
+class EE_API UILayoutBinary {
+  public:
+	enum NodeType : Uint8 { Widget, Style, Xml };
+
+	static constexpr Uint32 VERSION = 1;
+
+	static constexpr size_t HEADER_SIZE = 16;
+
+	/** @return True if the buffer starts with a binary layout header. */
+	static bool isBinaryLayout( const void* data, size_t size );
+
+	/** Compiles the node and its next siblings (same as UISceneNode::loadLayoutNodes loads).
+	 * The widgets must be registered in UIWidgetCreator before compiling, unknown elements are
+	 * skipped as the XML loader does.
+	 * @param out The compiled layout */
+	static bool compile( const pugi::xml_node& node, std::string& out );
+
+	static bool compileFromString( const std::string& xml, std::string& out );
+
+	static bool compileFromFile( const std::string& xmlPath, const std::string& binaryPath );
+
+	/** Sequential reader of a binary layout. It doesn't copy the buffer, which must outlive the
+	 * reader. */
+	class EE_API Reader {
+	  public:
+		Reader( const void* data, size_t size );
+
+		/** @return True if the header and the string table are valid. */
+		bool isValid() const;
+
+		Uint32 getStringCount() const;
+
+		/** @return The NUL terminated string, or an empty string for invalid ids. */
+		const char* getString( const Uint32& id ) const;
+
+		Uint32 getRootCount() const;
+
+		bool readU8( Uint8& value );
+
+		bool readU32( Uint32& value );
+
+		/** @return True if the reader didn't read past the end of the buffer. */
+		bool isGood() const;
+
+	  protected:
+		const char* mData;
+		size_t mSize;
+		size_t mPos{ 0 };
+		bool mValid{ false };
+		bool mGood{ true };
+		Uint32 mRootCount{ 0 };
+		std::vector<const char*> mStrings;
+	};
+};
+
+}} // namespace EE::UI
+
+#endif
@@ -6,6 +6,7 @@
 #include <eepp/system/translator.hpp>
 #include <eepp/ui/css/stylesheet.hpp>
 #include <eepp/ui/keyboardshortcut.hpp>
+#include <eepp/ui/uilayoutbinary.hpp>
 #include <list>
 
 namespace EE { namespace Graphics {
@@ -76,6 +77,11 @@ class EE_API UISceneNode : public SceneNode {
 	UIWidget* loadLayoutFromPack( Pack* pack, const std::string& FilePackPath,
 								  Node* parent = NULL );
 
+	/** Loads a layout compiled with UILayoutBinary. loadLayoutFromFile and loadLayoutFromMemory
+	 * also detect binary layouts. */
+	UIWidget* loadLayoutFromBinary( const void* data, size_t size, Node* parent = NULL,
+									const Uint32& marker = 0 );
+
 	void setStyleSheet( const CSS::StyleSheet& styleSheet );
 
 	void setStyleSheet( const std::string& inlineStyleSheet );
@@ -112,6 +118,8 @@ class EE_API UISceneNode : public SceneNode {
 
 	void updateDirtyStyles();
 
+	bool updateDirtyStylesParallel();
+
 	void updateDirtyStyleStates();
 
 	const bool& isUpdatingLayouts() const;
@@ -165,6 +173,17 @@ class EE_API UISceneNode : public SceneNode {
 
 	void setThreadPool( const std::shared_ptr<ThreadPool>& threadPool );
 
+	/** When enabled and the scene node has a thread pool, the styles of large dirty subtrees are
+	 * matched in parallel in the thread pool and then loaded in the main thread, in tree order.
+	 * Enabled by default. */
+	void setParallelStyleResolution( bool parallelStyleResolution );
+
+	bool isParallelStyleResolutionEnabled() const;
+
+	/** @return An executor that runs the future continuations in the main thread, during the
+	 * scene node update. */
+	Executor getMainThreadExecutor();
+
   protected:
 	friend class EE::UI::UIWindow;
 	friend class EE::UI::UIWidget;
@@ -194,6 +213,7 @@ class EE_API UISceneNode : public SceneNode {
 	Node* mCurParent{ nullptr };
 	Uint32 mCurOnSizeChangeListener{ 0 };
 	std::shared_ptr<ThreadPool> mThreadPool;
+	bool mParallelStyleResolution{ true };
 
 	virtual void resizeNode( EE::Window::Window* win );
 
@@ -236,6 +256,15 @@ class EE_API UISceneNode : public SceneNode {
 	CSS::MediaFeatures getMediaFeatures() const;
 
 	std::vector<UIWidget*> loadNode( pugi::xml_node node, Node* parent, const Uint32& marker );
+
+	UIWidget* loadLayoutWidgets( const std::function<std::vector<UIWidget*>()>& loadWidgets,
+								 const std::string& id );
+
+	struct BinaryLayoutCache;
+
+	std::vector<UIWidget*> loadBinaryNodes( UILayoutBinary::Reader& reader, const Uint32& count,
+											Node* parent, const Uint32& marker,
+											BinaryLayoutCache& cache );
 };
 
 }} // namespace EE::UI
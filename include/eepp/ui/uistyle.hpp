@@ -37,6 +37,10 @@ class EE_API UIStyle : public UIState {
 
 	void load();
 
+	/** Loads the style with a global definition already resolved for the widget (the result of
+	 * `getElementStyles( widget, false )`). */
+	void load( const std::shared_ptr<CSS::ElementDefinition>& globalDefinition );
+
 	void onStateChange();
 
 	const CSS::StyleSheetProperty* getStatelessStyleSheetProperty( const Uint32& propertyId ) const;
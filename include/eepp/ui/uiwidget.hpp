@@ -103,6 +103,10 @@ class EE_API UIWidget : public UINode {
 
 	virtual void loadFromXmlNode( const pugi::xml_node& node );
 
+	/** Applies already parsed inline properties, as loadFromXmlNode does with the node
+	 * attributes. Used by the binary layouts. */
+	void loadFromProperties( const std::vector<CSS::StyleSheetProperty>& properties );
+
 	void notifyLayoutAttrChange();
 
 	void notifyLayoutAttrChangeParent();
@@ -3,6 +3,8 @@
 
 #include <eepp/core.hpp>
 #include <eepp/ui/uiwidget.hpp>
+#include <set>
+#include <type_traits>
 
 namespace EE { namespace UI {
 
@@ -16,6 +18,10 @@ class EE_API UIWidgetCreator {
 
 	static UIWidget* createFromName( std::string widgetName );
 
+	/** @return The function that creates the widget, or nullptr if the widget isn't registered.
+	 * Resolving the factory once avoids looking up the widget name for every instance. */
+	static RegisterWidgetCb getWidgetFactory( std::string widgetName );
+
 	static void addCustomWidgetCallback( std::string widgetName, const CustomWidgetCb& cb );
 
 	static void removeCustomWidgetCallback( std::string widgetName );
@@ -24,6 +30,24 @@ class EE_API UIWidgetCreator {
 
 	static void registerWidget( std::string widgetName, const RegisterWidgetCb& cb );
 
+	/** Registers a widget from its New function. Widgets that override
+	 * UIWidget::loadFromXmlNode are flagged as XML node widgets (see isXmlNodeWidget). */
+	template <typename T> static void registerWidget( std::string widgetName, T* ( *cb )() ) {
+		registerWidget( widgetName, RegisterWidgetCb( cb ) );
+		// &T::loadFromXmlNode is a member of UIWidget unless T (or a base of T) overrides it
+		bool overridesXmlLoad = !std::is_same<decltype( &T::loadFromXmlNode ),
+											  decltype( &UIWidget::loadFromXmlNode )>::value;
+		setXmlNodeWidget( widgetName, overridesXmlLoad );
+	}
+
+	/** Flags a widget that reads its own XML node when loaded, for example to create its items
+	 * from its child elements. Needed by the widgets created with a custom callback. */
+	static void setXmlNodeWidget( std::string widgetName, bool xmlNodeWidget );
+
+	/** @return True if the widget reads its own XML node when loaded, so its layout can't be
+	 * loaded without the XML. */
+	static bool isXmlNodeWidget( std::string widgetName );
+
 	static void unregisterWidget( std::string widgetName );
 
 	static bool isWidgetRegistered( std::string widgetName );
@@ -37,6 +61,8 @@ class EE_API UIWidgetCreator {
 
 	static WidgetCallbackMap widgetCallback;
 
+	static std::set<std::string> xmlNodeWidgets;
+
 	static void createBaseWidgetList();
 };
 
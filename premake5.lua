@@ -1176,6 +1176,12 @@ workspace "eepp"
 		includedirs { "src/thirdparty" }
 		build_link_configuration( "eepp-ui-perf-test", true )
 
+	project "eepp-http-event-loop-test"
+		set_kind()
+		language "C++"
+		files { "src/tests/http_event_loop_test/*.cpp" }
+		build_link_configuration( "eepp-http-event-loop-test", true )
+
 if os.isfile("external_projects.lua") then
 	dofile("external_projects.lua")
 end
@@ -1,20 +1,20 @@
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <eepp/network/http.hpp>
-#include <eepp/network/http/httpstreamchunked.hpp>
+#include <eepp/network/http/httpresponseparser.hpp>
+#include <eepp/network/httpeventloop.hpp>
 #include <eepp/network/ssl/sslsocket.hpp>
 #include <eepp/network/uri.hpp>
-#include <eepp/system/compression.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/iostream.hpp>
 #include <eepp/system/iostreamfile.hpp>
-#include <eepp/system/iostreaminflate.hpp>
 #include <eepp/system/iostreamstring.hpp>
 #include <eepp/system/sys.hpp>
 #include <iostream>
 #include <iterator>
 #include <limits>
-#include <sstream>
+#include <string_view>
 
 #if EE_PLATFORM == EE_PLATFORM_EMSCRIPTEN
 #include <emscripten.h>
@@ -488,62 +488,87 @@ const std::string& Http::Response::getBody() const {
 }
 
 void Http::Response::parse( const std::string& data ) {
-	std::istringstream in( data );
+	parse( data.c_str(), data.size() );
+}
+
+void Http::Response::parse( const char* data, size_t size ) {
+	const char* end = data + size;
+	const char* cur = data;
 
 	// Extract the HTTP version from the first line
-	std::string version;
-
-	if ( in >> version ) {
-		std::locale loc;
-		if ( ( version.size() >= 8 ) && ( version[6] == '.' ) &&
-			 ( String::toLower( version.substr( 0, 5 ) ) == "http/" ) &&
-			 std::isdigit( version[5], loc ) && std::isdigit( version[7], loc ) ) {
-			mMajorVersion = version[5] - '0';
-			mMinorVersion = version[7] - '0';
-		} else {
-			// Invalid HTTP version
-			mStatus = InvalidResponse;
-			return;
-		}
+	while ( cur < end && std::isspace( static_cast<unsigned char>( *cur ) ) )
+		cur++;
+
+	const char* version = cur;
+
+	while ( cur < end && !std::isspace( static_cast<unsigned char>( *cur ) ) )
+		cur++;
+
+	if ( ( cur - version >= 8 ) && ( version[6] == '.' ) &&
+		 ( String::toLower( std::string( version, 5 ) ) == "http/" ) &&
+		 std::isdigit( static_cast<unsigned char>( version[5] ) ) &&
+		 std::isdigit( static_cast<unsigned char>( version[7] ) ) ) {
+		mMajorVersion = version[5] - '0';
+		mMinorVersion = version[7] - '0';
+	} else {
+		// Invalid HTTP version
+		mStatus = InvalidResponse;
+		return;
 	}
 
 	// Extract the status code from the first line
-	int status = InvalidResponse;
+	while ( cur < end && std::isspace( static_cast<unsigned char>( *cur ) ) )
+		cur++;
 
-	if ( in >> status ) {
-		mStatus = static_cast<Status>( status );
-	} else {
+	int status = 0;
+	const char* statusStart = cur;
+
+	while ( cur < end && std::isdigit( static_cast<unsigned char>( *cur ) ) && cur - statusStart < 9 )
+		status = status * 10 + ( *cur++ - '0' );
+
+	if ( cur == statusStart ) {
 		// Invalid status code
 		mStatus = InvalidResponse;
 		return;
 	}
 
+	mStatus = static_cast<Status>( status );
+
 	// Ignore the end of the first line
-	in.ignore( std::numeric_limits<std::streamsize>::max(), '\n' );
+	const char* eol = static_cast<const char*>( memchr( cur, '\n', end - cur ) );
 
 	// Parse the other lines, which contain fields, one by one
-	parseFields( in );
+	if ( NULL != eol )
+		parseFields( eol + 1, end - eol - 1 );
 
 	mBody.clear();
 }
 
-void Http::Response::parseFields( std::istream& in ) {
-	std::string line;
-	while ( std::getline( in, line ) && ( line.size() > 2 ) ) {
-		std::string::size_type pos = line.find( ": " );
+void Http::Response::parseFields( const char* data, size_t size ) {
+	const char* end = data + size;
+
+	while ( data < end ) {
+		const char* eol = static_cast<const char*>( memchr( data, '\n', end - data ) );
+		std::string_view line( data, ( NULL != eol ? eol : end ) - data );
 
-		if ( pos != std::string::npos ) {
+		if ( line.size() <= 2 )
+			break;
+
+		std::string_view::size_type pos = line.find( ": " );
+
+		if ( pos != std::string_view::npos ) {
 			// Extract the field name and its value
-			std::string field = line.substr( 0, pos );
-			std::string value = line.substr( pos + 2 );
+			std::string_view value = line.substr( pos + 2 );
 
 			// Remove any trailing \r
-			if ( !value.empty() && ( *value.rbegin() == '\r' ) )
-				value.erase( value.size() - 1 );
+			if ( !value.empty() && value.back() == '\r' )
+				value.remove_suffix( 1 );
 
 			// Add the field
-			mFields[String::toLower( field )] = value;
+			mFields[String::toLower( std::string( line.substr( 0, pos ) ) )] = std::string( value );
 		}
+
+		data = NULL != eol ? eol + 1 : end;
 	}
 }
 
@@ -585,7 +610,6 @@ void Http::requestAsync( const Http::AsyncResponseCallback& cb, const URI& uri,
 						 const Http::Request::ProgressCallback& progressCallback,
 						 const Http::Request::FieldTable& headers, const std::string& body,
 						 const bool& validateCertificate, const URI& proxy ) {
-	Http* http = sGlobalHttpPool.get( uri, proxy );
 	Request request( uri.getPathAndQuery(), method, body, validateCertificate, validateCertificate,
 					 true, true );
 	request.setProgressCallback( progressCallback );
@@ -593,7 +617,12 @@ void Http::requestAsync( const Http::AsyncResponseCallback& cb, const URI& uri,
 	for ( const auto& field : headers )
 		request.setField( field.first, field.second );
 
+#if EE_PLATFORM == EE_PLATFORM_EMSCRIPTEN
+	Http* http = sGlobalHttpPool.get( uri, proxy );
 	http->sendAsyncRequest( cb, request, timeout );
+#else
+	HttpEventLoop::getGlobal().request( uri, request, cb, timeout, proxy );
+#endif
 }
 
 void Http::getAsync( const Http::AsyncResponseCallback& cb, const URI& uri, const Time& timeout,
@@ -690,9 +719,11 @@ void Http::setHost( const std::string& host, unsigned short port, bool useSSL, U
 }
 
 Http::Response Http::sendRequest( const Http::Request& request, Time timeout ) {
-	IOStreamString stream;
-	Response response = downloadRequest( request, stream, timeout );
-	response.mBody = std::move( stream.getStream() );
+	std::string body;
+	HttpBodySink sink;
+	sink.setTarget( &body );
+	Response response = downloadRequest( request, sink, timeout );
+	response.mBody = std::move( body );
 	return response;
 }
 
@@ -870,210 +901,101 @@ Http::Response Http::downloadRequest( const Http::Request& request, IOStream& wr
 					request.mCancel = true;
 				}
 
-				// Wait for the server's response
-				std::size_t currentTotalBytes = 0;
-				std::size_t len = 0;
+				// Wait for the server's response. The parser writes the body to the stream
+				// straight from the receive buffer as it arrives, so the memory used doesn't
+				// depend on the response size.
+				char buffer[PACKET_BUFFER_SIZE];
 				std::size_t readed = 0;
-				char* eol = NULL; // end of line
-				char* bol = NULL; // beginning of line
-				char buffer[PACKET_BUFFER_SIZE + 1];
-				bool isnheader = false;
-				bool chunked = false;
-				bool compressed = false;
-				std::size_t contentLength = 0;
-				std::string headerBuffer;
-				HttpStreamChunked* chunkedStream = NULL;
-				IOStreamInflate* inflateStream = NULL;
-				IOStream* bufferStream = NULL;
+				bool keepAlive = true;
+				HttpResponseParser parser;
+				parser.reset( &received, &writeTo, request.getMethod() == Request::Head );
 
 				while ( !request.isCancelled() &&
 						( status = mConnection->getSocket()->receive( buffer, PACKET_BUFFER_SIZE,
 																	  readed ) ) == Socket::Done ) {
-					char* readBuffer = buffer;
-
-					// If we didn't receive the header yet, we will try to find the end of the
-					// header
-					if ( !isnheader ) {
-						// calculate combined length of unprocessed data and new data
-						len += readed;
-
-						// NULL terminate buffer for string functions
-						readBuffer[len] = '\0';
-
-						// process each line in buffer looking for header break
-						bol = readBuffer;
-
-						while ( !isnheader && ( eol = strchr( bol, '\n' ) ) != NULL ) {
-							// update bol based upon the value of eol
-							bol = eol + 1;
-
-							// test if end of headers has been reached
-							if ( 0 == strncmp( bol, "\r\n", 2 ) || 0 == strncmp( bol, "\n", 1 ) ) {
-								// note that end of headers has been reached
-								isnheader = true;
-
-								// update the value of bol to reflect the beginning of the line
-								// immediately after the headers
-								if ( bol[0] != '\n' )
-									bol += 1;
-
-								bol += 1;
-
-								// calculate the amount of data remaining in the buffer
-								len = readed - ( bol - readBuffer );
-
-								// Fill the header buffer
-								headerBuffer.append( readBuffer, ( bol - readBuffer ) );
-
-								if ( !headerBuffer.empty() ) {
-									// Build the Response object from the received data
-									received.parse( headerBuffer );
-
-									// Check if the response is chunked
-									chunked = received.getField( "transfer-encoding" ) == "chunked";
-
-									// Check if the content is compressed
-									std::string encoding( received.getField( "content-encoding" ) );
-									compressed = encoding == "gzip" || encoding == "deflate";
-
-									if ( compressed ) {
-										Compression::Mode compressionMode =
-											"gzip" == encoding ? Compression::MODE_GZIP
-															   : Compression::MODE_DEFLATE;
-
-										inflateStream =
-											IOStreamInflate::New( writeTo, compressionMode );
-									}
-
-									if ( chunked ) {
-										IOStream& writeToStream = compressed ? *inflateStream : writeTo;
-										chunkedStream =
-											eeNew( HttpStreamChunked, ( writeToStream ) );
-									}
-
-									bufferStream = chunked
-													   ? chunkedStream
-													   : ( compressed ? inflateStream : &writeTo );
-
-									// Get the content length
-									if ( !received.getField( "content-length" ).empty() ) {
-										if ( !String::fromString(
-												 contentLength,
-												 received.getField( "content-length" ) ) )
-											contentLength = 0;
-									}
-
-									if ( received.getField( "connection" ) == "closed" ) {
-										mConnection->setConnected( false );
-										mConnection->setTunneled( false );
-									}
-
-									// If a redirection is requested, and requests follows
-									// redirections, send a new request to the redirection location.
-									if ( ( received.getStatus() == Response::MovedPermanently ||
-										   received.getStatus() == Response::MovedTemporarily ) &&
-										 request.getFollowRedirect() ) {
-
-										// Only continue redirecting if less than 10 redirections
-										// were done
-										if ( request.mRedirectionCount <
-											 request.getMaxRedirects() ) {
-											std::string location( received.getField( "location" ) );
-											URI uri( location );
-
-											// Close the connection
-											if ( !mConnection->isKeepAlive() )
-												mConnection->disconnect();
-
-											eeSAFE_DELETE( chunkedStream );
-											eeSAFE_DELETE( inflateStream );
-
-											Http::Request newRequest( request );
-											newRequest.setUri( uri.getPathAndQuery() );
-
-											request.mRedirectionCount++;
-											newRequest.mRedirectionCount =
-												request.mRedirectionCount;
-
-											// Same host, expects a path in the same domain
-											if ( uri.getHost().empty() ||
-												 uri.getHost() == getHost() ) {
-												return downloadRequest( newRequest, writeTo,
-																		timeout );
-											} else {
-												// New host, we need to solve the host
-												Http http( uri.getHost(), uri.getPort(),
-														   uri.getScheme() == "https" ? true
-																					  : false );
-												return http.downloadRequest( request, writeTo,
-																			 timeout );
-											}
-										}
-									}
-
-									if ( !sendProgress( *this, request, received,
-														Request::HeaderReceived, contentLength,
-														0 ) ) {
-										request.mCancel = true;
-									}
-
-									// Move the readBuffer to the starting point
-									// of the file buffer
-									if ( len > 0 ) {
-										readBuffer = bol;
-										readed = len;
-									} else {
-										readed = 0;
-									}
-
-									headerBuffer.clear();
-								}
+					std::size_t pos = 0;
+
+					while ( pos < readed && !request.isCancelled() &&
+							( parser.getState() == HttpResponseParser::State::Header ||
+							  parser.getState() == HttpResponseParser::State::Body ) ) {
+						bool wasHeader = parser.getState() == HttpResponseParser::State::Header;
+
+						pos += parser.parse( buffer + pos, readed - pos );
+
+						// The parser stops at the end of the header, before writing any body
+						if ( !wasHeader || parser.getState() == HttpResponseParser::State::Header ||
+							 parser.getState() == HttpResponseParser::State::Error )
+							continue;
+
+						keepAlive = parser.isKeepAlive();
+
+						// If a redirection is requested, and requests follows redirections, send a
+						// new request to the redirection location.
+						if ( ( received.getStatus() == Response::MovedPermanently ||
+							   received.getStatus() == Response::MovedTemporarily ) &&
+							 request.getFollowRedirect() &&
+							 request.mRedirectionCount < request.getMaxRedirects() ) {
+							std::string location( received.getField( "location" ) );
+							URI uri( location );
+
+							// Close the connection
+							if ( !mConnection->isKeepAlive() || !keepAlive )
+								mConnection->disconnect();
+
+							Http::Request newRequest( request );
+							newRequest.setUri( uri.getPathAndQuery() );
+
+							request.mRedirectionCount++;
+							newRequest.mRedirectionCount = request.mRedirectionCount;
+
+							// Same host, expects a path in the same domain
+							if ( uri.getHost().empty() || uri.getHost() == getHost() ) {
+								return downloadRequest( newRequest, writeTo, timeout );
+							} else {
+								// New host, we need to solve the host
+								Http http( uri.getHost(), uri.getPort(),
+										   uri.getScheme() == "https" ? true : false );
+								return http.downloadRequest( request, writeTo, timeout );
 							}
 						}
 
-						if ( !isnheader ) {
-							headerBuffer.append( readBuffer, ( bol - readBuffer ) );
+						if ( !sendProgress( *this, request, received, Request::HeaderReceived,
+											parser.getContentLength(), 0 ) ) {
+							request.mCancel = true;
 						}
 					}
 
-					if ( isnheader ) {
-						currentTotalBytes += readed;
-
-						if ( readed > 0 )
-							bufferStream->write( readBuffer, readed );
-
-						if ( !sendProgress( *this, request, received, Request::ContentReceived,
-											contentLength, currentTotalBytes ) ) {
-							request.mCancel = true;
-							break;
-						}
+					if ( parser.getState() == HttpResponseParser::State::Body &&
+						 !request.isCancelled() &&
+						 !sendProgress( *this, request, received, Request::ContentReceived,
+										parser.getContentLength(),
+										parser.getBodyReceived() ) ) {
+						request.mCancel = true;
+					}
 
-						// If the response is compressed and the stream ended means that we received
-						// the message. So we can skip the socket receive call.
-						if ( ( compressed && NULL != inflateStream && !inflateStream->isOpen() ) ||
-							 ( contentLength > 0 && contentLength == currentTotalBytes ) ) {
-							break;
-						}
+					if ( parser.getState() == HttpResponseParser::State::Complete ) {
+						sendProgress( *this, request, received, Request::ContentReceived,
+									  parser.getContentLength(), parser.getBodyReceived() );
+						break;
 					}
-				}
 
-				if ( chunked && NULL != chunkedStream &&
-					 !chunkedStream->getHeaderBuffer().empty() ) {
-					headerBuffer.append( chunkedStream->getHeaderBuffer() );
+					if ( parser.getState() == HttpResponseParser::State::Error ) {
+						keepAlive = false;
+						break;
+					}
 				}
 
-				if ( !headerBuffer.empty() ) {
-					std::istringstream in( headerBuffer );
-					received.parseFields( in );
+				if ( status == Socket::Status::Disconnected ) {
+					// The responses without length end when the connection is closed
+					parser.finish();
+					keepAlive = false;
 				}
 
-				if ( status == Socket::Status::Disconnected ) {
-					mConnection->setConnected( false );
+				// The connection can't be reused if the response wasn't completely read
+				if ( !keepAlive || parser.getState() != HttpResponseParser::State::Complete ) {
+					mConnection->disconnect();
 					mConnection->setTunneled( false );
 				}
-
-				eeSAFE_DELETE( chunkedStream );
-				eeSAFE_DELETE( inflateStream );
 			} else {
 				mConnection->setConnected( false );
 				mConnection->setTunneled( false );
@@ -1094,6 +1016,20 @@ Http::Response Http::downloadRequest( const Http::Request& request, std::string
 	return downloadRequest( request, file, timeout );
 }
 
+Http::Response Http::downloadRequest( const Http::Request& request, const BodyCallback& onBody,
+									  Time timeout ) {
+	// The sink stops calling the callback once it cancels the body, the request must stop too
+	BodyCallback callback = [&request, &onBody]( const char* data, size_t size ) {
+		if ( onBody( data, size ) )
+			return true;
+		request.mCancel = true;
+		return false;
+	};
+	HttpBodySink sink;
+	sink.setCallback( &callback );
+	return downloadRequest( request, sink, timeout );
+}
+
 Http::AsyncRequest::AsyncRequest( Http* http, const Http::AsyncResponseCallback& cb,
 								  Http::Request request, Time timeout ) :
 	mHttp( http ),
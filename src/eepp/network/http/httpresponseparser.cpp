@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <cstring>
+#include <eepp/network/http/httpresponseparser.hpp>
+
+#define HTTP_MAX_HEADER_SIZE ( 64 * 1024 )
+#define HTTP_MAX_LINE_SIZE ( 8 * 1024 )
+
+namespace EE { namespace Network { namespace Private {
+
+void HttpBodySink::setTarget( std::string* target ) {
+	mTarget = target;
+	mCallback = NULL;
+	mWritten = 0;
+	mCancelled = false;
+}
+
+void HttpBodySink::setCallback( const Http::BodyCallback* callback ) {
+	mTarget = NULL;
+	mCallback = callback;
+	mWritten = 0;
+	mCancelled = false;
+}
+
+void HttpBodySink::clear() {
+	mTarget = NULL;
+	mCallback = NULL;
+}
+
+bool HttpBodySink::isCancelled() const {
+	return mCancelled;
+}
+
+ios_size HttpBodySink::read( char*, ios_size ) {
+	return 0;
+}
+
+ios_size HttpBodySink::write( const char* data, ios_size size ) {
+	if ( NULL != mTarget ) {
+		mTarget->append( data, size );
+	} else if ( NULL != mCallback && !mCancelled ) {
+		if ( !( *mCallback )( data, size ) ) {
+			mCancelled = true;
+			return 0;
+		}
+	} else {
+		return 0;
+	}
+
+	mWritten += size;
+	return size;
+}
+
+ios_size HttpBodySink::seek( ios_size ) {
+	return 0;
+}
+
+ios_size HttpBodySink::tell() {
+	return mWritten;
+}
+
+ios_size HttpBodySink::getSize() {
+	return mWritten;
+}
+
+bool HttpBodySink::isOpen() {
+	return NULL != mTarget || ( NULL != mCallback && !mCancelled );
+}
+
+HttpResponseParser::HttpResponseParser() {}
+
+HttpResponseParser::~HttpResponseParser() {
+	eeSAFE_DELETE( mInflate );
+}
+
+void HttpResponseParser::reset( Http::Response* response, IOStream* body, bool headRequest ) {
+	eeSAFE_DELETE( mInflate );
+	mResponse = response;
+	mBody = body;
+	mState = State::Header;
+	mBodyMode = BodyMode::None;
+	mChunkState = ChunkState::Size;
+	mHeadRequest = headRequest;
+	mKeepAlive = false;
+	mReceivedData = false;
+	mContentLength = 0;
+	mBodyReceived = 0;
+	mChunkRemaining = 0;
+	mHeader.clear();
+	mLine.clear();
+	mTrailer.clear();
+}
+
+size_t HttpResponseParser::parse( const char* data, size_t size ) {
+	size_t consumed = 0;
+
+	if ( size > 0 )
+		mReceivedData = true;
+
+	while ( consumed < size && ( mState == State::Header || mState == State::Body ) ) {
+		const char* cur = data + consumed;
+		size_t left = size - consumed;
+
+		if ( mState == State::Header ) {
+			consumed += parseHeader( cur, left );
+
+			if ( mState != State::Header )
+				break;
+			continue;
+		}
+
+		switch ( mBodyMode ) {
+			case BodyMode::Length: {
+				size_t len = std::min( left, mContentLength - mBodyReceived );
+				writeBody( cur, len );
+				mBodyReceived += len;
+				consumed += len;
+
+				if ( mBodyReceived == mContentLength )
+					complete();
+				break;
+			}
+			case BodyMode::UntilClose: {
+				writeBody( cur, left );
+				mBodyReceived += left;
+				consumed += left;
+				break;
+			}
+			case BodyMode::Chunked: {
+				consumed += parseChunked( cur, left );
+				break;
+			}
+			case BodyMode::None: {
+				complete();
+				break;
+			}
+		}
+	}
+
+	return consumed;
+}
+
+void HttpResponseParser::finish() {
+	if ( mState == State::Body && mBodyMode == BodyMode::UntilClose ) {
+		complete();
+	} else if ( mState != State::Complete ) {
+		mState = State::Error;
+	}
+}
+
+const HttpResponseParser::State& HttpResponseParser::getState() const {
+	return mState;
+}
+
+bool HttpResponseParser::isKeepAlive() const {
+	return mKeepAlive;
+}
+
+bool HttpResponseParser::hasReceivedData() const {
+	return mReceivedData;
+}
+
+size_t HttpResponseParser::getContentLength() const {
+	return mBodyMode == BodyMode::Length ? mContentLength : 0;
+}
+
+size_t HttpResponseParser::getBodyReceived() const {
+	return mBodyReceived;
+}
+
+size_t HttpResponseParser::findHeaderEnd( const char* data, size_t size, size_t from ) {
+	for ( size_t i = from; i < size; i++ ) {
+		const char* eol = static_cast<const char*>( memchr( data + i, '\n', size - i ) );
+
+		if ( NULL == eol )
+			break;
+
+		i = eol - data;
+
+		if ( i + 1 < size && data[i + 1] == '\n' )
+			return i + 2;
+
+		if ( i + 2 < size && data[i + 1] == '\r' && data[i + 2] == '\n' )
+			return i + 3;
+	}
+
+	return std::string::npos;
+}
+
+size_t HttpResponseParser::parseHeader( const char* data, size_t size ) {
+	// Usually the whole header arrives in the first read, then it's parsed from the receive buffer
+	if ( mHeader.empty() ) {
+		size_t headerEnd = findHeaderEnd( data, size, 0 );
+
+		if ( headerEnd != std::string::npos ) {
+			onHeaderEnd( data, headerEnd );
+			return headerEnd;
+		}
+
+		mHeader.append( data, size );
+
+		if ( mHeader.size() > HTTP_MAX_HEADER_SIZE )
+			mState = State::Error;
+
+		return size;
+	}
+
+	size_t prevSize = mHeader.size();
+	// The header end could be split between two reads
+	size_t searchFrom = prevSize >= 3 ? prevSize - 3 : 0;
+
+	mHeader.append( data, size );
+
+	size_t headerEnd = findHeaderEnd( mHeader.data(), mHeader.size(), searchFrom );
+
+	if ( headerEnd == std::string::npos ) {
+		if ( mHeader.size() > HTTP_MAX_HEADER_SIZE )
+			mState = State::Error;
+		return size;
+	}
+
+	onHeaderEnd( mHeader.data(), headerEnd );
+	mHeader.clear();
+	return headerEnd - prevSize;
+}
+
+void HttpResponseParser::onHeaderEnd( const char* header, size_t size ) {
+	mResponse->parse( header, size );
+
+	int status = mResponse->getStatus();
+
+	if ( status == Http::Response::InvalidResponse ) {
+		mState = State::Error;
+		return;
+	}
+
+	// Interim responses are followed by the final response
+	if ( status >= 100 && status < 200 && status != 101 )
+		return;
+
+	std::string connection( String::toLower( mResponse->getField( "connection" ) ) );
+
+	if ( mResponse->getMajorHttpVersion() * 10 + mResponse->getMinorHttpVersion() >= 11 ) {
+		mKeepAlive = connection != "close";
+	} else {
+		mKeepAlive = connection == "keep-alive";
+	}
+
+	if ( mHeadRequest || status < 200 || status == Http::Response::NoContent ||
+		 status == Http::Response::NotModified ) {
+		mBodyMode = BodyMode::None;
+	} else if ( String::toLower( mResponse->getField( "transfer-encoding" ) )
+					.find( "chunked" ) != std::string::npos ) {
+		mBodyMode = BodyMode::Chunked;
+	} else if ( mResponse->hasField( "content-length" ) &&
+				String::fromString( mContentLength, mResponse->getField( "content-length" ) ) ) {
+		mBodyMode = BodyMode::Length;
+	} else {
+		mBodyMode = BodyMode::UntilClose;
+		mKeepAlive = false;
+	}
+
+	std::string encoding( mResponse->getField( "content-encoding" ) );
+
+	if ( mBodyMode != BodyMode::None && NULL != mBody &&
+		 ( encoding == "gzip" || encoding == "deflate" ) ) {
+		mInflate = IOStreamInflate::New( *mBody, "gzip" == encoding ? Compression::MODE_GZIP
+																	: Compression::MODE_DEFLATE );
+	}
+
+	mState = State::Body;
+
+	if ( mBodyMode == BodyMode::None || ( mBodyMode == BodyMode::Length && 0 == mContentLength ) )
+		complete();
+}
+
+size_t HttpResponseParser::parseChunked( const char* data, size_t size ) {
+	size_t pos = 0;
+
+	while ( pos < size && mState == State::Body ) {
+		const char* cur = data + pos;
+		size_t left = size - pos;
+
+		if ( mChunkState == ChunkState::Data ) {
+			size_t len = std::min( left, mChunkRemaining );
+			writeBody( cur, len );
+			mChunkRemaining -= len;
+			mBodyReceived += len;
+			pos += len;
+
+			if ( 0 == mChunkRemaining )
+				mChunkState = ChunkState::DataEnd;
+			continue;
+		}
+
+		const char* eol = static_cast<const char*>( memchr( cur, '\n', left ) );
+
+		if ( NULL == eol ) {
+			if ( mChunkState != ChunkState::DataEnd ) {
+				mLine.append( cur, left );
+
+				if ( mLine.size() > HTTP_MAX_LINE_SIZE )
+					mState = State::Error;
+			}
+
+			pos = size;
+			break;
+		}
+
+		pos += eol - cur + 1;
+
+		if ( mChunkState == ChunkState::DataEnd ) {
+			mChunkState = ChunkState::Size;
+			continue;
+		}
+
+		mLine.append( cur, eol - cur );
+
+		if ( !mLine.empty() && mLine[mLine.size() - 1] == '\r' )
+			mLine.resize( mLine.size() - 1 );
+
+		if ( mChunkState == ChunkState::Size ) {
+			unsigned long length;
+
+			// Ignore the chunk extensions
+			if ( !String::fromString( length, mLine.substr( 0, mLine.find( ';' ) ), std::hex ) ) {
+				mState = State::Error;
+				break;
+			}
+
+			if ( length > 0 ) {
+				mChunkRemaining = length;
+				mChunkState = ChunkState::Data;
+			} else {
+				mChunkState = ChunkState::Trailer;
+			}
+		} else if ( mLine.empty() ) {
+			if ( !mTrailer.empty() )
+				mResponse->parseFields( mTrailer.data(), mTrailer.size() );
+
+			complete();
+		} else {
+			mTrailer += mLine + "\r\n";
+		}
+
+		mLine.clear();
+	}
+
+	return pos;
+}
+
+void HttpResponseParser::writeBody( const char* data, size_t size ) {
+	if ( size == 0 )
+		return;
+
+	if ( NULL != mInflate ) {
+		mInflate->write( data, size );
+	} else if ( NULL != mBody ) {
+		mBody->write( data, size );
+	}
+}
+
+void HttpResponseParser::complete() {
+	eeSAFE_DELETE( mInflate );
+	mState = State::Complete;
+}
+
+}}} // namespace EE::Network::Private
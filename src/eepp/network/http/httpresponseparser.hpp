@@ -0,0 +1,122 @@
+#ifndef EE_NETWORK_HTTPRESPONSEPARSER_HPP
+#define EE_NETWORK_HTTPRESPONSEPARSER_HPP
+
+#include <eepp/network/http.hpp>
+#include <eepp/system/iostreaminflate.hpp>
+
+using namespace EE::System;
+
+namespace EE { namespace Network { namespace Private {
+
+/** Write only stream that receives the response body, it appends it to a string ( used to receive
+ * the body directly in Http::Response ) or streams it to a body callback. Without target the body
+ * is discarded. */
+class HttpBodySink : public IOStream {
+  public:
+	void setTarget( std::string* target );
+
+	void setCallback( const Http::BodyCallback* callback );
+
+	/** Discards the rest of the body. */
+	void clear();
+
+	/** @return True if the body callback cancelled the request. */
+	bool isCancelled() const;
+
+	virtual ios_size read( char* data, ios_size size );
+
+	virtual ios_size write( const char* data, ios_size size );
+
+	virtual ios_size seek( ios_size position );
+
+	virtual ios_size tell();
+
+	virtual ios_size getSize();
+
+	virtual bool isOpen();
+
+  protected:
+	std::string* mTarget{ nullptr };
+	const Http::BodyCallback* mCallback{ nullptr };
+	size_t mWritten{ 0 };
+	bool mCancelled{ false };
+};
+
+/** Incremental HTTP/1.x response parser.
+ * It's fed with the received bytes as they arrive and writes the decoded body (dechunked and
+ * inflated) to a stream. The header is parsed in place when it arrives in a single buffer and
+ * the body is written straight from the received buffer, only the inflated data is copied.
+ * It stops at the end of the header, so the header can be inspected before any body is written,
+ * and at the end of the response, so it can parse pipelined responses from the same
+ * connection. */
+class HttpResponseParser {
+  public:
+	enum class State { Header, Body, Complete, Error };
+
+	HttpResponseParser();
+
+	~HttpResponseParser();
+
+	/** Starts a new response.
+	 * @param response The response that will receive the status and the fields
+	 * @param body The stream where the body will be written
+	 * @param headRequest True if the response is for a HEAD request ( it doesn't have body ) */
+	void reset( Http::Response* response, IOStream* body, bool headRequest );
+
+	/** @return The number of bytes consumed, less than size if the header or the response
+	 * ended. */
+	size_t parse( const char* data, size_t size );
+
+	/** Must be called when the connection is closed, it ends the responses without length. */
+	void finish();
+
+	const State& getState() const;
+
+	/** @return True if the connection can be reused after the response. */
+	bool isKeepAlive() const;
+
+	/** @return True if any byte of the response was received. */
+	bool hasReceivedData() const;
+
+	/** @return The content length, 0 if not known. */
+	size_t getContentLength() const;
+
+	/** @return The body bytes received ( before decoding ). */
+	size_t getBodyReceived() const;
+
+  protected:
+	enum class BodyMode { None, Length, Chunked, UntilClose };
+	enum class ChunkState { Size, Data, DataEnd, Trailer };
+
+	Http::Response* mResponse{ nullptr };
+	IOStream* mBody{ nullptr };
+	IOStreamInflate* mInflate{ nullptr };
+	State mState{ State::Header };
+	BodyMode mBodyMode{ BodyMode::None };
+	ChunkState mChunkState{ ChunkState::Size };
+	bool mHeadRequest{ false };
+	bool mKeepAlive{ false };
+	bool mReceivedData{ false };
+	size_t mContentLength{ 0 };
+	size_t mBodyReceived{ 0 };
+	size_t mChunkRemaining{ 0 };
+	std::string mHeader;
+	std::string mLine;
+	std::string mTrailer;
+
+	static size_t findHeaderEnd( const char* data, size_t size, size_t from );
+
+	size_t parseHeader( const char* data, size_t size );
+
+	size_t parseChunked( const char* data, size_t size );
+
+	void onHeaderEnd( const char* header, size_t size );
+
+	void writeBody( const char* data, size_t size );
+
+	void complete();
+};
+
+}}} // namespace EE::Network::Private
+
+#endif // EE_NETWORK_HTTPRESPONSEPARSER_HPP
@@ -0,0 +1,844 @@
+#include <algorithm>
+#include <eepp/network/http/httpresponseparser.hpp>
+#include <eepp/network/httpeventloop.hpp>
+#include <eepp/network/platform/platformimpl.hpp>
+#include <eepp/system/lock.hpp>
+#include <eepp/system/log.hpp>
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+#define eePoll WSAPoll
+#else
+#include <poll.h>
+#define eePoll poll
+#endif
+
+#define HTTP_EVENT_LOOP_WAIT_TIME Seconds( 1 )
+
+namespace EE { namespace Network {
+
+using namespace Private;
+
+HttpEventLoop& HttpEventLoop::getGlobal() {
+	static HttpEventLoop sGlobalLoop;
+	return sGlobalLoop;
+}
+
+HttpEventLoop::HttpEventLoop( bool runThread, Uint32 maxConnectionsPerHost,
+							  Uint32 pipelineDepth ) :
+	mRunThread( runThread ),
+	mMaxConnectionsPerHost( eemax<Uint32>( 1, maxConnectionsPerHost ) ),
+	mPipelineDepth( eemax<Uint32>( 1, pipelineDepth ) ) {
+	// The wake socket interrupts the poll when new requests are queued from other threads
+	mWakeSocket.setBlocking( false );
+
+	if ( mWakeSocket.bind( Socket::AnyPort, IpAddress::LocalHost ) == Socket::Done ) {
+		mWakePort = mWakeSocket.getLocalPort();
+	} else {
+		Log::error( "HttpEventLoop: couldn't bind the wake socket" );
+	}
+
+	if ( mRunThread ) {
+		mThread = std::make_unique<Thread>( &HttpEventLoop::run, this );
+		mThread->launch();
+	}
+}
+
+HttpEventLoop::~HttpEventLoop() {
+	mRunning = false;
+
+	if ( mThread ) {
+		wake();
+		mThread->wait();
+	}
+
+	// Waits the blocking requests
+	mBlockingPool.reset();
+
+	for ( auto& host : mHosts )
+		for ( auto& connection : host.second->connections )
+			eeDelete( connection );
+
+	for ( auto& connection : mClosed )
+		eeDelete( connection );
+
+	for ( auto& transaction : mTransactions )
+		eeDelete( transaction.second );
+
+	for ( auto& transaction : mIncoming )
+		eeDelete( transaction );
+}
+
+Uint64 HttpEventLoop::request( const URI& uri, const Http::Request& request,
+							   const Http::AsyncResponseCallback& cb, const Time& timeout,
+							   const URI& proxy ) {
+	Transaction* transaction = eeNew( Transaction, () );
+	transaction->id = ++mLastId;
+	transaction->request = request;
+	transaction->cb = cb;
+	transaction->uri = uri;
+	transaction->proxy = proxy;
+	transaction->timeout = timeout;
+	return enqueue( transaction );
+}
+
+Uint64 HttpEventLoop::download( const URI& uri, const Http::Request& request,
+								const Http::BodyCallback& onBody,
+								const Http::AsyncResponseCallback& cb, const Time& timeout,
+								const URI& proxy ) {
+	Transaction* transaction = eeNew( Transaction, () );
+	transaction->id = ++mLastId;
+	transaction->request = request;
+	transaction->cb = cb;
+	transaction->onBody = onBody;
+	transaction->uri = uri;
+	transaction->proxy = proxy;
+	transaction->timeout = timeout;
+	return enqueue( transaction );
+}
+
+Uint64 HttpEventLoop::download( const URI& uri, const Http::Request& request, IOStream& writeTo,
+								const Http::AsyncResponseCallback& cb, const Time& timeout,
+								const URI& proxy ) {
+	return download(
+		uri, request,
+		[&writeTo]( const char* data, size_t size ) {
+			return writeTo.write( data, size ) == static_cast<ios_size>( size );
+		},
+		cb, timeout, proxy );
+}
+
+Uint64 HttpEventLoop::enqueue( Transaction* transaction ) {
+	Uint64 id = transaction->id;
+
+	{
+		Lock l( mIncomingMutex );
+		mIncoming.push_back( transaction );
+	}
+
+	mPending++;
+	wake();
+
+	return id;
+}
+
+void HttpEventLoop::cancel( const Uint64& requestId ) {
+	{
+		Lock l( mIncomingMutex );
+		mCancelled.push_back( requestId );
+	}
+
+	wake();
+}
+
+size_t HttpEventLoop::getPendingCount() const {
+	return mPending;
+}
+
+void HttpEventLoop::setMaxConnectionsPerHost( Uint32 maxConnectionsPerHost ) {
+	mMaxConnectionsPerHost = eemax<Uint32>( 1, maxConnectionsPerHost );
+}
+
+Uint32 HttpEventLoop::getMaxConnectionsPerHost() const {
+	return mMaxConnectionsPerHost;
+}
+
+void HttpEventLoop::setPipelineDepth( Uint32 pipelineDepth ) {
+	mPipelineDepth = eemax<Uint32>( 1, pipelineDepth );
+}
+
+Uint32 HttpEventLoop::getPipelineDepth() const {
+	return mPipelineDepth;
+}
+
+void HttpEventLoop::setIdleTimeout( const Time& idleTimeout ) {
+	mIdleTimeout = idleTimeout;
+}
+
+const Time& HttpEventLoop::getIdleTimeout() const {
+	return mIdleTimeout;
+}
+
+void HttpEventLoop::run() {
+	while ( mRunning )
+		update( HTTP_EVENT_LOOP_WAIT_TIME );
+}
+
+void HttpEventLoop::wake() {
+	if ( 0 != mWakePort ) {
+		char signal = 0;
+		mWakeSocket.send( &signal, 1, IpAddress::LocalHost, mWakePort );
+	}
+}
+
+void HttpEventLoop::update( const Time& timeout ) {
+	processIncoming();
+	checkTimeouts();
+
+	std::vector<pollfd> fds;
+	std::vector<Connection*> polled;
+
+	pollfd wakeFd;
+	wakeFd.fd = mWakeSocket.getHandle();
+	wakeFd.events = POLLIN;
+	wakeFd.revents = 0;
+	fds.push_back( wakeFd );
+
+	for ( auto& host : mHosts ) {
+		for ( auto& connection : host.second->connections ) {
+			pollfd fd;
+			fd.fd = connection->socket->getHandle();
+			fd.revents = 0;
+
+			if ( connection->state == Connection::Connecting ) {
+				fd.events = POLLOUT;
+			} else {
+				fd.events = POLLIN;
+				if ( connection->outputSent < connection->output.size() )
+					fd.events |= POLLOUT;
+			}
+
+			fds.push_back( fd );
+			polled.push_back( connection );
+		}
+	}
+
+	int waitTime = static_cast<int>( timeout.asMilliseconds() );
+
+	if ( eePoll( fds.data(), fds.size(), waitTime ) > 0 ) {
+		if ( fds[0].revents & POLLIN ) {
+			char buffer[64];
+			std::size_t received;
+			IpAddress address;
+			unsigned short port;
+
+			while ( mWakeSocket.receive( buffer, sizeof( buffer ), received, address, port ) ==
+					Socket::Done ) {
+			}
+		}
+
+		for ( size_t i = 0; i < polled.size(); i++ ) {
+			Connection* connection = polled[i];
+			short revents = fds[i + 1].revents;
+
+			if ( 0 == revents || connection->state == Connection::Closed )
+				continue;
+
+			if ( connection->state == Connection::Connecting ) {
+				// The connection request returned, it may have been accepted or refused
+				if ( connection->socket->getRemoteAddress() != IpAddress::None ) {
+					connection->state = Connection::Open;
+					if ( !progress( connection, Http::Request::Connected ) ) {
+						closeConnection( connection, true );
+						continue;
+					}
+				} else {
+					closeConnection( connection, false );
+					continue;
+				}
+			}
+
+			if ( revents & ( POLLIN | POLLHUP | POLLERR ) )
+				onReadable( connection );
+
+			if ( connection->state == Connection::Open && ( revents & POLLOUT ) )
+				onWritable( connection );
+		}
+	}
+
+	processIncoming();
+
+	for ( auto& host : mHosts ) {
+		std::vector<Connection*> idle;
+
+		for ( auto& connection : host.second->connections ) {
+			if ( connection->inFlight.empty() &&
+				 connection->idleClock.getElapsedTime() >= mIdleTimeout )
+				idle.push_back( connection );
+		}
+
+		for ( auto& connection : idle )
+			closeConnection( connection, false );
+	}
+
+	for ( auto& connection : mClosed )
+		eeDelete( connection );
+
+	mClosed.clear();
+}
+
+void HttpEventLoop::processIncoming() {
+	std::vector<Transaction*> incoming;
+	std::vector<Transaction*> completed;
+	std::vector<Uint64> cancelled;
+	std::vector<std::pair<Host*, IpAddress>> resolved;
+
+	{
+		Lock l( mIncomingMutex );
+		incoming.swap( mIncoming );
+		completed.swap( mCompleted );
+		cancelled.swap( mCancelled );
+		resolved.swap( mResolved );
+	}
+
+	for ( auto& hostAddress : resolved ) {
+		Host* host = hostAddress.first;
+		host->address = hostAddress.second;
+		host->resolving = false;
+		host->resolved = true;
+	}
+
+	for ( auto& transaction : incoming ) {
+		mTransactions[transaction->id] = transaction;
+		transaction->host = getHost( transaction->uri, transaction->proxy );
+
+		if ( transaction->host->blocking ) {
+			dispatchBlocking( transaction );
+		} else {
+			transaction->host->queue.push_back( transaction );
+		}
+	}
+
+	for ( auto& transaction : completed )
+		finish( transaction, true );
+
+	for ( auto& id : cancelled )
+		cancelTransaction( id );
+
+	for ( auto& host : mHosts )
+		if ( !host.second->queue.empty() )
+			dispatch( host.second.get() );
+}
+
+HttpEventLoop::Host* HttpEventLoop::getHost( const URI& uri, const URI& proxy ) {
+	std::string key( uri.getSchemeAndAuthority() );
+
+	if ( !proxy.empty() )
+		key += "-" + proxy.getSchemeAndAuthority();
+
+	auto it = mHosts.find( key );
+
+	if ( it != mHosts.end() )
+		return it->second.get();
+
+	std::unique_ptr<Host> host = std::make_unique<Host>();
+	host->key = key;
+	host->http = std::make_unique<Http>( uri.getHost(), uri.getPort(), uri.getScheme() == "https",
+										 proxy );
+	host->blocking = host->http->isSSL() || host->http->isProxied();
+
+	Host* hostPtr = host.get();
+	mHosts[key] = std::move( host );
+	return hostPtr;
+}
+
+bool HttpEventLoop::isPipelineable( const Transaction* transaction ) const {
+	return transaction->request.getMethod() == Http::Request::Get ||
+		   transaction->request.getMethod() == Http::Request::Head;
+}
+
+void HttpEventLoop::dispatch( Host* host ) {
+	if ( !host->resolved ) {
+		// The requests stay queued until the host is resolved
+		resolve( host );
+		return;
+	}
+
+	if ( 0 == host->address.toInteger() ) {
+		Log::error( "HttpEventLoop: couldn't resolve host %s", host->http->getHostName().c_str() );
+
+		// Allow to retry the resolution in the next requests
+		host->resolved = false;
+
+		while ( !host->queue.empty() ) {
+			Transaction* transaction = host->queue.front();
+			host->queue.pop_front();
+			fail( transaction, Http::Response::ConnectionFailed );
+		}
+
+		return;
+	}
+
+	while ( !host->queue.empty() ) {
+		Transaction* transaction = host->queue.front();
+		Connection* target = NULL;
+
+		for ( auto& connection : host->connections ) {
+			if ( connection->state != Connection::Closed && connection->inFlight.empty() ) {
+				target = connection;
+				break;
+			}
+		}
+
+		if ( NULL == target && mPipelineDepth > 1 && isPipelineable( transaction ) ) {
+			for ( auto& connection : host->connections ) {
+				if ( connection->state == Connection::Closed ||
+					 connection->inFlight.size() >= mPipelineDepth )
+					continue;
+
+				bool pipelineable = true;
+
+				for ( auto& inFlight : connection->inFlight )
+					pipelineable = pipelineable && isPipelineable( inFlight );
+
+				if ( pipelineable ) {
+					target = connection;
+					break;
+				}
+			}
+		}
+
+		if ( NULL == target && host->connections.size() < mMaxConnectionsPerHost ) {
+			target = openConnection( host );
+
+			if ( NULL == target ) {
+				host->queue.pop_front();
+				fail( transaction, Http::Response::ConnectionFailed );
+				continue;
+			}
+		}
+
+		// Wait until any connection is available
+		if ( NULL == target )
+			break;
+
+		host->queue.pop_front();
+		startTransaction( target, transaction );
+	}
+}
+
+ThreadPool* HttpEventLoop::getBlockingPool() {
+	if ( !mBlockingPool )
+		mBlockingPool = ThreadPool::createUnique( mMaxConnectionsPerHost );
+	return mBlockingPool.get();
+}
+
+void HttpEventLoop::resolve( Host* host ) {
+	if ( host->resolving )
+		return;
+
+	// The name resolution blocks, it runs in the pool so it doesn't stall the other connections
+	host->resolving = true;
+	std::string hostName( host->http->getHostName() );
+
+	getBlockingPool()->run( [this, host, hostName] {
+		IpAddress address( hostName );
+
+		{
+			Lock l( mIncomingMutex );
+			mResolved.emplace_back( host, address );
+		}
+
+		wake();
+	} );
+}
+
+void HttpEventLoop::dispatchBlocking( Transaction* transaction ) {
+	getBlockingPool()->run( [this, transaction] {
+		Http* http = transaction->host->http.get();
+		Http::Response response =
+			transaction->onBody
+				? http->downloadRequest( transaction->request, transaction->onBody,
+										 transaction->timeout )
+				: http->sendRequest( transaction->request, transaction->timeout );
+
+		// Same as the async requests, the connection of the thread is destroyed
+		Http::HttpConnection* connection = http->mConnection;
+		eeSAFE_DELETE( connection );
+		http->mConnection = NULL;
+
+		{
+			Lock l( mIncomingMutex );
+			transaction->response = std::move( response );
+			mCompleted.push_back( transaction );
+		}
+
+		wake();
+	} );
+}
+
+HttpEventLoop::Connection* HttpEventLoop::openConnection( Host* host ) {
+	Connection* connection = eeNew( Connection, () );
+	connection->host = host;
+	connection->socket = std::make_unique<TcpSocket>();
+	connection->parser = std::make_unique<HttpResponseParser>();
+	connection->body = std::make_unique<HttpBodySink>();
+	connection->socket->setBlocking( false );
+
+	Socket::Status status = connection->socket->connect( host->address, host->http->getPort() );
+
+	if ( status == Socket::Done ) {
+		connection->state = Connection::Open;
+	} else if ( status == Socket::NotReady ) {
+		connection->state = Connection::Connecting;
+	} else {
+		eeDelete( connection );
+		return NULL;
+	}
+
+	host->connections.push_back( connection );
+	return connection;
+}
+
+void HttpEventLoop::startTransaction( Connection* connection, Transaction* transaction ) {
+	if ( transaction->requestData.empty() ) {
+		Http* http = connection->host->http.get();
+		Http::Request toSend( http->prepareFields( transaction->request ) );
+
+		// Keep the connection open for the next requests unless requested otherwise
+		if ( !transaction->request.hasField( "Connection" ) )
+			toSend.setField( "Connection", "keep-alive" );
+
+		transaction->requestData = toSend.prepare( *http );
+
+		if ( transaction->request.isVerbose() )
+			Log::info( "Request:\n%s", transaction->requestData.c_str() );
+	}
+
+	transaction->clock.restart();
+	connection->output.append( transaction->requestData );
+	connection->inFlight.push_back( transaction );
+
+	if ( connection->inFlight.size() == 1 )
+		beginResponse( connection );
+
+	if ( connection->state == Connection::Open )
+		onWritable( connection );
+}
+
+void HttpEventLoop::beginResponse( Connection* connection ) {
+	Transaction* transaction = connection->inFlight.front();
+	transaction->response = Http::Response();
+
+	if ( transaction->onBody ) {
+		connection->body->setCallback( &transaction->onBody );
+	} else {
+		connection->body->setTarget( &transaction->response.mBody );
+	}
+
+	connection->parser->reset( &transaction->response, connection->body.get(),
+							   transaction->request.getMethod() == Http::Request::Head );
+}
+
+bool HttpEventLoop::progress( Connection* connection, const Http::Request::Status& status ) {
+	if ( connection->inFlight.empty() )
+		return true;
+
+	Transaction* transaction = connection->inFlight.front();
+	const Http::Request& request = transaction->request;
+
+	if ( !request.getProgressCallback() )
+		return true;
+
+	if ( request.getProgressCallback()(
+			 *connection->host->http, request, transaction->response, status,
+			 connection->parser->getContentLength(), connection->parser->getBodyReceived() ) )
+		return true;
+
+	// Cancelled by the progress callback
+	connection->inFlight.pop_front();
+	connection->parser->reset( NULL, NULL, false );
+	finish( transaction, false );
+	return false;
+}
+
+void HttpEventLoop::onWritable( Connection* connection ) {
+	while ( connection->outputSent < connection->output.size() ) {
+		std::size_t sent = 0;
+		Socket::Status status = connection->socket->send(
+			connection->output.data() + connection->outputSent,
+			connection->output.size() - connection->outputSent, sent );
+
+		connection->outputSent += sent;
+
+		if ( status == Socket::Partial || status == Socket::NotReady )
+			return;
+
+		if ( status != Socket::Done ) {
+			closeConnection( connection, true );
+			return;
+		}
+	}
+
+	connection->output.clear();
+	connection->outputSent = 0;
+
+	if ( !progress( connection, Http::Request::Sent ) )
+		closeConnection( connection, true );
+}
+
+void HttpEventLoop::onReadable( Connection* connection ) {
+	while ( connection->state != Connection::Closed ) {
+		std::size_t received = 0;
+		Socket::Status status = connection->socket->receive( mBuffer, sizeof( mBuffer ), received );
+
+		if ( status == Socket::NotReady )
+			return;
+
+		if ( status != Socket::Done ) {
+			if ( !connection->inFlight.empty() ) {
+				connection->parser->finish();
+
+				if ( connection->parser->getState() == HttpResponseParser::State::Complete )
+					onResponseReceived( connection );
+			}
+
+			closeConnection( connection, true );
+			return;
+		}
+
+		size_t pos = 0;
+
+		while ( pos < received ) {
+			// The server sent data that wasn't requested
+			if ( connection->inFlight.empty() ) {
+				closeConnection( connection, false );
+				return;
+			}
+
+			HttpResponseParser* parser = connection->parser.get();
+			bool wasHeader = parser->getState() == HttpResponseParser::State::Header;
+
+			pos += parser->parse( mBuffer + pos, received - pos );
+
+			if ( parser->getState() == HttpResponseParser::State::Error ) {
+				Transaction* transaction = connection->inFlight.front();
+				connection->inFlight.pop_front();
+				fail( transaction, Http::Response::InvalidResponse );
+				closeConnection( connection, true );
+				return;
+			}
+
+			if ( wasHeader && parser->getState() != HttpResponseParser::State::Header ) {
+				// The body of the redirection isn't the body requested
+				if ( isRedirect( connection->inFlight.front() ) )
+					connection->body->clear();
+
+				if ( !progress( connection, Http::Request::HeaderReceived ) ) {
+					closeConnection( connection, true );
+					return;
+				}
+			}
+
+			if ( connection->body->isCancelled() ) {
+				// Cancelled by the body callback
+				Transaction* transaction = connection->inFlight.front();
+				connection->inFlight.pop_front();
+				parser->reset( NULL, NULL, false );
+				finish( transaction, false );
+				closeConnection( connection, true );
+				return;
+			}
+
+			if ( parser->getState() == HttpResponseParser::State::Complete ) {
+				if ( !onResponseReceived( connection ) )
+					return;
+			} else if ( !wasHeader && parser->getState() == HttpResponseParser::State::Body &&
+						!progress( connection, Http::Request::ContentReceived ) ) {
+				closeConnection( connection, true );
+				return;
+			}
+		}
+	}
+}
+
+bool HttpEventLoop::onResponseReceived( Connection* connection ) {
+	Transaction* transaction = connection->inFlight.front();
+	connection->inFlight.pop_front();
+	connection->responses++;
+	connection->body->setTarget( NULL );
+
+	bool keepAlive = connection->parser->isKeepAlive();
+
+	if ( !followRedirect( transaction ) )
+		finish( transaction, true );
+
+	if ( !keepAlive ) {
+		// The server closes the connection, the pipelined requests weren't processed and can be
+		// sent again
+		Host* host = connection->host;
+
+		for ( auto it = connection->inFlight.rbegin(); it != connection->inFlight.rend(); ++it ) {
+			( *it )->requestData.clear();
+			host->queue.push_front( *it );
+		}
+
+		connection->inFlight.clear();
+		closeConnection( connection, true );
+		return false;
+	}
+
+	if ( !connection->inFlight.empty() )
+		beginResponse( connection );
+
+	connection->idleClock.restart();
+	return true;
+}
+
+bool HttpEventLoop::isRedirect( const Transaction* transaction ) const {
+	const Http::Request& request = transaction->request;
+	Http::Response::Status status = transaction->response.getStatus();
+
+	return ( status == Http::Response::MovedPermanently ||
+			 status == Http::Response::MovedTemporarily ) &&
+		   request.getFollowRedirect() && request.mRedirectionCount < request.getMaxRedirects();
+}
+
+bool HttpEventLoop::followRedirect( Transaction* transaction ) {
+	if ( !isRedirect( transaction ) )
+		return false;
+
+	Http::Request& request = transaction->request;
+
+	URI location( transaction->response.getField( "location" ) );
+
+	request.mRedirectionCount++;
+	request.setUri( location.getPathAndQuery() );
+
+	// A location without host is a path in the same host
+	if ( !location.getHost().empty() )
+		transaction->uri = URI( location.getSchemeAndAuthority() );
+
+	transaction->requestData.clear();
+	transaction->retried = false;
+	transaction->host = getHost( transaction->uri, transaction->proxy );
+
+	if ( transaction->host->blocking ) {
+		dispatchBlocking( transaction );
+	} else {
+		transaction->host->queue.push_back( transaction );
+		dispatch( transaction->host );
+	}
+
+	return true;
+}
+
+void HttpEventLoop::closeConnection( Connection* connection, bool requeue ) {
+	if ( connection->state == Connection::Closed )
+		return;
+
+	Host* host = connection->host;
+	connection->state = Connection::Closed;
+	connection->socket->disconnect();
+	connection->body->setTarget( NULL );
+
+	host->connections.erase(
+		std::find( host->connections.begin(), host->connections.end(), connection ) );
+
+	// Requests without response are retried once on a new connection when it's safe: the
+	// connection was reused ( the server may have closed it while idle ) or the request is
+	// idempotent
+	std::vector<Transaction*> retry;
+
+	for ( size_t i = 0; i < connection->inFlight.size(); i++ ) {
+		Transaction* transaction = connection->inFlight[i];
+		bool receivedData = 0 == i && connection->parser->hasReceivedData();
+
+		if ( requeue && !transaction->retried && !receivedData &&
+			 ( connection->responses > 0 || isPipelineable( transaction ) ) ) {
+			transaction->retried = true;
+			transaction->requestData.clear();
+			retry.push_back( transaction );
+		} else {
+			fail( transaction, Http::Response::ConnectionFailed );
+		}
+	}
+
+	connection->inFlight.clear();
+
+	for ( auto it = retry.rbegin(); it != retry.rend(); ++it )
+		host->queue.push_front( *it );
+
+	mClosed.push_back( connection );
+}
+
+void HttpEventLoop::fail( Transaction* transaction, const Http::Response::Status& status ) {
+	transaction->response = Http::Response();
+	transaction->response.mStatus = status;
+	finish( transaction, true );
+}
+
+void HttpEventLoop::finish( Transaction* transaction, bool notify ) {
+	mTransactions.erase( transaction->id );
+	mPending--;
+
+	if ( notify && !transaction->cancelled && transaction->cb )
+		transaction->cb( *transaction->host->http, transaction->request, transaction->response );
+
+	eeDelete( transaction );
+}
+
+void HttpEventLoop::cancelTransaction( const Uint64& requestId ) {
+	auto it = mTransactions.find( requestId );
+
+	if ( it == mTransactions.end() )
+		return;
+
+	Transaction* transaction = it->second;
+	Host* host = transaction->host;
+	transaction->cancelled = true;
+
+	// Blocking requests can't be interrupted, they will just not be notified
+	if ( host->blocking )
+		return;
+
+	auto queued = std::find( host->queue.begin(), host->queue.end(), transaction );
+
+	if ( queued != host->queue.end() ) {
+		host->queue.erase( queued );
+		finish( transaction, false );
+		return;
+	}
+
+	for ( auto& connection : host->connections ) {
+		auto inFlight =
+			std::find( connection->inFlight.begin(), connection->inFlight.end(), transaction );
+
+		if ( inFlight != connection->inFlight.end() ) {
+			// The request was already sent, the connection can't be used for the next responses
+			if ( inFlight == connection->inFlight.begin() )
+				connection->parser->reset( NULL, NULL, false );
+
+			connection->inFlight.erase( inFlight );
+			finish( transaction, false );
+			closeConnection( connection, true );
+			return;
+		}
+	}
+}
+
+void HttpEventLoop::checkTimeouts() {
+	std::vector<Connection*> expired;
+
+	for ( auto& host : mHosts ) {
+		for ( auto& connection : host.second->connections ) {
+			for ( auto& transaction : connection->inFlight ) {
+				if ( transaction->timeout != Time::Zero &&
+					 transaction->clock.getElapsedTime() >= transaction->timeout ) {
+					expired.push_back( connection );
+					break;
+				}
+			}
+		}
+	}
+
+	for ( auto& connection : expired ) {
+		std::deque<Transaction*> inFlight;
+
+		for ( auto& transaction : connection->inFlight ) {
+			if ( transaction->timeout != Time::Zero &&
+				 transaction->clock.getElapsedTime() >= transaction->timeout ) {
+				if ( transaction == connection->inFlight.front() )
+					connection->parser->reset( NULL, NULL, false );
+
+				fail( transaction, Http::Response::ConnectionFailed );
+			} else {
+				inFlight.push_back( transaction );
+			}
+		}
+
+		connection->inFlight = std::move( inFlight );
+		closeConnection( connection, true );
+	}
+}
+
+}} // namespace EE::Network
@@ -1,5 +1,6 @@
 #include <cstring>
 #include <eepp/network/packet.hpp>
+#include <eepp/network/packetbufferpool.hpp>
 #include <eepp/network/platform/platformimpl.hpp>
 
 #ifndef EE_NO_WIDECHAR
@@ -8,15 +9,31 @@
 
 namespace EE { namespace Network {
 
-Packet::Packet() : mReadPos( 0 ), mSendPos( 0 ), mIsValid( true ) {}
+Packet::Packet() : mReadPos( 0 ), mSendPos( 0 ), mIsValid( true ), mPool( NULL ) {}
 
-Packet::~Packet() {}
+Packet::Packet( std::size_t reserveSize, PacketBufferPool* pool ) :
+	mReadPos( 0 ), mSendPos( 0 ), mIsValid( true ), mPool( pool ) {
+	if ( NULL != mPool ) {
+		mData = mPool->acquire( reserveSize );
+	} else {
+		mData.reserve( reserveSize );
+	}
+}
+
+Packet::~Packet() {
+	if ( NULL != mPool )
+		mPool->release( mData );
+}
+
+void Packet::reserve( std::size_t sizeInBytes ) {
+	mData.reserve( sizeInBytes );
+}
 
 void Packet::append( const void* data, std::size_t sizeInBytes ) {
 	if ( data && ( sizeInBytes > 0 ) ) {
-		std::size_t start = mData.size();
-		mData.resize( start + sizeInBytes );
-		std::memcpy( &mData[start], data, sizeInBytes );
+		// Unlike resize it doesn't zero the new bytes before copying them
+		const char* bytes = static_cast<const char*>( data );
+		mData.insert( mData.end(), bytes, bytes + sizeInBytes );
 	}
 }
 
@@ -156,6 +173,23 @@ Packet& Packet::operator>>( std::string& data ) {
 	return *this;
 }
 
+Packet& Packet::operator>>( std::string_view& data ) {
+	// First extract string length
+	Uint32 length = 0;
+	*this >> length;
+
+	data = std::string_view();
+	if ( ( length > 0 ) && checkSize( length ) ) {
+		// Then point to the characters
+		data = std::string_view( &mData[mReadPos], length );
+
+		// Update reading position
+		mReadPos += length;
+	}
+
+	return *this;
+}
+
 #ifndef EE_NO_WIDECHAR
 Packet& Packet::operator>>( wchar_t* data ) {
 	// First extract string length
@@ -285,6 +319,18 @@ Packet& Packet::operator<<( const std::string& data ) {
 	return *this;
 }
 
+Packet& Packet::operator<<( const std::string_view& data ) {
+	// First insert string length
+	Uint32 length = static_cast<Uint32>( data.size() );
+	*this << length;
+
+	// Then insert characters
+	if ( length > 0 )
+		append( data.data(), length * sizeof( std::string_view::value_type ) );
+
+	return *this;
+}
+
 #ifndef EE_NO_WIDECHAR
 Packet& Packet::operator<<( const wchar_t* data ) {
 	// First insert string length
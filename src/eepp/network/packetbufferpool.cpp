@@ -0,0 +1,60 @@
+#include <eepp/network/packetbufferpool.hpp>
+#include <eepp/system/lock.hpp>
+
+namespace EE { namespace Network {
+
+PacketBufferPool& PacketBufferPool::getGlobal() {
+	static PacketBufferPool sGlobalPool;
+	return sGlobalPool;
+}
+
+PacketBufferPool::PacketBufferPool( std::size_t maxBuffers, std::size_t maxBufferCapacity ) :
+	mMaxBuffers( maxBuffers ), mMaxBufferCapacity( maxBufferCapacity ) {}
+
+std::vector<char> PacketBufferPool::acquire( std::size_t capacity ) {
+	std::vector<char> buffer;
+
+	{
+		Lock l( mMutex );
+
+		// The last released buffer is the most likely to still be in cache
+		if ( !mBuffers.empty() ) {
+			buffer = std::move( mBuffers.back() );
+			mBuffers.pop_back();
+		}
+	}
+
+	buffer.reserve( capacity );
+	return buffer;
+}
+
+void PacketBufferPool::release( std::vector<char>& buffer ) {
+	if ( buffer.capacity() == 0 )
+		return;
+
+	if ( buffer.capacity() > mMaxBufferCapacity ) {
+		std::vector<char>().swap( buffer );
+		return;
+	}
+
+	buffer.clear();
+
+	Lock l( mMutex );
+
+	if ( mBuffers.size() < mMaxBuffers ) {
+		mBuffers.emplace_back( std::move( buffer ) );
+		buffer = std::vector<char>();
+	}
+}
+
+std::size_t PacketBufferPool::getCount() const {
+	Lock l( mMutex );
+	return mBuffers.size();
+}
+
+void PacketBufferPool::clear() {
+	Lock l( mMutex );
+	mBuffers.clear();
+}
+
+}} // namespace EE::Network
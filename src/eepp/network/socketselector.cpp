@@ -3,32 +3,209 @@
 #include <eepp/network/socket.hpp>
 #include <eepp/network/socketselector.hpp>
 #include <eepp/system/log.hpp>
+#include <unordered_map>
 #include <utility>
 
-#if EE_PLATFORM == EE_PLATFORM_HAIKU
-#include <sys/select.h>
+#if EE_PLATFORM == EE_PLATFORM_LINUX || EE_PLATFORM == EE_PLATFORM_ANDROID
+#define EE_SOCKET_SELECTOR_EPOLL
+#include <cerrno>
+#include <sys/epoll.h>
+#elif EE_PLATFORM == EE_PLATFORM_WIN
+#define eePoll WSAPoll
+#else
+#include <poll.h>
+#define eePoll poll
 #endif
 
-#ifdef _MSC_VER
-#pragma warning( \
-	disable : 4127 ) // "conditional expression is constant" generated by the FD_SET macro
-#endif
+#define SOCKET_SELECTOR_MIN_EVENTS ( 16 )
+#define SOCKET_SELECTOR_MAX_EVENTS ( 1024 )
 
 namespace EE { namespace Network {
 
 struct SocketSelector::SocketSelectorImpl {
-	fd_set AllSockets;	 ///< Set containing all the sockets handles
-	fd_set SocketsReady; ///< Set containing handles of the sockets that are ready
-	int MaxSocket;		 ///< Maximum socket handle
-	int SocketCount;	 ///< Number of socket handles
+	struct Entry {
+		Socket* socket;
+		void* userData;
+		Uint32 events;
+		Trigger trigger;
+		Uint32 readyEvents;
+		Uint64 readyWait; ///< The wait where readyEvents were reported
+		size_t index;	  ///< Index in the poll set ( poll backend only )
+	};
+
+	std::unordered_map<SocketHandle, Entry> Sockets; ///< The sockets by handle
+	std::vector<SocketSelector::Ready> ReadyList;	 ///< The sockets ready in the last wait
+	Uint64 WaitCount{ 0 };
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+	int EpollFd{ -1 };
+	std::vector<epoll_event> Events;
+#else
+	std::vector<pollfd> PollSet;
+	std::vector<Entry*> PollEntries; ///< The entry of each pollfd
+#endif
+
+	SocketSelectorImpl() {
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+		EpollFd = epoll_create1( EPOLL_CLOEXEC );
+
+		if ( EpollFd == -1 )
+			Log::error( "SocketSelector: epoll_create1 failed with error %d", errno );
+#endif
+	}
+
+	~SocketSelectorImpl() {
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+		if ( EpollFd != -1 )
+			::close( EpollFd );
+#endif
+	}
+
+	bool watch( SocketHandle handle, Entry& entry, bool isNew ) {
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+		epoll_event event{};
+		event.data.ptr = &entry;
+		if ( entry.events & SocketSelector::Read )
+			event.events |= EPOLLIN | EPOLLRDHUP;
+		if ( entry.events & SocketSelector::Write )
+			event.events |= EPOLLOUT;
+		if ( entry.trigger == Trigger::Edge )
+			event.events |= EPOLLET;
+
+		if ( epoll_ctl( EpollFd, isNew ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, handle, &event ) == 0 )
+			return true;
+
+		// The socket was closed and the handle reused without removing it from the selector
+		if ( !isNew && errno == ENOENT )
+			return epoll_ctl( EpollFd, EPOLL_CTL_ADD, handle, &event ) == 0;
+
+		return false;
+#else
+		if ( isNew ) {
+			entry.index = PollSet.size();
+			PollSet.push_back( pollfd() );
+			PollEntries.push_back( &entry );
+		}
+
+		pollfd& fd = PollSet[entry.index];
+		fd.fd = handle;
+		fd.events = ( ( entry.events & SocketSelector::Read ) ? POLLIN : 0 ) |
+					( ( entry.events & SocketSelector::Write ) ? POLLOUT : 0 );
+		fd.revents = 0;
+		return true;
+#endif
+	}
+
+	void unwatch( SocketHandle handle, Entry& entry ) {
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+		( void )entry;
+		epoll_event event{};
+		epoll_ctl( EpollFd, EPOLL_CTL_DEL, handle, &event );
+#else
+		( void )handle;
+		// Swap with the last pollfd to keep the set packed
+		size_t last = PollSet.size() - 1;
+
+		if ( entry.index != last ) {
+			PollSet[entry.index] = PollSet[last];
+			PollEntries[entry.index] = PollEntries[last];
+			PollEntries[entry.index]->index = entry.index;
+		}
+
+		PollSet.pop_back();
+		PollEntries.pop_back();
+#endif
+	}
+
+	void addReady( Entry& entry, Uint32 events ) {
+		if ( 0 == events )
+			return;
+
+		entry.readyEvents = events;
+		entry.readyWait = WaitCount;
+		ReadyList.push_back( { entry.socket, entry.userData, events } );
+	}
+
+	int wait( const Time& timeout ) {
+		WaitCount++;
+		ReadyList.clear();
+
+		// Round up, so short timeouts don't turn into busy waits
+		int timeoutMs =
+			timeout != Time::Zero ? static_cast<int>( ( timeout.asMicroseconds() + 999 ) / 1000 )
+								  : -1;
+
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+		if ( EpollFd == -1 )
+			return -1;
+
+		Events.resize( std::clamp<size_t>( Sockets.size(), SOCKET_SELECTOR_MIN_EVENTS,
+										   SOCKET_SELECTOR_MAX_EVENTS ) );
+
+		int count = epoll_wait( EpollFd, Events.data(), static_cast<int>( Events.size() ),
+								timeoutMs );
+
+		for ( int i = 0; i < count; i++ ) {
+			Uint32 flags = Events[i].events;
+			Uint32 events = 0;
+			if ( flags & EPOLLIN )
+				events |= SocketSelector::Read;
+			if ( flags & EPOLLOUT )
+				events |= SocketSelector::Write;
+			if ( flags & ( EPOLLERR | EPOLLHUP | EPOLLRDHUP ) )
+				events |= SocketSelector::Error;
+			addReady( *static_cast<Entry*>( Events[i].data.ptr ), events );
+		}
+#else
+		int count = eePoll( PollSet.data(), static_cast<unsigned long>( PollSet.size() ),
+							timeoutMs );
+
+		for ( size_t i = 0; count > 0 && i < PollSet.size(); i++ ) {
+			short flags = PollSet[i].revents;
+
+			if ( 0 == flags )
+				continue;
+
+			Uint32 events = 0;
+			if ( flags & POLLIN )
+				events |= SocketSelector::Read;
+			if ( flags & POLLOUT )
+				events |= SocketSelector::Write;
+			if ( flags & ( POLLERR | POLLHUP | POLLNVAL ) )
+				events |= SocketSelector::Error;
+			addReady( *PollEntries[i], events );
+		}
+#endif
+
+		return static_cast<int>( ReadyList.size() );
+	}
 };
 
-SocketSelector::SocketSelector() : mImpl( eeNew( SocketSelectorImpl, () ) ) {
-	clear();
+const char* SocketSelector::getBackendName() {
+#ifdef EE_SOCKET_SELECTOR_EPOLL
+	return "epoll";
+#else
+	return "poll";
+#endif
 }
 
+SocketSelector::SocketSelector() : mImpl( eeNew( SocketSelectorImpl, () ) ) {}
+
 SocketSelector::SocketSelector( const SocketSelector& copy ) :
-	mImpl( eeNew( SocketSelectorImpl, ( *copy.mImpl ) ) ) {}
+	mImpl( eeNew( SocketSelectorImpl, () ) ) {
+	// The backend handles can't be shared, the sockets are registered again
+	for ( const auto& it : copy.mImpl->Sockets ) {
+		const SocketSelectorImpl::Entry& source = it.second;
+
+		if ( add( *source.socket, source.events, source.userData, source.trigger ) ) {
+			SocketSelectorImpl::Entry& entry = mImpl->Sockets[it.first];
+			entry.readyEvents = source.readyEvents;
+			entry.readyWait = source.readyWait;
+		}
+	}
+
+	mImpl->ReadyList = copy.mImpl->ReadyList;
+	mImpl->WaitCount = copy.mImpl->WaitCount;
+}
 
 SocketSelector::~SocketSelector() {
 	eeSAFE_DELETE( mImpl );
@@ -37,90 +214,123 @@ SocketSelector::~SocketSelector() {
 void SocketSelector::add( Socket& socket ) {
 	SocketHandle handle = socket.getHandle();
 
-	if ( handle != Private::SocketImpl::invalidSocket() ) {
-#if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( mImpl->SocketCount >= FD_SETSIZE ) {
-			Log::error( "The socket can't be added to the selector because its ID is too high. "
-						"This is a limitation of your operating system's FD_SETSIZE setting." );
-			return;
-		}
+	if ( handle == Private::SocketImpl::invalidSocket() )
+		return;
 
-		if ( FD_ISSET( handle, &mImpl->AllSockets ) )
-			return;
+	auto it = mImpl->Sockets.find( handle );
 
-		mImpl->SocketCount++;
-#else
-		if ( handle >= FD_SETSIZE ) {
-			Log::error( "The socket can't be added to the selector because its ID is too high. "
-						"This is a limitation of your operating system's FD_SETSIZE setting." );
-			return;
-		}
+	// Already added: keep its registration as it is
+	if ( it != mImpl->Sockets.end() && it->second.socket == &socket )
+		return;
 
-		// SocketHandle is an int in POSIX
-		mImpl->MaxSocket = std::max( mImpl->MaxSocket, handle );
-#endif
+	add( socket, Read );
+}
+
+bool SocketSelector::add( Socket& socket, Uint32 events, void* userData, Trigger trigger ) {
+	SocketHandle handle = socket.getHandle();
+
+	if ( handle == Private::SocketImpl::invalidSocket() )
+		return false;
+
+	auto it = mImpl->Sockets.find( handle );
+	bool isNew = it == mImpl->Sockets.end();
+
+	if ( isNew )
+		it = mImpl->Sockets.emplace( handle, SocketSelectorImpl::Entry() ).first;
+
+	SocketSelectorImpl::Entry& entry = it->second;
+	entry.socket = &socket;
+	entry.userData = userData;
+	entry.events = events;
+	entry.trigger = trigger;
+
+	if ( isNew ) {
+		entry.readyEvents = 0;
+		entry.readyWait = 0;
+		entry.index = 0;
+	}
+
+	if ( !mImpl->watch( handle, entry, isNew ) ) {
+		Log::error( "SocketSelector: the socket can't be added to the selector" );
+
+		if ( !isNew )
+			mImpl->unwatch( handle, entry );
 
-		FD_SET( handle, &mImpl->AllSockets );
+		mImpl->Sockets.erase( it );
+		return false;
 	}
+
+	return true;
+}
+
+bool SocketSelector::modify( Socket& socket, Uint32 events, Trigger trigger ) {
+	auto it = mImpl->Sockets.find( socket.getHandle() );
+
+	if ( it == mImpl->Sockets.end() )
+		return false;
+
+	return add( socket, events, it->second.userData, trigger );
 }
 
 void SocketSelector::remove( Socket& socket ) {
 	SocketHandle handle = socket.getHandle();
 
-	if ( handle != Private::SocketImpl::invalidSocket() ) {
-#if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( !FD_ISSET( handle, &mImpl->AllSockets ) )
-			return;
+	if ( handle == Private::SocketImpl::invalidSocket() )
+		return;
 
-		mImpl->SocketCount--;
-#else
-		if ( handle >= FD_SETSIZE )
-			return;
-#endif
+	auto it = mImpl->Sockets.find( handle );
 
-		FD_CLR( handle, &mImpl->AllSockets );
-		FD_CLR( handle, &mImpl->SocketsReady );
-	}
+	if ( it == mImpl->Sockets.end() )
+		return;
+
+	mImpl->unwatch( handle, it->second );
+	mImpl->Sockets.erase( it );
+
+	auto& readyList = mImpl->ReadyList;
+	readyList.erase( std::remove_if( readyList.begin(), readyList.end(),
+									 [&socket]( const Ready& ready ) {
+										 return ready.socket == &socket;
+									 } ),
+					 readyList.end() );
 }
 
 void SocketSelector::clear() {
-	FD_ZERO( &mImpl->AllSockets );
-	FD_ZERO( &mImpl->SocketsReady );
+	for ( auto& it : mImpl->Sockets )
+		mImpl->unwatch( it.first, it.second );
 
-	mImpl->MaxSocket = 0;
-	mImpl->SocketCount = 0;
+	mImpl->Sockets.clear();
+	mImpl->ReadyList.clear();
 }
 
 bool SocketSelector::wait( Time timeout ) {
-	// Setup the timeout
-	timeval time;
-	time.tv_sec = static_cast<long>( timeout.asMicroseconds() / 1000000 );
-	time.tv_usec = static_cast<long>( timeout.asMicroseconds() % 1000000 );
-
-	// Initialize the set that will contain the sockets that are ready
-	mImpl->SocketsReady = mImpl->AllSockets;
+	return mImpl->wait( timeout ) > 0;
+}
 
-	// Wait until one of the sockets is ready for reading, or timeout is reached
-	// The first parameter is ignored on Windows
-	int count = select( mImpl->MaxSocket + 1, &mImpl->SocketsReady, NULL, NULL,
-						timeout != Time::Zero ? &time : NULL );
+const std::vector<SocketSelector::Ready>& SocketSelector::getReadyList() const {
+	return mImpl->ReadyList;
+}
 
-	return count > 0;
+size_t SocketSelector::getSocketCount() const {
+	return mImpl->Sockets.size();
 }
 
 bool SocketSelector::isReady( Socket& socket ) const {
+	// A closed connection is ready to read, the receive reports it
+	return ( getReadyEvents( socket ) & ( Read | Error ) ) != 0;
+}
+
+Uint32 SocketSelector::getReadyEvents( Socket& socket ) const {
 	SocketHandle handle = socket.getHandle();
 
-	if ( handle != Private::SocketImpl::invalidSocket() ) {
-#if EE_PLATFORM == EE_PLATFORM_WIN
-		if ( handle >= FD_SETSIZE )
-			return false;
-#endif
+	if ( handle == Private::SocketImpl::invalidSocket() )
+		return 0;
 
-		return FD_ISSET( handle, &mImpl->SocketsReady ) != 0;
-	}
+	auto it = mImpl->Sockets.find( handle );
+
+	if ( it == mImpl->Sockets.end() || it->second.readyWait != mImpl->WaitCount )
+		return 0;
 
-	return false;
+	return it->second.readyEvents;
 }
 
 SocketSelector& SocketSelector::operator=( const SocketSelector& right ) {
@@ -183,6 +183,35 @@ Socket::Status SSLSocket::receive( Packet& packet ) {
 	return TcpSocket::receive( packet );
 }
 
+Socket::Status SSLSocket::sendBuffers( const Buffer* buffers, std::size_t count,
+									   std::size_t& sent ) {
+	sent = 0;
+
+	if ( count == 1 && buffers[0].size > 0 ) {
+		Status status = send( buffers[0].data, buffers[0].size );
+
+		if ( status == Done )
+			sent = buffers[0].size;
+
+		return status;
+	}
+
+	std::string data;
+
+	for ( std::size_t i = 0; i < count; i++ )
+		data.append( static_cast<const char*>( buffers[i].data ), buffers[i].size );
+
+	if ( data.empty() )
+		return Done;
+
+	Status status = send( data.data(), data.size() );
+
+	if ( status == Done )
+		sent = data.size();
+
+	return status;
+}
+
 Socket::Status SSLSocket::sslConnect( const IpAddress& remoteAddress, unsigned short remotePort,
 									  Time timeout ) {
 	return mImpl->connect( remoteAddress, remotePort, timeout );
@@ -12,6 +12,10 @@
 #include <sys/select.h>
 #endif
 
+#if EE_PLATFORM != EE_PLATFORM_WIN
+#include <sys/uio.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning( \
 	disable : 4127 ) // "conditional expression is constant" generated by the FD_SET macro
@@ -26,6 +30,10 @@ const int flags = 0;
 #endif
 } // namespace
 
+#define TCP_SOCKET_MAX_SEND_BUFFERS ( 64 )
+#define TCP_SOCKET_BATCH_PACKETS ( TCP_SOCKET_MAX_SEND_BUFFERS / 2 )
+#define TCP_SOCKET_PACKET_RECEIVE_CHUNK ( 4096 )
+
 namespace EE { namespace Network {
 
 TcpSocket* TcpSocket::New() {
@@ -212,6 +220,87 @@ Socket::Status TcpSocket::send( const void* data, std::size_t size, std::size_t&
 	return Done;
 }
 
+Socket::Status TcpSocket::sendBuffers( const Buffer* buffers, std::size_t count,
+									  std::size_t& sent ) {
+	sent = 0;
+
+	std::size_t index = 0;
+	std::size_t offset = 0; // Bytes of the current buffer already sent
+
+	for ( ;; ) {
+		while ( index < count && offset == buffers[index].size ) {
+			index++;
+			offset = 0;
+		}
+
+		if ( index == count )
+			return Done;
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		WSABUF vecs[TCP_SOCKET_MAX_SEND_BUFFERS];
+#else
+		iovec vecs[TCP_SOCKET_MAX_SEND_BUFFERS];
+#endif
+		std::size_t vecCount = 0;
+
+		for ( std::size_t i = index; i < count && vecCount < TCP_SOCKET_MAX_SEND_BUFFERS; i++ ) {
+			std::size_t skip = i == index ? offset : 0;
+
+			if ( buffers[i].size == skip )
+				continue;
+
+			char* data = const_cast<char*>( static_cast<const char*>( buffers[i].data ) ) + skip;
+#if EE_PLATFORM == EE_PLATFORM_WIN
+			vecs[vecCount].buf = data;
+			vecs[vecCount].len = static_cast<ULONG>( buffers[i].size - skip );
+#else
+			vecs[vecCount].iov_base = data;
+			vecs[vecCount].iov_len = buffers[i].size - skip;
+#endif
+			vecCount++;
+		}
+
+		// Send as many buffers as possible in a single call
+#if EE_PLATFORM == EE_PLATFORM_WIN
+		DWORD result = 0;
+		bool failed = WSASend( getHandle(), vecs, static_cast<DWORD>( vecCount ), &result, 0, NULL,
+							   NULL ) == SOCKET_ERROR;
+#else
+		msghdr message{};
+		message.msg_iov = vecs;
+		message.msg_iovlen = vecCount;
+		ssize_t result = sendmsg( getHandle(), &message, flags );
+		bool failed = result < 0;
+#endif
+
+		if ( failed ) {
+			Status status = Private::SocketImpl::getErrorStatus();
+
+			if ( ( status == NotReady ) && sent )
+				return Partial;
+
+			return status;
+		}
+
+		std::size_t written = static_cast<std::size_t>( result );
+		sent += written;
+
+		// Advance to the first byte not sent
+		while ( written > 0 ) {
+			std::size_t left = buffers[index].size - offset;
+
+			if ( written < left ) {
+				offset += written;
+				written = 0;
+			} else {
+				written -= left;
+				index++;
+				offset = 0;
+			}
+		}
+	}
+}
+
 Socket::Status TcpSocket::receive( void* data, std::size_t size, std::size_t& received ) {
 	// First clear the variables to fill
 	received = 0;
@@ -238,43 +327,77 @@ Socket::Status TcpSocket::receive( void* data, std::size_t size, std::size_t& re
 }
 
 Socket::Status TcpSocket::send( Packet& packet ) {
+	Packet* packets[] = { &packet };
+	return sendBatch( packets, 1 );
+}
+
+Socket::Status TcpSocket::sendBatch( Packet* const* packets, std::size_t count ) {
 	// TCP is a stream protocol, it doesn't preserve messages boundaries.
 	// This means that we have to send the packet size first, so that the
 	// receiver knows the actual end of the packet in the data stream.
 
-	// We allocate an extra memory block so that the size can be sent
-	// together with the data in a single call. This may seem inefficient,
-	// but it is actually required to avoid partial send, which could cause
-	// data corruption on the receiving end.
+	// The size and the data of every packet are sent together with a vectored
+	// write, so they don't need to be copied into a single block to avoid partial
+	// sends, which could cause data corruption on the receiving end.
+	bool anySent = false;
 
-	// Get the data to send from the packet
-	std::size_t size = 0;
-	const void* data = packet.onSend( size );
+	for ( std::size_t first = 0; first < count; first += TCP_SOCKET_BATCH_PACKETS ) {
+		std::size_t last = eemin<std::size_t>( count, first + TCP_SOCKET_BATCH_PACKETS );
+		Uint32 sizes[TCP_SOCKET_BATCH_PACKETS];
+		std::size_t totals[TCP_SOCKET_BATCH_PACKETS];
+		Buffer buffers[TCP_SOCKET_BATCH_PACKETS * 2];
+		std::size_t bufferCount = 0;
 
-	// First convert the packet size to network byte order
-	Uint32 packetSize = htonl( static_cast<Uint32>( size ) );
+		for ( std::size_t i = first; i < last; i++ ) {
+			Packet& packet = *packets[i];
+			std::size_t k = i - first;
 
-	// Allocate memory for the data block to send
-	std::vector<char> blockToSend( sizeof( packetSize ) + size );
+			// Get the data to send from the packet
+			std::size_t size = 0;
+			const char* data = static_cast<const char*>( packet.onSend( size ) );
 
-	// Copy the packet size and data into the block to send
-	std::memcpy( &blockToSend[0], &packetSize, sizeof( packetSize ) );
-	if ( size > 0 )
-		std::memcpy( &blockToSend[0] + sizeof( packetSize ), data, size );
+			// Convert the packet size to network byte order
+			sizes[k] = htonl( static_cast<Uint32>( size ) );
+			totals[k] = sizeof( Uint32 ) + size;
 
-	// Send the data block
-	std::size_t sent;
-	Status status =
-		send( &blockToSend[0] + packet.mSendPos, blockToSend.size() - packet.mSendPos, sent );
-
-	// In the case of a partial send, record the location to resume from
-	if ( status == Partial ) {
-		packet.mSendPos += sent;
-	} else if ( status == Done ) {
-		packet.mSendPos = 0;
+			// Resume from the location recorded in a partial send
+			std::size_t pos = packet.mSendPos;
+
+			if ( pos >= totals[k] )
+				continue;
+
+			if ( pos < sizeof( Uint32 ) ) {
+				buffers[bufferCount++] = { reinterpret_cast<const char*>( &sizes[k] ) + pos,
+										   sizeof( Uint32 ) - pos };
+				pos = sizeof( Uint32 );
+			}
+
+			if ( pos < totals[k] )
+				buffers[bufferCount++] = { data + pos - sizeof( Uint32 ), totals[k] - pos };
+		}
+
+		std::size_t sent = 0;
+		Status status = sendBuffers( buffers, bufferCount, sent );
+
+		// Record the location to resume from for each packet
+		for ( std::size_t i = first; i < last && sent > 0; i++ ) {
+			Packet& packet = *packets[i];
+			std::size_t total = totals[i - first];
+			std::size_t advance =
+				eemin<std::size_t>( sent, total - eemin<std::size_t>( packet.mSendPos, total ) );
+			packet.mSendPos += advance;
+			sent -= advance;
+			anySent = anySent || advance > 0;
+		}
+
+		if ( status != Done )
+			return ( status == NotReady && anySent ) ? Partial : status;
 	}
 
-	return status;
+	for ( std::size_t i = 0; i < count; i++ )
+		packets[i]->mSendPos = 0;
+
+	return Done;
 }
 
 Socket::Status TcpSocket::receive( Packet& packet ) {
@@ -305,30 +428,39 @@ Socket::Status TcpSocket::receive( Packet& packet ) {
 		packetSize = ntohl( mPendingPacket.Size );
 	}
 
-	// Loop until we receive all the packet data
-	char buffer[1024];
-	while ( mPendingPacket.Data.size() < packetSize ) {
-		// Receive a chunk of data
-		std::size_t sizeToGet = eemin(
-			static_cast<std::size_t>( packetSize - mPendingPacket.Data.size() ), sizeof( buffer ) );
-		Status status = receive( buffer, sizeToGet, received );
+	// Loop until we receive all the packet data. It's received straight into the pending
+	// packet, growing it as the data arrives, so a bogus size doesn't allocate it all at once.
+	PendingPacket& pending = mPendingPacket;
+
+	while ( pending.DataReceived < packetSize ) {
+		if ( pending.Data.size() == pending.DataReceived ) {
+			pending.Data.resize( eemin<std::size_t>(
+				packetSize, eemax<std::size_t>( pending.DataReceived * 2,
+												TCP_SOCKET_PACKET_RECEIVE_CHUNK ) ) );
+		}
+
+		Status status = receive( &pending.Data[pending.DataReceived],
+								 pending.Data.size() - pending.DataReceived, received );
 		if ( status != Done )
 			return status;
 
-		// Append it into the packet
-		if ( received > 0 ) {
-			mPendingPacket.Data.resize( mPendingPacket.Data.size() + received );
-			char* begin = &mPendingPacket.Data[0] + mPendingPacket.Data.size() - received;
-			std::memcpy( begin, buffer, received );
-		}
+		pending.DataReceived += received;
 	}
 
 	// We have received all the packet data: we can copy it to the user packet
-	if ( !mPendingPacket.Data.empty() )
-		packet.onReceive( &mPendingPacket.Data[0], mPendingPacket.Data.size() );
-
-	// Clear the pending packet data
-	mPendingPacket = PendingPacket();
+	if ( packetSize > 0 )
+		packet.onReceive( &pending.Data[0], packetSize );
+
+	// Clear the pending packet data. Small buffers are kept for the next packet, the buffer of
+	// a big packet is released so the socket doesn't hold it until it's closed.
+	pending.Size = 0;
+	pending.SizeReceived = 0;
+	pending.DataReceived = 0;
+	if ( pending.Data.capacity() > TCP_SOCKET_PACKET_RECEIVE_CHUNK ) {
+		std::vector<char>().swap( pending.Data );
+	} else {
+		pending.Data.clear();
+	}
 
 	return Done;
 }
@@ -366,6 +498,7 @@ void TcpSocket::startAsyncRead( ReadFn readFn ) {
 	} );
 }
 
-TcpSocket::PendingPacket::PendingPacket() : Size( 0 ), SizeReceived( 0 ), Data() {}
+TcpSocket::PendingPacket::PendingPacket() :
+	Size( 0 ), SizeReceived( 0 ), DataReceived( 0 ), Data() {}
 
 }} // namespace EE::Network
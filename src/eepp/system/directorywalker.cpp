@@ -0,0 +1,208 @@
+#include <condition_variable>
+#include <eepp/core/string.hpp>
+#include <eepp/system/directorywalker.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <mutex>
+#include <sys/stat.h>
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#if defined( DT_DIR ) && EE_PLATFORM != EE_PLATFORM_HAIKU
+#define EE_DIRECTORY_WALKER_D_TYPE
+#endif
+#if EE_PLATFORM == EE_PLATFORM_LINUX || EE_PLATFORM == EE_PLATFORM_ANDROID || \
+	EE_PLATFORM == EE_PLATFORM_MACOSX || EE_PLATFORM == EE_PLATFORM_BSD
+#define EE_DIRECTORY_WALKER_FSTATAT
+#endif
+#endif
+
+namespace EE { namespace System {
+
+#if EE_PLATFORM != EE_PLATFORM_WIN
+static void getEntryType( DIR* dp, const std::string& path, DirectoryWalker::Entry& entry ) {
+	struct stat st;
+#ifdef EE_DIRECTORY_WALKER_FSTATAT
+	// The entry is looked up relative to the open directory, the path is not resolved again
+	( void )path;
+	int fd = dirfd( dp );
+	if ( 0 != fstatat( fd, entry.name.c_str(), &st, AT_SYMLINK_NOFOLLOW ) )
+		return;
+	entry.isLink = S_ISLNK( st.st_mode );
+	if ( entry.isLink && 0 != fstatat( fd, entry.name.c_str(), &st, 0 ) )
+		return;
+#else
+	( void )dp;
+	std::string filePath( path + entry.name );
+	if ( 0 != lstat( filePath.c_str(), &st ) )
+		return;
+	entry.isLink = S_ISLNK( st.st_mode );
+	if ( entry.isLink && 0 != stat( filePath.c_str(), &st ) )
+		return;
+#endif
+	entry.isDirectory = S_ISDIR( st.st_mode );
+}
+#endif
+
+bool DirectoryWalker::list( const std::string& path, std::vector<Entry>& entries ) {
+	entries.clear();
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	String widePath( path );
+
+	if ( widePath[widePath.size() - 1] == '/' || widePath[widePath.size() - 1] == '\\' ) {
+		widePath += "*";
+	} else {
+		widePath += "\\*";
+	}
+
+	WIN32_FIND_DATAW findFileData;
+	HANDLE hFind = FindFirstFileW( widePath.toWideString().c_str(), &findFileData );
+
+	if ( hFind == INVALID_HANDLE_VALUE )
+		return false;
+
+	do {
+		std::string name( String( findFileData.cFileName ).toUtf8() );
+
+		if ( name == "." || name == ".." )
+			continue;
+
+		Entry entry;
+		entry.name = std::move( name );
+		entry.isDirectory = 0 != ( findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY );
+		entry.isLink = 0 != ( findFileData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT );
+		entries.emplace_back( std::move( entry ) );
+	} while ( FindNextFileW( hFind, &findFileData ) );
+
+	FindClose( hFind );
+#else
+	DIR* dp;
+	struct dirent* dirp;
+
+	if ( ( dp = opendir( path.c_str() ) ) == NULL )
+		return false;
+
+	std::string dirPath( path );
+	FileSystem::dirAddSlashAtEnd( dirPath );
+
+	while ( ( dirp = readdir( dp ) ) != NULL ) {
+		const char* name = dirp->d_name;
+
+		if ( name[0] == '.' && ( name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' ) ) )
+			continue;
+
+		Entry entry;
+		entry.name = name;
+
+#ifdef EE_DIRECTORY_WALKER_D_TYPE
+		switch ( dirp->d_type ) {
+			case DT_DIR:
+				entry.isDirectory = true;
+				break;
+			case DT_LNK:
+			case DT_UNKNOWN:
+				getEntryType( dp, dirPath, entry );
+				break;
+			default:
+				break;
+		}
+#else
+		getEntryType( dp, dirPath, entry );
+#endif
+
+		entries.emplace_back( std::move( entry ) );
+	}
+
+	closedir( dp );
+#endif
+
+	return true;
+}
+
+void DirectoryWalker::walk( ThreadPool* pool, const std::string& path, const DirectoryCb& cb,
+							std::shared_ptr<void> data, const CancellationToken& token,
+							const ThreadPool::Priority& priority ) {
+	struct Pending {
+		std::string path;
+		size_t depth;
+		std::shared_ptr<void> data;
+	};
+
+	std::mutex mutex;
+	std::condition_variable available;
+	std::vector<Pending> pending;
+	size_t active = 0;
+
+	std::string rootPath( path );
+	FileSystem::dirAddSlashAtEnd( rootPath );
+	pending.push_back( { rootPath, 0, std::move( data ) } );
+
+	// Every thread takes the last directory queued, so the tree is walked mostly depth first and
+	// the queue stays small. A thread without directories waits until another one queues more or
+	// all of them are done.
+	auto walkDirectories = [&] {
+		Directory directory;
+		std::unique_lock<std::mutex> lock( mutex );
+		while ( true ) {
+			if ( token.isCancelled() )
+				pending.clear();
+
+			if ( pending.empty() ) {
+				if ( active == 0 ) {
+					available.notify_all();
+					return;
+				}
+				available.wait( lock );
+				continue;
+			}
+
+			Pending next( std::move( pending.back() ) );
+			pending.pop_back();
+			active++;
+			lock.unlock();
+
+			directory.path = std::move( next.path );
+			directory.depth = next.depth;
+			directory.data = std::move( next.data );
+			list( directory.path, directory.entries );
+			cb( directory );
+
+			lock.lock();
+			for ( const auto& entry : directory.entries ) {
+				if ( entry.isDirectory && !entry.isLink ) {
+					pending.push_back( { directory.path + entry.name + FileSystem::getOSSlash(),
+										 directory.depth + 1, directory.data } );
+				}
+			}
+			active--;
+
+			if ( !pending.empty() || active == 0 )
+				available.notify_all();
+		}
+	};
+
+	Uint32 helpers = pool ? pool->numThreads() : 0;
+
+	if ( helpers == 0 ) {
+		walkDirectories();
+		return;
+	}
+
+	TaskGroup group( pool, priority );
+	for ( Uint32 i = 0; i < helpers; ++i )
+		group.run( walkDirectories );
+	walkDirectories();
+	group.cancel();
+	group.wait();
+}
+
+}} // namespace EE::System
@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <climits>
+#include <eepp/system/directorywalker.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/iostreamfile.hpp>
 #include <eepp/system/sys.hpp>
@@ -471,85 +472,32 @@ std::vector<std::string> FileSystem::filesGetInPath( const std::string& path,
 													 const bool& foldersFirst,
 													 const bool& ignoreHidden ) {
 	std::vector<std::string> files;
+	std::vector<DirectoryWalker::Entry> entries;
 
-#if EE_PLATFORM == EE_PLATFORM_WIN
-	String widePath( path );
-
-	if ( widePath[widePath.size() - 1] == '/' || widePath[widePath.size() - 1] == '\\' ) {
-		widePath += "*";
-	} else {
-		widePath += "\\*";
-	}
-
-	WIN32_FIND_DATAW findFileData;
-	HANDLE hFind = FindFirstFileW( widePath.toWideString().c_str(), &findFileData );
-
-	if ( hFind != INVALID_HANDLE_VALUE ) {
-		String tmpstr( findFileData.cFileName );
-
-		if ( tmpstr != "." && tmpstr != ".." )
-			files.push_back( tmpstr.toUtf8() );
-
-		while ( FindNextFileW( hFind, &findFileData ) ) {
-			tmpstr = String( findFileData.cFileName );
-
-			if ( tmpstr != "." && tmpstr != ".." )
-				files.push_back( String( findFileData.cFileName ).toUtf8() );
-		}
-
-		FindClose( hFind );
-	}
-#else
-	DIR* dp;
-	struct dirent* dirp;
-
-	if ( ( dp = opendir( path.c_str() ) ) == NULL )
+	if ( !DirectoryWalker::list( path, entries ) )
 		return files;
 
-	while ( ( dirp = readdir( dp ) ) != NULL ) {
-#if EE_PLATFORM != EE_PLATFORM_HAIKU
-		if ( strncmp( dirp->d_name, "..", sizeof( dirp->d_name ) ) != 0 &&
-			 strncmp( dirp->d_name, ".", sizeof( dirp->d_name ) ) != 0 )
-#else
-		if ( strcmp( dirp->d_name, ".." ) != 0 && strcmp( dirp->d_name, "." ) != 0 )
-#endif
-			files.push_back( std::string( dirp->d_name ) );
-	}
-
-	closedir( dp );
-#endif
-
 	if ( sortByName ) {
-		std::sort( files.begin(), files.end() );
+		std::sort( entries.begin(), entries.end(),
+				   []( const DirectoryWalker::Entry& left, const DirectoryWalker::Entry& right ) {
+					   return left.name < right.name;
+				   } );
 	}
 
+	// The listing already knows which entries are directories
 	if ( foldersFirst ) {
-		std::string fpath( path );
-		dirAddSlashAtEnd( fpath );
-		std::vector<std::string> folders;
-		std::vector<std::string> file;
-		for ( size_t i = 0; i < files.size(); i++ ) {
-			if ( FileSystem::isDirectory( fpath + files[i] ) ) {
-				folders.push_back( files[i] );
-			} else {
-				file.push_back( files[i] );
-			}
-		}
-		files.clear();
-		for ( auto& folder : folders )
-			files.push_back( folder );
-		for ( auto& f : file )
-			files.push_back( f );
+		std::stable_partition(
+			entries.begin(), entries.end(),
+			[]( const DirectoryWalker::Entry& entry ) { return entry.isDirectory; } );
 	}
 
-	if ( ignoreHidden ) {
-		std::string fpath( path );
-		dirAddSlashAtEnd( fpath );
-		std::vector<std::string> filtered;
-		for ( size_t i = 0; i < files.size(); i++ )
-			if ( !FileSystem::fileIsHidden( fpath + files[i] ) )
-				filtered.push_back( files[i] );
-		return filtered;
+	std::string fpath( path );
+	dirAddSlashAtEnd( fpath );
+	files.reserve( entries.size() );
+
+	for ( auto& entry : entries ) {
+		if ( !ignoreHidden || !FileSystem::fileIsHidden( fpath + entry.name ) )
+			files.emplace_back( std::move( entry.name ) );
 	}
 
 	return files;
@@ -414,8 +414,69 @@ static int push_captures( MatchState* ms, const char* s, const char* e, LuaMatch
 	return nlevels; /* number of strings pushed */
 }
 
-int lua_str_match( const char* s, int offset, size_t ls, const char* p, LuaMatch* mm ) {
-	size_t lp = strlen( p );
+#define FIRST_SET_HAS( set, c ) ( ( set )[uchar( c ) >> 3] & ( 1 << ( uchar( c ) & 7 ) ) )
+
+int lua_str_first_set( const char* p, size_t lp, unsigned char* set ) {
+	MatchState ms;
+	const char* ep;
+	int c;
+	memset( set, 0, 32 );
+	if ( lp > 0 && *p == '^' ) {
+		p++;
+		lp--;
+	}
+	ms.p_end = p + lp;
+	/* captures don't consume input */
+	while ( p < ms.p_end && *p == '(' ) {
+		p++;
+		if ( p < ms.p_end && *p == ')' )
+			p++;
+	}
+	if ( p >= ms.p_end )
+		return 0;
+	if ( *p == '$' && p + 1 == ms.p_end )
+		return 0;
+	if ( *p == L_ESC && p + 1 < ms.p_end ) {
+		switch ( *( p + 1 ) ) {
+			case 'b':
+				if ( p + 2 >= ms.p_end )
+					return 0;
+				set[uchar( *( p + 2 ) ) >> 3] |= 1 << ( uchar( *( p + 2 ) ) & 7 );
+				return 1;
+			case 'f':
+				return 0;
+			default:
+				if ( isdigit( uchar( *( p + 1 ) ) ) )
+					return 0;
+		}
+	}
+	ep = classend( &ms, p );
+	if ( *ep == '*' || *ep == '?' || *ep == '-' ) /* accepts empty */
+		return 0;
+	if ( *p == '.' )
+		return 0;
+	for ( c = 0; c < 256; c++ ) {
+		int res;
+		switch ( *p ) {
+			case L_ESC:
+				res = match_class( c, uchar( *( p + 1 ) ) );
+				break;
+			case '[':
+				res = matchbracketclass( c, p, ep - 1 );
+				break;
+			default:
+				res = ( uchar( *p ) == c );
+		}
+		if ( res )
+			set[c >> 3] |= 1 << ( c & 7 );
+	}
+	return 1;
+}
+
+int lua_str_match( const char* s, int offset, size_t ls, const char* p, LuaMatch* mm, size_t lp,
+				   const unsigned char* firstSet ) {
+	if ( lp == 0 )
+		lp = strlen( p );
 	const char* s1 = s + offset;
 	MatchState ms;
 	int anchor = ( *p == '^' );
@@ -429,6 +490,16 @@ int lua_str_match( const char* s, int offset, size_t ls, const char* p, LuaMatch
 	ms.p_end = p + lp;
 	do {
 		const char* res;
+		if ( firstSet ) {
+			/* skip the positions that can't start a match */
+			while ( s1 < ms.src_end && !FIRST_SET_HAS( firstSet, *s1 ) ) {
+				if ( anchor )
+					return 0;
+				s1++;
+			}
+			if ( s1 >= ms.src_end )
+				return 0;
+		}
 		ms.level = 0;
 		if ( ( res = match( &ms, s1, p ) ) != NULL ) {
 			mm[0].start = s1 - s; /* start */
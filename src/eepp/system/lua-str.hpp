@@ -12,6 +12,11 @@ struct LuaMatch {
 	int end;
 };
 
-int lua_str_match( const char* text, int offset, size_t len, const char* pattern, LuaMatch* mm );
+int lua_str_match( const char* text, int offset, size_t len, const char* pattern, LuaMatch* mm,
+				   size_t patternLen = 0, const unsigned char* firstSet = NULL );
+
+/* Fills "set" (a 256 bits mask) with the bytes that can start a match of the pattern.
+   Returns 0 if the set can't be determined (any position can start a match). */
+int lua_str_first_set( const char* pattern, size_t patternLen, unsigned char* set );
 
 #endif // EE_SYSTEM_LUA_STR_HPP
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <cstring>
 #include <eepp/core/core.hpp>
 #include <eepp/system/lua-str.hpp>
@@ -52,13 +53,17 @@ bool LuaPattern::matches( const std::string& string, const std::string& pattern
 	return find( string, pattern ).isValid();
 }
 
-LuaPattern::LuaPattern( const std::string& pattern ) : mPattern( pattern ) {
+static void initFailHandler() {
 	if ( !sFailHandlerInitialized ) {
 		sFailHandlerInitialized = true;
 		lua_str_fail_func( failHandler );
 	}
 }
 
+LuaPattern::LuaPattern( const std::string& pattern ) : mPattern( pattern ) {
+	initFailHandler();
+}
+
 bool LuaPattern::matches( const char* stringSearch, int stringStartOffset,
 						  LuaPattern::Range* matchList, size_t stringLength ) const {
 	LuaPattern::Range matchesBuffer[MAX_DEFAULT_MATCHES];
@@ -240,4 +245,78 @@ std::string LuaPattern::gsub( const std::string& text, const std::string& replac
 	return gsub( text.c_str(), replace.c_str() );
 }
 
+static bool isQuantifier( char c ) {
+	return c == '*' || c == '+' || c == '-' || c == '?';
+}
+
+static std::string literalPrefix( const std::string& pattern ) {
+	std::string prefix;
+	size_t i = !pattern.empty() && pattern[0] == '^' ? 1 : 0;
+	while ( i < pattern.size() ) {
+		char c = pattern[i];
+		size_t next = i + 1;
+		if ( c == '%' ) {
+			if ( next >= pattern.size() || std::isalnum( (unsigned char)pattern[next] ) )
+				break;
+			c = pattern[next];
+			next++;
+		} else if ( std::strchr( "^$*+?.()[-", c ) != nullptr ) {
+			break;
+		}
+		if ( next < pattern.size() && isQuantifier( pattern[next] ) )
+			break;
+		prefix += c;
+		i = next;
+	}
+	return prefix;
+}
+
+LuaCompiledPattern::LuaCompiledPattern( const std::string& pattern ) :
+	mPattern( pattern ), mAnchored( !pattern.empty() && pattern[0] == '^' ) {
+	initFailHandler();
+	try {
+		mLiteralPrefix = literalPrefix( mPattern );
+		mHasFirstSet = lua_str_first_set( mPattern.c_str(), mPattern.size(), mFirstSet ) != 0;
+	} catch ( const std::string& ) {
+		mLiteralPrefix.clear();
+		mHasFirstSet = false;
+	}
+}
+
+size_t LuaCompiledPattern::matches( const char* stringSearch, int stringStartOffset,
+									LuaPattern::Range* matchList, size_t stringLength ) const {
+	if ( mPattern.empty() )
+		return 0;
+	if ( mAnchored && mLiteralPrefix.size() > 1 &&
+		 ( stringStartOffset + mLiteralPrefix.size() > stringLength ||
+		   std::memcmp( stringSearch + stringStartOffset, mLiteralPrefix.c_str(),
+						mLiteralPrefix.size() ) != 0 ) )
+		return 0;
+	try {
+		return lua_str_match( stringSearch, stringStartOffset, stringLength, mPattern.c_str(),
+							  (LuaMatch*)matchList, mPattern.size(),
+							  mHasFirstSet ? mFirstSet : nullptr );
+	} catch ( const std::string& ) {
+		return 0;
+	}
+}
+
+size_t LuaCompiledPattern::matches( const std::string& str, LuaPattern::Range* matchList,
+									int stringStartOffset ) const {
+	return matches( str.c_str(), stringStartOffset, matchList, str.size() );
+}
+
+bool LuaCompiledPattern::find( const std::string& str, int& startMatch, int& endMatch,
+							   int offset ) const {
+	LuaPattern::Range matchesBuffer[MAX_DEFAULT_MATCHES];
+	if ( matches( str.c_str(), offset, matchesBuffer, str.size() ) > 0 ) {
+		startMatch = matchesBuffer[0].start;
+		endMatch = matchesBuffer[0].end;
+		return true;
+	}
+	startMatch = -1;
+	endMatch = -1;
+	return false;
+}
+
 }} // namespace EE::System
@@ -0,0 +1,122 @@
+#include <eepp/core/string.hpp>
+#include <eepp/system/memorymappedfile.hpp>
+
+#if EE_PLATFORM == EE_PLATFORM_WIN
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace EE { namespace System {
+
+MemoryMappedFile::MemoryMappedFile( const std::string& path ) : mPath( path ) {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	HANDLE file = CreateFileW( String::fromUtf8( path ).toWideString().c_str(), GENERIC_READ,
+							   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+							   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE )
+		return;
+	mFile = file;
+	LARGE_INTEGER size;
+	if ( !GetFileSizeEx( file, &size ) ) {
+		close();
+		return;
+	}
+	mSize = static_cast<size_t>( size.QuadPart );
+	if ( mSize == 0 ) {
+		mOpen = true;
+		return;
+	}
+	HANDLE mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if ( mapping == NULL ) {
+		close();
+		return;
+	}
+	mMapping = mapping;
+	mData = static_cast<char*>( MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+	if ( mData == nullptr ) {
+		close();
+		return;
+	}
+	mOpen = true;
+#else
+	int fd = ::open( path.c_str(), O_RDONLY );
+	if ( fd == -1 )
+		return;
+	struct stat st;
+	if ( fstat( fd, &st ) != 0 || !S_ISREG( st.st_mode ) ) {
+		::close( fd );
+		return;
+	}
+	mSize = static_cast<size_t>( st.st_size );
+	if ( mSize > 0 ) {
+		void* data = mmap( nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( data == MAP_FAILED ) {
+			mSize = 0;
+			::close( fd );
+			return;
+		}
+		mData = static_cast<char*>( data );
+	}
+	// The mapping keeps its own reference to the file.
+	::close( fd );
+	mOpen = true;
+#endif
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	close();
+}
+
+bool MemoryMappedFile::isOpen() const {
+	return mOpen;
+}
+
+const char* MemoryMappedFile::getData() const {
+	return mData;
+}
+
+size_t MemoryMappedFile::getSize() const {
+	return mSize;
+}
+
+const std::string& MemoryMappedFile::getPath() const {
+	return mPath;
+}
+
+void MemoryMappedFile::adviseSequential() {
+#if defined( EE_PLATFORM_POSIX ) && EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN
+	if ( mData != nullptr )
+		madvise( mData, mSize, MADV_SEQUENTIAL );
+#endif
+}
+
+void MemoryMappedFile::close() {
+#if EE_PLATFORM == EE_PLATFORM_WIN
+	if ( mData != nullptr )
+		UnmapViewOfFile( mData );
+	if ( mMapping != nullptr )
+		CloseHandle( static_cast<HANDLE>( mMapping ) );
+	if ( mFile != nullptr )
+		CloseHandle( static_cast<HANDLE>( mFile ) );
+	mMapping = nullptr;
+	mFile = nullptr;
+#else
+	if ( mData != nullptr )
+		munmap( mData, mSize );
+#endif
+	mData = nullptr;
+	mSize = 0;
+	mOpen = false;
+}
+
+}} // namespace EE::System
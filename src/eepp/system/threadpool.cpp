@@ -1,8 +1,15 @@
 #include <algorithm>
+#include <chrono>
 #include <eepp/system/threadpool.hpp>
 
 namespace EE { namespace System {
 
+static constexpr size_t NO_WORKER = static_cast<size_t>( -1 );
+
+/// The pool and worker index of the current thread, if it is a pool worker.
+static thread_local ThreadPool* sCurrentPool = nullptr;
+static thread_local size_t sCurrentWorker = NO_WORKER;
+
 std::shared_ptr<ThreadPool> ThreadPool::createShared( Uint32 numThreads, bool terminateOnClose ) {
 	std::shared_ptr<ThreadPool> pool( new ThreadPool( numThreads, terminateOnClose ) );
 	return pool;
@@ -19,8 +26,11 @@ ThreadPool* ThreadPool::createRaw( Uint32 numThreads, bool terminateOnClose ) {
 
 ThreadPool::ThreadPool( Uint32 numThreads, bool terminateOnClose ) :
 	mTerminateOnClose( terminateOnClose ) {
+	for ( Uint32 i = 0; i < numThreads; ++i )
+		mWorkerQueues.emplace_back( std::make_unique<WorkerQueue>() );
+
 	for ( Uint32 i = 0; i < numThreads; ++i ) {
-		mThreads.emplace_back( std::make_unique<Thread>( &ThreadPool::threadFunc, this ) );
+		mThreads.emplace_back( std::make_unique<Thread>( [this, i] { threadFunc( i ); } ) );
 		mThreads.back().get()->launch();
 	}
 }
@@ -42,28 +52,131 @@ ThreadPool::~ThreadPool() {
 	}
 }
 
-void ThreadPool::threadFunc() {
+void ThreadPool::threadFunc( size_t index ) {
+	sCurrentPool = this;
+	sCurrentWorker = index;
+
 	while ( true ) {
-		std::unique_ptr<Work> work;
-		{
-			std::unique_lock<std::mutex> lock( mMutex );
+		std::unique_ptr<Work> work = pop( index );
+
+		if ( work ) {
+			execute( std::move( work ) );
+			continue;
+		}
 
-			mWorkAvailable.wait( lock, [this]() { return !mWork.empty() || mShuttingDown; } );
+		std::unique_lock<std::mutex> lock( mMutex );
 
-			if ( mShuttingDown && mWork.empty() ) {
-				return;
-			}
+		mWorkAvailable.wait( lock, [this]() { return mPendingWork > 0 || mShuttingDown; } );
+
+		if ( mShuttingDown && mPendingWork == 0 )
+			return;
+	}
+}
+
+bool ThreadPool::push( std::unique_ptr<Work>&& work, const Priority& priority ) {
+	// The pool lock is only held to synchronize with the workers about to wait (so the
+	// notification is never lost) and with the shutdown.
+	{
+		std::lock_guard<std::mutex> poolLock( mMutex );
+
+		if ( mShuttingDown )
+			return false;
+
+		// Work scheduled from a worker goes to its own queue, any other thread uses the shared
+		// one.
+		WorkerQueue& queue =
+			sCurrentPool == this ? *mWorkerQueues[sCurrentWorker].get() : mSharedQueue;
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.work[static_cast<size_t>( priority )].emplace_back( std::move( work ) );
+		mPendingWork++;
+	}
+
+	mWorkAvailable.notify_one();
+
+	return true;
+}
 
-			work = std::move( mWork.front() );
-			mWork.pop_front();
+std::unique_ptr<ThreadPool::Work> ThreadPool::pop( size_t worker ) {
+	if ( mPendingWork == 0 )
+		return nullptr;
+
+	const size_t workers = mWorkerQueues.size();
+
+	for ( size_t p = 0; p < static_cast<size_t>( Priority::Count ); ++p ) {
+		// The worker runs its newest work first, it's usually the hottest in cache.
+		if ( worker != NO_WORKER ) {
+			WorkerQueue& queue = *mWorkerQueues[worker].get();
+			std::lock_guard<std::mutex> lock( queue.mutex );
+			if ( !queue.work[p].empty() ) {
+				std::unique_ptr<Work> work = std::move( queue.work[p].back() );
+				queue.work[p].pop_back();
+				mPendingWork--;
+				return work;
+			}
 		}
 
-		work->func();
+		{
+			std::lock_guard<std::mutex> lock( mSharedQueue.mutex );
+			if ( !mSharedQueue.work[p].empty() ) {
+				std::unique_ptr<Work> work = std::move( mSharedQueue.work[p].front() );
+				mSharedQueue.work[p].pop_front();
+				mPendingWork--;
+				return work;
+			}
+		}
 
-		if ( work->callback != nullptr ) {
-			work->callback( work->id );
+		// Steals the oldest work of the other workers.
+		for ( size_t i = 1; i <= workers; ++i ) {
+			size_t victim = worker != NO_WORKER ? ( worker + i ) % workers : i - 1;
+			if ( victim == worker )
+				continue;
+			WorkerQueue& queue = *mWorkerQueues[victim].get();
+			std::lock_guard<std::mutex> lock( queue.mutex );
+			if ( !queue.work[p].empty() ) {
+				std::unique_ptr<Work> work = std::move( queue.work[p].front() );
+				queue.work[p].pop_front();
+				mPendingWork--;
+				return work;
+			}
 		}
 	}
+
+	return nullptr;
+}
+
+void ThreadPool::execute( std::unique_ptr<Work>&& work ) {
+	if ( work->token.isCancelled() )
+		return;
+
+	work->func();
+
+	if ( work->callback != nullptr ) {
+		work->callback( work->id );
+	}
+}
+
+bool ThreadPool::runPendingWork() {
+	std::unique_ptr<Work> work = pop( sCurrentPool == this ? sCurrentWorker : NO_WORKER );
+	if ( !work )
+		return false;
+	execute( std::move( work ) );
+	return true;
+}
+
+template <typename F> bool ThreadPool::forEachQueue( F func ) {
+	auto visit = [&]( WorkerQueue& queue ) {
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		for ( auto& work : queue.work )
+			if ( func( work ) )
+				return true;
+		return false;
+	};
+	if ( visit( mSharedQueue ) )
+		return true;
+	for ( auto& queue : mWorkerQueues )
+		if ( visit( *queue.get() ) )
+			return true;
+	return false;
 }
 
 bool ThreadPool::terminateOnClose() const {
@@ -75,62 +188,188 @@ void ThreadPool::setTerminateOnClose( bool terminateOnClose ) {
 }
 
 bool ThreadPool::existsIdInQueue( const Uint64& id ) {
-	std::unique_lock<std::mutex> lock( mMutex );
-	return std::any_of( mWork.begin(), mWork.end(),
-						[id]( const std::unique_ptr<Work>& work ) { return work->id == id; } );
+	return forEachQueue( [id]( WorkQueue& queue ) {
+		return std::any_of( queue.begin(), queue.end(),
+							[id]( const std::unique_ptr<Work>& work ) { return work->id == id; } );
+	} );
 }
 
 bool ThreadPool::existsTagInQueue( const Uint64& tag ) {
-	std::unique_lock<std::mutex> lock( mMutex );
-	return std::any_of( mWork.begin(), mWork.end(),
-						[tag]( const std::unique_ptr<Work>& work ) { return work->tag == tag; } );
+	return forEachQueue( [tag]( WorkQueue& queue ) {
+		return std::any_of( queue.begin(), queue.end(), [tag]( const std::unique_ptr<Work>& work ) {
+			return work->tag == tag;
+		} );
+	} );
 }
 
 bool ThreadPool::removeId( const Uint64& id ) {
-	std::unique_lock<std::mutex> lock( mMutex );
-	for ( auto it = mWork.begin(); it != mWork.end(); ++it ) {
-		if ( it->get()->id == id ) {
-			mWork.erase( it );
-			return true;
+	return forEachQueue( [this, id]( WorkQueue& queue ) {
+		for ( auto it = queue.begin(); it != queue.end(); ++it ) {
+			if ( it->get()->id == id ) {
+				queue.erase( it );
+				mPendingWork--;
+				return true;
+			}
 		}
-	}
-	return false;
+		return false;
+	} );
 }
 
 bool ThreadPool::removeWithTag( const Uint64& tag ) {
-	std::vector<Uint64> ids;
-	{
-		std::unique_lock<std::mutex> lock( mMutex );
-		for ( const auto& work : mWork )
-			if ( work->tag == tag )
-				ids.emplace_back( work->id );
-	}
-	for ( const auto& id : ids )
-		removeId( id );
-	return !ids.empty();
+	bool removed = false;
+	forEachQueue( [this, tag, &removed]( WorkQueue& queue ) {
+		size_t size = queue.size();
+		queue.erase( std::remove_if( queue.begin(), queue.end(),
+									 [tag]( const std::unique_ptr<Work>& work ) {
+										 return work->tag == tag;
+									 } ),
+					 queue.end() );
+		if ( queue.size() != size ) {
+			mPendingWork -= size - queue.size();
+			removed = true;
+		}
+		return false;
+	} );
+	return removed;
 }
 
-Uint64 ThreadPool::run( const std::function<void()>& func,
-						const std::function<void( const Uint64& )>& doneCallback,
-						const Uint64& tag ) {
+Uint64 ThreadPool::run( std::function<void()> func,
+						std::function<void( const Uint64& )> doneCallback, const Uint64& tag,
+						const Priority& priority ) {
 	Uint64 id = ++mLastWorkId;
-	{
-		std::unique_lock<std::mutex> lock( mMutex );
 
-		if ( mShuttingDown )
-			return id;
+	push( std::unique_ptr<Work>(
+			  new Work{ id, std::move( func ), std::move( doneCallback ), tag,
+						CancellationToken( nullptr ) } ),
+		  priority );
 
-		mWork.emplace_back( new Work{ id, func, doneCallback, tag } );
-	}
+	return id;
+}
 
-	mWorkAvailable.notify_one();
+Uint64 ThreadPool::run( std::function<void()> func, const Priority& priority,
+						const CancellationToken& token,
+						std::function<void( const Uint64& )> doneCallback ) {
+	Uint64 id = ++mLastWorkId;
+
+	push( std::unique_ptr<Work>(
+			  new Work{ id, std::move( func ), std::move( doneCallback ), 0, token } ),
+		  priority );
 
 	return id;
 }
 
+void ThreadPool::parallelFor( size_t begin, size_t end,
+							  const std::function<void( size_t, size_t )>& func,
+							  const Priority& priority, size_t grainSize ) {
+	if ( begin >= end )
+		return;
+
+	size_t count = end - begin;
+	if ( grainSize == 0 )
+		grainSize = std::max<size_t>( 1, count / ( std::max<size_t>( 1, mThreads.size() ) * 4 ) );
+
+	if ( count <= grainSize || mThreads.empty() ) {
+		func( begin, end );
+		return;
+	}
+
+	// The ranges are claimed from a shared counter by the calling thread and the helpers, so the
+	// calling thread never needs to run unrelated work of the pool while it waits.
+	std::atomic<size_t> next{ begin };
+	auto runRanges = [&func, &next, end, grainSize] {
+		while ( true ) {
+			size_t from = next.fetch_add( grainSize );
+			if ( from >= end )
+				break;
+			func( from, from + std::min( grainSize, end - from ) );
+		}
+	};
+
+	size_t ranges = ( count + grainSize - 1 ) / grainSize;
+	TaskGroup group( this, priority );
+	for ( size_t i = 0; i < std::min( ranges - 1, mThreads.size() ); ++i )
+		group.run( runRanges );
+	runRanges();
+	group.cancel();
+	group.wait();
+}
+
+Executor ThreadPool::getExecutor( const Priority& priority ) {
+	return [this, priority]( std::function<void()> func ) { run( std::move( func ), priority ); };
+}
+
 Uint32 ThreadPool::numThreads() const {
-	std::unique_lock<std::mutex> lock( mMutex );
 	return mShuttingDown ? 0 : static_cast<Uint32>( mThreads.size() );
 }
 
+TaskGroup::TaskGroup( ThreadPool* pool, const ThreadPool::Priority& priority ) :
+	mPool( pool ), mPriority( priority ), mState( std::make_shared<State>() ) {}
+
+TaskGroup::~TaskGroup() {
+	wait();
+}
+
+void TaskGroup::run( std::function<void()> func ) {
+	{
+		std::lock_guard<std::mutex> lock( mState->mutex );
+		mState->pending++;
+	}
+
+	// The cancellation is checked while holding the state lock, so once wait() sees a cancelled
+	// group without running jobs no other job can start. The group can be destroyed by then, the
+	// jobs only keep the shared state.
+	auto job = [state = mState, token = mToken, func = std::move( func )] {
+		{
+			std::lock_guard<std::mutex> lock( state->mutex );
+			if ( token.isCancelled() ) {
+				state->pending--;
+				return;
+			}
+			state->running++;
+		}
+		func();
+		std::lock_guard<std::mutex> lock( state->mutex );
+		state->running--;
+		state->pending--;
+		state->done.notify_all();
+	};
+
+	if ( !mPool->push( std::unique_ptr<ThreadPool::Work>( new ThreadPool::Work{
+						   0, std::move( job ), nullptr, 0, CancellationToken( nullptr ) } ),
+					   mPriority ) ) {
+		// The pool is shutting down, the work runs in the calling thread.
+		job();
+	}
+}
+
+void TaskGroup::wait() {
+	// Only the pool workers help (or any thread if the pool has no workers), since they could
+	// otherwise wait for work queued behind them. Any other thread (usually the main thread) just
+	// waits, so it never picks a long unrelated job.
+	bool help = sCurrentPool == mPool || mPool->mThreads.empty();
+	auto finished = [this] {
+		return mState->pending == 0 || ( mToken.isCancelled() && mState->running == 0 );
+	};
+	std::unique_lock<std::mutex> lock( mState->mutex );
+	while ( !finished() ) {
+		if ( !help ) {
+			mState->done.wait( lock, finished );
+			break;
+		}
+		lock.unlock();
+		bool ranWork = mPool->runPendingWork();
+		lock.lock();
+		if ( !ranWork )
+			mState->done.wait_for( lock, std::chrono::milliseconds( 1 ), finished );
+	}
+}
+
+void TaskGroup::cancel() {
+	{
+		std::lock_guard<std::mutex> lock( mState->mutex );
+		mToken.cancel();
+	}
+	mState->done.notify_all();
+}
+
 }} // namespace EE::System
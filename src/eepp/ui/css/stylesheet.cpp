@@ -1,6 +1,7 @@
 #include <algorithm>
-#include <array>
+#include <eepp/system/lock.hpp>
 #include <eepp/ui/css/stylesheet.hpp>
+#include <eepp/ui/css/stylesheetancestorfilter.hpp>
 #include <eepp/ui/css/stylesheetproperty.hpp>
 #include <eepp/ui/css/stylesheetselector.hpp>
 #include <eepp/ui/uiwidget.hpp>
@@ -10,6 +11,29 @@ namespace EE { namespace UI { namespace CSS {
 
 StyleSheet::StyleSheet() {}
 
+StyleSheet::StyleSheet( const StyleSheet& other ) {
+	*this = other;
+}
+
+StyleSheet& StyleSheet::operator=( const StyleSheet& other ) {
+	if ( this == &other )
+		return *this;
+	mMarker = other.mMarker;
+	mStyleOrder = other.mStyleOrder;
+	mNodes = other.mNodes;
+	mNodeIndex = other.mNodeIndex;
+	mMediaQueryList = other.mMediaQueryList;
+	mKeyframesMap = other.mKeyframesMap;
+	ElementDefinitionCache nodeCache;
+	{
+		Lock l( other.mNodeCacheMutex );
+		nodeCache = other.mNodeCache;
+	}
+	Lock l( mNodeCacheMutex );
+	mNodeCache = std::move( nodeCache );
+	return *this;
+}
+
 template <class T> inline void HashCombine( std::size_t& seed, const T& v ) {
 	std::hash<T> hasher;
 	seed ^= hasher( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
@@ -24,7 +48,15 @@ size_t StyleSheet::nodeHash( const std::string& tag, const std::string& id ) {
 	return seed;
 }
 
+size_t StyleSheet::classNodeHash( const std::string& cls ) {
+	// Salted so a class bucket doesn't share its hash with the tag bucket of the same name.
+	size_t seed = 0x5bd1e995;
+	HashCombine( seed, cls );
+	return seed;
+}
+
 void StyleSheet::invalidateCache() {
+	Lock l( mNodeCacheMutex );
 	mNodeCache.clear();
 }
 
@@ -54,18 +86,11 @@ void StyleSheet::removeAllWithMarker( const Uint32& marker ) {
 
 	std::vector<size_t> deprecatedNodeIndex;
 	for ( auto& nodeIndex : mNodeIndex ) {
-		std::vector<StyleSheetStyle*> removeNodesIndex;
-		for ( auto node : nodeIndex.second ) {
-			if ( node->getMarker() == marker ) {
-				removeNodesIndex.emplace_back( node );
-			}
-		}
-		for ( auto removeNodeIndex : removeNodesIndex ) {
-			auto found =
-				std::find( nodeIndex.second.begin(), nodeIndex.second.end(), removeNodeIndex );
-			if ( found != nodeIndex.second.end() )
-				nodeIndex.second.erase( found );
-		}
+		nodeIndex.second.erase( std::remove_if( nodeIndex.second.begin(), nodeIndex.second.end(),
+												[marker]( const IndexedStyle& node ) {
+													return node.style->getMarker() == marker;
+												} ),
+								nodeIndex.second.end() );
 		if ( nodeIndex.second.empty() )
 			deprecatedNodeIndex.emplace_back( nodeIndex.first );
 	}
@@ -119,6 +144,7 @@ StyleSheet::findStyleFromSelectorName( const std::string& selector ) {
 bool StyleSheet::refreshCacheFromStyles(
 	const std::vector<std::shared_ptr<StyleSheetStyle>>& styles ) {
 	bool refreshed = false;
+	Lock l( mNodeCacheMutex );
 	for ( const auto& style : styles ) {
 		for ( auto& node : mNodeCache ) {
 			for ( auto& nodeStyle : node.second->getStyles() ) {
@@ -136,11 +162,18 @@ bool StyleSheet::addStyleToNodeIndex( StyleSheetStyle* style ) {
 	const std::string& id = style->getSelector().getSelectorId();
 	const std::string& tag = style->getSelector().getSelectorTagName();
 	if ( style->hasProperties() || style->hasVariables() ) {
-		size_t nodeHash = this->nodeHash( "*" == tag ? "" : tag, id );
-		StyleSheetStyleVector& nodes = mNodeIndex[nodeHash];
-		auto it = std::find( nodes.begin(), nodes.end(), style );
+		// Selectors keyed only by classes are indexed by their first class, since an element must
+		// have all of them to match.
+		const auto& classes = style->getSelector().getRule( 0 ).getClasses();
+		size_t nodeHash = tag.empty() && id.empty() && !classes.empty()
+							  ? classNodeHash( classes.front() )
+							  : this->nodeHash( "*" == tag ? "" : tag, id );
+		std::vector<IndexedStyle>& nodes = mNodeIndex[nodeHash];
+		auto it = std::find_if( nodes.begin(), nodes.end(), [style]( const IndexedStyle& node ) {
+			return node.style == style;
+		} );
 		if ( it == nodes.end() ) {
-			nodes.push_back( style );
+			nodes.push_back( { style, mStyleOrder++ } );
 			return true;
 		} else {
 			Log::debug( "Ignored style %s", style->getSelector().getName().c_str() );
@@ -189,51 +222,82 @@ void StyleSheet::combineStyleSheet( const StyleSheet& styleSheet ) {
 	addKeyframes( styleSheet.getKeyframes() );
 }
 
-inline static bool StyleSheetNodeSort( const StyleSheetStyle* lhs, const StyleSheetStyle* rhs ) {
-	return lhs->getSelector().getSpecificity() < rhs->getSelector().getSpecificity();
+namespace {
+
+struct MatchedStyle {
+	StyleSheetStyle* style;
+	/// Rank of the bucket where the style was found: universal and classes, tag, id, tag and id.
+	Uint32 rank;
+	Uint64 order;
+};
+
+inline bool MatchedStyleSort( const MatchedStyle& lhs, const MatchedStyle& rhs ) {
+	Uint32 lhsSpecificity = lhs.style->getSelector().getSpecificity();
+	Uint32 rhsSpecificity = rhs.style->getSelector().getSpecificity();
+	if ( lhsSpecificity != rhsSpecificity )
+		return lhsSpecificity < rhsSpecificity;
+	if ( lhs.rank != rhs.rank )
+		return lhs.rank < rhs.rank;
+	return lhs.order < rhs.order;
 }
 
+} // namespace
+
 // This is based on the RmlUi implementation.
 std::shared_ptr<ElementDefinition> StyleSheet::getElementStyles( UIWidget* element,
 																 const bool& applyPseudo ) const {
-	static StyleSheetStyleVector applicableNodes;
+	// Scratch storage per thread, so styles can be resolved from several threads.
+	static thread_local std::vector<MatchedStyle> matchedNodes;
+	static thread_local StyleSheetStyleVector applicableNodes;
+	matchedNodes.clear();
 	applicableNodes.clear();
 
 	const std::string& tag = element->getElementTag();
 	const std::string& id = element->getId();
+	const std::vector<std::string>& classes = element->getStyleSheetClasses();
+	const StyleSheetAncestorFilter* ancestorFilter = StyleSheetAncestorFilter::getActive( element );
+
+	auto matchBucket = [&]( const size_t& hash, const Uint32& rank ) {
+		auto itNodes = mNodeIndex.find( hash );
+		if ( itNodes == mNodeIndex.end() )
+			return;
+		for ( const IndexedStyle& node : itNodes->second ) {
+			const StyleSheetSelector& selector = node.style->getSelector();
+			if ( NULL != ancestorFilter &&
+				 !ancestorFilter->mayContainAll( selector.getAncestorHashes() ) )
+				continue;
+			if ( node.style->isMediaValid() && selector.select( element, applyPseudo ) )
+				matchedNodes.push_back( { node.style, rank, node.order } );
+		}
+	};
 
-	std::array<size_t, 4> nodeHash;
-	int numHashes = 2;
-
-	nodeHash[0] = 0;
-	nodeHash[1] = this->nodeHash( tag, "" );
+	matchBucket( 0, 0 );
 
-	if ( !id.empty() ) {
-		numHashes = 4;
-		nodeHash[2] = this->nodeHash( "", id );
-		nodeHash[3] = this->nodeHash( tag, id );
+	for ( size_t i = 0; i < classes.size(); i++ ) {
+		if ( std::find( classes.begin(), classes.begin() + i, classes[i] ) ==
+			 classes.begin() + i )
+			matchBucket( classNodeHash( classes[i] ), 0 );
 	}
 
-	for ( int i = 0; i < numHashes; i++ ) {
-		auto itNodes = mNodeIndex.find( nodeHash[i] );
-		if ( itNodes != mNodeIndex.end() ) {
-			const StyleSheetStyleVector& nodes = itNodes->second;
-			for ( StyleSheetStyle* node : nodes ) {
-				if ( node->isMediaValid() && node->getSelector().select( element, applyPseudo ) ) {
-					applicableNodes.push_back( node );
-				}
-			}
-		}
-	}
+	matchBucket( this->nodeHash( tag, "" ), 1 );
 
-	std::sort( applicableNodes.begin(), applicableNodes.end(), StyleSheetNodeSort );
+	if ( !id.empty() ) {
+		matchBucket( this->nodeHash( "", id ), 2 );
+		matchBucket( this->nodeHash( tag, id ), 3 );
+	}
 
-	if ( applicableNodes.empty() )
+	if ( matchedNodes.empty() )
 		return nullptr;
 
+	std::sort( matchedNodes.begin(), matchedNodes.end(), MatchedStyleSort );
+
 	size_t seed = 0;
-	for ( const StyleSheetStyle* node : applicableNodes )
-		HashCombine( seed, node );
+	for ( const MatchedStyle& node : matchedNodes ) {
+		applicableNodes.push_back( node.style );
+		HashCombine( seed, node.style );
+	}
+
+	Lock l( mNodeCacheMutex );
 
 	auto cacheIterator = mNodeCache.find( seed );
 	if ( cacheIterator != mNodeCache.end() ) {
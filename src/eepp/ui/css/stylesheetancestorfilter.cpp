@@ -0,0 +1,155 @@
+#include <eepp/core/string.hpp>
+#include <eepp/ui/css/stylesheetancestorfilter.hpp>
+#include <eepp/ui/uiwidget.hpp>
+
+namespace EE { namespace UI { namespace CSS {
+
+static thread_local StyleSheetAncestorFilter* sActiveFilter = nullptr;
+
+static Uint32 saltedHash( const std::string& name, Uint32 salt ) {
+	// Mixes the string hash so both filter slots get well distributed bits.
+	Uint32 hash = String::hash( name ) ^ salt;
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6B;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+Uint32 StyleSheetAncestorFilter::tagHash( const std::string& tag ) {
+	return saltedHash( tag, 0x9E3779B9 );
+}
+
+Uint32 StyleSheetAncestorFilter::idHash( const std::string& id ) {
+	return saltedHash( id, 0x7F4A7C15 );
+}
+
+Uint32 StyleSheetAncestorFilter::classHash( const std::string& cls ) {
+	return saltedHash( cls, 0x2545F491 );
+}
+
+const StyleSheetAncestorFilter* StyleSheetAncestorFilter::getActive( UIWidget* element ) {
+	UIWidget* parent = element->getStyleSheetParentElement();
+	return sActiveFilter != nullptr && parent != nullptr && sActiveFilter->getTop() == parent
+			   ? sActiveFilter
+			   : nullptr;
+}
+
+StyleSheetAncestorFilter* StyleSheetAncestorFilter::setActive( StyleSheetAncestorFilter* filter ) {
+	StyleSheetAncestorFilter* previous = sActiveFilter;
+	sActiveFilter = filter;
+	return previous;
+}
+
+StyleSheetAncestorFilter::StyleSheetAncestorFilter( UIWidget* element ) {
+	std::vector<UIWidget*> ancestors;
+	UIWidget* ancestor = element->getStyleSheetParentElement();
+	while ( NULL != ancestor ) {
+		ancestors.push_back( ancestor );
+		ancestor = ancestor->getStyleSheetParentElement();
+	}
+	for ( auto it = ancestors.rbegin(); it != ancestors.rend(); ++it )
+		pushElement( *it );
+}
+
+void StyleSheetAncestorFilter::pushElement( UIWidget* element ) {
+	// The hashes are kept so the element is removed with the same values that were added, even
+	// if it changed in the meantime.
+	mElements.push_back( element );
+	mFrames.push_back( mHashes.size() );
+	mHashes.push_back( tagHash( element->getElementTag() ) );
+	if ( !element->getId().empty() )
+		mHashes.push_back( idHash( element->getId() ) );
+	for ( const auto& cls : element->getStyleSheetClasses() )
+		mHashes.push_back( classHash( cls ) );
+	for ( size_t i = mFrames.back(); i < mHashes.size(); ++i )
+		add( mHashes[i] );
+}
+
+void StyleSheetAncestorFilter::popElement() {
+	if ( mElements.empty() )
+		return;
+	for ( size_t i = mFrames.back(); i < mHashes.size(); ++i )
+		remove( mHashes[i] );
+	mHashes.resize( mFrames.back() );
+	mFrames.pop_back();
+	mElements.pop_back();
+}
+
+void StyleSheetAncestorFilter::moveTo( UIWidget* element ) {
+	if ( getTop() == element )
+		return;
+
+	std::vector<UIWidget*> chain;
+	while ( NULL != element ) {
+		chain.push_back( element );
+		element = element->getStyleSheetParentElement();
+	}
+
+	size_t common = 0;
+	while ( common < mElements.size() && common < chain.size() &&
+			mElements[common] == chain[chain.size() - 1 - common] )
+		common++;
+
+	while ( mElements.size() > common )
+		popElement();
+
+	for ( size_t i = chain.size() - common; i > 0; --i )
+		pushElement( chain[i - 1] );
+}
+
+UIWidget* StyleSheetAncestorFilter::getTop() const {
+	return mElements.empty() ? nullptr : mElements.back();
+}
+
+bool StyleSheetAncestorFilter::mayContain( const Uint32& hash ) const {
+	return mCounters[hash & COUNTERS_MASK] != 0 && mCounters[( hash >> 16 ) & COUNTERS_MASK] != 0;
+}
+
+bool StyleSheetAncestorFilter::mayContainAll( const std::vector<Uint32>& hashes ) const {
+	for ( const auto& hash : hashes )
+		if ( !mayContain( hash ) )
+			return false;
+	return true;
+}
+
+void StyleSheetAncestorFilter::add( const Uint32& hash ) {
+	Uint8& first = mCounters[hash & COUNTERS_MASK];
+	Uint8& second = mCounters[( hash >> 16 ) & COUNTERS_MASK];
+	if ( first != COUNTER_MAX )
+		++first;
+	if ( second != COUNTER_MAX )
+		++second;
+}
+
+void StyleSheetAncestorFilter::remove( const Uint32& hash ) {
+	// Saturated counters are never decremented, they can't know their real count anymore.
+	Uint8& first = mCounters[hash & COUNTERS_MASK];
+	Uint8& second = mCounters[( hash >> 16 ) & COUNTERS_MASK];
+	if ( first != COUNTER_MAX )
+		--first;
+	if ( second != COUNTER_MAX )
+		--second;
+}
+
+StyleSheetAncestorFilter::Scope::Scope( UIWidget* element ) : mPrevious( sActiveFilter ) {
+	if ( nullptr != mPrevious && NULL != element->getStyleSheetParentElement() &&
+		 mPrevious->getTop() == element->getStyleSheetParentElement() ) {
+		mPrevious->pushElement( element );
+	} else {
+		mFilter = std::make_unique<StyleSheetAncestorFilter>( element );
+		mFilter->pushElement( element );
+		sActiveFilter = mFilter.get();
+	}
+}
+
+StyleSheetAncestorFilter::Scope::~Scope() {
+	if ( mFilter ) {
+		sActiveFilter = mPrevious;
+	} else {
+		mPrevious->popElement();
+	}
+}
+
+}}} // namespace EE::UI::CSS
@@ -201,8 +201,12 @@ static std::string positionToPercentage( const std::string& pos ) {
 }
 
 StyleSheetLength StyleSheetLength::fromString( std::string str, const Float& defaultValue ) {
-	StyleSheetLength length;
-	length.setValue( defaultValue, Unit::Px );
+	StyleSheetLength length( defaultValue, Unit::Px );
+	parse( std::move( str ), length );
+	return length;
+}
+
+bool StyleSheetLength::parse( std::string str, StyleSheetLength& length ) {
 	std::string num;
 	std::string unit;
 	str = positionToPercentage( str );
@@ -223,10 +227,11 @@ StyleSheetLength StyleSheetLength::fromString( std::string str, const Float& def
 
 		if ( res ) {
 			length.setValue( val, unitFromString( unit ) );
+			return true;
 		}
 	}
 
-	return length;
+	return false;
 }
 
 std::string StyleSheetLength::toString() const {
@@ -33,6 +33,7 @@ StyleSheetProperty::StyleSheetProperty( const PropertyDefinition* definition,
 	checkImportant();
 	createIndexed();
 	checkVars();
+	parseValue();
 
 	if ( NULL == mShorthandDefinition && NULL == mPropertyDefinition ) {
 		Log::warning( "Property %s is not defined!", mName.c_str() );
@@ -57,6 +58,7 @@ StyleSheetProperty::StyleSheetProperty( const bool& isVolatile,
 	cleanValue();
 	checkImportant();
 	checkVars();
+	parseValue();
 
 	if ( NULL == mShorthandDefinition && NULL == mPropertyDefinition ) {
 		Log::warning( "Property %s is not defined!", mName.c_str() );
@@ -83,6 +85,7 @@ StyleSheetProperty::StyleSheetProperty( const std::string& name, const std::stri
 	checkImportant();
 	createIndexed();
 	checkVars();
+	parseValue();
 
 	if ( NULL == mShorthandDefinition && NULL == mPropertyDefinition ) {
 		Log::warning( "Property %s is not defined!", mName.c_str() );
@@ -109,12 +112,31 @@ StyleSheetProperty::StyleSheetProperty( const std::string& name, const std::stri
 	checkImportant();
 	createIndexed();
 	checkVars();
+	parseValue();
 
 	if ( NULL == mShorthandDefinition && NULL == mPropertyDefinition ) {
 		Log::warning( "Property %s is not defined!" );
 	}
 }
 
+StyleSheetProperty::StyleSheetProperty( const PropertyDefinition* definition, const Color& color,
+										const Uint32& index ) :
+	mName( definition->getName() ),
+	mNameHash( definition->getId() ),
+	mValue( color.toHexString() ),
+	mValueHash( String::hash( mValue ) ),
+	mSpecificity( 0 ),
+	mIndex( index ),
+	mVolatile( false ),
+	mImportant( false ),
+	mIsVarValue( false ),
+	mPropertyDefinition( definition ),
+	mShorthandDefinition( NULL ),
+	mValueType( ValueType::Color ),
+	mColor( color ) {
+	createIndexed();
+}
+
 Uint32 StyleSheetProperty::getId() const {
 	return NULL != mPropertyDefinition
 			   ? mPropertyDefinition->getId()
@@ -160,6 +182,7 @@ void StyleSheetProperty::setValue( const std::string& value, bool updateHash ) {
 		mValueHash = String::hash( value );
 	mIsVarValue = String::startsWith( mValue, "var(" );
 	createIndexed();
+	parseValue();
 }
 
 const bool& StyleSheetProperty::isVolatile() const {
@@ -214,6 +237,27 @@ void StyleSheetProperty::checkVars() {
 	}
 }
 
+void StyleSheetProperty::parseValue() {
+	mValueType = ValueType::None;
+
+	if ( NULL == mPropertyDefinition || mIsVarValue || mValue.empty() )
+		return;
+
+	switch ( mPropertyDefinition->getType() ) {
+		case PropertyType::Color:
+			mColor = Color::fromString( mValue );
+			mValueType = ValueType::Color;
+			break;
+		case PropertyType::NumberLength:
+		case PropertyType::NumberLengthFixed:
+			if ( StyleSheetLength::parse( mValue, mLength ) )
+				mValueType = ValueType::Length;
+			break;
+		default:
+			break;
+	}
+}
+
 static void varToVal( VariableFunctionCache& varCache, const std::string& varDef ) {
 	FunctionString functionType = FunctionString::parse( varDef );
 	if ( !functionType.getParameters().empty() ) {
@@ -295,7 +339,7 @@ bool StyleSheetProperty::asBool( bool defaultValue ) const {
 }
 
 Color StyleSheetProperty::asColor() const {
-	return Color::fromString( mValue );
+	return mValueType == ValueType::Color ? mColor : Color::fromString( mValue );
 }
 
 Float StyleSheetProperty::asDpDimension( const std::string& defaultValue ) const {
@@ -656,7 +700,7 @@ Sizei StyleSheetProperty::asSizei( UINode* node, const Sizei& defaultValue ) con
 }
 
 StyleSheetLength StyleSheetProperty::asStyleSheetLength() const {
-	return StyleSheetLength( mValue );
+	return mValueType == ValueType::Length ? mLength : StyleSheetLength( mValue );
 }
 
 const String::HashType& StyleSheetProperty::getValueHash() const {
@@ -667,4 +711,8 @@ const std::vector<VariableFunctionCache>& StyleSheetProperty::getVarCache() cons
 	return mVarCache;
 }
 
+const StyleSheetProperty::ValueType& StyleSheetProperty::getValueType() const {
+	return mValueType;
+}
+
 }}} // namespace EE::UI::CSS
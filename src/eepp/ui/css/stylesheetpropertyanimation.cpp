@@ -73,8 +73,7 @@ void StyleSheetPropertyAnimation::tweenProperty( UIWidget* widget, const Float&
 			resColor.a = static_cast<Uint8>( eemin(
 				static_cast<Int32>( startColor.a + ( endColor.a - startColor.a ) * progress ),
 				255 ) );
-			widget->applyProperty(
-				StyleSheetProperty( property, resColor.toHexString(), propertyIndex ) );
+			widget->applyProperty( StyleSheetProperty( property, resColor, propertyIndex ) );
 			break;
 		}
 		case PropertyType::NumberLength: {
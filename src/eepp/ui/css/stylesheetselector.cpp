@@ -1,3 +1,4 @@
+#include <eepp/ui/css/stylesheetancestorfilter.hpp>
 #include <eepp/ui/css/stylesheetselector.hpp>
 #include <eepp/ui/uiwidget.hpp>
 
@@ -101,6 +102,26 @@ void StyleSheetSelector::parseSelector( std::string selector ) {
 				}
 			}
 		}
+
+		// Descendant and child rules always match an ancestor of the element. The universal rule
+		// matches any element when the pseudo classes are not applied, so it can't be required.
+		for ( size_t i = 1; i < mSelectorRules.size(); i++ ) {
+			const StyleSheetSelectorRule& rule = mSelectorRules[i];
+
+			if ( ( rule.getPatternMatch() != StyleSheetSelectorRule::DESCENDANT &&
+				   rule.getPatternMatch() != StyleSheetSelectorRule::CHILD ) ||
+				 rule.getTagName() == "*" )
+				continue;
+
+			if ( !rule.getTagName().empty() )
+				mAncestorHashes.push_back( StyleSheetAncestorFilter::tagHash( rule.getTagName() ) );
+
+			if ( !rule.getId().empty() )
+				mAncestorHashes.push_back( StyleSheetAncestorFilter::idHash( rule.getId() ) );
+
+			for ( const auto& cls : rule.getClasses() )
+				mAncestorHashes.push_back( StyleSheetAncestorFilter::classHash( cls ) );
+		}
 	}
 }
 
@@ -309,7 +330,7 @@ const bool& StyleSheetSelector::isStructurallyVolatile() const {
 	return mStructurallyVolatile;
 }
 
-const StyleSheetSelectorRule& StyleSheetSelector::getRule( const Uint32& index ) {
+const StyleSheetSelectorRule& StyleSheetSelector::getRule( const Uint32& index ) const {
 	return mSelectorRules[index];
 }
 
@@ -321,4 +342,8 @@ const std::string& StyleSheetSelector::getSelectorTagName() const {
 	return mSelectorRules[0].getTagName();
 }
 
+const std::vector<Uint32>& StyleSheetSelector::getAncestorHashes() const {
+	return mAncestorHashes;
+}
+
 }}} // namespace EE::UI::CSS
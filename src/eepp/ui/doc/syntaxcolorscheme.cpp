@@ -199,29 +199,42 @@ SyntaxColorScheme::SyntaxColorScheme( const std::string& name,
 static const SyntaxColorScheme::Style StyleEmpty = { Color::Transparent };
 static const SyntaxColorScheme StyleDefault = SyntaxColorScheme::getDefault();
 
+const SyntaxColorScheme::Style&
+SyntaxColorScheme::getSyntaxStyle( const SyntaxStyleType& type ) const {
+	auto foundIt = mStyleCache.find( type );
+	if ( foundIt != mStyleCache.end() )
+		return foundIt->second;
+	return cacheSyntaxStyle( type, SyntaxStyleTypeCache::getName( type ) );
+}
+
 const SyntaxColorScheme::Style& SyntaxColorScheme::getSyntaxStyle( const std::string& type ) const {
-	auto it = mSyntaxColors.find( type );
+	auto foundIt = mStyleCache.find( String::hash( type ) );
+	if ( foundIt != mStyleCache.end() )
+		return foundIt->second;
+	return cacheSyntaxStyle( SyntaxStyleTypeCache::intern( type ), type );
+}
+
+const SyntaxColorScheme::Style&
+SyntaxColorScheme::cacheSyntaxStyle( const SyntaxStyleType& type, const std::string& name ) const {
+	auto it = mSyntaxColors.find( name );
 	if ( it != mSyntaxColors.end() )
-		return it->second;
-	else if ( type == "keyword3" )
-		return getSyntaxStyle( "symbol" );
-	else if ( type == "link" || type == "link_hover" )
-		return getSyntaxStyle( "function" );
-	else {
-		auto foundIt = mStyleCache.find( type );
-		if ( foundIt != mStyleCache.end() )
-			return foundIt->second;
-		bool colorWasSet;
-		mStyleCache[type] = parseStyle( type, &colorWasSet, &mSyntaxColors );
-		if ( !colorWasSet ) {
-			auto normalStyle = mSyntaxColors.find( "normal" );
-			if ( normalStyle != mSyntaxColors.end() ) {
-				mStyleCache[type].color = normalStyle->second.color;
-			}
-		}
-		return mStyleCache[type];
+		return mStyleCache[type] = it->second;
+	else if ( type == SyntaxStyleTypes::Keyword3 )
+		return mStyleCache[type] = getSyntaxStyle( SyntaxStyleTypes::Symbol );
+	else if ( type == SyntaxStyleTypes::Link || type == SyntaxStyleTypes::LinkHover )
+		return mStyleCache[type] = getSyntaxStyle( SyntaxStyleTypes::Function );
+	bool colorWasSet;
+	Style style = parseStyle( name, &colorWasSet, &mSyntaxColors );
+	if ( !colorWasSet ) {
+		auto normalStyle = mSyntaxColors.find( "normal" );
+		if ( normalStyle != mSyntaxColors.end() )
+			style.color = normalStyle->second.color;
 	}
-	return StyleEmpty;
+	return mStyleCache[type] = style;
+}
+
+bool SyntaxColorScheme::hasSyntaxStyle( const SyntaxStyleType& type ) const {
+	return hasSyntaxStyle( SyntaxStyleTypeCache::getName( type ) );
 }
 
 bool SyntaxColorScheme::hasSyntaxStyle( const std::string& type ) const {
@@ -230,11 +243,13 @@ bool SyntaxColorScheme::hasSyntaxStyle( const std::string& type ) const {
 
 void SyntaxColorScheme::setSyntaxStyles( const std::unordered_map<std::string, Style>& styles ) {
 	mSyntaxColors.insert( styles.begin(), styles.end() );
+	mStyleCache.clear();
 }
 
 void SyntaxColorScheme::setSyntaxStyle( const std::string& type,
 										const SyntaxColorScheme::Style& style ) {
 	mSyntaxColors[type] = style;
+	mStyleCache.clear();
 }
 
 const SyntaxColorScheme::Style&
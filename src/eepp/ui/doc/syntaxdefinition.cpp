@@ -1,9 +1,88 @@
 #include <eepp/core/memorymanager.hpp>
 #include <eepp/core/string.hpp>
+#include <eepp/system/lock.hpp>
+#include <eepp/system/log.hpp>
+#include <eepp/system/mutex.hpp>
 #include <eepp/ui/doc/syntaxdefinition.hpp>
 
+using namespace EE::System;
+
 namespace EE { namespace UI { namespace Doc {
 
+// Function local statics, patterns might be interned during static initialization.
+static Mutex& styleTypesMutex() {
+	static Mutex mutex;
+	return mutex;
+}
+
+static std::unordered_map<SyntaxStyleType, std::string>& styleTypesNames() {
+	static std::unordered_map<SyntaxStyleType, std::string> names = {
+		{ SyntaxStyleTypes::Normal, "normal" },		{ SyntaxStyleTypes::Symbol, "symbol" },
+		{ SyntaxStyleTypes::Comment, "comment" },	{ SyntaxStyleTypes::Keyword, "keyword" },
+		{ SyntaxStyleTypes::Keyword2, "keyword2" }, { SyntaxStyleTypes::Keyword3, "keyword3" },
+		{ SyntaxStyleTypes::Number, "number" },		{ SyntaxStyleTypes::Literal, "literal" },
+		{ SyntaxStyleTypes::String, "string" },		{ SyntaxStyleTypes::Operator, "operator" },
+		{ SyntaxStyleTypes::Function, "function" }, { SyntaxStyleTypes::Link, "link" },
+		{ SyntaxStyleTypes::LinkHover, "link_hover" } };
+	return names;
+}
+
+SyntaxStyleType SyntaxStyleTypeCache::intern( const std::string& name ) {
+	SyntaxStyleType type = String::hash( name );
+	auto& names = styleTypesNames();
+	Lock l( styleTypesMutex() );
+	auto it = names.find( type );
+	if ( it == names.end() ) {
+		names[type] = name;
+	} else if ( it->second != name ) {
+		Log::warning( "SyntaxStyleTypeCache::intern: style type \"%s\" collides with \"%s\"",
+					  name.c_str(), it->second.c_str() );
+	}
+	return type;
+}
+
+std::string SyntaxStyleTypeCache::getName( const SyntaxStyleType& type ) {
+	auto& names = styleTypesNames();
+	Lock l( styleTypesMutex() );
+	auto it = names.find( type );
+	return it != names.end() ? it->second : "normal";
+}
+
+static std::vector<SyntaxStyleType> internTypes( const std::vector<std::string>& types ) {
+	std::vector<SyntaxStyleType> typesIds;
+	typesIds.reserve( types.size() );
+	for ( const auto& type : types )
+		typesIds.push_back( SyntaxStyleTypeCache::intern( type ) );
+	return typesIds;
+}
+
+SyntaxPattern::SyntaxPattern( std::vector<std::string> _patterns, std::string _type,
+							  std::string _syntax ) :
+	patterns( _patterns ),
+	types( { _type } ),
+	typesIds( internTypes( types ) ),
+	syntax( _syntax ) {
+	compile();
+}
+
+SyntaxPattern::SyntaxPattern( std::vector<std::string> _patterns,
+							  std::vector<std::string> _types, std::string _syntax ) :
+	patterns( _patterns ), types( _types ), typesIds( internTypes( types ) ), syntax( _syntax ) {
+	compile();
+}
+
+void SyntaxPattern::compile() {
+	if ( patterns.empty() )
+		return;
+	startPattern = LuaCompiledPattern( !patterns[0].empty() && patterns[0][0] == '^'
+										   ? patterns[0]
+										   : "^" + patterns[0] );
+	if ( patterns.size() >= 2 ) {
+		endPattern = LuaCompiledPattern( patterns[1] );
+		endAnchoredPattern = LuaCompiledPattern( "^" + patterns[1] );
+	}
+}
+
 SyntaxDefinition::SyntaxDefinition() {}
 
 SyntaxDefinition::SyntaxDefinition( const std::string& languageName,
@@ -20,7 +99,10 @@ SyntaxDefinition::SyntaxDefinition( const std::string& languageName,
 	mSymbols( symbols ),
 	mComment( comment ),
 	mHeaders( headers ),
-	mLSPName( lspName.empty() ? String::toLower( mLanguageName ) : lspName ) {}
+	mLSPName( lspName.empty() ? String::toLower( mLanguageName ) : lspName ) {
+	for ( const auto& symbol : mSymbols )
+		mSymbolTypes[symbol.first] = SyntaxStyleTypeCache::intern( symbol.second );
+}
 
 const std::vector<std::string>& SyntaxDefinition::getFiles() const {
 	return mFiles;
@@ -65,6 +147,13 @@ std::string SyntaxDefinition::getSymbol( const std::string& symbol ) const {
 	return "";
 }
 
+SyntaxStyleType SyntaxDefinition::getSymbolType( const std::string& symbol ) const {
+	auto it = mSymbolTypes.find( symbol );
+	if ( it != mSymbolTypes.end() )
+		return it->second;
+	return SyntaxStyleTypes::None;
+}
+
 SyntaxDefinition& SyntaxDefinition::addFileType( const std::string& fileType ) {
 	mFiles.push_back( fileType );
 	return *this;
@@ -87,6 +176,7 @@ SyntaxDefinition& SyntaxDefinition::addPatternToFront( const SyntaxPattern& patt
 SyntaxDefinition& SyntaxDefinition::addSymbol( const std::string& symbolName,
 											   const std::string& typeName ) {
 	mSymbols[symbolName] = typeName;
+	mSymbolTypes[symbolName] = SyntaxStyleTypeCache::intern( typeName );
 	return *this;
 }
 
@@ -118,6 +208,7 @@ void SyntaxDefinition::clearPatterns() {
 
 void SyntaxDefinition::clearSymbols() {
 	mSymbols.clear();
+	mSymbolTypes.clear();
 }
 
 const std::string& SyntaxDefinition::getLSPName() const {
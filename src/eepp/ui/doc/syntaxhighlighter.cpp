@@ -5,6 +5,26 @@
 
 namespace EE { namespace UI { namespace Doc {
 
+// Number of lines snapshotted and tokenized by each background tokenization job
+#define ASYNC_TOKENIZE_CHUNK_LINES ( 4096 )
+
+struct SyntaxHighlighter::AsyncSnapshot {
+	struct Line {
+		std::string text;
+		String::HashType hash;
+		bool cached{ false };
+		Uint64 cachedInitState{ SYNTAX_TOKENIZER_STATE_NONE };
+		Uint64 cachedState{ SYNTAX_TOKENIZER_STATE_NONE };
+	};
+	Uint64 version{ 0 };
+	Int64 fromLine{ 0 };
+	Int64 lastInvalidLine{ -1 };
+	Int64 tokenizedLine{ 0 };
+	Uint64 initState{ SYNTAX_TOKENIZER_STATE_NONE };
+	std::shared_ptr<SyntaxDefinition> syntax;
+	std::vector<Line> lines;
+};
+
 static constexpr void _hash( Uint64& signature, const String::HashType& val ) {
 	Int64 len = sizeof( decltype( val ) );
 	while ( --len >= 0 )
@@ -14,7 +34,7 @@ static constexpr void _hash( Uint64& signature, const String::HashType& val ) {
 Uint64 TokenizedLine::calcSignature( const std::vector<SyntaxTokenPosition>& tokens ) {
 	Uint64 signature = 5381;
 	for ( const auto& token : tokens )
-		_hash( signature, String::hash( token.type ) );
+		_hash( signature, token.type );
 	return signature;
 }
 
@@ -27,7 +47,12 @@ SyntaxHighlighter::SyntaxHighlighter( TextDocument* doc ) :
 	reset();
 }
 
+SyntaxHighlighter::~SyntaxHighlighter() {
+	cancelAsync();
+}
+
 void SyntaxHighlighter::changeDoc( TextDocument* doc ) {
+	cancelAsync();
 	mDoc = doc;
 	reset();
 	mMaxWantedLine = (Int64)mDoc->linesCount() - 1;
@@ -35,14 +60,22 @@ void SyntaxHighlighter::changeDoc( TextDocument* doc ) {
 
 void SyntaxHighlighter::reset() {
 	Lock l( mLinesMutex );
+	++mVersion;
 	mLines.clear();
 	mFirstInvalidLine = 0;
 	mMaxWantedLine = 0;
+	mAsyncFirstInvalidLine = 0;
+	mAsyncTokenizedLine = 0;
+	mAsyncLastInvalidLine = -1;
 }
 
 void SyntaxHighlighter::invalidate( Int64 lineIndex ) {
 	mFirstInvalidLine = eemin( lineIndex, mFirstInvalidLine );
 	mMaxWantedLine = eemin<Int64>( mMaxWantedLine, (Int64)mDoc->linesCount() - 1 );
+	Lock l( mLinesMutex );
+	++mVersion;
+	mAsyncFirstInvalidLine = eemin( lineIndex, mAsyncFirstInvalidLine );
+	mAsyncLastInvalidLine = eemax( lineIndex, mAsyncLastInvalidLine );
 }
 
 TokenizedLine SyntaxHighlighter::tokenizeLine( const size_t& line, const Uint64& state ) {
@@ -62,6 +95,14 @@ Mutex& SyntaxHighlighter::getLinesMutex() {
 }
 
 void SyntaxHighlighter::moveHighlight( const Int64& fromLine, const Int64& numLines ) {
+	Lock l( mLinesMutex );
+	++mVersion;
+	mAsyncFirstInvalidLine = eemin( fromLine, mAsyncFirstInvalidLine );
+	if ( mAsyncTokenizedLine > fromLine )
+		mAsyncTokenizedLine = eemax( fromLine, mAsyncTokenizedLine + numLines );
+	if ( mAsyncLastInvalidLine > fromLine )
+		mAsyncLastInvalidLine = eemax( fromLine, mAsyncLastInvalidLine + numLines );
+	mAsyncLastInvalidLine = eemax( fromLine, mAsyncLastInvalidLine );
 	if ( mLines.find( fromLine ) == mLines.end() )
 		return;
 	Int64 linesCount = mDoc->linesCount();
@@ -99,7 +140,8 @@ Uint64 SyntaxHighlighter::getTokenizedLineSignature( const size_t& index ) {
 
 const std::vector<SyntaxTokenPosition>& SyntaxHighlighter::getLine( const size_t& index ) {
 	if ( mDoc->getSyntaxDefinition().getPatterns().empty() ) {
-		static std::vector<SyntaxTokenPosition> noHighlightVector = { { "normal", 0 } };
+		static std::vector<SyntaxTokenPosition> noHighlightVector = {
+			{ SyntaxStyleTypes::Normal, 0 } };
 		noHighlightVector[0].len = mDoc->line( index ).size();
 		return noHighlightVector;
 	}
@@ -134,11 +176,12 @@ Int64 SyntaxHighlighter::getMaxWantedLine() const {
 bool SyntaxHighlighter::updateDirty( int visibleLinesCount ) {
 	if ( visibleLinesCount <= 0 )
 		return 0;
+	bool changed = false;
 	if ( mFirstInvalidLine > mMaxWantedLine ) {
 		mMaxWantedLine = 0;
 	} else {
-		bool changed = false;
 		Int64 max = eemax( 0LL, eemin( mFirstInvalidLine + visibleLinesCount, mMaxWantedLine ) );
+		Lock l( mLinesMutex );
 
 		for ( Int64 index = mFirstInvalidLine; index <= max; index++ ) {
 			Uint64 state = SYNTAX_TOKENIZER_STATE_NONE;
@@ -157,9 +200,142 @@ bool SyntaxHighlighter::updateDirty( int visibleLinesCount ) {
 		}
 
 		mFirstInvalidLine = max + 1;
-		return changed;
 	}
-	return false;
+	if ( mThreadPool )
+		tokenizeAsync();
+	return mAsyncChanged.exchange( false ) || changed;
+}
+
+void SyntaxHighlighter::setThreadPool( const std::shared_ptr<ThreadPool>& pool ) {
+	if ( mThreadPool == pool )
+		return;
+	cancelAsync();
+	mThreadPool = pool;
+	mAsyncStop = false;
+}
+
+const std::shared_ptr<ThreadPool>& SyntaxHighlighter::getThreadPool() const {
+	return mThreadPool;
+}
+
+bool SyntaxHighlighter::isTokenizingAsync() const {
+	return mTokenizingAsync;
+}
+
+void SyntaxHighlighter::cancelAsync() {
+	if ( !mTokenizingAsync )
+		return;
+	mAsyncStop = true;
+	std::unique_lock<std::mutex> lock( mAsyncMutex );
+	if ( mThreadPool && mThreadPool->removeId( mAsyncJobId ) )
+		mTokenizingAsync = false;
+	mAsyncDone.wait( lock, [this] { return !mTokenizingAsync; } );
+	mAsyncStop = false;
+}
+
+void SyntaxHighlighter::tokenizeAsync() {
+	if ( mTokenizingAsync || mDoc->isLoading() ||
+		 mDoc->getSyntaxDefinition().getPatterns().empty() )
+		return;
+
+	Int64 linesCount = (Int64)mDoc->linesCount();
+	auto snapshot = std::make_shared<AsyncSnapshot>();
+	{
+		Lock l( mLinesMutex );
+		if ( mAsyncFirstInvalidLine >= linesCount )
+			return;
+		snapshot->version = mVersion;
+		snapshot->fromLine = mAsyncFirstInvalidLine;
+		snapshot->lastInvalidLine = mAsyncLastInvalidLine;
+		snapshot->tokenizedLine = mAsyncTokenizedLine;
+		if ( snapshot->fromLine > 0 ) {
+			auto prevIt = mLines.find( snapshot->fromLine - 1 );
+			if ( prevIt != mLines.end() )
+				snapshot->initState = prevIt->second.state;
+		}
+		Int64 toLine = eemin<Int64>( snapshot->fromLine + ASYNC_TOKENIZE_CHUNK_LINES, linesCount );
+		snapshot->lines.resize( toLine - snapshot->fromLine );
+		for ( Int64 i = snapshot->fromLine; i < toLine; ++i ) {
+			auto& line = snapshot->lines[i - snapshot->fromLine];
+			const auto& docLine = mDoc->line( i );
+			line.hash = docLine.getHash();
+			auto it = mLines.find( i );
+			if ( it != mLines.end() && it->second.hash == line.hash ) {
+				line.cached = true;
+				line.cachedInitState = it->second.initState;
+				line.cachedState = it->second.state;
+			}
+			line.text = docLine.toUtf8();
+		}
+	}
+
+	// The document syntax definition can be changed from the main thread at any time, so the
+	// background tokenizer works with its own copy.
+	if ( !mAsyncSyntaxDefinition || mAsyncSyntaxDefinition->getLanguageId() !=
+										mDoc->getSyntaxDefinition().getLanguageId() ) {
+		mAsyncSyntaxDefinition = std::make_shared<SyntaxDefinition>( mDoc->getSyntaxDefinition() );
+	}
+	snapshot->syntax = mAsyncSyntaxDefinition;
+
+	mTokenizingAsync = true;
+	mAsyncJobId = mThreadPool->run( [this, snapshot] {
+		std::vector<std::pair<size_t, TokenizedLine>> results;
+		Uint64 state = snapshot->initState;
+		Int64 convergedLine = -1;
+		auto converges = [&snapshot]( Int64 index ) {
+			return index > snapshot->lastInvalidLine && index < snapshot->tokenizedLine;
+		};
+		for ( size_t i = 0; i < snapshot->lines.size() && !mAsyncStop; ++i ) {
+			const auto& line = snapshot->lines[i];
+			Int64 index = snapshot->fromLine + i;
+			// Same input state and same content: the cached state is still valid. Past the
+			// invalidated lines the following ones were tokenized before and are unchanged too, so
+			// the propagation ends.
+			if ( line.cached && line.cachedInitState == state ) {
+				if ( converges( index ) ) {
+					convergedLine = index;
+					break;
+				}
+				state = line.cachedState;
+				continue;
+			}
+			TokenizedLine tokenizedLine;
+			tokenizedLine.initState = state;
+			tokenizedLine.hash = line.hash;
+			auto res = SyntaxTokenizer::tokenizePosition( *snapshot->syntax, line.text, state );
+			tokenizedLine.tokens = std::move( res.first );
+			tokenizedLine.state = res.second;
+			tokenizedLine.updateSignature();
+			state = tokenizedLine.state;
+			results.emplace_back( index, std::move( tokenizedLine ) );
+			if ( line.cached && state == line.cachedState && converges( index ) ) {
+				convergedLine = index + 1;
+				break;
+			}
+		}
+
+		if ( !mAsyncStop ) {
+			Lock l( mLinesMutex );
+			if ( snapshot->version == mVersion ) {
+				for ( auto& result : results )
+					mLines[result.first] = std::move( result.second );
+				if ( convergedLine != -1 ) {
+					// The lines after the converged one were already tokenized in the background
+					mAsyncFirstInvalidLine = eemax( convergedLine, mAsyncTokenizedLine );
+					mAsyncLastInvalidLine = -1;
+				} else {
+					mAsyncFirstInvalidLine = snapshot->fromLine + snapshot->lines.size();
+				}
+				mAsyncTokenizedLine = eemax( mAsyncTokenizedLine, mAsyncFirstInvalidLine );
+				if ( !results.empty() )
+					mAsyncChanged = true;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock( mAsyncMutex );
+		mTokenizingAsync = false;
+		mAsyncDone.notify_all();
+	} );
 }
 
 const SyntaxDefinition&
@@ -179,25 +355,28 @@ SyntaxHighlighter::getSyntaxDefinitionFromTextPosition( const TextPosition& posi
 	return *state.currentSyntax;
 }
 
-std::string SyntaxHighlighter::getTokenTypeAt( const TextPosition& pos ) {
+SyntaxStyleType SyntaxHighlighter::getTokenTypeAt( const TextPosition& pos ) {
 	if ( !pos.isValid() || pos.line() < 0 || pos.line() >= (Int64)mDoc->linesCount() )
-		return "normal";
-	auto tokens = getLine( pos.line() );
+		return SyntaxStyleTypes::Normal;
+	// The background tokenizer can replace the line while it's read
+	Lock l( mLinesMutex );
+	const auto& tokens = getLine( pos.line() );
 	if ( tokens.empty() )
-		return "normal";
+		return SyntaxStyleTypes::Normal;
 	Int64 col = 0;
 	for ( const auto& token : tokens ) {
 		col += token.len;
 		if ( col > pos.column() )
 			return token.type;
 	}
-	return "normal";
+	return SyntaxStyleTypes::Normal;
 }
 
 SyntaxTokenPosition SyntaxHighlighter::getTokenPositionAt( const TextPosition& pos ) {
 	if ( !pos.isValid() || pos.line() < 0 || pos.line() >= (Int64)mDoc->linesCount() )
 		return {};
-	auto tokens = getLine( pos.line() );
+	Lock l( mLinesMutex );
+	const auto& tokens = getLine( pos.line() );
 	if ( tokens.empty() )
 		return {};
 	Int64 col = 0;
@@ -31,10 +31,10 @@ static int isInMultiByteCodePoint( const char* text, const size_t& textSize, con
 }
 
 template <typename T>
-static void pushToken( std::vector<T>& tokens, const std::string& type, const std::string& text ) {
+static void pushToken( std::vector<T>& tokens, const SyntaxStyleType& type,
+					   const std::string& text ) {
 	if ( !tokens.empty() && ( tokens[tokens.size() - 1].type == type ) ) {
 		size_t tpos = tokens.size() - 1;
-		tokens[tpos].type = type;
 		if constexpr ( std::is_same_v<T, SyntaxTokenComplete> )
 			tokens[tpos].text += text;
 		tokens[tpos].len += String::utf8Length( text );
@@ -91,12 +91,11 @@ bool isScaped( const std::string& text, const size_t& startIndex, const std::str
 	return count % 2 == 1;
 }
 
-std::pair<int, int> findNonEscaped( const std::string& text, const std::string& pattern, int offset,
-									const std::string& escapeStr ) {
+std::pair<int, int> findNonEscaped( const std::string& text, const LuaCompiledPattern& pattern,
+									int offset, const std::string& escapeStr ) {
 	while ( true ) {
-		LuaPattern words( pattern );
 		int start, end;
-		if ( words.find( text, start, end, offset ) ) {
+		if ( pattern.find( text, start, end, offset ) ) {
 			if ( !escapeStr.empty() && isScaped( text, start, escapeStr ) ) {
 				offset = end;
 			} else {
@@ -148,7 +147,7 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 	size_t numMatches;
 
 	if ( syntax.getPatterns().empty() ) {
-		pushToken( tokens, "normal", text );
+		pushToken( tokens, SyntaxStyleTypes::Normal, text );
 		return std::make_pair( std::move( tokens ), SYNTAX_TOKENIZER_STATE_NONE );
 	}
 
@@ -184,14 +183,14 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 			const SyntaxPattern& pattern =
 				curState.currentSyntax->getPatterns()[curState.currentPatternIdx - 1];
 			std::pair<int, int> range =
-				findNonEscaped( text, pattern.patterns[1], i,
+				findNonEscaped( text, pattern.endPattern, i,
 								pattern.patterns.size() >= 3 ? pattern.patterns[2] : "" );
 
 			bool skip = false;
 
 			if ( curState.subsyntaxInfo != nullptr ) {
 				std::pair<int, int> rangeSubsyntax =
-					findNonEscaped( text, curState.subsyntaxInfo->patterns[1], i,
+					findNonEscaped( text, curState.subsyntaxInfo->endPattern, i,
 									curState.subsyntaxInfo->patterns.size() >= 3
 										? curState.subsyntaxInfo->patterns[2]
 										: "" );
@@ -199,7 +198,7 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 				if ( rangeSubsyntax.first != -1 &&
 					 ( range.first == -1 || rangeSubsyntax.first < range.first ) ) {
 					if ( !skipSubSyntaxSeparator ) {
-						pushToken( tokens, curState.subsyntaxInfo->types[0],
+						pushToken( tokens, curState.subsyntaxInfo->typesIds[0],
 								   text.substr( i, rangeSubsyntax.second - i ) );
 					}
 					popSubsyntax();
@@ -210,11 +209,11 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 
 			if ( !skip ) {
 				if ( range.first != -1 ) {
-					pushToken( tokens, pattern.types[0], text.substr( i, range.second - i ) );
+					pushToken( tokens, pattern.typesIds[0], text.substr( i, range.second - i ) );
 					setSubsyntaxPatternIdx( SYNTAX_TOKENIZER_STATE_NONE );
 					i = range.second;
 				} else {
-					pushToken( tokens, pattern.types[0], text.substr( i ) );
+					pushToken( tokens, pattern.typesIds[0], text.substr( i ) );
 					break;
 				}
 			}
@@ -222,13 +221,13 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 
 		if ( curState.subsyntaxInfo != nullptr ) {
 			std::pair<int, int> rangeSubsyntax = findNonEscaped(
-				text, "^" + curState.subsyntaxInfo->patterns[1], i,
+				text, curState.subsyntaxInfo->endAnchoredPattern, i,
 				curState.subsyntaxInfo->patterns.size() >= 3 ? curState.subsyntaxInfo->patterns[2]
 															 : "" );
 
 			if ( rangeSubsyntax.first != -1 ) {
 				if ( !skipSubSyntaxSeparator ) {
-					pushToken( tokens, curState.subsyntaxInfo->types[0],
+					pushToken( tokens, curState.subsyntaxInfo->typesIds[0],
 							   text.substr( i, rangeSubsyntax.second - i ) );
 				}
 				popSubsyntax();
@@ -243,16 +242,13 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 			const SyntaxPattern& pattern = curState.currentSyntax->getPatterns()[patternIndex];
 			if ( i != 0 && pattern.patterns[0][0] == '^' )
 				continue;
-			const std::string& patternStr(
-				pattern.patterns[0][0] == '^' ? pattern.patterns[0] : "^" + pattern.patterns[0] );
-			LuaPattern words( patternStr );
-			if ( words.matches( text, matches, i ) && ( numMatches = words.getNumMatches() ) > 0 ) {
+			if ( ( numMatches = pattern.startPattern.matches( text, matches, i ) ) > 0 ) {
 				if ( numMatches > 1 ) {
 					int patternMatchStart = matches[0].start;
 					int patternMatchEnd = matches[0].end;
 					std::string patternFullText(
 						text.substr( patternMatchStart, patternMatchEnd - patternMatchStart ) );
-					auto patternType = pattern.types[0];
+					SyntaxStyleType patternType = pattern.typesIds[0];
 					int lastStart = patternMatchStart;
 					int lastEnd = patternMatchEnd;
 
@@ -272,13 +268,14 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 						}
 
 						std::string patternText( text.substr( start, end - start ) );
-						std::string type = curState.currentSyntax->getSymbol( patternText );
+						SyntaxStyleType type = curState.currentSyntax->getSymbolType( patternText );
 						if ( !skipSubSyntaxSeparator || pattern.syntax.empty() ) {
 							pushToken( tokens,
-									   type.empty() ? ( curMatch < pattern.types.size()
-															? pattern.types[curMatch]
-															: pattern.types[0] )
-													: type,
+									   type == SyntaxStyleTypes::None
+										   ? ( curMatch < pattern.typesIds.size()
+												   ? pattern.typesIds[curMatch]
+												   : pattern.typesIds[0] )
+										   : type,
 									   patternText );
 						}
 
@@ -309,13 +306,14 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 							 text[i - 1] == pattern.patterns[2][0] )
 							continue;
 						std::string patternText( text.substr( start, end - start ) );
-						std::string type = curState.currentSyntax->getSymbol( patternText );
+						SyntaxStyleType type = curState.currentSyntax->getSymbolType( patternText );
 						if ( !skipSubSyntaxSeparator || pattern.syntax.empty() ) {
 							pushToken( tokens,
-									   type.empty() ? ( curMatch < pattern.types.size()
-															? pattern.types[curMatch]
-															: pattern.types[0] )
-													: type,
+									   type == SyntaxStyleTypes::None
+										   ? ( curMatch < pattern.typesIds.size()
+												   ? pattern.typesIds[curMatch]
+												   : pattern.typesIds[0] )
+										   : type,
 									   patternText );
 						}
 						if ( !pattern.syntax.empty() ) {
@@ -337,7 +335,7 @@ _tokenize( const SyntaxDefinition& syntax, const std::string& text, const Uint32
 			String::utf8Next( strEnd );
 			int dist = strEnd - strStart;
 			if ( dist > 0 ) {
-				pushToken( tokens, "normal", text.substr( i, dist ) );
+				pushToken( tokens, SyntaxStyleTypes::Normal, text.substr( i, dist ) );
 				i += dist;
 			} else {
 				Log::error( "Error parsing \"%s\" using syntax: %s", text.c_str(),
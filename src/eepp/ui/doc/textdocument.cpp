@@ -1,5 +1,6 @@
 ﻿#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <eepp/core/debug.hpp>
 #include <eepp/network/uri.hpp>
 #include <eepp/system/filesystem.hpp>
@@ -75,6 +76,7 @@ void TextDocument::reset() {
 	mLastSelection = 0;
 	mLines.clear();
 	mLines.emplace_back( String( "\n" ) );
+	mBuffer.reset();
 	mSyntaxDefinition = SyntaxDefinitionManager::instance()->getPlainStyle();
 	mUndoStack.clear();
 	cleanChangeId();
@@ -92,16 +94,61 @@ void TextDocument::resetCursor() {
 	notifySelectionChanged();
 }
 
-static String ptrGetLine( char* data, const size_t& size, size_t& position ) {
-	position = 0;
-	while ( position < size && data[position] != '\n' && data[position] != '\r' )
-		position++;
-	if ( position < size ) {
-		if ( position + 1 < size && data[position] == '\r' && data[position + 1] == '\n' )
-			position++;
-		position++;
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define EE_TEXT_DOCUMENT_SSE2
+#include <emmintrin.h>
+#ifdef EE_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#endif
+
+#define TEXT_DOCUMENT_MAPPED_FILE_MIN_SIZE ( EE_1MB * 16 )
+#define TEXT_DOCUMENT_INDEX_BLOCK_SIZE ( EE_1MB )
+
+static const char* findByte( const char* begin, const char* end, const char& byte ) {
+	const char* found = static_cast<const char*>( memchr( begin, byte, end - begin ) );
+	return found != nullptr ? found : end;
+}
+
+#ifdef EE_TEXT_DOCUMENT_SSE2
+static inline int firstBitSet( int mask ) {
+#ifdef EE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return static_cast<int>( index );
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+#endif
+
+/** Finds the line terminator and reports if the line only contains ASCII characters, in a single
+ * pass over the line. */
+static const char* findLineEnd( const char* begin, const char* end, const char& terminator,
+								bool& ascii ) {
+	const char* it = begin;
+	unsigned char high = 0;
+#ifdef EE_TEXT_DOCUMENT_SSE2
+	const __m128i needle = _mm_set1_epi8( terminator );
+	__m128i highBits = _mm_setzero_si128();
+	while ( end - it >= 16 ) {
+		__m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( it ) );
+		int found = _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, needle ) );
+		if ( found ) {
+			int pos = firstBitSet( found );
+			int highMask = _mm_movemask_epi8( chunk ) & ( ( 1 << pos ) - 1 );
+			ascii = !highMask && !_mm_movemask_epi8( highBits );
+			return it + pos;
+		}
+		highBits = _mm_or_si128( highBits, chunk );
+		it += 16;
 	}
-	return String( data, position );
+	high = _mm_movemask_epi8( highBits ) ? 0x80 : 0;
+#endif
+	while ( it < end && *it != terminator )
+		high |= static_cast<unsigned char>( *it++ );
+	ascii = high < 0x80;
+	return it;
 }
 
 TextDocument::LoadStatus TextDocument::loadFromStream( IOStream& file ) {
@@ -116,84 +163,27 @@ TextDocument::LoadStatus TextDocument::loadFromStream( IOStream& file, std::stri
 	if ( callReset )
 		reset();
 	mLines.clear();
+	mBuffer.reset();
 	if ( file.isOpen() ) {
 		const size_t BLOCK_SIZE = EE_1MB;
 		size_t total = file.getSize();
-		size_t pending = total;
-		size_t blockSize = eemin( total, BLOCK_SIZE );
+		std::string data;
+		data.resize( total );
 		size_t read = 0;
-		String lineBuffer;
-		size_t position;
-		int consume;
-		char* bufferPtr;
-		TScopedBuffer<char> data( blockSize );
-		while ( pending && mLoading ) {
-			read = file.read( data.get(), blockSize );
-			bufferPtr = data.get();
-			consume = read;
-
-			if ( pending == total ) {
-				// Check UTF-8 BOM header
-				if ( (char)0xef == data.get()[0] && (char)0xbb == data.get()[1] &&
-					 (char)0xbf == data.get()[2] ) {
-					bufferPtr += 3;
-					consume -= 3;
-					mIsBOM = true;
-				}
-			}
-
-			while ( consume && mLoading ) {
-				lineBuffer += ptrGetLine( bufferPtr, consume, position );
-				bufferPtr += position;
-				consume -= position;
-				size_t lineBufferSize = lineBuffer.size();
-				char lastChar = lineBuffer[lineBufferSize - 1];
-
-				if ( lastChar == '\n' || lastChar == '\r' || !consume ) {
-					if ( mLines.empty() ) {
-						if ( lineBufferSize > 1 && lineBuffer[lineBufferSize - 2] == '\r' &&
-							 lastChar == '\n' ) {
-							mLineEnding = LineEnding::CRLF;
-						} else if ( lastChar == '\r' ) {
-							mLineEnding = LineEnding::CR;
-						}
-
-						mMightBeBinary = lineBuffer.find_first_of( (String::StringBaseType)'\0' ) !=
-										 String::InvalidPos;
-					}
-
-					if ( mLineEnding == LineEnding::CRLF && lineBufferSize > 1 &&
-						 lastChar == '\n' ) {
-						lineBuffer[lineBuffer.size() - 2] = '\n';
-						lineBuffer.resize( lineBufferSize - 1 );
-					} else if ( mLineEnding == LineEnding::CR && lineBufferSize > 0 ) {
-						lineBuffer[lineBuffer.size() - 1] = '\n';
-					}
-
-					mLines.push_back( lineBuffer );
-					lineBuffer.resize( 0 );
-				}
-
-				if ( consume < 0 ) {
-					eeASSERT( !consume );
-					break;
-				}
-			}
-
-			if ( !mLines.empty() ) {
-				const String& lastLine = mLines[mLines.size() - 1].getText();
-				if ( lastLine[lastLine.size() - 1] == '\n' ) {
-					mLines.push_back( String( "\n" ) );
-				} else {
-					mLines[mLines.size() - 1].append( "\n" );
-				}
-			}
-
-			if ( !read )
+		while ( read < total && mLoading ) {
+			size_t blockRead = file.read( &data[read], eemin( total - read, BLOCK_SIZE ) );
+			if ( !blockRead )
 				break;
-			pending -= read;
-			blockSize = eemin( pending, BLOCK_SIZE );
-		};
+			read += blockRead;
+		}
+		data.resize( read );
+
+		// The lines are not decoded, they reference the original UTF-8 buffer until they are
+		// used or modified.
+		mBuffer = std::make_shared<TextDocumentBuffer>( std::move( data ) );
+		initBufferIndexing();
+		while ( mLoading && !indexBufferLines( TEXT_DOCUMENT_INDEX_BLOCK_SIZE ) ) {
+		}
 	}
 
 	if ( mLines.empty() )
@@ -214,6 +204,118 @@ TextDocument::LoadStatus TextDocument::loadFromStream( IOStream& file, std::stri
 						  : ( file.isOpen() ? LoadStatus::Loaded : LoadStatus::Failed );
 }
 
+TextDocument::LoadStatus TextDocument::loadFromMappedFile( const std::string& path ) {
+	auto mappedFile = std::make_shared<MemoryMappedFile>( path );
+	if ( !mappedFile->isOpen() ) {
+		IOStreamFile file( path, "rb" );
+		return loadFromStream( file, path, true );
+	}
+
+	mLoading = true;
+	Lock l( mLoadingMutex );
+	Clock clock;
+	reset();
+	mLines.clear();
+	mappedFile->adviseSequential();
+	mBuffer = std::make_shared<TextDocumentBuffer>( std::move( mappedFile ) );
+	initBufferIndexing();
+
+	// All the lines are indexed before the document is published, the newline scan is cheap and
+	// the lines are only decoded when they are used.
+	while ( mLoading && !indexBufferLines( TEXT_DOCUMENT_INDEX_BLOCK_SIZE ) ) {
+	}
+
+	if ( mAutoDetectIndentType )
+		guessIndentType();
+
+	if ( mVerbose )
+		Log::info( "Document \"%s\" mapped in %.2fms.", path.c_str(),
+				   clock.getElapsedTime().asMilliseconds() );
+
+	bool wasInterrupted = !mLoading;
+	if ( wasInterrupted )
+		reset();
+	mLoading = false;
+	return wasInterrupted ? LoadStatus::Interrupted : LoadStatus::Loaded;
+}
+
+void TextDocument::initBufferIndexing() {
+	const char* data = mBuffer->getData();
+	const char* end = data + mBuffer->getSize();
+	mIndexingOffset = 0;
+
+	// Check UTF-8 BOM header
+	if ( end - data >= 3 && (char)0xef == data[0] && (char)0xbb == data[1] &&
+		 (char)0xbf == data[2] ) {
+		mIndexingOffset = 3;
+		mIsBOM = true;
+	}
+
+	const char* lineStart = data + mIndexingOffset;
+	const char* firstLF = findByte( lineStart, end, '\n' );
+	const char* firstCR = findByte( lineStart, firstLF, '\r' );
+	if ( firstCR < firstLF )
+		mLineEnding = firstCR + 1 == firstLF ? LineEnding::CRLF : LineEnding::CR;
+
+	const char* firstLineEnd = eemin( firstLF, firstCR );
+	mMightBeBinary = findByte( lineStart, firstLineEnd, '\0' ) != firstLineEnd;
+}
+
+bool TextDocument::indexBufferLines( size_t maxBytes ) {
+	const char* lineStart = mBuffer->getData() + mIndexingOffset;
+	const char* end = mBuffer->getData() + mBuffer->getSize();
+	const char* limit =
+		maxBytes < static_cast<size_t>( end - lineStart ) ? lineStart + maxBytes : end;
+	bool ascii;
+
+	if ( mLineEnding == LineEnding::CR ) {
+		// Any of \r, \r\n or \n ends a line.
+		while ( true ) {
+			const char* lineEnd = findByte( lineStart, findByte( lineStart, end, '\r' ), '\n' );
+			if ( lineEnd == end ) {
+				mLines.emplace_back( lineStart, end - lineStart );
+				mIndexingOffset = end - mBuffer->getData();
+				return true;
+			}
+			mLines.emplace_back( lineStart, lineEnd - lineStart );
+			lineStart = lineEnd + ( *lineEnd == '\r' && lineEnd + 1 < end && lineEnd[1] == '\n' ? 2
+																								  : 1 );
+			if ( lineStart >= limit )
+				break;
+		}
+	} else {
+		while ( true ) {
+			const char* lineEnd = findLineEnd( lineStart, end, '\n', ascii );
+			if ( lineEnd == end ) {
+				// The last line is always present, even if it's empty.
+				mLines.emplace_back( lineStart, end - lineStart, ascii );
+				mIndexingOffset = end - mBuffer->getData();
+				return true;
+			}
+			size_t lineSize = lineEnd - lineStart;
+			if ( mLineEnding == LineEnding::CRLF && lineSize > 0 && lineEnd[-1] == '\r' )
+				lineSize--;
+			mLines.emplace_back( lineStart, lineSize, ascii );
+			lineStart = lineEnd + 1;
+			if ( lineStart >= limit )
+				break;
+		}
+	}
+
+	mIndexingOffset = lineStart - mBuffer->getData();
+	return false;
+}
+
+void TextDocument::releaseMappedBuffer() {
+	if ( !mBuffer || !mBuffer->isMapped() )
+		return;
+	auto buffer = std::make_shared<TextDocumentBuffer>(
+		std::string( mBuffer->getData(), mBuffer->getSize() ) );
+	for ( auto& line : mLines )
+		line.moveBuffer( mBuffer->getData(), buffer->getData() );
+	mBuffer = std::move( buffer );
+}
+
 void TextDocument::guessIndentType() {
 	int guessSpaces = 0;
 	int guessTabs = 0;
@@ -374,8 +476,13 @@ TextDocument::LoadStatus TextDocument::loadFromFile( const std::string& path ) {
 		}
 	}
 
-	IOStreamFile file( path, "rb" );
-	auto ret = loadFromStream( file, path, true );
+	LoadStatus ret;
+	if ( FileSystem::fileSize( path ) >= TEXT_DOCUMENT_MAPPED_FILE_MIN_SIZE ) {
+		ret = loadFromMappedFile( path );
+	} else {
+		IOStreamFile file( path, "rb" );
+		ret = loadFromStream( file, path, true );
+	}
 	mFilePath = path;
 	mFileURI = URI( "file://" + mFilePath );
 	mFileRealPath = FileInfo::isLink( mFilePath ) ? FileInfo( FileInfo( mFilePath ).linksTo() )
@@ -518,6 +625,8 @@ bool TextDocument::save( const std::string& path ) {
 	if ( path.empty() || mDefaultFileName == path )
 		return false;
 	if ( FileSystem::fileCanWrite( FileSystem::fileRemoveFileName( path ) ) ) {
+		// Truncating the mapped file would invalidate the lines that weren't written yet
+		releaseMappedBuffer();
 		IOStreamFile file( path, "wb" );
 		std::string oldFilePath( mFilePath );
 		URI oldFileURI( mFileURI );
@@ -2085,28 +2194,30 @@ TextRange TextDocument::findText( String text, TextPosition from, bool caseSensi
 	if ( !caseSensitive )
 		text.toLower();
 
+	// Lines not loaded yet are decoded in a scratch buffer, a search doesn't load the document
+	String lineBuffer;
 	for ( Int64 i = from.line(); i <= to.line(); i++ ) {
+		const String& lineText = line( i ).getText( lineBuffer );
 		std::pair<size_t, size_t> col;
 		if ( i == from.line() ) {
 			col = caseSensitive
-					  ? findType( line( i ).getText().substr( from.column() ), text, type )
-					  : findType( String::toLower( line( i ).getText() ).substr( from.column() ),
-								  text, type );
+					  ? findType( lineText.substr( from.column() ), text, type )
+					  : findType( String::toLower( lineText ).substr( from.column() ), text, type );
 			if ( String::StringType::npos != col.first ) {
 				col.first += from.column();
 				col.second += from.column();
 			}
 		} else if ( i == to.line() && to != endOfDoc() ) {
 			col = caseSensitive
-					  ? findType( line( i ).getText().substr( 0, to.column() ), text, type )
-					  : findType( String::toLower( line( i ).getText() ).substr( 0, to.column() ),
-								  text, type );
+					  ? findType( lineText.substr( 0, to.column() ), text, type )
+					  : findType( String::toLower( lineText ).substr( 0, to.column() ), text,
+								  type );
 		} else {
-			col = caseSensitive ? findType( line( i ).getText(), text, type )
-								: findType( String::toLower( line( i ).getText() ), text, type );
+			col = caseSensitive ? findType( lineText, text, type )
+								: findType( String::toLower( lineText ), text, type );
 		}
 		if ( String::StringType::npos != col.first &&
-			 ( !wholeWord || String::isWholeWord( line( i ).getText(), text, col.first ) ) ) {
+			 ( !wholeWord || String::isWholeWord( lineText, text, col.first ) ) ) {
 			TextRange pos( { { (Int64)i, (Int64)col.first }, { (Int64)i, (Int64)col.second } } );
 			if ( pos.end().column() == (Int64)mLines[pos.end().line()].size() )
 				pos.setEnd( positionOffset( pos.end(), 1 ) );
@@ -2138,30 +2249,31 @@ TextRange TextDocument::findTextLast( String text, TextPosition from, bool caseS
 	if ( !caseSensitive )
 		text.toLower();
 
+	// Lines not loaded yet are decoded in a scratch buffer, a search doesn't load the document
+	String lineBuffer;
 	for ( Int64 i = from.line(); i >= to.line(); i-- ) {
+		const String& lineText = line( i ).getText( lineBuffer );
 		std::pair<size_t, size_t> col;
 		if ( i == from.line() ) {
 			col = caseSensitive
-					  ? findLastType( line( i ).getText().substr( 0, from.column() ), text, type )
-					  : findLastType(
-							String::toLower( line( i ).getText().substr( 0, from.column() ) ), text,
-							type );
+					  ? findLastType( lineText.substr( 0, from.column() ), text, type )
+					  : findLastType( String::toLower( lineText.substr( 0, from.column() ) ), text,
+									  type );
 		} else if ( i == to.line() ) {
 			col = caseSensitive
-					  ? findLastType( line( i ).getText().substr( to.column() ), text, type )
-					  : findLastType( String::toLower( line( i ).getText().substr( to.column() ) ),
+					  ? findLastType( lineText.substr( to.column() ), text, type )
+					  : findLastType( String::toLower( lineText.substr( to.column() ) ),
 									  text, type );
 			if ( String::StringType::npos != col.first ) {
 				col.first += to.column();
 				col.second += to.column();
 			}
 		} else {
-			col = caseSensitive
-					  ? findLastType( line( i ).getText(), text, type )
-					  : findLastType( String::toLower( line( i ).getText() ), text, type );
+			col = caseSensitive ? findLastType( lineText, text, type )
+								: findLastType( String::toLower( lineText ), text, type );
 		}
 		if ( String::StringType::npos != col.first &&
-			 ( !wholeWord || String::isWholeWord( line( i ).getText(), text, col.first ) ) ) {
+			 ( !wholeWord || String::isWholeWord( lineText, text, col.first ) ) ) {
 			TextRange pos( { { (Int64)i, (Int64)col.second }, { (Int64)i, (Int64)col.first } } );
 			if ( pos.start().column() == (Int64)mLines[pos.start().line()].size() )
 				pos.setStart( positionOffset( pos.start(), 1 ) );
@@ -2201,12 +2313,13 @@ TextRange TextDocument::find( const String& text, TextPosition from, bool caseSe
 		return TextRange();
 
 	TextPosition initPos( range.end().line(), 0 );
+	String lineBuffer;
 
 	for ( size_t i = 1; i < textLines.size() - 1; i++ ) {
 		if ( initPos < from || initPos > to )
 			return find( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
 
-		String currentLine( mLines[initPos.line()].getText() );
+		String currentLine( mLines[initPos.line()].getText( lineBuffer ) );
 
 		if ( TextPosition( initPos.line(), (Int64)currentLine.size() - 1 ) > to )
 			return find( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
@@ -2229,7 +2342,7 @@ TextRange TextDocument::find( const String& text, TextPosition from, bool caseSe
 	if ( initPos < from || initPos > to )
 		return find( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
 
-	const String& lastLine = mLines[initPos.line()].getText();
+	const String& lastLine = mLines[initPos.line()].getText( lineBuffer );
 	const String& curSearch = textLines[textLines.size() - 1];
 
 	if ( TextPosition( initPos.line(), (Int64)curSearch.size() - 1 ) > to )
@@ -2282,12 +2395,13 @@ TextRange TextDocument::findLast( const String& text, TextPosition from, bool ca
 		return TextRange();
 
 	TextPosition initPos( range.end().line(), 0 );
+	String lineBuffer;
 
 	for ( size_t i = 1; i < textLines.size() - 1; i++ ) {
 		if ( initPos < from || initPos > to )
 			return findLast( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
 
-		String currentLine( mLines[initPos.line()].getText() );
+		String currentLine( mLines[initPos.line()].getText( lineBuffer ) );
 
 		if ( TextPosition( initPos.line(), (Int64)currentLine.size() - 1 ) > to )
 			return findLast( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
@@ -2307,7 +2421,7 @@ TextRange TextDocument::findLast( const String& text, TextPosition from, bool ca
 	if ( initPos < from || initPos > to )
 		return findLast( text, range.end(), caseSensitive, wholeWord, type, restrictRange );
 
-	const String& lastLine = mLines[initPos.line()].getText();
+	const String& lastLine = mLines[initPos.line()].getText( lineBuffer );
 	const String& curSearch = textLines[textLines.size() - 1];
 
 	if ( TextPosition( initPos.line(), (Int64)curSearch.size() - 1 ) > to )
@@ -2441,7 +2555,7 @@ TextPosition TextDocument::getMatchingBracket( TextPosition sp,
 		if ( byte == openBracket ) {
 			if ( highlighter ) {
 				auto type = highlighter->getTokenTypeAt( sp );
-				if ( type != "comment" && type != "string" )
+				if ( type != SyntaxStyleTypes::Comment && type != SyntaxStyleTypes::String )
 					depth++;
 			} else {
 				depth++;
@@ -2452,7 +2566,7 @@ TextPosition TextDocument::getMatchingBracket( TextPosition sp,
 		} else if ( byte == closeBracket ) {
 			if ( highlighter ) {
 				auto type = highlighter->getTokenTypeAt( sp );
-				if ( type != "comment" && type != "string" )
+				if ( type != SyntaxStyleTypes::Comment && type != SyntaxStyleTypes::String )
 					depth--;
 			} else {
 				depth--;
@@ -0,0 +1,24 @@
+#include <eepp/ui/doc/textdocumentbuffer.hpp>
+
+namespace EE { namespace UI { namespace Doc {
+
+TextDocumentBuffer::TextDocumentBuffer( std::string&& data ) : mData( std::move( data ) ) {}
+
+TextDocumentBuffer::TextDocumentBuffer( std::shared_ptr<MemoryMappedFile> mappedFile ) :
+	mMappedFile( std::move( mappedFile ) ) {}
+
+const char* TextDocumentBuffer::getData() const {
+	// An empty mapping has no data, but the lines always need a valid pointer.
+	return mMappedFile && mMappedFile->getData() != nullptr ? mMappedFile->getData()
+															: mData.data();
+}
+
+size_t TextDocumentBuffer::getSize() const {
+	return mMappedFile ? mMappedFile->getSize() : mData.size();
+}
+
+bool TextDocumentBuffer::isMapped() const {
+	return mMappedFile != nullptr;
+}
+
+}}} // namespace EE::UI::Doc
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <eepp/core/utf.hpp>
+#include <eepp/system/lock.hpp>
+#include <eepp/system/mutex.hpp>
+#include <eepp/ui/doc/textdocumentline.hpp>
+
+using namespace EE::System;
+
+namespace EE { namespace UI { namespace Doc {
+
+static Mutex& materializeMutex() {
+	static Mutex mutex;
+	return mutex;
+}
+
+static bool isAscii( const char* data, const size_t& size ) {
+	unsigned char acc = 0;
+	for ( size_t i = 0; i < size; ++i )
+		acc |= static_cast<unsigned char>( data[i] );
+	return acc < 0x80;
+}
+
+static String decodeLine( const char* data, const size_t& size ) {
+	String text( data, size );
+	text.append( '\n' );
+	return text;
+}
+
+static String::HashType nonZeroHash( const String::HashType& hash ) {
+	// 0 is reserved to flag that the hash was not computed yet.
+	return hash != 0 ? hash : 1;
+}
+
+TextDocumentLine::TextDocumentLine( const char* data, const size_t& size ) :
+	TextDocumentLine( data, size, isAscii( data, size ) ) {}
+
+TextDocumentLine::TextDocumentLine( const char* data, const size_t& size, bool ascii ) :
+	mData( data ), mSize( size ), mAscii( ascii ) {
+	// The line length includes the new line character appended to every document line.
+	mLength = ( mAscii ? size : Utf8::count( data, data + size ) ) + 1;
+}
+
+TextDocumentLine::TextDocumentLine( const TextDocumentLine& other ) :
+	mData( other.mData.load( std::memory_order_acquire ) ),
+	mSize( other.mSize ),
+	mLength( other.mLength ),
+	mHash( other.mHash.load( std::memory_order_relaxed ) ),
+	mAscii( other.mAscii ) {
+	if ( mData == nullptr )
+		mText = other.mText;
+}
+
+TextDocumentLine::TextDocumentLine( TextDocumentLine&& other ) noexcept :
+	mText( std::move( other.mText ) ),
+	mData( other.mData.load( std::memory_order_acquire ) ),
+	mSize( other.mSize ),
+	mLength( other.mLength ),
+	mHash( other.mHash.load( std::memory_order_relaxed ) ),
+	mAscii( other.mAscii ) {}
+
+TextDocumentLine& TextDocumentLine::operator=( const TextDocumentLine& other ) {
+	if ( this == &other )
+		return *this;
+	const char* data = other.mData.load( std::memory_order_acquire );
+	mText = data == nullptr ? other.mText : String();
+	mData.store( data, std::memory_order_release );
+	mSize = other.mSize;
+	mLength = other.mLength;
+	mHash.store( other.mHash.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+	mAscii = other.mAscii;
+	return *this;
+}
+
+TextDocumentLine& TextDocumentLine::operator=( TextDocumentLine&& other ) noexcept {
+	if ( this == &other )
+		return *this;
+	mText = std::move( other.mText );
+	mData.store( other.mData.load( std::memory_order_acquire ), std::memory_order_release );
+	mSize = other.mSize;
+	mLength = other.mLength;
+	mHash.store( other.mHash.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+	mAscii = other.mAscii;
+	return *this;
+}
+
+const String& TextDocumentLine::getText( String& buffer ) const {
+	const char* data = mData.load( std::memory_order_acquire );
+	if ( data == nullptr )
+		return mText;
+	buffer.clear();
+	buffer.reserve( mLength );
+	const char* end = data + mSize;
+	while ( data < end ) {
+		Uint32 codepoint;
+		data = Utf8::decode( data, end, codepoint );
+		buffer.push_back( codepoint );
+	}
+	buffer.push_back( '\n' );
+	return buffer;
+}
+
+size_t TextDocumentLine::count( const char& ch ) const {
+	const char* data = mData.load( std::memory_order_acquire );
+	if ( data != nullptr && mAscii )
+		return std::count( data, data + mSize, ch ) + ( ch == '\n' ? 1 : 0 );
+	const String& text = getText();
+	return std::count( text.begin(), text.end(), static_cast<String::StringBaseType>( ch ) );
+}
+
+String::HashType TextDocumentLine::getHash() const {
+	String::HashType hash = mHash.load( std::memory_order_relaxed );
+	if ( hash != 0 )
+		return hash;
+	// Unmodified lines compute their hash on demand, without keeping the decoded text.
+	const char* data = mData.load( std::memory_order_acquire );
+	hash = nonZeroHash( data != nullptr ? decodeLine( data, mSize ).getHash() : mText.getHash() );
+	mHash.store( hash, std::memory_order_relaxed );
+	return hash;
+}
+
+std::string TextDocumentLine::toUtf8() const {
+	const char* data = mData.load( std::memory_order_acquire );
+	if ( data == nullptr )
+		return mText.toUtf8();
+	if ( !mAscii )
+		return decodeLine( data, mSize ).toUtf8();
+	std::string text;
+	text.reserve( mSize + 1 );
+	text.append( data, mSize );
+	text.push_back( '\n' );
+	return text;
+}
+
+void TextDocumentLine::moveBuffer( const char* buffer, const char* newBuffer ) {
+	// Another thread could be loading the line
+	Lock l( materializeMutex() );
+	const char* data = mData.load( std::memory_order_relaxed );
+	if ( data != nullptr )
+		mData.store( newBuffer + ( data - buffer ), std::memory_order_release );
+}
+
+void TextDocumentLine::materialize() const {
+	if ( mData.load( std::memory_order_acquire ) == nullptr )
+		return;
+	Lock l( materializeMutex() );
+	const char* data = mData.load( std::memory_order_relaxed );
+	if ( data == nullptr )
+		return;
+	mText = decodeLine( data, mSize );
+	mData.store( nullptr, std::memory_order_release );
+}
+
+void TextDocumentLine::updateHash() {
+	mHash.store( nonZeroHash( mText.getHash() ), std::memory_order_relaxed );
+}
+
+}}} // namespace EE::UI::Doc
@@ -1,15 +1,19 @@
 #include <eepp/scene/scenemanager.hpp>
+#include <eepp/system/directorywalker.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/sys.hpp>
 #include <eepp/ui/abstract/uiabstractview.hpp>
 #include <eepp/ui/models/filesystemmodel.hpp>
 #include <eepp/ui/uiiconthememanager.hpp>
 #include <eepp/ui/uiscenenode.hpp>
+#include <eepp/window/engine.hpp>
 
 #ifndef INDEX_ALREADY_EXISTS
 #define INDEX_ALREADY_EXISTS eeINDEX_NOT_FOUND
 #endif
 
+#define FILE_SYSTEM_MODEL_PARALLEL_MIN_FILES ( 256 )
+
 using namespace EE::Scene;
 
 namespace EE { namespace UI { namespace Models {
@@ -135,6 +139,55 @@ FileSystemModel::Node* FileSystemModel::Node::childWithPathExists( const std::st
 	return nullptr;
 }
 
+/** Same as FileSystem::filesInfoGetInPath, but the file information of big directories is read
+ * in parallel when it's not called from the main thread. */
+static std::vector<FileInfo> getDirectoryFiles( std::string path, const FileSystemModel& model ) {
+	const auto& displayCfg = model.getDisplayConfig();
+	std::vector<DirectoryWalker::Entry> entries;
+	FileSystem::dirAddSlashAtEnd( path );
+	DirectoryWalker::list( path, entries );
+
+	if ( displayCfg.ignoreHidden ) {
+		entries.erase( std::remove_if( entries.begin(), entries.end(),
+									   [&path]( const DirectoryWalker::Entry& entry ) {
+										   return FileSystem::fileIsHidden( path + entry.name );
+									   } ),
+					   entries.end() );
+	}
+
+	if ( displayCfg.sortByName ) {
+		std::sort( entries.begin(), entries.end(),
+				   []( const DirectoryWalker::Entry& left, const DirectoryWalker::Entry& right ) {
+					   return left.name < right.name;
+				   } );
+	}
+
+	if ( displayCfg.foldersFirst ) {
+		std::stable_partition(
+			entries.begin(), entries.end(),
+			[]( const DirectoryWalker::Entry& entry ) { return entry.isDirectory; } );
+	}
+
+	std::vector<FileInfo> files( entries.size() );
+	auto getInfo = [&]( size_t from, size_t to ) {
+		for ( size_t i = from; i < to; i++ )
+			files[i] = FileInfo( path + entries[i].name, false );
+	};
+
+	// The main thread reads them serially, it can't wait for the pool workers while they are
+	// busy with other jobs ( like scanning the project tree )
+	ThreadPool* pool = model.getThreadPool().get();
+	bool isMainThread = NULL != Engine::existsSingleton() && Engine::instance()->isMainThread();
+	if ( pool && !isMainThread && entries.size() >= FILE_SYSTEM_MODEL_PARALLEL_MIN_FILES ) {
+		pool->parallelFor( 0, entries.size(), getInfo, ThreadPool::Priority::High,
+						   FILE_SYSTEM_MODEL_PARALLEL_MIN_FILES / 4 );
+	} else {
+		getInfo( 0, entries.size() );
+	}
+
+	return files;
+}
+
 static bool isAcceptedExtension( const std::vector<std::string>& acceptedExtensions,
 								 const FileInfo& file ) {
 	if ( !acceptedExtensions.empty() && file.isRegularFile() ) {
@@ -154,8 +207,7 @@ void FileSystemModel::Node::refresh( const FileSystemModel& model ) {
 
 	const auto& displayCfg = model.getDisplayConfig();
 
-	auto files = FileSystem::filesInfoGetInPath( mInfo.getFilepath(), false, displayCfg.sortByName,
-												 displayCfg.foldersFirst, displayCfg.ignoreHidden );
+	auto files = getDirectoryFiles( mInfo.getFilepath(), model );
 
 	std::vector<Node*> newChildren;
 	Node* node = nullptr;
@@ -203,8 +255,7 @@ void FileSystemModel::Node::traverseIfNeeded( const FileSystemModel& model ) {
 
 	const auto& displayCfg = model.getDisplayConfig();
 
-	auto files = FileSystem::filesInfoGetInPath( mInfo.getFilepath(), false, displayCfg.sortByName,
-												 displayCfg.foldersFirst, displayCfg.ignoreHidden );
+	auto files = getDirectoryFiles( mInfo.getFilepath(), model );
 
 	const auto& patterns = displayCfg.acceptedExtensions;
 	bool accepted;
@@ -267,16 +318,20 @@ void FileSystemModel::Node::updateMimeType() {
 
 std::shared_ptr<FileSystemModel> FileSystemModel::New( const std::string& rootPath,
 													   const FileSystemModel::Mode& mode,
-													   const DisplayConfig& displayConfig ) {
-	return std::shared_ptr<FileSystemModel>( new FileSystemModel( rootPath, mode, displayConfig ) );
+													   const DisplayConfig& displayConfig,
+													   std::shared_ptr<ThreadPool> threadPool ) {
+	return std::shared_ptr<FileSystemModel>(
+		new FileSystemModel( rootPath, mode, displayConfig, threadPool ) );
 }
 
 FileSystemModel::FileSystemModel( const std::string& rootPath, const FileSystemModel::Mode& mode,
-								  const DisplayConfig& displayConfig ) :
+								  const DisplayConfig& displayConfig,
+								  std::shared_ptr<ThreadPool> threadPool ) :
 	mRootPath( rootPath ),
 	mRealRootPath( FileSystem::getRealPath( rootPath ) ),
 	mMode( mode ),
-	mDisplayConfig( displayConfig ) {
+	mDisplayConfig( displayConfig ),
+	mThreadPool( threadPool ) {
 	mRoot = std::make_unique<Node>( mRootPath, *this );
 	mInitOK = true;
 	onModelUpdate();
@@ -516,6 +571,10 @@ const FileSystemModel::DisplayConfig& FileSystemModel::getDisplayConfig() const
 	return mDisplayConfig;
 }
 
+const std::shared_ptr<ThreadPool>& FileSystemModel::getThreadPool() const {
+	return mThreadPool;
+}
+
 void FileSystemModel::setDisplayConfig( const DisplayConfig& displayConfig ) {
 	if ( mDisplayConfig != displayConfig ) {
 		mDisplayConfig = displayConfig;
@@ -1430,7 +1430,9 @@ Float UICodeEditor::getLineWidth( const Int64& lineIndex ) {
 		return Text::getTextWidth( mFont, getCharacterSize(), mDoc->line( lineIndex ).getText(),
 								   mFontStyleConfig.Style, mTabWidth ) +
 			   getGlyphWidth();
-	return getTextWidth( mDoc->line( lineIndex ).getText() );
+	// Monospace widths only need the line length and its tabs, the line is not decoded.
+	const TextDocumentLine& line = mDoc->line( lineIndex );
+	return getGlyphWidth() * ( line.size() + line.count( '\t' ) * ( mTabWidth - 1 ) );
 }
 
 void UICodeEditor::updateScrollBar() {
@@ -2763,8 +2765,8 @@ void UICodeEditor::drawLineText( const Int64& line, Vector2f position, const Flo
 
 						SyntaxColorScheme::Style linkStyle = style;
 
-						if ( mColorScheme.hasSyntaxStyle( "link_hover" ) ) {
-							linkStyle = mColorScheme.getSyntaxStyle( "link_hover" );
+						if ( mColorScheme.hasSyntaxStyle( SyntaxStyleTypes::LinkHover ) ) {
+							linkStyle = mColorScheme.getSyntaxStyle( SyntaxStyleTypes::LinkHover );
 							if ( linkStyle.color != Color::Transparent )
 								txt.setColor( Color( linkStyle.color ).blendAlpha( mAlpha ) );
 							txt.setStyle( linkStyle.style );
@@ -3276,14 +3278,14 @@ void UICodeEditor::drawMinimap( const Vector2f& start,
 
 	Float gutterWidth = PixelDensity::dpToPx( mMinimapConfig.gutterWidth );
 	Float lineY = rect.Top;
-	Color color = mColorScheme.getSyntaxStyle( "normal" ).color;
+	Color color = mColorScheme.getSyntaxStyle( SyntaxStyleTypes::Normal ).color;
 	color.a *= 0.5f;
 	Float batchWidth = 0;
 	Float batchStart = rect.Left;
 	Float minimapCutoffX = rect.Left + rect.getWidth();
-	std::string batchSyntaxType = "normal";
+	SyntaxStyleType batchSyntaxType = SyntaxStyleTypes::Normal;
 	Float widthScale = charSpacing / getGlyphWidth();
-	auto flushBatch = [&]( const std::string& type ) {
+	auto flushBatch = [&]( const SyntaxStyleType& type ) {
 		Color oldColor = color;
 		color = mColorScheme.getSyntaxStyle( batchSyntaxType ).color;
 		if ( mMinimapConfig.syntaxHighlight && color != Color::Transparent ) {
@@ -3411,7 +3413,7 @@ void UICodeEditor::drawMinimap( const Vector2f& start,
 
 	if ( mMinimapConfig.syntaxHighlight ) {
 		for ( int index = minimapStartLine; index <= endidx; index++ ) {
-			batchSyntaxType = "normal";
+			batchSyntaxType = SyntaxStyleTypes::Normal;
 			batchStart = rect.Left + gutterWidth;
 			batchWidth = 0;
 
@@ -3456,7 +3458,7 @@ void UICodeEditor::drawMinimap( const Vector2f& start,
 				txtPos += token.len;
 			}
 
-			flushBatch( "normal" );
+			flushBatch( SyntaxStyleTypes::Normal );
 
 			for ( auto* plugin : mPlugins )
 				plugin->minimapDrawAfterLineText( this, index, { rect.Left, lineY },
@@ -3480,7 +3482,7 @@ void UICodeEditor::drawMinimap( const Vector2f& start,
 		}
 	} else {
 		for ( int index = minimapStartLine; index <= endidx; index++ ) {
-			batchSyntaxType = "normal";
+			batchSyntaxType = SyntaxStyleTypes::Normal;
 			batchStart = rect.Left + gutterWidth;
 			batchWidth = 0;
 
@@ -3491,19 +3493,19 @@ void UICodeEditor::drawMinimap( const Vector2f& start,
 			for ( size_t i = 0; i < text.size(); ++i ) {
 				String::StringBaseType ch = text[i];
 				if ( ch == ' ' || ch == '\n' ) {
-					flushBatch( "normal" );
+					flushBatch( SyntaxStyleTypes::Normal );
 					batchStart += charSpacing;
 				} else if ( ch == '\t' ) {
-					flushBatch( "normal" );
+					flushBatch( SyntaxStyleTypes::Normal );
 					batchStart += charSpacing * mMinimapConfig.tabWidth;
 				} else if ( batchStart + batchWidth > minimapCutoffX ) {
-					flushBatch( "normal" );
+					flushBatch( SyntaxStyleTypes::Normal );
 					break;
 				} else {
 					batchWidth += charSpacing;
 				}
 			}
-			flushBatch( "normal" );
+			flushBatch( SyntaxStyleTypes::Normal );
 			lineY = lineY + lineSpacing;
 		}
 	}
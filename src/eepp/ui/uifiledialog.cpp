@@ -316,9 +316,6 @@ void UIFileDialog::refreshFolder( bool resetScroll ) {
 		mMultiView->getTableView()->setColumnsVisible( { FileSystemModel::Name } );
 		mMultiView->setModel( SortingProxyModel::New( mDiskDrivesModel ) );
 	} else {
-		std::vector<String> flist = FileSystem::filesGetInPath(
-			String( mCurPath ), getSortAlphabetically(), getFoldersFirst(), !getShowHidden() );
-		std::vector<String> files;
 		std::vector<std::string> patterns;
 
 		if ( "*" != mFiletype->getText() ) {
@@ -334,7 +331,8 @@ void UIFileDialog::refreshFolder( bool resetScroll ) {
 				getShowOnlyFolders() ? FileSystemModel::Mode::DirectoriesOnly
 									 : FileSystemModel::Mode::FilesAndDirectories,
 				FileSystemModel::DisplayConfig( getSortAlphabetically(), getFoldersFirst(),
-												!getShowHidden(), patterns ) );
+												!getShowHidden(), patterns ),
+				getUISceneNode()->getThreadPool() );
 		} else {
 			mModel->setRootPath( mCurPath );
 		}
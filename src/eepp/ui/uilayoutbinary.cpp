@@ -0,0 +1,252 @@
+#include <cstring>
+#include <eepp/core/string.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/log.hpp>
+#include <eepp/ui/uilayoutbinary.hpp>
+#include <eepp/ui/uiwidgetcreator.hpp>
+#include <sstream>
+#include <unordered_map>
+#define PUGIXML_HEADER_ONLY
+#include <pugixml/pugixml.hpp>
+
+namespace EE { namespace UI {
+
+static const char LAYOUT_MAGIC[4] = { 'E', 'E', 'U', 'L' };
+
+static void writeU8( std::string& out, const Uint8& value ) {
+	out.push_back( static_cast<char>( value ) );
+}
+
+static void writeU32( std::string& out, const Uint32& value ) {
+	for ( int i = 0; i < 4; i++ )
+		out.push_back( static_cast<char>( ( value >> ( i * 8 ) ) & 0xFF ) );
+}
+
+static Uint32 readLE32( const char* data ) {
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>( data );
+	return static_cast<Uint32>( bytes[0] ) | ( static_cast<Uint32>( bytes[1] ) << 8 ) |
+		   ( static_cast<Uint32>( bytes[2] ) << 16 ) | ( static_cast<Uint32>( bytes[3] ) << 24 );
+}
+
+namespace {
+
+class LayoutWriter {
+  public:
+	std::vector<std::string> strings;
+	std::string nodes;
+	Uint32 rootCount{ 0 };
+
+	Uint32 intern( const std::string& str ) {
+		auto it = mIds.find( str );
+		if ( it != mIds.end() )
+			return it->second;
+		Uint32 id = static_cast<Uint32>( strings.size() );
+		strings.push_back( str );
+		mIds[str] = id;
+		return id;
+	}
+
+	bool isWidget( const std::string& tag ) {
+		auto it = mIsWidget.find( tag );
+		if ( it != mIsWidget.end() )
+			return it->second;
+		bool isWidget = UIWidgetCreator::getWidgetFactory( tag ) != nullptr;
+		mIsWidget[tag] = isWidget;
+		return isWidget;
+	}
+
+	/** @return True if the XML loader would load something from the node. */
+	bool isLoadable( const pugi::xml_node& node ) {
+		if ( node.type() != pugi::node_element )
+			return false;
+		std::string tag( String::toLower( std::string( node.name() ) ) );
+		return "style" == tag || isWidget( tag );
+	}
+
+	bool needsXml( const pugi::xml_node& node, const std::string& tag ) {
+		if ( UIWidgetCreator::isXmlNodeWidget( tag ) )
+			return true;
+		// Child elements that are not widgets are consumed by the widget itself.
+		for ( pugi::xml_node child = node.first_child(); child; child = child.next_sibling() ) {
+			if ( child.type() == pugi::node_element && !isLoadable( child ) )
+				return true;
+		}
+		return false;
+	}
+
+	void writeNode( const pugi::xml_node& node ) {
+		std::string tag( String::toLower( std::string( node.name() ) ) );
+
+		if ( "style" == tag ) {
+			writeU8( nodes, UILayoutBinary::Style );
+			writeU32( nodes, intern( node.text().as_string() ) );
+			return;
+		}
+
+		if ( needsXml( node, tag ) ) {
+			std::ostringstream xml;
+			node.print( xml, "", pugi::format_raw );
+			writeU8( nodes, UILayoutBinary::Xml );
+			writeU32( nodes, intern( xml.str() ) );
+			return;
+		}
+
+		writeU8( nodes, UILayoutBinary::Widget );
+		writeU32( nodes, intern( tag ) );
+
+		Uint32 attributeCount = 0;
+		for ( pugi::xml_attribute attr = node.first_attribute(); attr;
+			  attr = attr.next_attribute() )
+			attributeCount++;
+
+		writeU32( nodes, attributeCount );
+		for ( pugi::xml_attribute attr = node.first_attribute(); attr;
+			  attr = attr.next_attribute() ) {
+			writeU32( nodes, intern( attr.name() ) );
+			writeU32( nodes, intern( attr.value() ) );
+		}
+
+		Uint32 childCount = 0;
+		for ( pugi::xml_node child = node.first_child(); child; child = child.next_sibling() )
+			if ( isLoadable( child ) )
+				childCount++;
+
+		writeU32( nodes, childCount );
+		for ( pugi::xml_node child = node.first_child(); child; child = child.next_sibling() )
+			if ( isLoadable( child ) )
+				writeNode( child );
+	}
+
+  protected:
+	std::unordered_map<std::string, Uint32> mIds;
+	std::unordered_map<std::string, bool> mIsWidget;
+};
+
+} // namespace
+
+bool UILayoutBinary::isBinaryLayout( const void* data, size_t size ) {
+	return NULL != data && size >= HEADER_SIZE && memcmp( data, LAYOUT_MAGIC, 4 ) == 0;
+}
+
+bool UILayoutBinary::compile( const pugi::xml_node& node, std::string& out ) {
+	if ( !node )
+		return false;
+
+	LayoutWriter writer;
+
+	for ( pugi::xml_node root = node; root; root = root.next_sibling() ) {
+		if ( writer.isLoadable( root ) ) {
+			writer.writeNode( root );
+			writer.rootCount++;
+		}
+	}
+
+	out.clear();
+	out.append( LAYOUT_MAGIC, 4 );
+	writeU32( out, VERSION );
+	writeU32( out, static_cast<Uint32>( writer.strings.size() ) );
+	writeU32( out, writer.rootCount );
+
+	for ( const auto& str : writer.strings ) {
+		writeU32( out, static_cast<Uint32>( str.size() ) );
+		out.append( str );
+		out.push_back( '\0' );
+	}
+
+	out.append( writer.nodes );
+
+	return true;
+}
+
+bool UILayoutBinary::compileFromString( const std::string& xml, std::string& out ) {
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_string( xml.c_str() );
+
+	if ( !result ) {
+		Log::error( "UILayoutBinary: couldn't parse layout: %s", result.description() );
+		return false;
+	}
+
+	return compile( doc.first_child(), out );
+}
+
+bool UILayoutBinary::compileFromFile( const std::string& xmlPath, const std::string& binaryPath ) {
+	pugi::xml_document doc;
+	pugi::xml_parse_result result = doc.load_file( xmlPath.c_str() );
+
+	if ( !result ) {
+		Log::error( "UILayoutBinary: couldn't parse layout %s: %s", xmlPath.c_str(),
+					result.description() );
+		return false;
+	}
+
+	std::string out;
+	return compile( doc.first_child(), out ) && FileSystem::fileWrite( binaryPath, out );
+}
+
+UILayoutBinary::Reader::Reader( const void* data, size_t size ) :
+	mData( static_cast<const char*>( data ) ), mSize( size ) {
+	if ( !isBinaryLayout( data, size ) || readLE32( mData + 4 ) != VERSION )
+		return;
+
+	Uint32 stringCount = readLE32( mData + 8 );
+	mRootCount = readLE32( mData + 12 );
+	mPos = HEADER_SIZE;
+
+	// Every string takes at least 5 bytes, this rejects corrupted counts before reserving.
+	if ( stringCount > ( mSize - mPos ) / 5 )
+		return;
+
+	mStrings.reserve( stringCount );
+
+	for ( Uint32 i = 0; i < stringCount; i++ ) {
+		Uint32 length;
+		if ( !readU32( length ) || length >= mSize - mPos || mData[mPos + length] != '\0' )
+			return;
+		mStrings.push_back( mData + mPos );
+		mPos += length + 1;
+	}
+
+	mValid = true;
+}
+
+bool UILayoutBinary::Reader::isValid() const {
+	return mValid;
+}
+
+Uint32 UILayoutBinary::Reader::getStringCount() const {
+	return static_cast<Uint32>( mStrings.size() );
+}
+
+const char* UILayoutBinary::Reader::getString( const Uint32& id ) const {
+	return id < mStrings.size() ? mStrings[id] : "";
+}
+
+Uint32 UILayoutBinary::Reader::getRootCount() const {
+	return mRootCount;
+}
+
+bool UILayoutBinary::Reader::readU8( Uint8& value ) {
+	if ( mPos + 1 > mSize ) {
+		mGood = false;
+		return false;
+	}
+	value = static_cast<Uint8>( mData[mPos++] );
+	return true;
+}
+
+bool UILayoutBinary::Reader::readU32( Uint32& value ) {
+	if ( mPos + 4 > mSize ) {
+		mGood = false;
+		return false;
+	}
+	value = readLE32( mData + mPos );
+	mPos += 4;
+	return true;
+}
+
+bool UILayoutBinary::Reader::isGood() const {
+	return mGood;
+}
+
+}} // namespace EE::UI
@@ -1570,6 +1570,12 @@ Float UINode::lengthFromValue( const std::string& value,
 
 Float UINode::lengthFromValue( const CSS::StyleSheetProperty& property,
 							   const Float& defaultValue ) {
+	if ( property.getValueType() == CSS::StyleSheetProperty::ValueType::Length ) {
+		return convertLength( property.asStyleSheetLength(),
+							  getPropertyRelativeTargetContainerLength(
+								  property.getPropertyDefinition()->getRelativeTarget(),
+								  defaultValue, property.getIndex() ) );
+	}
 	return lengthFromValue( property.getValue(),
 							property.getPropertyDefinition()->getRelativeTarget(), defaultValue,
 							property.getIndex() );
@@ -1586,6 +1592,12 @@ Float UINode::lengthFromValueAsDp( const std::string& value,
 
 Float UINode::lengthFromValueAsDp( const CSS::StyleSheetProperty& property,
 								   const Float& defaultValue ) const {
+	if ( property.getValueType() == CSS::StyleSheetProperty::ValueType::Length ) {
+		return convertLengthAsDp( property.asStyleSheetLength(),
+								  getPropertyRelativeTargetContainerLength(
+									  property.getPropertyDefinition()->getRelativeTarget(),
+									  defaultValue, property.getIndex() ) );
+	}
 	return lengthFromValueAsDp( property.getValue(),
 								property.getPropertyDefinition()->getRelativeTarget(), defaultValue,
 								property.getIndex() );
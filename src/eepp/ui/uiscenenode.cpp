@@ -7,15 +7,18 @@
 #include <eepp/scene/scenemanager.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/functionstring.hpp>
+#include <eepp/system/memorymappedfile.hpp>
 #include <eepp/system/packmanager.hpp>
 #include <eepp/system/virtualfilesystem.hpp>
 #include <eepp/ui/css/mediaquery.hpp>
+#include <eepp/ui/css/stylesheetancestorfilter.hpp>
 #include <eepp/ui/css/stylesheetparser.hpp>
 #include <eepp/ui/uieventdispatcher.hpp>
 #include <eepp/ui/uiiconthememanager.hpp>
 #include <eepp/ui/uilayout.hpp>
 #include <eepp/ui/uiroot.hpp>
 #include <eepp/ui/uiscenenode.hpp>
+#include <eepp/ui/uistyle.hpp>
 #include <eepp/ui/uithememanager.hpp>
 #include <eepp/ui/uitooltip.hpp>
 #include <eepp/ui/uiwidgetcreator.hpp>
@@ -24,6 +27,8 @@
 #define PUGIXML_HEADER_ONLY
 #include <pugixml/pugixml.hpp>
 
+#define PARALLEL_STYLE_RESOLUTION_MIN_WIDGETS 512
+
 using namespace EE::Network;
 
 namespace EE { namespace UI {
@@ -309,14 +314,121 @@ std::vector<UIWidget*> UISceneNode::loadNode( pugi::xml_node node, Node* parent,
 	return rootWidgets;
 }
 
-UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent, const Uint32& marker ) {
+struct UISceneNode::BinaryLayoutCache {
+	std::vector<UIWidgetCreator::RegisterWidgetCb> factories;
+	std::vector<bool> factoryResolved;
+	/// Inline properties of each distinct attribute, keyed by its name and value string ids.
+	std::unordered_map<Uint64, std::vector<CSS::StyleSheetProperty>> properties;
+	std::vector<CSS::StyleSheetProperty> widgetProperties;
+};
+
+std::vector<UIWidget*> UISceneNode::loadBinaryNodes( UILayoutBinary::Reader& reader,
+													 const Uint32& count, Node* parent,
+													 const Uint32& marker,
+													 BinaryLayoutCache& cache ) {
+	std::vector<UIWidget*> rootWidgets;
+
+	if ( NULL == parent )
+		parent = this;
+
+	for ( Uint32 i = 0; i < count && reader.isGood(); i++ ) {
+		Uint8 type;
+		Uint32 stringId;
+
+		if ( !reader.readU8( type ) || !reader.readU32( stringId ) ||
+			 stringId >= reader.getStringCount() )
+			break;
+
+		if ( UILayoutBinary::Widget == type ) {
+			Uint32 attributeCount;
+			if ( !reader.readU32( attributeCount ) )
+				break;
+
+			cache.widgetProperties.clear();
+
+			for ( Uint32 a = 0; a < attributeCount; a++ ) {
+				Uint32 nameId, valueId;
+				if ( !reader.readU32( nameId ) || !reader.readU32( valueId ) )
+					break;
+
+				Uint64 key = ( static_cast<Uint64>( nameId ) << 32 ) | valueId;
+				auto it = cache.properties.find( key );
+
+				if ( it == cache.properties.end() ) {
+					const char* value = reader.getString( valueId );
+					// Create a property without triming its value
+					CSS::StyleSheetProperty prop( reader.getString( nameId ), value, false,
+												  CSS::StyleSheetSelectorRule::SpecificityInline );
+					std::vector<CSS::StyleSheetProperty> properties;
+
+					if ( prop.getShorthandDefinition() != NULL ) {
+						properties = prop.getShorthandDefinition()->parse( value );
+					} else {
+						properties.emplace_back( std::move( prop ) );
+					}
+
+					it = cache.properties.emplace( key, std::move( properties ) ).first;
+				}
+
+				cache.widgetProperties.insert( cache.widgetProperties.end(), it->second.begin(),
+											   it->second.end() );
+			}
+
+			Uint32 childCount;
+			if ( !reader.readU32( childCount ) )
+				break;
+
+			if ( !cache.factoryResolved[stringId] ) {
+				cache.factories[stringId] =
+					UIWidgetCreator::getWidgetFactory( reader.getString( stringId ) );
+				cache.factoryResolved[stringId] = true;
+			}
+
+			UIWidget* uiwidget = cache.factories[stringId] ? cache.factories[stringId]() : NULL;
+
+			if ( NULL != uiwidget ) {
+				rootWidgets.push_back( uiwidget );
+				uiwidget->setParent( parent );
+				uiwidget->loadFromProperties( cache.widgetProperties );
+				loadBinaryNodes( reader, childCount, uiwidget, marker, cache );
+				uiwidget->onWidgetCreated();
+			} else {
+				Log::error( "UISceneNode::loadLayoutFromBinary: unknown widget %s",
+							reader.getString( stringId ) );
+				// The children still need to be read to keep the reader in sync.
+				loadBinaryNodes( reader, childCount, parent, marker, cache );
+			}
+		} else if ( UILayoutBinary::Style == type ) {
+			CSS::StyleSheetParser parser;
+
+			if ( parser.loadFromString( reader.getString( stringId ) ) ) {
+				parser.getStyleSheet().setMarker( marker );
+				combineStyleSheet( parser.getStyleSheet(), false );
+			}
+		} else if ( UILayoutBinary::Xml == type ) {
+			pugi::xml_document doc;
+
+			if ( doc.load_string( reader.getString( stringId ) ) ) {
+				std::vector<UIWidget*> widgets = loadNode( doc.first_child(), parent, marker );
+				rootWidgets.insert( rootWidgets.end(), widgets.begin(), widgets.end() );
+			}
+		} else {
+			Log::error( "UISceneNode::loadLayoutFromBinary: invalid node type %d", type );
+			break;
+		}
+	}
+
+	return rootWidgets;
+}
+
+UIWidget* UISceneNode::loadLayoutWidgets(
+	const std::function<std::vector<UIWidget*>()>& loadWidgets, const std::string& id ) {
 	Clock clock;
 	UISceneNode* prevUISceneNode = SceneManager::instance()->getUISceneNode();
 	SceneManager::instance()->setCurrentUISceneNode( this );
-	std::string id( node.attribute( "id" ).as_string() );
 	mIsLoading = true;
 	Clock innerClock;
-	std::vector<UIWidget*> widgets = loadNode( node, parent, marker );
+	std::vector<UIWidget*> widgets = loadWidgets();
 
 	if ( mVerbose ) {
 		std::sort(
@@ -354,6 +466,38 @@ UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent, const
 	return widgets.empty() ? NULL : widgets[0];
 }
 
+UIWidget* UISceneNode::loadLayoutNodes( pugi::xml_node node, Node* parent, const Uint32& marker ) {
+	return loadLayoutWidgets(
+		[this, node, parent, marker] { return loadNode( node, parent, marker ); },
+		node.attribute( "id" ).as_string() );
+}
+
+UIWidget* UISceneNode::loadLayoutFromBinary( const void* data, size_t size, Node* parent,
+											 const Uint32& marker ) {
+	UILayoutBinary::Reader reader( data, size );
+
+	if ( !reader.isValid() ) {
+		Log::error( "Couldn't load UI Layout from binary: invalid layout" );
+		return NULL;
+	}
+
+	BinaryLayoutCache cache;
+	cache.factories.resize( reader.getStringCount() );
+	cache.factoryResolved.resize( reader.getStringCount(), false );
+
+	UIWidget* widget = loadLayoutWidgets(
+		[&] {
+			return loadBinaryNodes( reader, reader.getRootCount(),
+									NULL != parent ? parent : this, marker, cache );
+		},
+		"" );
+
+	if ( !reader.isGood() )
+		Log::error( "UISceneNode::loadLayoutFromBinary: truncated layout" );
+
+	return widget;
+}
+
 void UISceneNode::setStyleSheet( const CSS::StyleSheet& styleSheet ) {
 	mStyleSheet = styleSheet;
 	processStyleSheetAtRules( styleSheet );
@@ -420,9 +564,32 @@ void UISceneNode::setThreadPool( const std::shared_ptr<ThreadPool>& threadPool )
 	mThreadPool = threadPool;
 }
 
+void UISceneNode::setParallelStyleResolution( bool parallelStyleResolution ) {
+	mParallelStyleResolution = parallelStyleResolution;
+}
+
+bool UISceneNode::isParallelStyleResolutionEnabled() const {
+	return mParallelStyleResolution;
+}
+
+Executor UISceneNode::getMainThreadExecutor() {
+	return [this]( std::function<void()> func ) { runOnMainThread( std::move( func ) ); };
+}
+
 UIWidget* UISceneNode::loadLayoutFromFile( const std::string& layoutPath, Node* parent,
 										   const Uint32& marker ) {
 	if ( FileSystem::fileExists( layoutPath ) ) {
+		MemoryMappedFile mappedFile( layoutPath );
+
+		if ( mappedFile.isOpen() &&
+			 UILayoutBinary::isBinaryLayout( mappedFile.getData(), mappedFile.getSize() ) ) {
+			mappedFile.adviseSequential();
+			return loadLayoutFromBinary( mappedFile.getData(), mappedFile.getSize(), parent,
+										 marker );
+		}
+
+		mappedFile.close();
+
 		pugi::xml_document doc;
 		pugi::xml_parse_result result = doc.load_file( layoutPath.c_str() );
 
@@ -463,6 +630,9 @@ UIWidget* UISceneNode::loadLayoutFromString( const std::string& layoutString, No
 
 UIWidget* UISceneNode::loadLayoutFromMemory( const void* buffer, Int32 bufferSize, Node* parent,
 											 const Uint32& marker ) {
+	if ( bufferSize > 0 && UILayoutBinary::isBinaryLayout( buffer, bufferSize ) )
+		return loadLayoutFromBinary( buffer, bufferSize, parent, marker );
+
 	pugi::xml_document doc;
 	pugi::xml_parse_result result = doc.load_buffer( buffer, bufferSize );
 
@@ -788,8 +958,10 @@ void UISceneNode::updateDirtyLayouts() {
 void UISceneNode::updateDirtyStyles() {
 	if ( !mDirtyStyle.empty() ) {
 		Clock clock;
-		for ( auto& node : mDirtyStyle ) {
-			node->reloadStyle( true, false, false );
+		if ( !updateDirtyStylesParallel() ) {
+			for ( auto& node : mDirtyStyle ) {
+				node->reloadStyle( true, false, false );
+			}
 		}
 		mDirtyStyle.clear();
 
@@ -798,6 +970,58 @@ void UISceneNode::updateDirtyStyles() {
 	}
 }
 
+bool UISceneNode::updateDirtyStylesParallel() {
+	if ( !mParallelStyleResolution || !mThreadPool || mThreadPool->numThreads() < 2 )
+		return false;
+
+	// Collects the widgets in the same order that UIWidget::reloadStyle visits them.
+	std::vector<UIWidget*> widgets;
+	std::function<void( UIWidget* )> collect = [&]( UIWidget* widget ) {
+		widget->createStyle();
+
+		if ( NULL == widget->getUIStyle() )
+			return;
+
+		widgets.push_back( widget );
+
+		for ( Node* child = widget->getFirstChild(); NULL != child; child = child->getNextNode() ) {
+			if ( child->isWidget() )
+				collect( child->asType<UIWidget>() );
+		}
+	};
+
+	for ( auto& node : mDirtyStyle )
+		collect( node );
+
+	if ( widgets.size() < PARALLEL_STYLE_RESOLUTION_MIN_WIDGETS )
+		return false;
+
+	// Matching only reads the widget tree and the style sheet, so it can run in the pool while
+	// this thread waits for it. Loading the styles updates the widgets, it stays in this thread.
+	std::vector<std::shared_ptr<CSS::ElementDefinition>> definitions( widgets.size() );
+
+	mThreadPool->parallelFor(
+		0, widgets.size(),
+		[&]( size_t begin, size_t end ) {
+			CSS::StyleSheetAncestorFilter filter;
+			CSS::StyleSheetAncestorFilter* previous =
+				CSS::StyleSheetAncestorFilter::setActive( &filter );
+
+			for ( size_t i = begin; i < end; i++ ) {
+				filter.moveTo( widgets[i]->getStyleSheetParentElement() );
+				definitions[i] = mStyleSheet.getElementStyles( widgets[i], false );
+			}
+
+			CSS::StyleSheetAncestorFilter::setActive( previous );
+		},
+		ThreadPool::Priority::High, 64 );
+
+	for ( size_t i = 0; i < widgets.size(); i++ )
+		widgets[i]->getUIStyle()->load( definitions[i] );
+
+	return true;
+}
+
 void UISceneNode::updateDirtyStyleStates() {
 	if ( !mDirtyStyleState.empty() ) {
 		Clock clock;
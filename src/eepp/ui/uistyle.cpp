@@ -60,9 +60,13 @@ void UIStyle::resetGlobalDefinition() {
 }
 
 void UIStyle::load() {
+	load( mWidget->getUISceneNode()->getStyleSheet().getElementStyles( mWidget, false ) );
+}
+
+void UIStyle::load( const std::shared_ptr<CSS::ElementDefinition>& globalDefinition ) {
 	removeStructurallyVolatileWidgetFromParent();
 
-	resetGlobalDefinition();
+	mGlobalDefinition = globalDefinition;
 
 	unsubscribeNonCacheableStyles();
 
@@ -2,6 +2,7 @@
 #include <eepp/scene/actions/actions.hpp>
 #include <eepp/scene/scenemanager.hpp>
 #include <eepp/ui/css/shorthanddefinition.hpp>
+#include <eepp/ui/css/stylesheetancestorfilter.hpp>
 #include <eepp/ui/css/stylesheetproperty.hpp>
 #include <eepp/ui/css/stylesheetselector.hpp>
 #include <eepp/ui/css/stylesheetspecification.hpp>
@@ -903,6 +904,7 @@ void UIWidget::reloadStyle( const bool& reloadChilds, const bool& disableAnimati
 		mStyle->load();
 
 		if ( NULL != getFirstChild() && reloadChilds ) {
+			CSS::StyleSheetAncestorFilter::Scope ancestorFilterScope( this );
 			Node* child = getFirstChild();
 
 			while ( NULL != child ) {
@@ -1786,6 +1788,18 @@ void UIWidget::loadFromXmlNode( const pugi::xml_node& node ) {
 	endAttributesTransaction();
 }
 
+void UIWidget::loadFromProperties( const std::vector<CSS::StyleSheetProperty>& properties ) {
+	beginAttributesTransaction();
+
+	for ( auto& property : properties ) {
+		if ( NULL != mStyle )
+			mStyle->setStyleSheetProperty( property );
+		applyProperty( property );
+	}
+
+	endAttributesTransaction();
+}
+
 std::string UIWidget::getLayoutWidthPolicyString() const {
 	SizePolicy rules = getLayoutWidthPolicy();
 
@@ -49,69 +49,71 @@ UIWidgetCreator::WidgetCallbackMap UIWidgetCreator::widgetCallback =
 UIWidgetCreator::RegisteredWidgetCallbackMap UIWidgetCreator::registeredWidget =
 	UIWidgetCreator::RegisteredWidgetCallbackMap();
 
+std::set<std::string> UIWidgetCreator::xmlNodeWidgets = std::set<std::string>();
+
 void UIWidgetCreator::createBaseWidgetList() {
 	if ( !sBaseListCreated ) {
-		registeredWidget["widget"] = UIWidget::New;
-		registeredWidget["linearlayout"] = UILinearLayout::NewVertical;
-		registeredWidget["relativelayout"] = UIRelativeLayout::New;
-		registeredWidget["textview"] = UITextView::New;
-		registeredWidget["pushbutton"] = UIPushButton::New;
-		registeredWidget["checkbox"] = UICheckBox::New;
-		registeredWidget["radiobutton"] = UIRadioButton::New;
-		registeredWidget["combobox"] = UIComboBox::New;
-		registeredWidget["dropdownlist"] = UIDropDownList::New;
-		registeredWidget["image"] = UIImage::New;
-		registeredWidget["listbox"] = UIListBox::New;
-		registeredWidget["menubar"] = UIMenuBar::New;
-		registeredWidget["progressbar"] = UIProgressBar::New;
-		registeredWidget["scrollbar"] = UIScrollBar::New;
-		registeredWidget["slider"] = UISlider::New;
-		registeredWidget["spinbox"] = UISpinBox::New;
-		registeredWidget["sprite"] = UISprite::New;
-		registeredWidget["tab"] = UITab::New;
-		registeredWidget["widgettable"] = UIWidgetTable::New;
-		registeredWidget["widgettablerow"] = UIWidgetTableRow::New;
-		registeredWidget["tabwidget"] = UITabWidget::New;
-		registeredWidget["textedit"] = UITextEdit::New;
-		registeredWidget["textinput"] = UITextInput::New;
-		registeredWidget["textinputpassword"] = UITextInputPassword::New;
-		registeredWidget["loader"] = UILoader::New;
-		registeredWidget["selectbutton"] = UISelectButton::New;
-		registeredWidget["window"] = UIWindow::New;
-		registeredWidget["scrollview"] = UIScrollView::New;
-		registeredWidget["textureregion"] = UITextureRegion::New;
-		registeredWidget["touchdraggable"] = UITouchDraggableWidget::New;
-		registeredWidget["gridlayout"] = UIGridLayout::New;
-		registeredWidget["layout"] = UILayout::New;
-		registeredWidget["viewpager"] = UIViewPager::New;
-		registeredWidget["codeeditor"] = UICodeEditor::New;
-		registeredWidget["splitter"] = UISplitter::New;
-		registeredWidget["treeview"] = UITreeView::New;
-		registeredWidget["tableview"] = UITableView::New;
-		registeredWidget["listview"] = UIListView::New;
-		registeredWidget["stackwidget"] = UIStackWidget::New;
-		registeredWidget["console"] = UIConsole::New;
+		registerWidget( "widget", UIWidget::New );
+		registerWidget( "linearlayout", UILinearLayout::NewVertical );
+		registerWidget( "relativelayout", UIRelativeLayout::New );
+		registerWidget( "textview", UITextView::New );
+		registerWidget( "pushbutton", UIPushButton::New );
+		registerWidget( "checkbox", UICheckBox::New );
+		registerWidget( "radiobutton", UIRadioButton::New );
+		registerWidget( "combobox", UIComboBox::New );
+		registerWidget( "dropdownlist", UIDropDownList::New );
+		registerWidget( "image", UIImage::New );
+		registerWidget( "listbox", UIListBox::New );
+		registerWidget( "menubar", UIMenuBar::New );
+		registerWidget( "progressbar", UIProgressBar::New );
+		registerWidget( "scrollbar", UIScrollBar::New );
+		registerWidget( "slider", UISlider::New );
+		registerWidget( "spinbox", UISpinBox::New );
+		registerWidget( "sprite", UISprite::New );
+		registerWidget( "tab", UITab::New );
+		registerWidget( "widgettable", UIWidgetTable::New );
+		registerWidget( "widgettablerow", UIWidgetTableRow::New );
+		registerWidget( "tabwidget", UITabWidget::New );
+		registerWidget( "textedit", UITextEdit::New );
+		registerWidget( "textinput", UITextInput::New );
+		registerWidget( "textinputpassword", UITextInputPassword::New );
+		registerWidget( "loader", UILoader::New );
+		registerWidget( "selectbutton", UISelectButton::New );
+		registerWidget( "window", UIWindow::New );
+		registerWidget( "scrollview", UIScrollView::New );
+		registerWidget( "textureregion", UITextureRegion::New );
+		registerWidget( "touchdraggable", UITouchDraggableWidget::New );
+		registerWidget( "gridlayout", UIGridLayout::New );
+		registerWidget( "layout", UILayout::New );
+		registerWidget( "viewpager", UIViewPager::New );
+		registerWidget( "codeeditor", UICodeEditor::New );
+		registerWidget( "splitter", UISplitter::New );
+		registerWidget( "treeview", UITreeView::New );
+		registerWidget( "tableview", UITableView::New );
+		registerWidget( "listview", UIListView::New );
+		registerWidget( "stackwidget", UIStackWidget::New );
+		registerWidget( "console", UIConsole::New );
 		// registeredWidget["menu"] = UIMenu::New;
-		registeredWidget["menucheckbox"] = UIMenuCheckBox::New;
-		registeredWidget["menuradiobutton"] = UIMenuRadioButton::New;
-		registeredWidget["menuseparator"] = UIMenuSeparator::New;
-		registeredWidget["anchor"] = UIAnchor::New;
-
-		registeredWidget["hbox"] = UILinearLayout::NewHorizontal;
-		registeredWidget["vbox"] = UILinearLayout::NewVertical;
-		registeredWidget["input"] = UITextInput::New;
-		registeredWidget["inputpassword"] = UITextInputPassword::New;
-		registeredWidget["viewpagerhorizontal"] = UIViewPager::NewHorizontal;
-		registeredWidget["viewpagervertical"] = UIViewPager::NewHorizontal;
-		registeredWidget["vslider"] = UISlider::NewHorizontal;
-		registeredWidget["hslider"] = UISlider::NewHorizontal;
-		registeredWidget["vscrollbar"] = UIScrollBar::NewVertical;
-		registeredWidget["hscrollbar"] = UIScrollBar::NewHorizontal;
-		registeredWidget["button"] = UIPushButton::New;
-		registeredWidget["rlay"] = UIRelativeLayout::New;
-		registeredWidget["tooltip"] = UITooltip::New;
-		registeredWidget["tv"] = UITextView::New;
-		registeredWidget["a"] = UIAnchor::New;
+		registerWidget( "menucheckbox", UIMenuCheckBox::New );
+		registerWidget( "menuradiobutton", UIMenuRadioButton::New );
+		registerWidget( "menuseparator", UIMenuSeparator::New );
+		registerWidget( "anchor", UIAnchor::New );
+
+		registerWidget( "hbox", UILinearLayout::NewHorizontal );
+		registerWidget( "vbox", UILinearLayout::NewVertical );
+		registerWidget( "input", UITextInput::New );
+		registerWidget( "inputpassword", UITextInputPassword::New );
+		registerWidget( "viewpagerhorizontal", UIViewPager::NewHorizontal );
+		registerWidget( "viewpagervertical", UIViewPager::NewHorizontal );
+		registerWidget( "vslider", UISlider::NewHorizontal );
+		registerWidget( "hslider", UISlider::NewHorizontal );
+		registerWidget( "vscrollbar", UIScrollBar::NewVertical );
+		registerWidget( "hscrollbar", UIScrollBar::NewHorizontal );
+		registerWidget( "button", UIPushButton::New );
+		registerWidget( "rlay", UIRelativeLayout::New );
+		registerWidget( "tooltip", UITooltip::New );
+		registerWidget( "tv", UITextView::New );
+		registerWidget( "a", UIAnchor::New );
 
 		sBaseListCreated = true;
 	}
@@ -133,6 +135,24 @@ UIWidget* UIWidgetCreator::createFromName( std::string widgetName ) {
 	return NULL;
 }
 
+UIWidgetCreator::RegisterWidgetCb UIWidgetCreator::getWidgetFactory( std::string widgetName ) {
+	createBaseWidgetList();
+
+	String::toLowerInPlace( widgetName );
+
+	auto registeredIt = registeredWidget.find( widgetName );
+	if ( registeredIt != registeredWidget.end() )
+		return registeredIt->second;
+
+	auto callbackIt = widgetCallback.find( widgetName );
+	if ( callbackIt != widgetCallback.end() ) {
+		CustomWidgetCb cb = callbackIt->second;
+		return [cb, widgetName]() { return cb( widgetName ); };
+	}
+
+	return nullptr;
+}
+
 void UIWidgetCreator::addCustomWidgetCallback( std::string widgetName,
 											   const UIWidgetCreator::CustomWidgetCb& cb ) {
 	widgetCallback[String::toLower( widgetName )] = cb;
@@ -152,13 +172,29 @@ void UIWidgetCreator::registerWidget( std::string widgetName,
 }
 
 void UIWidgetCreator::unregisterWidget( std::string widgetName ) {
-	registeredWidget.erase( String::toLower( widgetName ) );
+	String::toLowerInPlace( widgetName );
+	registeredWidget.erase( widgetName );
+	xmlNodeWidgets.erase( widgetName );
 }
 
 bool UIWidgetCreator::isWidgetRegistered( std::string widgetName ) {
 	return registeredWidget.find( String::toLower( widgetName ) ) != registeredWidget.end();
 }
 
+void UIWidgetCreator::setXmlNodeWidget( std::string widgetName, bool xmlNodeWidget ) {
+	String::toLowerInPlace( widgetName );
+	if ( xmlNodeWidget ) {
+		xmlNodeWidgets.insert( widgetName );
+	} else {
+		xmlNodeWidgets.erase( widgetName );
+	}
+}
+
+bool UIWidgetCreator::isXmlNodeWidget( std::string widgetName ) {
+	createBaseWidgetList();
+	return xmlNodeWidgets.find( String::toLower( widgetName ) ) != xmlNodeWidgets.end();
+}
+
 const UIWidgetCreator::RegisteredWidgetCallbackMap& UIWidgetCreator::getRegisteredWidgets() {
 	return registeredWidget;
 }
@@ -40,6 +40,7 @@
 #include <eterm/system/iprocess.hpp>
 #include <eterm/terminal/ipseudoterminal.hpp>
 #include <eterm/terminal/iterminaldisplay.hpp>
+#include <eterm/terminal/terminalhistory.hpp>
 #include <eterm/terminal/terminaltypes.hpp>
 #include <memory>
 #include <stdint.h>
@@ -63,8 +64,6 @@ struct Term {
 	int col{ 0 };				   /* nb col */
 	Line* line{ nullptr };		   /* screen */
 	Line* alt{ nullptr };		   /* alternate screen */
-	Line* hist{ nullptr };		   /* history buffer */
-	int histcursize{ 0 };		   /* history current size */
 	int histsize{ 0 };			   /* history max size */
 	int histi{ 0 };				   /* history index */
 	int scr{ 0 };				   /* scroll back */
@@ -221,6 +220,15 @@ class TerminalEmulator final {
 
 	void setAllowMemoryTrimnming( bool allowMemoryTrimnming );
 
+	/** Sets the maximum number of history pages ( 256 lines each ) kept in memory, the older pages
+	 * are spilled to a temporary file. 0 keeps the whole history in memory. */
+	void setHistoryMaxMemoryPages( size_t maxMemoryPages );
+
+	size_t getHistoryMaxMemoryPages() const;
+
+	/** @return The bytes used by the history lines kept in memory. */
+	size_t getHistoryMemoryUsage() const;
+
   private:
 	DpyPtr mDpy;
 	PtyPtr mPty;
@@ -237,6 +245,7 @@ class TerminalEmulator final {
 	int mBuflen;
 
 	Term mTerm;
+	mutable TerminalHistory mHistory;
 	TerminalSelection mSel;
 	CSIEscape mCsiescseq;
 	STREscape mStrescseq;
@@ -249,7 +258,6 @@ class TerminalEmulator final {
 	int mAllowAltScreen;
 	int mAllowWindowOps;
 
-	void resizeHistory();
 	void setClipboard( const char* str );
 
 	void loadColors();
@@ -279,6 +287,7 @@ class TerminalEmulator final {
 	void tdeleteline( int );
 	void tinsertblank( int );
 	void tinsertblankline( int );
+	Line thistline( int ) const;
 	int tlinelen( int ) const;
 	int tiswrapped( int );
 	void tmoveto( int, int );
@@ -286,6 +295,7 @@ class TerminalEmulator final {
 	void tnewline( int );
 	void tputtab( int );
 	void tputc( Rune );
+	size_t tputascii( const char*, size_t );
 	void treset();
 	void tscrollup( int, int, int );
 	void tscrolldown( int, int, int );
@@ -0,0 +1,107 @@
+#ifndef ETERM_TERMINALHISTORY_HPP
+#define ETERM_TERMINALHISTORY_HPP
+
+#include <cstdio>
+#include <eterm/terminal/terminaltypes.hpp>
+#include <memory>
+#include <vector>
+
+namespace eterm { namespace Terminal {
+
+/** @brief Compact scrollback store of the terminal emulator.
+ * The history is a ring of slots, each one holds an encoded line: the attributes are run-length
+ * encoded and the runes are packed as variable length integers, repeated runes ( usually the
+ * trailing blanks ) are stored once with its count. The slots are grouped in pages, the least
+ * recently used pages can be spilled to a temporary file when the number of pages kept in memory
+ * is limited.
+ * The decoded lines are kept in a small cache indexed by slot, so the lines being drawn or
+ * selected are decoded only once. */
+class TerminalHistory {
+  public:
+	TerminalHistory();
+
+	~TerminalHistory();
+
+	TerminalHistory( const TerminalHistory& ) = delete;
+
+	TerminalHistory& operator=( const TerminalHistory& ) = delete;
+
+	/** Clears the history and sets its number of slots. */
+	void reset( size_t capacity );
+
+	size_t getCapacity() const;
+
+	/** Encodes the line into the slot, replacing its previous content. */
+	void store( size_t slot, const TerminalGlyph* line, int columns );
+
+	/** @return The decoded line of the slot, truncated or padded with blank glyphs with the fill
+	 * attributes to the number of columns. The line is owned by the history and is valid until the
+	 * slot is stored or its cache entry is reused by another slot. */
+	Line get( size_t slot, int columns, const TerminalGlyph& fill );
+
+	/** Stores the line into the slot and copies the previous slot content to the line. */
+	void exchange( size_t slot, Line line, int columns, const TerminalGlyph& fill );
+
+	/** Releases all the lines, the capacity is kept. */
+	void clear();
+
+	/** Sets the maximum number of pages kept in memory, the rest are spilled to a temporary file.
+	 * 0 keeps all the pages in memory ( default ). */
+	void setMaxMemoryPages( size_t maxMemoryPages );
+
+	size_t getMaxMemoryPages() const;
+
+	/** @return The bytes used by the encoded lines kept in memory. */
+	size_t getMemoryUsage() const;
+
+	/** @return The bytes used by the encoded lines spilled to disk. */
+	size_t getDiskUsage() const;
+
+  protected:
+	struct Page {
+		std::vector<uint8_t> data;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> sizes; ///< 0 if the slot is empty
+		size_t garbage{ 0 };		 ///< Bytes of the replaced lines still in data
+		size_t dataSize{ 0 };		 ///< Size of the data while it's spilled
+		long fileOffset{ -1 };
+		size_t fileCapacity{ 0 };
+		bool resident{ true };
+		uint64_t lastUse{ 0 };
+	};
+
+	struct CacheEntry {
+		size_t slot{ SIZE_MAX };
+		std::vector<TerminalGlyph> line;
+	};
+
+	size_t mCapacity{ 0 };
+	size_t mMaxMemoryPages{ 0 };
+	size_t mResidentPages{ 0 };
+	size_t mMemoryUsage{ 0 };
+	size_t mDiskUsage{ 0 };
+	uint64_t mUseCount{ 0 };
+	std::vector<std::unique_ptr<Page>> mPages;
+	std::vector<CacheEntry> mCache;
+	std::vector<uint8_t> mEncoded;
+	FILE* mFile{ nullptr };
+
+	Page* getPage( size_t slot, bool create );
+
+	void touch( Page* page );
+
+	void compact( Page* page );
+
+	bool spill( Page* page );
+
+	bool load( Page* page );
+
+	void encode( const TerminalGlyph* line, int columns );
+
+	static void decode( const uint8_t* data, size_t size, TerminalGlyph* line, int columns,
+						const TerminalGlyph& fill );
+};
+
+}} // namespace eterm::Terminal
+
+#endif
@@ -92,6 +92,14 @@ static const unsigned int tabspaces = 4;
 #include <windows.h>
 #endif
 
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ETERM_SSE2
+#include <emmintrin.h>
+#ifdef EE_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#endif
+
 #define MIN( a, b ) ( ( a ) < ( b ) ? ( a ) : ( b ) )
 #define MAX( a, b ) ( ( a ) < ( b ) ? ( b ) : ( a ) )
 #define LEN( a ) ( sizeof( a ) / sizeof( a )[0] )
@@ -117,10 +125,8 @@ static const unsigned int tabspaces = 4;
 #define ISCONTROLC1( c ) ( BETWEEN( c, 0x80, 0x9f ) )
 #define ISCONTROL( c ) ( ISCONTROLC0( c ) || ISCONTROLC1( c ) )
 #define ISDELIM( u ) ( u && _wcschr( worddelimiters, u ) )
-#define TLINE( y )                                                                                \
-	( ( y ) < mTerm.scr && mTerm.histsize > 0                                                     \
-		  ? mTerm.hist[( ( y ) + mTerm.histi - mTerm.scr + mTerm.histsize + 1 ) % mTerm.histsize] \
-		  : mTerm.line[(y)-mTerm.scr] )
+#define TLINE( y )                                                                           \
+	( ( y ) < mTerm.scr && mTerm.histsize > 0 ? thistline( y ) : mTerm.line[(y)-mTerm.scr] )
 
 typedef struct emoji_range {
 	int32_t min_code;
@@ -237,6 +243,7 @@ static Rune utf8decodebyte( char, size_t* );
 static char utf8encodebyte( Rune, size_t );
 static size_t utf8validate( Rune*, size_t );
 static size_t utf8encode( Rune, char* );
+static size_t asciiprintlen( const char*, size_t );
 
 static char* base64dec( const char* );
 static char base64dec_getc( const char** );
@@ -303,6 +310,39 @@ size_t utf8validate( Rune* u, size_t i ) {
 	return i;
 }
 
+#ifdef ETERM_SSE2
+static inline int firstbitset( int mask ) {
+#ifdef EE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return (int)index;
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+#endif
+
+/* length of the leading run of printable ascii ( 0x20 - 0x7e ) */
+size_t asciiprintlen( const char* s, size_t len ) {
+	size_t i = 0;
+#ifdef ETERM_SSE2
+	const __m128i low = _mm_set1_epi8( 0x1f );
+	const __m128i high = _mm_set1_epi8( 0x7f );
+	/* signed compares, the bytes >= 0x80 are negative */
+	for ( ; i + 16 <= len; i += 16 ) {
+		__m128i chunk = _mm_loadu_si128( (const __m128i*)( s + i ) );
+		__m128i print =
+			_mm_and_si128( _mm_cmpgt_epi8( chunk, low ), _mm_cmplt_epi8( chunk, high ) );
+		int mask = ~_mm_movemask_epi8( print ) & 0xffff;
+		if ( mask )
+			return i + firstbitset( mask );
+	}
+#endif
+	while ( i < len && BETWEEN( (uchar)s[i], 0x20, 0x7e ) )
+		i++;
+	return i;
+}
+
 static const char base64_digits[] = {
 	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,		  0,  0,  0,  0,
 	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,	0,		  0,  0,  0,  62,
@@ -358,6 +398,11 @@ void TerminalEmulator::selinit( void ) {
 	mSel.ob.x = -1;
 }
 
+Line TerminalEmulator::thistline( int y ) const {
+	return mHistory.get( ( y + mTerm.histi - mTerm.scr + mTerm.histsize + 1 ) % mTerm.histsize,
+						 mTerm.col, mTerm.c.attr );
+}
+
 int TerminalEmulator::tlinelen( int y ) const {
 	int i = mTerm.col;
 
@@ -714,10 +759,7 @@ void TerminalEmulator::trimMemory() {
 }
 
 void TerminalEmulator::clearHistory() {
-	for ( int i = 0; i < mTerm.histcursize; ++i )
-		eeSAFE_FREE( mTerm.hist[i] );
-	eeSAFE_FREE( mTerm.hist );
-	mTerm.histcursize = 0;
+	mHistory.clear();
 	mTerm.histi = 0;
 	trimMemory();
 }
@@ -866,6 +908,7 @@ void TerminalEmulator::tnew( int col, int row, size_t historySize ) {
 	mTerm.c.attr.fg = mDefaultFg;
 	mTerm.c.attr.bg = mDefaultBg;
 	mTerm.histsize = historySize;
+	mHistory.reset( historySize );
 
 	tresize( col, row );
 	treset();
@@ -880,23 +923,6 @@ void TerminalEmulator::tswapscreen( void ) {
 	tfulldirt();
 }
 
-void TerminalEmulator::resizeHistory() {
-	size_t oriSize = mTerm.histcursize;
-	if ( mTerm.histi >= (int)mTerm.histcursize ) {
-		int newSize = eemin( mTerm.histi + mTerm.row, mTerm.histsize );
-		mTerm.hist = (Line*)xrealloc( mTerm.hist, newSize * sizeof( Line ) );
-		mTerm.histcursize = newSize;
-
-		for ( int i = oriSize; i < mTerm.histcursize; i++ ) {
-			mTerm.hist[i] = (TerminalGlyph*)xmalloc( mTerm.col * sizeof( TerminalGlyph ) );
-			for ( int j = 0; j < mTerm.col; j++ ) {
-				mTerm.hist[i][j] = mTerm.c.attr;
-				mTerm.hist[i][j].u = ' ';
-			}
-		}
-	}
-}
-
 void TerminalEmulator::tscrolldown( int top, int n, int copyhist ) {
 	int i;
 	Line temp;
@@ -904,10 +930,7 @@ void TerminalEmulator::tscrolldown( int top, int n, int copyhist ) {
 	LIMIT( n, 0, mTerm.bot - top + 1 );
 	if ( copyhist && mTerm.histsize > 0 ) {
 		mTerm.histi = ( mTerm.histi - 1 + mTerm.histsize ) % mTerm.histsize;
-		resizeHistory();
-		temp = mTerm.hist[mTerm.histi];
-		mTerm.hist[mTerm.histi] = mTerm.line[mTerm.bot];
-		mTerm.line[mTerm.bot] = temp;
+		mHistory.exchange( mTerm.histi, mTerm.line[mTerm.bot], mTerm.col, mTerm.c.attr );
 	}
 
 	tsetdirt( top, mTerm.bot - n );
@@ -931,10 +954,8 @@ void TerminalEmulator::tscrollup( int top, int n, int copyhist ) {
 
 	if ( copyhist && mTerm.histsize > 0 ) {
 		mTerm.histi = ( mTerm.histi + 1 ) % mTerm.histsize;
-		resizeHistory();
-		temp = mTerm.hist[mTerm.histi];
-		mTerm.hist[mTerm.histi] = mTerm.line[top];
-		mTerm.line[top] = temp;
+		/* line[top] is cleared below, so it's only stored */
+		mHistory.store( mTerm.histi, mTerm.line[top], mTerm.col );
 	}
 
 	if ( mTerm.scr > 0 && mTerm.scr < mTerm.histsize )
@@ -1053,23 +1074,23 @@ void TerminalEmulator::tsetchar( Rune u, TerminalGlyph* attr, int x, int y ) {
 		 vt100_0[u - 0x41] )
 		utf8decode( vt100_0[u - 0x41], &u, UTF_SIZ );
 
-	if ( TLINE( y )[x].mode & ATTR_WIDE ) {
+	if ( mTerm.line[y][x].mode & ATTR_WIDE ) {
 		if ( x + 1 < mTerm.col ) {
-			TLINE( y )[x + 1].u = ' ';
-			TLINE( y )[x + 1].mode &= ~ATTR_WDUMMY;
+			mTerm.line[y][x + 1].u = ' ';
+			mTerm.line[y][x + 1].mode &= ~ATTR_WDUMMY;
 		}
-	} else if ( TLINE( y )[x].mode & ATTR_WDUMMY ) {
-		TLINE( y )[x - 1].u = ' ';
-		TLINE( y )[x - 1].mode &= ~ATTR_WIDE;
+	} else if ( mTerm.line[y][x].mode & ATTR_WDUMMY ) {
+		mTerm.line[y][x - 1].u = ' ';
+		mTerm.line[y][x - 1].mode &= ~ATTR_WIDE;
 	}
 
 	mTerm.dirty[y] = 1;
-	TLINE( y )[x] = *attr;
-	TLINE( y )[x].u = u;
+	mTerm.line[y][x] = *attr;
+	mTerm.line[y][x].u = u;
 	mDirty = true;
 
 	if ( isboxdraw( u ) )
-		TLINE( y )[x].mode |= ATTR_BOXDRAW;
+		mTerm.line[y][x].mode |= ATTR_BOXDRAW;
 }
 
 void TerminalEmulator::tclearregion( int x1, int y1, int x2, int y2 ) {
@@ -1090,7 +1111,7 @@ void TerminalEmulator::tclearregion( int x1, int y1, int x2, int y2 ) {
 		mTerm.dirty[y] = 1;
 		mDirty = true;
 		for ( x = x1; x <= x2; x++ ) {
-			gp = &TLINE( y )[x];
+			gp = &mTerm.line[y][x];
 			if ( selected( x, y ) )
 				selclear();
 			gp->fg = mTerm.c.attr.fg;
@@ -2259,12 +2280,76 @@ check_control_code:
 	}
 }
 
+/*
+ * Writes the leading run of printable ascii straight into the lines, with the
+ * same effect as calling tputc for each character. It only handles the plain
+ * state ( no sequence, insert mode, printer, graphic charset or selection ),
+ * otherwise nothing is written and the characters go through tputc.
+ */
+size_t TerminalEmulator::tputascii( const char* buf, size_t len ) {
+	size_t run, done = 0;
+	int x, y, count;
+	Line line;
+
+	if ( mTerm.esc || !IS_SET( MODE_WRAP ) || IS_SET( MODE_INSERT ) || IS_SET( MODE_PRINT ) ||
+		 mTerm.trantbl[mTerm.charset] == CS_GRAPHIC0 || mSel.ob.x != -1 )
+		return 0;
+
+	run = asciiprintlen( buf, len );
+
+	while ( done < run ) {
+		if ( mTerm.c.state & CURSOR_WRAPNEXT ) {
+			mTerm.line[mTerm.c.y][mTerm.c.x].mode |= ATTR_WRAP;
+			tnewline( 1 );
+		}
+
+		x = mTerm.c.x;
+		y = mTerm.c.y;
+		count = (int)MIN( run - done, (size_t)( mTerm.col - x ) );
+		line = mTerm.line[y];
+
+		/* break the wide characters partially overwritten */
+		if ( x > 0 && ( line[x].mode & ATTR_WDUMMY ) ) {
+			line[x - 1].u = ' ';
+			line[x - 1].mode &= ~ATTR_WIDE;
+		}
+		if ( x + count < mTerm.col && ( line[x + count - 1].mode & ATTR_WIDE ) ) {
+			line[x + count].u = ' ';
+			line[x + count].mode &= ~ATTR_WDUMMY;
+		}
+
+		for ( int i = 0; i < count; i++ ) {
+			line[x + i] = mTerm.c.attr;
+			line[x + i].u = (uchar)buf[done + i];
+		}
+
+		mTerm.dirty[y] = 1;
+		done += count;
+
+		if ( x + count < mTerm.col ) {
+			tmoveto( x + count, y );
+		} else {
+			tmoveto( mTerm.col - 1, y );
+			mTerm.c.state |= CURSOR_WRAPNEXT;
+		}
+	}
+
+	if ( run > 0 ) {
+		mTerm.lastc = (uchar)buf[run - 1];
+		mDirty = true;
+	}
+
+	return run;
+}
+
 int TerminalEmulator::twrite( const char* buf, int buflen, int show_ctrl ) {
 	size_t charsize;
 	Rune u;
 	int n;
 
 	for ( n = 0; n < buflen; n += charsize ) {
+		if ( !show_ctrl && ( charsize = tputascii( buf + n, buflen - n ) ) > 0 )
+			continue;
 		if ( IS_SET( MODE_UTF8 ) ) {
 			/* process a complete utf8 char */
 			charsize = utf8decode( buf + n, &u, buflen - n );
@@ -2290,7 +2375,7 @@ int TerminalEmulator::twrite( const char* buf, int buflen, int show_ctrl ) {
 }
 
 void TerminalEmulator::tresize( int col, int row ) {
-	int i, j;
+	int i;
 	int minrow = MIN( row, mTerm.row );
 	int mincol = MIN( col, mTerm.col );
 	int* bp;
@@ -2338,15 +2423,6 @@ void TerminalEmulator::tresize( int col, int row ) {
 		mTerm.alt[i] = (Line)xmalloc( col * sizeof( TerminalGlyph ) );
 	}
 
-	/* add new columns to history */
-	for ( int i = 0; i < mTerm.histcursize; i++ ) {
-		mTerm.hist[i] = (TerminalGlyph*)xrealloc( mTerm.hist[i], col * sizeof( TerminalGlyph ) );
-		for ( j = mincol; j < col; j++ ) {
-			mTerm.hist[i][j] = mTerm.c.attr;
-			mTerm.hist[i][j].u = ' ';
-		}
-	}
-
 	if ( col > mTerm.col ) {
 		bp = mTerm.tabs + mTerm.col;
 
@@ -2680,6 +2756,18 @@ int TerminalEmulator::getHistorySize() const {
 	return mTerm.histi;
 }
 
+void TerminalEmulator::setHistoryMaxMemoryPages( size_t maxMemoryPages ) {
+	mHistory.setMaxMemoryPages( maxMemoryPages );
+}
+
+size_t TerminalEmulator::getHistoryMaxMemoryPages() const {
+	return mHistory.getMaxMemoryPages();
+}
+
+size_t TerminalEmulator::getHistoryMemoryUsage() const {
+	return mHistory.getMemoryUsage();
+}
+
 int TerminalEmulator::write( const char* buf, size_t buflen ) {
 	return mPty->write( buf, (int)buflen );
 }
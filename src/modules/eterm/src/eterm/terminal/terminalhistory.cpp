@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cstring>
+#include <eterm/terminal/terminalhistory.hpp>
+
+#define HISTORY_PAGE_LINES ( 256 )
+#define HISTORY_CACHE_LINES ( 64 )
+#define HISTORY_MIN_REPEAT ( 3 )
+#define HISTORY_MIN_COMPACT ( 4 * 1024 )
+
+namespace eterm { namespace Terminal {
+
+static inline void putVarint( std::vector<uint8_t>& out, uint32_t value ) {
+	while ( value >= 0x80 ) {
+		out.push_back( static_cast<uint8_t>( value | 0x80 ) );
+		value >>= 7;
+	}
+	out.push_back( static_cast<uint8_t>( value ) );
+}
+
+static inline uint32_t getVarint( const uint8_t* data, size_t size, size_t& pos ) {
+	uint32_t value = 0;
+
+	for ( int shift = 0; pos < size && shift < 35; shift += 7 ) {
+		uint8_t byte = data[pos++];
+		value |= static_cast<uint32_t>( byte & 0x7F ) << shift;
+
+		if ( !( byte & 0x80 ) )
+			break;
+	}
+
+	return value;
+}
+
+static inline bool sameAttributes( const TerminalGlyph& a, const TerminalGlyph& b ) {
+	return a.mode == b.mode && a.fg == b.fg && a.bg == b.bg;
+}
+
+TerminalHistory::TerminalHistory() : mCache( HISTORY_CACHE_LINES ) {}
+
+TerminalHistory::~TerminalHistory() {
+	clear();
+}
+
+void TerminalHistory::reset( size_t capacity ) {
+	clear();
+	mCapacity = capacity;
+	mPages.resize( ( capacity + HISTORY_PAGE_LINES - 1 ) / HISTORY_PAGE_LINES );
+}
+
+size_t TerminalHistory::getCapacity() const {
+	return mCapacity;
+}
+
+void TerminalHistory::store( size_t slot, const TerminalGlyph* line, int columns ) {
+	if ( slot >= mCapacity )
+		return;
+
+	CacheEntry& entry = mCache[slot % HISTORY_CACHE_LINES];
+
+	if ( entry.slot == slot )
+		entry.slot = SIZE_MAX;
+
+	encode( line, columns );
+
+	// The line is appended to the page, the replaced lines are dropped when the page is compacted
+	Page* page = getPage( slot, true );
+	size_t index = slot % HISTORY_PAGE_LINES;
+	size_t oldSize = page->data.size();
+
+	page->garbage += page->sizes[index];
+	page->offsets[index] = static_cast<uint32_t>( oldSize );
+	page->sizes[index] = static_cast<uint32_t>( mEncoded.size() );
+	page->data.insert( page->data.end(), mEncoded.begin(), mEncoded.end() );
+
+	if ( page->garbage >= HISTORY_MIN_COMPACT && page->garbage > page->data.size() / 2 )
+		compact( page );
+
+	mMemoryUsage = mMemoryUsage + page->data.size() - oldSize;
+}
+
+Line TerminalHistory::get( size_t slot, int columns, const TerminalGlyph& fill ) {
+	CacheEntry& entry = mCache[slot % HISTORY_CACHE_LINES];
+
+	if ( entry.slot == slot && entry.line.size() == static_cast<size_t>( columns ) )
+		return entry.line.data();
+
+	entry.line.resize( columns );
+	entry.slot = slot;
+
+	Page* page = slot < mCapacity ? getPage( slot, false ) : nullptr;
+	size_t index = slot % HISTORY_PAGE_LINES;
+
+	if ( nullptr != page && page->sizes[index] > 0 ) {
+		decode( page->data.data() + page->offsets[index], page->sizes[index], entry.line.data(),
+				columns, fill );
+	} else {
+		decode( nullptr, 0, entry.line.data(), columns, fill );
+	}
+
+	return entry.line.data();
+}
+
+void TerminalHistory::exchange( size_t slot, Line line, int columns, const TerminalGlyph& fill ) {
+	Line cur = get( slot, columns, fill );
+	std::vector<TerminalGlyph> prev( cur, cur + columns );
+
+	store( slot, line, columns );
+	memcpy( line, prev.data(), columns * sizeof( TerminalGlyph ) );
+}
+
+void TerminalHistory::clear() {
+	for ( auto& page : mPages )
+		page.reset();
+
+	for ( auto& entry : mCache ) {
+		entry.slot = SIZE_MAX;
+		std::vector<TerminalGlyph>().swap( entry.line );
+	}
+
+	if ( nullptr != mFile ) {
+		fclose( mFile );
+		mFile = nullptr;
+	}
+
+	mResidentPages = 0;
+	mMemoryUsage = 0;
+	mDiskUsage = 0;
+}
+
+void TerminalHistory::setMaxMemoryPages( size_t maxMemoryPages ) {
+	mMaxMemoryPages = maxMemoryPages;
+
+	while ( mMaxMemoryPages > 0 && mResidentPages > mMaxMemoryPages ) {
+		Page* lru = nullptr;
+
+		for ( auto& page : mPages ) {
+			if ( page && page->resident && ( nullptr == lru || page->lastUse < lru->lastUse ) )
+				lru = page.get();
+		}
+
+		if ( nullptr == lru || !spill( lru ) )
+			break;
+	}
+}
+
+size_t TerminalHistory::getMaxMemoryPages() const {
+	return mMaxMemoryPages;
+}
+
+size_t TerminalHistory::getMemoryUsage() const {
+	return mMemoryUsage;
+}
+
+size_t TerminalHistory::getDiskUsage() const {
+	return mDiskUsage;
+}
+
+TerminalHistory::Page* TerminalHistory::getPage( size_t slot, bool create ) {
+	std::unique_ptr<Page>& page = mPages[slot / HISTORY_PAGE_LINES];
+
+	if ( !page ) {
+		if ( !create )
+			return nullptr;
+
+		page.reset( new Page() );
+		page->offsets.resize( HISTORY_PAGE_LINES, 0 );
+		page->sizes.resize( HISTORY_PAGE_LINES, 0 );
+		mResidentPages++;
+	}
+
+	touch( page.get() );
+	return page.get();
+}
+
+void TerminalHistory::touch( Page* page ) {
+	page->lastUse = ++mUseCount;
+
+	if ( !page->resident )
+		load( page );
+
+	if ( 0 == mMaxMemoryPages || mResidentPages <= mMaxMemoryPages )
+		return;
+
+	Page* lru = nullptr;
+
+	for ( auto& cur : mPages ) {
+		if ( cur && cur.get() != page && cur->resident &&
+			 ( nullptr == lru || cur->lastUse < lru->lastUse ) )
+			lru = cur.get();
+	}
+
+	if ( nullptr != lru )
+		spill( lru );
+}
+
+void TerminalHistory::compact( Page* page ) {
+	std::vector<uint8_t> data;
+	data.reserve( page->data.size() - page->garbage );
+
+	for ( size_t i = 0; i < HISTORY_PAGE_LINES; i++ ) {
+		if ( 0 == page->sizes[i] )
+			continue;
+
+		const uint8_t* line = page->data.data() + page->offsets[i];
+		page->offsets[i] = static_cast<uint32_t>( data.size() );
+		data.insert( data.end(), line, line + page->sizes[i] );
+	}
+
+	page->data.swap( data );
+	page->garbage = 0;
+}
+
+bool TerminalHistory::spill( Page* page ) {
+	if ( nullptr == mFile && nullptr == ( mFile = tmpfile() ) )
+		return false;
+
+	size_t oldSize = page->data.size();
+
+	if ( page->garbage > 0 )
+		compact( page );
+
+	size_t size = page->data.size();
+	mMemoryUsage = mMemoryUsage + size - oldSize;
+
+	// Reuse the file region of the page when the data still fits in it
+	if ( size > page->fileCapacity ) {
+		if ( 0 != fseek( mFile, 0, SEEK_END ) )
+			return false;
+
+		long offset = ftell( mFile );
+
+		if ( offset < 0 )
+			return false;
+
+		page->fileOffset = offset;
+		page->fileCapacity = size;
+	} else if ( 0 != fseek( mFile, page->fileOffset, SEEK_SET ) ) {
+		return false;
+	}
+
+	if ( size > 0 && fwrite( page->data.data(), 1, size, mFile ) != size ) {
+		page->fileCapacity = 0;
+		return false;
+	}
+
+	std::vector<uint8_t>().swap( page->data );
+	page->dataSize = size;
+	page->resident = false;
+	mResidentPages--;
+	mMemoryUsage -= size;
+	mDiskUsage += size;
+	return true;
+}
+
+bool TerminalHistory::load( Page* page ) {
+	bool loaded = false;
+
+	page->data.resize( page->dataSize );
+
+	if ( 0 == page->dataSize ) {
+		loaded = true;
+	} else if ( nullptr != mFile && 0 == fseek( mFile, page->fileOffset, SEEK_SET ) ) {
+		loaded = fread( page->data.data(), 1, page->dataSize, mFile ) == page->dataSize;
+	}
+
+	// The lines can't be recovered, the slots are left empty
+	if ( !loaded ) {
+		page->data.clear();
+		std::fill( page->sizes.begin(), page->sizes.end(), 0 );
+	}
+
+	mDiskUsage -= page->dataSize;
+	mMemoryUsage += page->data.size();
+	mResidentPages++;
+	page->dataSize = 0;
+	page->resident = true;
+	return loaded;
+}
+
+void TerminalHistory::encode( const TerminalGlyph* line, int columns ) {
+	mEncoded.clear();
+	putVarint( mEncoded, columns );
+
+	// Attribute runs: length, mode, foreground and background
+	for ( int x = 0; x < columns; ) {
+		int start = x;
+
+		while ( x < columns && sameAttributes( line[x], line[start] ) )
+			x++;
+
+		putVarint( mEncoded, x - start );
+		putVarint( mEncoded, line[start].mode );
+		putVarint( mEncoded, line[start].fg );
+		putVarint( mEncoded, line[start].bg );
+	}
+
+	// Runes: rune + 1, or 0 followed by the count and the rune for repeated runes
+	for ( int x = 0; x < columns; ) {
+		Rune u = line[x].u;
+		int count = 1;
+
+		while ( x + count < columns && line[x + count].u == u )
+			count++;
+
+		if ( count >= HISTORY_MIN_REPEAT ) {
+			putVarint( mEncoded, 0 );
+			putVarint( mEncoded, count );
+			putVarint( mEncoded, u );
+		} else {
+			for ( int i = 0; i < count; i++ )
+				putVarint( mEncoded, u + 1 );
+		}
+
+		x += count;
+	}
+}
+
+void TerminalHistory::decode( const uint8_t* data, size_t size, TerminalGlyph* line, int columns,
+							  const TerminalGlyph& fill ) {
+	size_t pos = 0;
+	uint32_t lineColumns = getVarint( data, size, pos );
+	int stored = static_cast<int>( std::min<uint32_t>( lineColumns, columns ) );
+	uint32_t decoded = 0;
+	int x = 0;
+
+	// All the runs are read, even when the line is truncated, since the runes follow them
+	while ( decoded < lineColumns && pos < size ) {
+		uint32_t length = getVarint( data, size, pos );
+		ushort mode = static_cast<ushort>( getVarint( data, size, pos ) );
+		uint32_t fg = getVarint( data, size, pos );
+		uint32_t bg = getVarint( data, size, pos );
+
+		if ( 0 == length )
+			break;
+
+		decoded += length;
+
+		for ( ; x < stored && length > 0; x++, length-- ) {
+			line[x].mode = mode;
+			line[x].fg = fg;
+			line[x].bg = bg;
+		}
+	}
+
+	stored = x;
+	x = 0;
+
+	while ( x < stored && pos < size ) {
+		uint32_t token = getVarint( data, size, pos );
+
+		if ( token > 0 ) {
+			line[x++].u = token - 1;
+			continue;
+		}
+
+		uint32_t length = getVarint( data, size, pos );
+		int count = static_cast<int>( std::min<uint32_t>( length, stored - x ) );
+		Rune u = getVarint( data, size, pos );
+
+		for ( int i = 0; i < count; i++ )
+			line[x++].u = u;
+	}
+
+	for ( int i = x; i < stored; i++ )
+		line[i].u = ' ';
+
+	for ( int i = stored; i < columns; i++ ) {
+		line[i] = fill;
+		line[i].u = ' ';
+	}
+}
+
+}} // namespace eterm::Terminal
@@ -0,0 +1,148 @@
+#include <eepp/ee.hpp>
+
+// Runs HttpEventLoop requests against a loopback server: the responses must be parsed correctly
+// ( content length and chunked bodies ) and the requests must reuse the same keep-alive
+// connection.
+
+static const std::string LENGTH_BODY = "Hello from the loopback server";
+static const std::string CHUNKED_BODY = "Hello chunked world";
+
+class LoopbackServer {
+  public:
+	LoopbackServer() : mThread( &LoopbackServer::run, this ) {}
+
+	~LoopbackServer() {
+		mRunning = false;
+		mThread.wait();
+		mListener.close();
+	}
+
+	bool start() {
+		if ( mListener.listen( Socket::AnyPort, IpAddress::LocalHost ) != Socket::Done )
+			return false;
+		mListener.setBlocking( false );
+		mThread.launch();
+		return true;
+	}
+
+	unsigned short getPort() const { return mListener.getLocalPort(); }
+
+	int getConnectionsAccepted() const { return mConnectionsAccepted; }
+
+  protected:
+	TcpListener mListener;
+	Thread mThread;
+	std::atomic<bool> mRunning{ true };
+	std::atomic<int> mConnectionsAccepted{ 0 };
+
+	void run() {
+		std::vector<std::unique_ptr<TcpSocket>> clients;
+		std::vector<std::string> buffers;
+
+		while ( mRunning ) {
+			auto client = std::make_unique<TcpSocket>();
+			if ( mListener.accept( *client ) == Socket::Done ) {
+				client->setBlocking( false );
+				clients.emplace_back( std::move( client ) );
+				buffers.emplace_back();
+				mConnectionsAccepted++;
+			}
+
+			for ( size_t i = 0; i < clients.size(); i++ ) {
+				char data[1024];
+				std::size_t received = 0;
+				if ( clients[i]->receive( data, sizeof( data ), received ) == Socket::Done )
+					buffers[i].append( data, received );
+
+				size_t end;
+				while ( ( end = buffers[i].find( "\r\n\r\n" ) ) != std::string::npos ) {
+					std::string request( buffers[i].substr( 0, end ) );
+					buffers[i].erase( 0, end + 4 );
+					respond( *clients[i], request );
+				}
+			}
+
+			Sys::sleep( Milliseconds( 1 ) );
+		}
+	}
+
+	void respond( TcpSocket& client, const std::string& request ) {
+		std::string response;
+
+		if ( request.find( "GET /chunked " ) == 0 ) {
+			response = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+			size_t half = CHUNKED_BODY.size() / 2;
+			response += String::format( "%zx\r\n", half ) + CHUNKED_BODY.substr( 0, half ) +
+						"\r\n";
+			response += String::format( "%zx\r\n", CHUNKED_BODY.size() - half ) +
+						CHUNKED_BODY.substr( half ) + "\r\n0\r\n\r\n";
+		} else {
+			response = String::format( "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n\r\n",
+									   LENGTH_BODY.size() ) +
+					   LENGTH_BODY;
+		}
+
+		client.setBlocking( true );
+		client.send( response.c_str(), response.size() );
+		client.setBlocking( false );
+	}
+};
+
+EE_MAIN_FUNC int main( int, char*[] ) {
+	bool success = true;
+
+	{
+		LoopbackServer server;
+
+		if ( !server.start() ) {
+			std::cerr << "Couldn't start the loopback server" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		HttpEventLoop loop( false, 1 );
+		URI uri( String::format( "http://127.0.0.1:%d", (int)server.getPort() ) );
+		std::vector<std::pair<std::string, std::string>> requests = {
+			{ "/length", LENGTH_BODY }, { "/chunked", CHUNKED_BODY }, { "/length", LENGTH_BODY } };
+		size_t completed = 0;
+
+		for ( const auto& request : requests ) {
+			std::string path( request.first );
+			std::string expected( request.second );
+			loop.request( uri, Http::Request( path ),
+						  [&completed, &success, path, expected](
+							  const Http&, Http::Request&, Http::Response& response ) {
+							  completed++;
+							  if ( response.getStatus() != Http::Response::Ok ||
+								   response.getBody() != expected ) {
+								  std::cerr << "Unexpected response for " << path << ": "
+											<< response.getStatus() << " \""
+											<< response.getBody() << "\"" << std::endl;
+								  success = false;
+							  }
+						  },
+						  Seconds( 5 ) );
+		}
+
+		Clock clock;
+		while ( completed < requests.size() && clock.getElapsedTime() < Seconds( 10 ) )
+			loop.update( Milliseconds( 10 ) );
+
+		if ( completed != requests.size() ) {
+			std::cerr << "Only " << completed << " of " << requests.size()
+					  << " requests completed" << std::endl;
+			success = false;
+		}
+
+		if ( server.getConnectionsAccepted() != 1 ) {
+			std::cerr << "The requests used " << server.getConnectionsAccepted()
+					  << " connections instead of reusing one" << std::endl;
+			success = false;
+		}
+	}
+
+	std::cout << ( success ? "HttpEventLoop loopback test passed"
+						   : "HttpEventLoop loopback test failed" )
+			  << std::endl;
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,6 @@
 #include "commandpalette.hpp"
+#include "fuzzymatcher.hpp"
+#include <climits>
 
 namespace ecode {
 
@@ -66,24 +68,28 @@ void CommandPalette::setCurModel( const std::shared_ptr<CommandPaletteModel>& cu
 
 std::shared_ptr<CommandPaletteModel>
 CommandPalette::fuzzyMatch( const std::vector<std::vector<std::string>>& cmdPalette,
-							const std::string& match, const size_t& max ) const {
+							const std::string& match, const size_t& max,
+							const CancellationToken& token ) const {
 	if ( cmdPalette.empty() )
 		return {};
 
-	Lock rl( mMatchingMutex );
-	std::multimap<int, int, std::greater<int>> matchesMap;
 	std::vector<std::vector<std::string>> ret;
-
-	for ( size_t i = 0; i < cmdPalette.size(); i++ ) {
-		int matchName = String::fuzzyMatch( cmdPalette[i][0], match );
-		int matchKeybind = String::fuzzyMatch( cmdPalette[i][1], match );
-		matchesMap.insert( { std::max( matchName, matchKeybind ), i } );
-	}
-	for ( auto& res : matchesMap ) {
-		if ( ret.size() < max ) {
-			ret.push_back( { cmdPalette[res.second][0], cmdPalette[res.second][1],
-							 cmdPalette[res.second][2] } );
-		}
+	FuzzyMatcher matcher( match );
+	auto matches = matcher.match(
+		mPool.get(), cmdPalette.size(),
+		[&]( size_t i ) {
+			int matchName = matcher.mayMatch( cmdPalette[i][0] )
+								? matcher.score( cmdPalette[i][0] )
+								: INT_MIN;
+			int matchKeybind = matcher.mayMatch( cmdPalette[i][1] )
+								   ? matcher.score( cmdPalette[i][1] )
+								   : INT_MIN;
+			return std::max( matchName, matchKeybind );
+		},
+		max, token );
+	for ( const auto& res : matches ) {
+		ret.push_back(
+			{ cmdPalette[res.index][0], cmdPalette[res.index][1], cmdPalette[res.index][2] } );
 	}
 	return CommandPaletteModel::create( 3, ret );
 }
@@ -93,11 +99,22 @@ void CommandPalette::asyncFuzzyMatch( const std::string& match, const size_t& ma
 	if ( !mCurModel )
 		return;
 
-	mPool->run( [&, match, max, res]() {
-		const std::vector<std::vector<std::string>>& cmdPalette =
-			mCurModel.get() == mBaseModel.get() ? mCommandPalette : mCommandPaletteEditor;
-		res( fuzzyMatch( cmdPalette, match, max ) );
-	} );
+	CancellationToken token;
+	{
+		Lock l( mMatchTokenMutex );
+		mMatchToken.cancel();
+		mMatchToken = token;
+	}
+	// The commands are copied, so they are matched without locks while the palette can change
+	std::vector<std::vector<std::string>> cmdPalette(
+		mCurModel.get() == mBaseModel.get() ? mCommandPalette : mCommandPaletteEditor );
+	mPool->run(
+		[this, cmdPalette = std::move( cmdPalette ), match, max, res, token]() {
+			auto model = fuzzyMatch( cmdPalette, match, max, token );
+			if ( !token.isCancelled() )
+				res( model );
+		},
+		ThreadPool::Priority::High, token );
 }
 
 } // namespace ecode
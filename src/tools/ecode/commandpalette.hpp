@@ -27,11 +27,13 @@ class CommandPalette {
 	static std::shared_ptr<CommandPaletteModel>
 	asModel( const std::vector<std::string>& commandList, const EE::UI::KeyBindings& keybindings );
 
+	/** Matches in the thread pool. A new match cancels the previous one if it didn't finish,
+	 * its callback is not called. */
 	void asyncFuzzyMatch( const std::string& match, const size_t& max, MatchResultCb res ) const;
 
 	std::shared_ptr<CommandPaletteModel>
 	fuzzyMatch( const std::vector<std::vector<std::string>>& cmdPalette, const std::string& match,
-				const size_t& max ) const;
+				const size_t& max, const CancellationToken& token = CancellationToken() ) const;
 
 	void setCommandPalette( const std::vector<std::string>& commandList,
 							const EE::UI::KeyBindings& keybindings );
@@ -57,7 +59,8 @@ class CommandPalette {
 	void setCurModel( const std::shared_ptr<CommandPaletteModel>& curModel );
 
   protected:
-	mutable Mutex mMatchingMutex;
+	mutable Mutex mMatchTokenMutex;
+	mutable CancellationToken mMatchToken;
 	std::shared_ptr<ThreadPool> mPool;
 	std::vector<std::vector<std::string>> mCommandPalette;
 	std::vector<std::vector<std::string>> mCommandPaletteEditor;
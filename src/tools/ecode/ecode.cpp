@@ -510,6 +510,10 @@ ProjectDirectoryTree* App::getDirTree() const {
 	return mDirTree ? mDirTree.get() : nullptr;
 }
 
+ProjectSearchIndex* App::getProjectSearchIndex() const {
+	return mProjectSearchIndex ? mProjectSearchIndex.get() : nullptr;
+}
+
 std::shared_ptr<ThreadPool> App::getThreadPool() const {
 	return mThreadPool;
 }
@@ -632,6 +636,7 @@ App::App( const size_t& jobs, const std::vector<std::string>& args ) :
 		ThreadPool::createShared( jobs > 0 ? jobs : eemax<int>( 2, Sys::getCPUCount() ) ) ) {}
 
 App::~App() {
+	closeProjectSearchIndex();
 	mThreadPool.reset();
 	if ( mFileWatcher ) {
 		Lock l( mWatchesLock );
@@ -1769,6 +1774,7 @@ void App::closeEditors() {
 	}
 
 	mCurrentProject = "";
+	closeProjectSearchIndex();
 	mDirTree = nullptr;
 	if ( mFileSystemListener )
 		mFileSystemListener->setDirTree( mDirTree );
@@ -1998,6 +2004,7 @@ void App::onCodeEditorCreated( UICodeEditor* editor, TextDocument& doc ) {
 	doc.setIndentType( docc.indentSpaces ? TextDocument::IndentType::IndentSpaces
 										 : TextDocument::IndentType::IndentTabs );
 	doc.setIndentWidth( docc.indentWidth );
+	doc.getHighlighter()->setThreadPool( mThreadPool );
 	doc.setAutoDetectIndentType( docc.autoDetectIndentType );
 	doc.setBOM( docc.writeUnicodeBOM );
 
@@ -2215,6 +2222,56 @@ void App::removeFolderWatches() {
 	}
 }
 
+void App::closeProjectSearchIndex() {
+	if ( !mProjectSearchIndex )
+		return;
+	if ( mFileSystemListener )
+		mFileSystemListener->removeListener( mProjectSearchIndexListenerId );
+	mProjectSearchIndex->close();
+	mProjectSearchIndex.reset();
+}
+
+void App::loadProjectSearchIndex( const std::string& path ) {
+	closeProjectSearchIndex();
+	if ( !mDirTree || mDirTree->getPath() != path )
+		return;
+	std::string projectFolder( path );
+	FileSystem::dirAddSlashAtEnd( projectFolder );
+	std::string projectsPath( mConfigPath + "projects" + FileSystem::getOSSlash() );
+	if ( !FileSystem::fileExists( projectsPath ) )
+		FileSystem::makeDir( projectsPath );
+	mProjectSearchIndex = std::make_shared<ProjectSearchIndex>(
+		projectsPath + MD5::fromString( projectFolder ).toHexString() + ".trigrams", mThreadPool );
+	mProjectSearchIndex->build( mDirTree->getFiles() );
+	if ( !mFileSystemListener )
+		return;
+	// File events are received in the file watcher thread, after the directory tree was updated.
+	std::weak_ptr<ProjectSearchIndex> weakIndex( mProjectSearchIndex );
+	std::weak_ptr<ProjectDirectoryTree> weakDirTree( mDirTree );
+	mProjectSearchIndexListenerId = mFileSystemListener->addListener(
+		[weakIndex, weakDirTree]( const FileEvent& event, const FileInfo& file ) {
+			auto index = weakIndex.lock();
+			auto dirTree = weakDirTree.lock();
+			if ( !index || !dirTree )
+				return;
+			switch ( event.type ) {
+				case FileSystemEventType::Moved:
+					index->onFileRemoved( FileSystem::isRelativePath( event.oldFilename )
+											  ? event.directory + event.oldFilename
+											  : event.oldFilename );
+					[[fallthrough]];
+				case FileSystemEventType::Add:
+				case FileSystemEventType::Modified:
+					if ( file.isRegularFile() && dirTree->isFileInTree( file.getFilepath() ) )
+						index->onFileChanged( file.getFilepath() );
+					break;
+				case FileSystemEventType::Delete:
+					index->onFileRemoved( file.getFilepath() );
+					break;
+			}
+		} );
+}
+
 void App::loadDirTree( const std::string& path ) {
 	Clock* clock = eeNew( Clock, () );
 	mDirTreeReady = false;
@@ -2226,10 +2283,13 @@ void App::loadDirTree( const std::string& path ) {
 					   clock->getElapsedTime().asMilliseconds(), dirTree.getFilesCount() );
 			eeDelete( clock );
 			mDirTreeReady = true;
-			mUISceneNode->runOnMainThread( [&] {
+			mUISceneNode->runOnMainThread( [&, path = dirTree.getPath()] {
 				mUniversalLocator->updateFilesTable();
 				if ( mSplitter->curEditorExistsAndFocused() )
 					syncProjectTreeWithEditor( mSplitter->getCurEditor() );
+#if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
+				loadProjectSearchIndex( path );
+#endif
 			} );
 			if ( mFileWatcher ) {
 				removeFolderWatches();
@@ -2363,7 +2423,8 @@ void App::toggleHiddenFiles() {
 											   {},
 											   [&]( const std::string& filePath ) -> bool {
 												   return isFileVisibleInTreeView( filePath );
-											   } } );
+											   } },
+											 mThreadPool );
 	if ( mProjectTreeView )
 		mProjectTreeView->setModel( mFileSystemModel );
 	if ( mFileSystemListener )
@@ -2607,7 +2668,8 @@ void App::initProjectTreeView( std::string path ) {
 					folderPath, FileSystemModel::Mode::FilesAndDirectories,
 					{ true, true, true, {}, [&]( const std::string& filePath ) -> bool {
 						 return isFileVisibleInTreeView( filePath );
-					 } } );
+					 } },
+					mThreadPool );
 
 				mProjectTreeView->setModel( mFileSystemModel );
 				mProjectViewEmptyCont->setVisible( false );
@@ -2808,7 +2870,8 @@ void App::loadFolder( const std::string& path ) {
 		FileSystemModel::New( rpath, FileSystemModel::Mode::FilesAndDirectories,
 							  { true, true, true, {}, [&]( const std::string& filePath ) -> bool {
 								   return isFileVisibleInTreeView( filePath );
-							   } } );
+							   } },
+							  mThreadPool );
 
 	if ( mProjectTreeView )
 		mProjectTreeView->setModel( mFileSystemModel );
@@ -9,6 +9,7 @@
 #include "notificationcenter.hpp"
 #include "plugins/pluginmanager.hpp"
 #include "projectdirectorytree.hpp"
+#include "projectsearchindex.hpp"
 #include "terminalmanager.hpp"
 #include "universallocator.hpp"
 #include <eepp/ee.hpp>
@@ -72,6 +73,8 @@ class App : public UICodeEditorSplitter::Client {
 
 	ProjectDirectoryTree* getDirTree() const;
 
+	ProjectSearchIndex* getProjectSearchIndex() const;
+
 	std::shared_ptr<ThreadPool> getThreadPool() const;
 
 	void loadFileFromPath( const std::string& path, bool inNewTab = true,
@@ -384,6 +387,8 @@ class App : public UICodeEditorSplitter::Client {
 	Float mDisplayDPI{ 96 };
 	std::shared_ptr<ThreadPool> mThreadPool;
 	std::shared_ptr<ProjectDirectoryTree> mDirTree;
+	std::shared_ptr<ProjectSearchIndex> mProjectSearchIndex;
+	Uint64 mProjectSearchIndexListenerId{ 0 };
 	UITreeView* mProjectTreeView{ nullptr };
 	UILinearLayout* mProjectViewEmptyCont{ nullptr };
 	std::shared_ptr<FileSystemModel> mFileSystemModel;
@@ -429,6 +434,10 @@ class App : public UICodeEditorSplitter::Client {
 
 	void loadDirTree( const std::string& path );
 
+	void loadProjectSearchIndex( const std::string& path );
+
+	void closeProjectSearchIndex();
+
 	void showSidePanel( bool show );
 
 	void onFileDropped( String file );
@@ -0,0 +1,147 @@
+#include "fuzzymatcher.hpp"
+#include <algorithm>
+#include <climits>
+#include <eepp/core/string.hpp>
+#include <eepp/system/lock.hpp>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ECODE_FUZZY_MATCHER_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FUZZY_MATCHER_MAX_CHARS ( 32 )
+#define FUZZY_MATCHER_MIN_GRAIN ( 1024 )
+#define FUZZY_MATCHER_CANCEL_CHECK ( 256 )
+
+namespace ecode {
+
+static inline char asciiToLower( char c ) {
+	return c >= 'A' && c <= 'Z' ? c + ( 'a' - 'A' ) : c;
+}
+
+static inline bool isBetterMatch( const FuzzyMatcher::Match& left,
+								  const FuzzyMatcher::Match& right ) {
+	return left.score > right.score || ( left.score == right.score && left.index < right.index );
+}
+
+/** Keeps the best max matches in a heap where the front is the worst of them. */
+static inline void pushBestMatch( std::vector<FuzzyMatcher::Match>& heap,
+								  const FuzzyMatcher::Match& match, const size_t& max ) {
+	if ( heap.size() < max ) {
+		heap.push_back( match );
+		std::push_heap( heap.begin(), heap.end(), isBetterMatch );
+	} else if ( isBetterMatch( match, heap.front() ) ) {
+		std::pop_heap( heap.begin(), heap.end(), isBetterMatch );
+		heap.back() = match;
+		std::push_heap( heap.begin(), heap.end(), isBetterMatch );
+	}
+}
+
+FuzzyMatcher::FuzzyMatcher( const std::string& pattern ) : mPattern( pattern ) {
+	// The prefilter only needs a subset of the characters to discard candidates
+	for ( const auto& c : pattern ) {
+		char lower = asciiToLower( c );
+		if ( lower != ' ' && mChars.find( lower ) == std::string::npos &&
+			 mChars.size() < FUZZY_MATCHER_MAX_CHARS )
+			mChars.push_back( lower );
+	}
+}
+
+bool FuzzyMatcher::mayMatch( const std::string& str ) const {
+	size_t chars = mChars.size();
+	if ( chars == 0 )
+		return true;
+	Uint32 pending = chars == 32 ? 0xFFFFFFFF : ( 1u << chars ) - 1;
+	const char* it = str.data();
+	const char* end = it + str.size();
+#ifdef ECODE_FUZZY_MATCHER_SSE2
+	__m128i needles[FUZZY_MATCHER_MAX_CHARS];
+	for ( size_t i = 0; i < chars; i++ )
+		needles[i] = _mm_set1_epi8( mChars[i] );
+	const __m128i upperMin = _mm_set1_epi8( 'A' - 1 );
+	const __m128i upperMax = _mm_set1_epi8( 'Z' + 1 );
+	const __m128i caseBit = _mm_set1_epi8( 'a' - 'A' );
+	while ( end - it >= 16 ) {
+		__m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( it ) );
+		// Only ASCII is lowercased, the bytes >= 0x80 are negative and never in the range
+		__m128i upper =
+			_mm_and_si128( _mm_cmpgt_epi8( chunk, upperMin ), _mm_cmplt_epi8( chunk, upperMax ) );
+		chunk = _mm_or_si128( chunk, _mm_and_si128( upper, caseBit ) );
+		for ( size_t i = 0; i < chars; i++ ) {
+			if ( ( pending & ( 1u << i ) ) &&
+				 _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, needles[i] ) ) )
+				pending &= ~( 1u << i );
+		}
+		if ( !pending )
+			return true;
+		it += 16;
+	}
+#endif
+	for ( ; it < end; ++it ) {
+		char c = asciiToLower( *it );
+		for ( size_t i = 0; i < chars; i++ ) {
+			if ( mChars[i] == c )
+				pending &= ~( 1u << i );
+		}
+		if ( !pending )
+			return true;
+	}
+	return false;
+}
+
+int FuzzyMatcher::score( const std::string& str ) const {
+	return String::fuzzyMatch( str, mPattern );
+}
+
+std::vector<FuzzyMatcher::Match>
+FuzzyMatcher::match( ThreadPool* pool, size_t count, const std::function<int( size_t )>& scoreFn,
+					 size_t max, const CancellationToken& token ) const {
+	std::vector<Match> best;
+	if ( max == 0 || count == 0 )
+		return best;
+
+	Mutex bestMutex;
+	auto scoreRange = [&]( size_t from, size_t to ) {
+		std::vector<Match> heap;
+		heap.reserve( std::min( max, to - from ) );
+		for ( size_t i = from; i < to; i++ ) {
+			if ( ( i - from ) % FUZZY_MATCHER_CANCEL_CHECK == 0 && token.isCancelled() )
+				return;
+			int score = scoreFn( i );
+			if ( score != INT_MIN )
+				pushBestMatch( heap, { score, i }, max );
+		}
+		Lock l( bestMutex );
+		for ( const auto& match : heap )
+			pushBestMatch( best, match, max );
+	};
+
+	if ( pool ) {
+		size_t grainSize = std::max<size_t>(
+			FUZZY_MATCHER_MIN_GRAIN, count / ( std::max<size_t>( 1, pool->numThreads() ) * 4 ) );
+		pool->parallelFor( 0, count, scoreRange, ThreadPool::Priority::High, grainSize );
+	} else {
+		scoreRange( 0, count );
+	}
+
+	if ( token.isCancelled() )
+		return {};
+
+	std::sort( best.begin(), best.end(), isBetterMatch );
+
+	if ( best.size() < max ) {
+		std::vector<size_t> matched;
+		matched.reserve( best.size() );
+		for ( const auto& match : best )
+			matched.push_back( match.index );
+		std::sort( matched.begin(), matched.end() );
+		for ( size_t i = 0; i < count && best.size() < max; i++ ) {
+			if ( !std::binary_search( matched.begin(), matched.end(), i ) )
+				best.push_back( { INT_MIN, i } );
+		}
+	}
+
+	return best;
+}
+
+} // namespace ecode
@@ -0,0 +1,58 @@
+#ifndef ECODE_FUZZYMATCHER_HPP
+#define ECODE_FUZZYMATCHER_HPP
+
+#include <eepp/system/threadpool.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+
+namespace ecode {
+
+/** Fuzzy matches a pattern against a large list of candidates, keeping only the best results.
+ * The candidates are scored with String::fuzzyMatch in parallel ranges on a thread pool, every
+ * range keeps its best results in a heap bounded to the number of results requested, and the
+ * heaps are merged at the end, so the full list of scores is never sorted.
+ * A candidate can only match if it contains every character of the pattern, mayMatch checks it
+ * with a vectorized scan that is much cheaper than the scoring, so most candidates are discarded
+ * before being scored. */
+class FuzzyMatcher {
+  public:
+	struct Match {
+		int score;
+		size_t index;
+	};
+
+	explicit FuzzyMatcher( const std::string& pattern );
+
+	const std::string& getPattern() const { return mPattern; }
+
+	/** @return False if the string doesn't contain all the pattern characters ( ignoring case
+	 * and spaces ), in that case it can't match the pattern. */
+	bool mayMatch( const std::string& str ) const;
+
+	/** @return The fuzzy match score of the string, INT_MIN if it doesn't match. */
+	int score( const std::string& str ) const;
+
+	/** Scores the candidates [0, count) and returns the best max matches sorted by score, ties
+	 * sorted by index. If less than max candidates match, the result is completed with the
+	 * candidates that didn't match in index order, scored INT_MIN.
+	 * @param pool The pool where the candidates are scored. The calling thread scores candidates
+	 * too, so it can be called from a pool worker. If null the candidates are scored serially.
+	 * @param scoreFn Returns the score of a candidate, INT_MIN if it doesn't match.
+	 * @param token If cancelled, the matching stops as soon as possible and returns no
+	 * results. */
+	std::vector<Match> match( ThreadPool* pool, size_t count,
+							  const std::function<int( size_t )>& scoreFn, size_t max,
+							  const CancellationToken& token = CancellationToken() ) const;
+
+  protected:
+	std::string mPattern;
+	std::string mChars; ///< The distinct lowercased characters of the pattern, without spaces
+};
+
+} // namespace ecode
+
+#endif // ECODE_FUZZYMATCHER_HPP
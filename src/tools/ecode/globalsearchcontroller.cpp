@@ -479,29 +479,72 @@ void GlobalSearchController::doGlobalSearch( String text, bool caseSensitive, bo
 		if ( escapeSequence )
 			text.unescape();
 		std::string search( text.toUtf8() );
+		Uint64 searchId = ++mGlobalSearchId;
+		// Results are displayed as they are found, the search threads queue them and the main
+		// thread appends them in batches to the live model.
+		auto model = ProjectSearch::asModel( {} );
+		auto pending = std::make_shared<PendingSearchResults>();
+		auto flushPending = [this, model, pending, searchId]() -> bool {
+			ProjectSearch::Result results;
+			{
+				Lock l( pending->mutex );
+				results.swap( pending->results );
+				pending->scheduled = false;
+			}
+			if ( searchId != mGlobalSearchId )
+				return false;
+			if ( !results.empty() )
+				model->addResults( results );
+			return true;
+		};
+		// The trigram index discards the files that can't contain the searched text.
+		ProjectSearchIndex* index = mApp->getProjectSearchIndex();
 		ProjectSearch::find(
-			mApp->getDirTree()->getFiles(), search,
+			index && !luaPattern ? index->filterCandidates( mApp->getDirTree()->getFiles(), search )
+								 : mApp->getDirTree()->getFiles(),
+			search,
 #if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
 			mApp->getThreadPool(),
 #endif
-			[&, clock, search, loader, searchReplace,
-			 searchAgain]( const ProjectSearch::Result& res ) {
+			[&, clock, search, loader, searchReplace, searchAgain, model,
+			 flushPending]( const ProjectSearch::Result& ) {
 				Log::info( "Global search for \"%s\" took %.2fms", search.c_str(),
 						   clock->getElapsedTime().asMilliseconds() );
 				eeDelete( clock );
-				mUISceneNode->runOnMainThread( [&, loader, res, search, searchReplace, searchAgain,
-												escapeSequence] {
-					auto model = ProjectSearch::asModel( res );
+				mUISceneNode->runOnMainThread( [&, loader, model, flushPending, search,
+												searchReplace, searchAgain, escapeSequence] {
+					loader->setVisible( false );
+					loader->close();
+					if ( !flushPending() )
+						return;
 					updateGlobalSearchHistory( model, search, searchReplace, searchAgain,
 											   escapeSequence );
 					updateGlobalSearchBarResults( search, model, searchReplace, escapeSequence );
-					loader->setVisible( false );
-					loader->close();
 				} );
 			},
 			caseSensitive, wholeWord,
 			luaPattern ? TextDocument::FindReplaceType::LuaPattern
-					   : TextDocument::FindReplaceType::Normal );
+					   : TextDocument::FindReplaceType::Normal
+#if EE_PLATFORM != EE_PLATFORM_EMSCRIPTEN || defined( __EMSCRIPTEN_PTHREADS__ )
+			,
+			[this, model, pending, flushPending]( const ProjectSearch::ResultData& fileResult ) {
+				Lock l( pending->mutex );
+				pending->results.push_back( fileResult );
+				if ( pending->scheduled )
+					return;
+				pending->scheduled = true;
+				mUISceneNode->runOnMainThread( [this, model, flushPending] {
+					if ( !flushPending() )
+						return;
+					if ( mGlobalSearchTree->getModel() != model.get() )
+						mGlobalSearchTree->setModel( model );
+					mGlobalSearchLayout->findByClass<UITextView>( "search_total" )
+						->setText(
+							String::format( "%zu matches found.", model->resultCount() ) );
+				} );
+			}
+#endif
+		);
 	}
 }
 
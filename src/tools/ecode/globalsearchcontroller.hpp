@@ -78,6 +78,13 @@ class GlobalSearchController {
 	Uint32 mGlobalSearchHistoryOnItemSelectedCb{ 0 };
 	std::deque<std::pair<std::string, std::shared_ptr<ProjectSearch::ResultModel>>>
 		mGlobalSearchHistory;
+	Uint64 mGlobalSearchId{ 0 };
+
+	struct PendingSearchResults {
+		Mutex mutex;
+		ProjectSearch::Result results;
+		bool scheduled{ false };
+	};
 
 	void onLoadDone( const Variant& lineNum, const Variant& colNum );
 
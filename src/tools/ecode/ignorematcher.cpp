@@ -142,12 +142,24 @@ bool gitignore_glob_match( const std::string& text, const std::string& glob,
 	return j >= m;
 }
 
+static bool isGlobLiteral( const std::string& glob, size_t from = 0 ) {
+	return glob.find_first_of( "*?[\\", from ) == std::string::npos;
+}
+
 IgnoreMatcher::IgnoreMatcher( const std::string& rootPath ) : mPath( rootPath ) {
 	FileSystem::dirAddSlashAtEnd( mPath );
 }
 
 IgnoreMatcher::~IgnoreMatcher() {}
 
+bool IgnoreMatcher::matchPath( const std::string& dir, const std::string& value,
+							   bool isDirectory ) const {
+	std::string localPath;
+	if ( String::startsWith( dir, mPath ) )
+		localPath = dir.substr( mPath.size() );
+	return isDirectory ? matchDirectory( localPath + value ) : match( localPath + value );
+}
+
 GitIgnoreMatcher::GitIgnoreMatcher( const std::string& rootPath,
 									const std::string& ignoreFileName ) :
 	IgnoreMatcher( rootPath ),
@@ -189,32 +201,141 @@ bool GitIgnoreMatcher::parse() {
 	}
 	if ( FileSystem::fileExists( mPath + ".git" ) )
 		mPatterns.emplace_back( std::make_pair( "/.git", false ) ); // Also ignore the .git folder
+	compile();
 	return !mPatterns.empty();
 }
 
+void GitIgnoreMatcher::compile() {
+	for ( size_t i = 0; i < mPatterns.size(); i++ ) {
+		const std::string& pattern = mPatterns[i].first;
+
+		// Negations are only evaluated after the pattern they follow matches
+		if ( mPatterns[i].second ) {
+			mHasNegations = true;
+			continue;
+		}
+
+		// The kinds keep the first pattern index, the first match is the one that counts
+		if ( isGlobLiteral( pattern ) ) {
+			if ( pattern.size() > 1 && pattern[0] == '/' ) {
+				mAnchoredPaths.emplace( pattern.substr( 1 ), i );
+			} else if ( pattern.find( '/' ) != std::string::npos ) {
+				mPaths.emplace( pattern, i );
+			} else {
+				mNames.emplace( pattern, i );
+			}
+		} else if ( pattern[0] == '*' && isGlobLiteral( pattern, 1 ) &&
+					pattern.find( '/' ) == std::string::npos ) {
+			std::string suffix( pattern.substr( 1 ) );
+			bool isExtension = suffix.size() > 1 && suffix[0] == '.' &&
+							   suffix.find( '.', 1 ) == std::string::npos;
+			if ( isExtension )
+				mExtensions.emplace( suffix, i );
+			else
+				mSuffixes.emplace_back( suffix, i );
+		} else {
+			mGlobs.push_back( i );
+		}
+
+		if ( String::endsWith( pattern, "/**" ) ) {
+			std::string dir( pattern.substr( 0, pattern.size() - 3 ) );
+			if ( String::startsWith( dir, "**/" ) ) {
+				dir = dir.substr( 3 );
+				if ( !dir.empty() && isGlobLiteral( dir ) )
+					mIgnoredDirNames.emplace_back( dir );
+			} else if ( isGlobLiteral( dir ) ) {
+				if ( !dir.empty() && dir[0] == '/' )
+					dir = dir.substr( 1 );
+				if ( !dir.empty() )
+					mIgnoredDirs.emplace_back( dir );
+			}
+		}
+	}
+}
+
+size_t GitIgnoreMatcher::findFirstMatch( const std::string& value ) const {
+	size_t first = std::string::npos;
+	auto findPattern = [&first]( const PatternIndexMap& patterns, const std::string& key ) {
+		auto it = patterns.find( key );
+		if ( it != patterns.end() && it->second < first )
+			first = it->second;
+	};
+
+	size_t sep = value.rfind( '/' );
+	std::string name( sep != std::string::npos ? value.substr( sep + 1 ) : value );
+
+	if ( !mNames.empty() )
+		findPattern( mNames, name );
+
+	if ( !mExtensions.empty() ) {
+		size_t dot = name.rfind( '.' );
+		if ( dot != std::string::npos )
+			findPattern( mExtensions, name.substr( dot ) );
+	}
+
+	for ( const auto& suffix : mSuffixes ) {
+		if ( suffix.second >= first )
+			break;
+		if ( String::endsWith( name, suffix.first ) ) {
+			first = suffix.second;
+			break;
+		}
+	}
+
+	if ( !mPaths.empty() )
+		findPattern( mPaths, value );
+
+	if ( !mAnchoredPaths.empty() ) {
+		// Same as the glob matching: the leading "./" pairs and "/" are ignored
+		size_t start = 0;
+		while ( start + 1 < value.size() && value[start] == '.' && value[start + 1] == '/' )
+			start += 2;
+		if ( start < value.size() && value[start] == '/' )
+			start++;
+		findPattern( mAnchoredPaths, value.substr( start ) );
+	}
+
+	// Only the patterns before the first match found need to be globbed
+	for ( const auto& index : mGlobs ) {
+		if ( index >= first )
+			break;
+		if ( gitignore_glob_match( value, mPatterns[index].first ) ) {
+			first = index;
+			break;
+		}
+	}
+
+	return first;
+}
+
 bool GitIgnoreMatcher::match( const std::string& value ) const {
 	if ( mPatterns.empty() )
 		return false;
-	bool match = false;
-	for ( size_t i = 0; i < mPatterns.size(); i++ ) {
-		auto& pattern = mPatterns[i];
-		match = gitignore_glob_match( value, pattern.first );
-		if ( pattern.second )
-			match = !match;
-		if ( match && !pattern.second ) {
-			if ( i + 1 < mPatterns.size() && mPatterns[i + 1].second ) {
-				for ( size_t n = i + 1; n < mPatterns.size(); n++ ) {
-					// Check if there's a positive negate after the match
-					if ( mPatterns[n].second ) {
-						if ( gitignore_glob_match( value, mPatterns[n].first ) )
-							return false;
-					} else {
-						break;
-					}
-				}
-			}
+	size_t first = findFirstMatch( value );
+	if ( first == std::string::npos )
+		return false;
+	// Check if there's a positive negate after the match
+	for ( size_t n = first + 1; n < mPatterns.size() && mPatterns[n].second; n++ ) {
+		if ( gitignore_glob_match( value, mPatterns[n].first ) )
+			return false;
+	}
+	return true;
+}
+
+bool GitIgnoreMatcher::matchDirectory( const std::string& value ) const {
+	if ( match( value ) )
+		return true;
+	// A negation could include back some of the directory files
+	if ( mHasNegations || value.empty() || value[0] == '/' || String::startsWith( value, "./" ) )
+		return false;
+	for ( const auto& dir : mIgnoredDirs ) {
+		if ( value == dir )
+			return true;
+	}
+	// "**/" matches any prefix, as in the glob matching
+	for ( const auto& dir : mIgnoredDirNames ) {
+		if ( String::endsWith( value, dir ) )
 			return true;
-		}
 	}
 	return false;
 }
@@ -261,10 +382,17 @@ bool IgnoreMatcherManager::foundMatch() const {
 bool IgnoreMatcherManager::match( const std::string& dir, const std::string& value ) const {
 	eeASSERT( foundMatch() );
 	for ( const auto& matcher : mMatchers ) {
-		std::string localPath;
-		if ( String::startsWith( dir, matcher->getPath() ) )
-			localPath = dir.substr( matcher->getPath().size() );
-		if ( matcher->match( localPath + value ) )
+		if ( matcher->matchPath( dir, value ) )
+			return true;
+	}
+	return false;
+}
+
+bool IgnoreMatcherManager::matchDirectory( const std::string& dir,
+										   const std::string& value ) const {
+	eeASSERT( foundMatch() );
+	for ( const auto& matcher : mMatchers ) {
+		if ( matcher->matchPath( dir, value, true ) )
 			return true;
 	}
 	return false;
@@ -4,6 +4,7 @@
 #include <eepp/system/filesystem.hpp>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace EE;
@@ -21,6 +22,15 @@ class IgnoreMatcher {
 
 	virtual bool match( const std::string& value ) const = 0;
 
+	/** @return True if the directory and everything inside it is ignored, so it doesn't need to
+	 * be walked. */
+	virtual bool matchDirectory( const std::string& value ) const { return match( value ); }
+
+	/** Matches a file of a directory, the directory is made relative to the matcher path.
+	 * @param isDirectory If the file is a directory, matches it with matchDirectory. */
+	bool matchPath( const std::string& dir, const std::string& value,
+					bool isDirectory = false ) const;
+
 	virtual std::string findRepositoryRootPath() const = 0;
 
 	virtual const std::string& getIgnoreFilePath() const = 0;
@@ -47,14 +57,33 @@ class GitIgnoreMatcher : public IgnoreMatcher {
 
 	bool match( const std::string& value ) const override;
 
+	bool matchDirectory( const std::string& value ) const override;
+
 	std::string findRepositoryRootPath() const override;
 
   protected:
+	typedef std::unordered_map<std::string, size_t> PatternIndexMap;
+
 	std::string mIgnoreFileName;
 	std::string mIgnoreFilePath;
 	std::vector<std::pair<std::string, bool>> mPatterns;
+	/* The ignore patterns are compiled by kind, each kind keeps the index of the patterns, so
+	 * the first pattern that matches can be found without globbing every pattern. */
+	PatternIndexMap mNames;			///< Literal file names
+	PatternIndexMap mExtensions;	///< "*.ext" patterns, by extension
+	PatternIndexMap mPaths;			///< Literal paths relative to the ignore file directory
+	PatternIndexMap mAnchoredPaths; ///< Literal paths starting with "/", without it
+	std::vector<std::pair<std::string, size_t>> mSuffixes; ///< Other "*suffix" patterns
+	std::vector<size_t> mGlobs;								///< Patterns that need globbing
+	std::vector<std::string> mIgnoredDirs;		///< Directories of "dir/**" patterns
+	std::vector<std::string> mIgnoredDirNames; ///< Directories of "**/dir/**" patterns
+	bool mHasNegations{ false };
 
 	bool parse() override;
+
+	void compile();
+
+	size_t findFirstMatch( const std::string& value ) const;
 };
 
 class IgnoreMatcherManager {
@@ -71,6 +100,9 @@ class IgnoreMatcherManager {
 
 	bool match( const std::string& dir, const std::string& value ) const;
 
+	/** @return True if the directory and everything inside it is ignored. */
+	bool matchDirectory( const std::string& dir, const std::string& value ) const;
+
 	std::string findRepositoryRootPath() const;
 
 	const std::string& getPath() const;
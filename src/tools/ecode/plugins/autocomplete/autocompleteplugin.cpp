@@ -66,6 +66,62 @@ fuzzyMatchSymbols( const std::vector<const AutoCompletePlugin::SymbolsList*>& sy
 	return matches;
 }
 
+void AutoCompletePlugin::addLangSymbol( LangCache& lang, const std::string& text,
+									   const Uint32& lines ) {
+	auto it = lang.index.find( text );
+	if ( it != lang.index.end() ) {
+		it->second.lines += lines;
+		return;
+	}
+	lang.index.insert( { text, { lang.symbols.size(), lines } } );
+	lang.symbols.emplace_back( text );
+}
+
+void AutoCompletePlugin::removeLangSymbol( LangCache& lang, const std::string& text,
+										  const Uint32& lines ) {
+	auto it = lang.index.find( text );
+	if ( it == lang.index.end() )
+		return;
+	if ( it->second.lines > lines ) {
+		it->second.lines -= lines;
+		return;
+	}
+	// Swap with the last symbol to keep the list packed
+	size_t index = it->second.index;
+	size_t last = lang.symbols.size() - 1;
+	if ( index != last ) {
+		lang.symbols[index] = std::move( lang.symbols[last] );
+		lang.index.find( lang.symbols[index].text )->second.index = index;
+	}
+	lang.symbols.pop_back();
+	lang.index.erase( it );
+}
+
+AutoCompletePlugin::DocumentClient::DocumentClient( AutoCompletePlugin* plugin,
+													TextDocument* doc ) :
+	mPlugin( plugin ), mDoc( doc ) {}
+
+void AutoCompletePlugin::DocumentClient::onDocumentLoaded( TextDocument* ) {
+	mPlugin->invalidateDocCache( mDoc );
+}
+
+void AutoCompletePlugin::DocumentClient::onDocumentTextChanged(
+	const DocumentContentChange& change ) {
+	mPlugin->onDocumentTextChanged( mDoc, change );
+}
+
+void AutoCompletePlugin::DocumentClient::onDocumentUndoRedo( const TextDocument::UndoRedo& ) {
+	mPlugin->onDocumentUndoRedo( mDoc );
+}
+
+void AutoCompletePlugin::DocumentClient::onDocumentClosed( TextDocument* ) {
+	mClosed = true;
+}
+
+void AutoCompletePlugin::DocumentClient::onDocumentReloaded( TextDocument* ) {
+	mPlugin->invalidateDocCache( mDoc );
+}
+
 UICodeEditorPlugin* AutoCompletePlugin::New( PluginManager* pluginManager ) {
 	return eeNew( AutoCompletePlugin, ( pluginManager ) );
 }
@@ -92,6 +148,10 @@ AutoCompletePlugin::~AutoCompletePlugin() {
 			editor.first->removeEventListener( listener );
 		editor.first->unregisterPlugin( this );
 	}
+	for ( const auto& cache : mDocCache ) {
+		if ( cache.second.client && !cache.second.client->isClosed() )
+			cache.first->unregisterClient( cache.second.client.get() );
+	}
 }
 
 void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
@@ -105,11 +165,12 @@ void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
 
 	listeners.push_back(
 		editor->addEventListener( Event::OnDocumentClosed, [&]( const Event* event ) {
-			Lock l( mDocMutex );
+			Lock l( mLangSymbolsMutex );
+			Lock l2( mDocMutex );
 			const DocEvent* docEvent = static_cast<const DocEvent*>( event );
 			TextDocument* doc = docEvent->getDoc();
 			mDocs.erase( doc );
-			mDocCache.erase( doc );
+			removeDocCache( doc );
 			mDirty = true;
 		} ) );
 
@@ -117,9 +178,10 @@ void AutoCompletePlugin::onRegister( UICodeEditor* editor ) {
 		editor->addEventListener( Event::OnDocumentChanged, [&, editor]( const Event* ) {
 			TextDocument* oldDoc = mEditorDocs[editor];
 			TextDocument* newDoc = editor->getDocumentRef().get();
-			Lock l( mDocMutex );
+			Lock l( mLangSymbolsMutex );
+			Lock l2( mDocMutex );
 			mDocs.erase( oldDoc );
-			mDocCache.erase( oldDoc );
+			removeDocCache( oldDoc );
 			mEditorDocs[editor] = newDoc;
 			mDirty = true;
 		} ) );
@@ -165,7 +227,8 @@ void AutoCompletePlugin::onUnregister( UICodeEditor* editor ) {
 		resetSuggestions( editor );
 	if ( mSignatureHelpEditor == editor )
 		resetSignatureHelp();
-	Lock l( mDocMutex );
+	Lock l( mLangSymbolsMutex );
+	Lock l2( mDocMutex );
 	TextDocument* doc = mEditorDocs[editor];
 	auto cbs = mEditors[editor];
 	for ( auto listener : cbs )
@@ -176,7 +239,7 @@ void AutoCompletePlugin::onUnregister( UICodeEditor* editor ) {
 		if ( ceditor.second == doc )
 			return;
 	mDocs.erase( doc );
-	mDocCache.erase( doc );
+	removeDocCache( doc );
 	mDirty = true;
 }
 
@@ -386,8 +449,13 @@ bool AutoCompletePlugin::onTextInput( UICodeEditor* editor, const TextInputEvent
 
 void AutoCompletePlugin::updateDocCache( TextDocument* doc ) {
 	{
-		Lock lu( mDocsUpdatingMutex );
-		mDocsUpdating[doc] = true;
+		// The queued changes are included in the new index, the ones made from now on invalidate it
+		Lock l( mDocChangesMutex );
+		{
+			Lock lu( mDocsUpdatingMutex );
+			mDocsUpdating[doc] = true;
+		}
+		mDocChanges.erase( doc );
 	}
 	Clock clock;
 	std::unordered_map<TextDocument*, DocCache>::iterator docCache;
@@ -400,34 +468,190 @@ void AutoCompletePlugin::updateDocCache( TextDocument* doc ) {
 
 	auto changeId = doc->getCurrentChangeId();
 	auto symbols = getDocumentSymbols( doc );
+	std::string langName( doc->getSyntaxDefinition().getLanguageName() );
 
 	{
-		Lock l( mDocMutex );
+		Lock l( mLangSymbolsMutex );
+		Lock l2( mDocMutex );
 		docCache = mDocCache.find( doc );
 		if ( docCache == mDocCache.end() || mShuttingDown )
 			return;
 		auto& cache = docCache->second;
+		// Replace the previous document symbols in the language
+		if ( !cache.langName.empty() ) {
+			auto& oldLang = mLangCache[cache.langName];
+			for ( const auto& symbol : cache.index.symbols )
+				removeLangSymbol( oldLang, symbol.first, symbol.second.lines );
+		}
+		auto& lang = mLangCache[langName];
+		for ( const auto& symbol : symbols.symbols )
+			addLangSymbol( lang, symbol.first, symbol.second.lines );
+		cache.index = std::move( symbols );
+		cache.langName = langName;
+		// If the document changed while it was being indexed the changes were not tracked, so
+		// it will be indexed again
 		cache.changeId = changeId;
-		cache.symbols = std::move( symbols );
 	}
+	Log::debug( "Dictionary for %s updated in: %.2fms", doc->getFilename().c_str(),
+				clock.getElapsedTime().asMilliseconds() );
+	{
+		Lock lu( mDocsUpdatingMutex );
+		mDocsUpdating[doc] = false;
+	}
+}
 
-	std::string langName( doc->getSyntaxDefinition().getLanguageName() );
+void AutoCompletePlugin::removeDocCache( TextDocument* doc ) {
+	Lock l( mLangSymbolsMutex );
+	Lock l2( mDocMutex );
+	auto docCache = mDocCache.find( doc );
+	if ( docCache == mDocCache.end() )
+		return;
+	auto& cache = docCache->second;
+	if ( !cache.langName.empty() ) {
+		auto& lang = mLangCache[cache.langName];
+		for ( const auto& symbol : cache.index.symbols )
+			removeLangSymbol( lang, symbol.first, symbol.second.lines );
+	}
+	if ( cache.client && !cache.client->isClosed() )
+		doc->unregisterClient( cache.client.get() );
+	mDocCache.erase( docCache );
+	Lock l3( mDocChangesMutex );
+	mDocChanges.erase( doc );
+}
+
+void AutoCompletePlugin::invalidateDocCache( TextDocument* doc ) {
+	// Called from the document clients while the document holds its clients lock, so it can't
+	// take mDocMutex: removeDocCache holds it while unregistering the client
+	DocChange docChange;
+	docChange.type = DocChange::Type::Invalidate;
+	queueDocChange( doc, std::move( docChange ) );
+	mDirty = true;
+}
+
+void AutoCompletePlugin::onDocumentUndoRedo( TextDocument* doc ) {
+	// The undo stack can merge several changes, so the change id is only known after the undo
+	DocChange docChange;
+	docChange.type = DocChange::Type::ChangeId;
+	docChange.changeId = doc->getCurrentChangeId();
+	queueDocChange( doc, std::move( docChange ) );
+}
+
+void AutoCompletePlugin::onDocumentTextChanged( TextDocument* doc,
+												const DocumentContentChange& change ) {
+	if ( mShuttingDown )
+		return;
+
+	TextRange range( change.range.normalized() );
+	Int64 linesAdded = 0;
+	DocChange docChange;
+	docChange.line = range.start().line();
+	if ( change.text.empty() ) {
+		docChange.linesRemoved = range.end().line() - range.start().line();
+	} else {
+		linesAdded = std::count( change.text.begin(), change.text.end(), '\n' );
+	}
+	docChange.linesCount = doc->linesCount();
+	docChange.changeId = doc->getCurrentChangeId();
+
+	// The text of the changed lines is copied now, the document can't be read from the pool
+	if ( docChange.line < 0 || docChange.line + linesAdded >= docChange.linesCount ) {
+		docChange.type = DocChange::Type::Invalidate;
+	} else {
+		for ( Int64 i = docChange.line; i <= docChange.line + linesAdded; i++ )
+			docChange.lines.emplace_back( doc->line( i ).toUtf8() );
+	}
+
+	queueDocChange( doc, std::move( docChange ) );
+}
+
+void AutoCompletePlugin::queueDocChange( TextDocument* doc, DocChange&& change ) {
+	bool apply = false;
 	{
+		Lock l( mDocChangesMutex );
+		{
+			// The changes made while the document is being indexed are not tracked
+			Lock lu( mDocsUpdatingMutex );
+			auto du = mDocsUpdating.find( doc );
+			if ( du != mDocsUpdating.end() && du->second == true ) {
+				change.type = DocChange::Type::Invalidate;
+				change.lines.clear();
+			}
+		}
+		mDocChanges[doc].emplace_back( std::move( change ) );
+		apply = !mApplyingDocChanges;
+		mApplyingDocChanges = true;
+	}
+	if ( apply ) {
+#if AUTO_COMPLETE_THREADED
+		mThreadPool->run( [this] { applyDocChanges(); } );
+#else
+		applyDocChanges();
+#endif
+	}
+}
+
+void AutoCompletePlugin::applyDocChanges() {
+	LuaPattern pattern( mSymbolPattern );
+	while ( !mShuttingDown ) {
 		Lock l( mLangSymbolsMutex );
-		auto& lang = mLangCache[langName];
-		lang.clear();
 		Lock l2( mDocMutex );
-		for ( const auto& d : mDocCache ) {
-			if ( d.first->getSyntaxDefinition().getLanguageName() == langName )
-				lang.insert( lang.end(), d.second.symbols.begin(), d.second.symbols.end() );
+		std::unordered_map<TextDocument*, std::vector<DocChange>> docChanges;
+		{
+			Lock l3( mDocChangesMutex );
+			if ( mDocChanges.empty() ) {
+				mApplyingDocChanges = false;
+				return;
+			}
+			docChanges.swap( mDocChanges );
+		}
+		for ( const auto& changes : docChanges ) {
+			auto docCache = mDocCache.find( changes.first );
+			if ( docCache == mDocCache.end() )
+				continue;
+			for ( const auto& change : changes.second )
+				applyDocChange( docCache->second, change, pattern );
 		}
 	}
-	Log::debug( "Dictionary for %s updated in: %.2fms", doc->getFilename().c_str(),
-				clock.getElapsedTime().asMilliseconds() );
-	{
-		Lock lu( mDocsUpdatingMutex );
-		mDocsUpdating[doc] = false;
+	Lock l( mDocChangesMutex );
+	mApplyingDocChanges = false;
+}
+
+void AutoCompletePlugin::applyDocChange( DocCache& cache, const DocChange& change,
+										 LuaPattern& pattern ) {
+	if ( cache.changeId == static_cast<Uint64>( -1 ) )
+		return;
+
+	if ( change.type == DocChange::Type::ChangeId ) {
+		cache.changeId = change.changeId;
+		return;
+	}
+
+	Int64 line = change.line;
+	Int64 linesRemoved = change.linesRemoved;
+	Int64 linesAdded = (Int64)change.lines.size() - 1;
+	auto& lines = cache.index.lines;
+	// The index is out of sync with the document, it must be rebuilt
+	if ( change.type == DocChange::Type::Invalidate || line + linesRemoved >= (Int64)lines.size() ||
+		 (Int64)lines.size() - linesRemoved + linesAdded != change.linesCount ) {
+		cache.changeId = static_cast<Uint64>( -1 );
+		mDirty = true;
+		return;
 	}
+
+	LangCache* lang = !cache.langName.empty() ? &mLangCache[cache.langName] : nullptr;
+	for ( Int64 i = line + 1; i <= line + linesRemoved; i++ )
+		removeLineSymbols( cache.index, lang, i );
+	if ( linesRemoved > 0 )
+		lines.erase( lines.begin() + line + 1, lines.begin() + line + 1 + linesRemoved );
+	if ( linesAdded > 0 )
+		lines.insert( lines.begin() + line + 1, linesAdded, {} );
+
+	for ( Int64 i = 0; i <= linesAdded; i++ ) {
+		removeLineSymbols( cache.index, lang, line + i );
+		indexLine( cache.index, lang, line + i, change.lines[i], pattern );
+	}
+
+	cache.changeId = change.changeId;
 }
 
 void AutoCompletePlugin::updateLangCache( const std::string& langName ) {
@@ -435,10 +659,14 @@ void AutoCompletePlugin::updateLangCache( const std::string& langName ) {
 	Lock l( mLangSymbolsMutex );
 	Lock l2( mDocMutex );
 	auto& lang = mLangCache[langName];
-	lang.clear();
-	for ( const auto& d : mDocCache ) {
-		if ( d.first->getSyntaxDefinition().getLanguageName() == langName )
-			lang.insert( lang.end(), d.second.symbols.begin(), d.second.symbols.end() );
+	lang.symbols.clear();
+	lang.index.clear();
+	for ( auto& d : mDocCache ) {
+		if ( d.first->getSyntaxDefinition().getLanguageName() == langName ) {
+			d.second.langName = langName;
+			for ( const auto& symbol : d.second.index.symbols )
+				addLangSymbol( lang, symbol.first, symbol.second.lines );
+		}
 	}
 	Log::debug( "Lang dictionary for %s updated in: %.2fms", langName.c_str(),
 				clock.getElapsedTime().asMilliseconds() );
@@ -492,9 +720,10 @@ AutoCompletePlugin::processCodeCompletion( const LSPCompletionList& completion )
 		SymbolsList fuzzySuggestions;
 		{
 			Lock l2( mLangSymbolsMutex );
-			auto& symbols = mLangCache[lang];
+			auto& symbols = mLangCache[lang].symbols;
 			fuzzySuggestions = fuzzyMatchSymbols( { &suggestions, &symbols }, symbol,
 												  eemax<size_t>( 100UL, suggestions.size() ) );
+			removeTypedSymbol( fuzzySuggestions, lang, symbol );
 		}
 		Lock l( mSuggestionsMutex );
 		mSuggestions = fuzzySuggestions;
@@ -581,7 +810,12 @@ void AutoCompletePlugin::update( UICodeEditor* ) {
 		mDirty = false;
 		Lock l( mDocMutex );
 		for ( auto& doc : mDocs ) {
-			if ( !doc->isLoading() && mDocCache[doc].changeId != doc->getCurrentChangeId() ) {
+			auto& cache = mDocCache[doc];
+			if ( !cache.client ) {
+				cache.client = std::make_unique<DocumentClient>( this, doc );
+				doc->registerClient( cache.client.get() );
+			}
+			if ( !doc->isLoading() && cache.changeId != doc->getCurrentChangeId() ) {
 				{
 					Lock lu( mDocsUpdatingMutex );
 					auto du = mDocsUpdating.find( doc );
@@ -927,36 +1161,79 @@ void AutoCompletePlugin::resetSignatureHelp() {
 	mSignatureHelpEditor = nullptr;
 }
 
-AutoCompletePlugin::SymbolsList AutoCompletePlugin::getDocumentSymbols( TextDocument* doc ) {
+void AutoCompletePlugin::indexLine( DocSymbols& index, LangCache* lang, const Int64& line,
+									const std::string& text, LuaPattern& pattern ) {
+	auto& lineSymbols = index.lines[line];
+	// Each scan is stamped, so a symbol repeated in the line is counted once
+	Uint64 scan = ++index.scan;
+	for ( auto& match : pattern.gmatch( text ) ) {
+		std::string matchStr( match[0] );
+		if ( matchStr.size() < 3 )
+			continue;
+		auto symbol = index.symbols.find( matchStr );
+		if ( symbol == index.symbols.end() )
+			symbol = index.symbols.insert( { std::move( matchStr ), {} } ).first;
+		else if ( symbol->second.scan == scan )
+			continue;
+		symbol->second.scan = scan;
+		symbol->second.lines++;
+		lineSymbols.push_back( &*symbol );
+		if ( lang )
+			addLangSymbol( *lang, symbol->first, 1 );
+	}
+}
+
+void AutoCompletePlugin::removeLineSymbols( DocSymbols& index, LangCache* lang,
+											const Int64& line ) {
+	for ( auto symbol : index.lines[line] ) {
+		if ( lang )
+			removeLangSymbol( *lang, symbol->first, 1 );
+		if ( --symbol->second.lines == 0 )
+			index.symbols.erase( index.symbols.find( symbol->first ) );
+	}
+	index.lines[line].clear();
+}
+
+AutoCompletePlugin::DocSymbols AutoCompletePlugin::getDocumentSymbols( TextDocument* doc ) {
 	LuaPattern pattern( mSymbolPattern );
-	AutoCompletePlugin::SymbolsList symbols;
+	DocSymbols index;
 	Int64 lc = doc->linesCount();
-	if ( lc == 0 || lc > 50000 || mShuttingDown )
-		return symbols;
-	std::string current( getPartialSymbol( doc ) );
-	TextPosition end = doc->getSelection().end();
+	if ( lc == 0 || mShuttingDown )
+		return index;
+	index.lines.resize( lc );
 	for ( Int64 i = 0; i < lc; i++ ) {
-		const auto& string = doc->line( i ).getText().toUtf8();
-		for ( auto& match : pattern.gmatch( string ) ) {
-			std::string matchStr( match[0] );
-			// Ignore the symbol if is actually the current symbol being written
-			if ( matchStr.size() < 3 || ( end.line() == i && current == matchStr ) )
-				continue;
-			if ( std::none_of( symbols.begin(), symbols.end(),
-							   [matchStr]( const Suggestion& suggestion ) {
-								   return suggestion.text == matchStr;
-							   } ) )
-				symbols.push_back( std::move( matchStr ) );
-		}
+		indexLine( index, nullptr, i, doc->line( i ).toUtf8(), pattern );
 		if ( mShuttingDown )
 			break;
 	}
-	return symbols;
+	return index;
+}
+
+void AutoCompletePlugin::removeTypedSymbol( SymbolsList& matches, const std::string& lang,
+											const std::string& symbol ) {
+	// Ignore the symbol if it's only found where it's being written
+	auto langCache = mLangCache.find( lang );
+	if ( langCache == mLangCache.end() )
+		return;
+	auto found = langCache->second.index.find( symbol );
+	if ( found == langCache->second.index.end() || found->second.lines > 1 )
+		return;
+	matches.erase( std::remove_if( matches.begin(), matches.end(),
+								   [&symbol]( const Suggestion& suggestion ) {
+									   return suggestion.kind == LSPCompletionItemKind::Text &&
+											  suggestion.text == symbol;
+								   } ),
+				   matches.end() );
 }
 
-void AutoCompletePlugin::runUpdateSuggestions( const std::string& symbol,
-											   const SymbolsList& symbols, UICodeEditor* editor ) {
+void AutoCompletePlugin::runUpdateSuggestions( const std::string& symbol, UICodeEditor* editor ) {
 	{
+		const std::string& lang = editor->getDocument().getSyntaxDefinition().getLanguageName();
+		{
+			Lock l( mLangSymbolsMutex );
+			if ( mLangCache.find( lang ) == mLangCache.end() )
+				return;
+		}
 		{
 			Lock l( mSuggestionsEditorMutex );
 			mSuggestionsEditor = editor;
@@ -967,26 +1244,21 @@ void AutoCompletePlugin::runUpdateSuggestions( const std::string& symbol,
 			return;
 		Lock l( mLangSymbolsMutex );
 		Lock l2( mSuggestionsMutex );
-		mSuggestions = fuzzyMatchSymbols( { &symbols }, symbol, mSuggestionsMaxVisible );
+		mSuggestions =
+			fuzzyMatchSymbols( { &mLangCache[lang].symbols }, symbol, mSuggestionsMaxVisible );
+		removeTypedSymbol( mSuggestions, lang, symbol );
 	}
 	editor->runOnMainThread( [editor] { editor->invalidateDraw(); } );
 }
 
 void AutoCompletePlugin::updateSuggestions( const std::string& symbol, UICodeEditor* editor ) {
-	const std::string& lang = editor->getDocument().getSyntaxDefinition().getLanguageName();
-	Lock l( mLangSymbolsMutex );
-	auto langSuggestions = mLangCache.find( lang );
-	if ( langSuggestions == mLangCache.end() )
-		return;
-	const auto& symbols = langSuggestions->second;
-	{
+	// The language symbols are looked up by the pool, the main thread doesn't wait for the
+	// symbols lock while other suggestions are being matched
 #if AUTO_COMPLETE_THREADED
-		mThreadPool->run(
-			[this, symbol, &symbols, editor] { runUpdateSuggestions( symbol, symbols, editor ); } );
+	mThreadPool->run( [this, symbol, editor] { runUpdateSuggestions( symbol, editor ); } );
 #else
-		runUpdateSuggestions( symbol, symbols, editor );
+	runUpdateSuggestions( symbol, editor );
 #endif
-	}
 }
 
 } // namespace ecode
@@ -5,12 +5,15 @@
 #include "../pluginmanager.hpp"
 #include <eepp/config.hpp>
 #include <eepp/system/clock.hpp>
+#include <eepp/system/luapattern.hpp>
 #include <eepp/system/mutex.hpp>
 #include <eepp/system/sys.hpp>
 #include <eepp/system/threadpool.hpp>
 #include <eepp/ui/uicodeeditor.hpp>
+#include <memory>
 #include <set>
 #include <unordered_map>
+#include <vector>
 using namespace EE;
 using namespace EE::System;
 using namespace EE::UI;
@@ -119,12 +122,86 @@ class AutoCompletePlugin : public Plugin {
 	bool mDirty{ false };
 	bool mReplacing{ false };
 	bool mSignatureHelpVisible{ false };
+
+	/** Forwards the document changes to the plugin, so the symbols index is updated only for the
+	 * modified lines. */
+	class DocumentClient : public TextDocument::Client {
+	  public:
+		DocumentClient( AutoCompletePlugin* plugin, TextDocument* doc );
+
+		bool isClosed() const { return mClosed; }
+
+		virtual void onDocumentLoaded( TextDocument* );
+		virtual void onDocumentTextChanged( const DocumentContentChange& change );
+		virtual void onDocumentUndoRedo( const TextDocument::UndoRedo& );
+		virtual void onDocumentCursorChange( const TextPosition& ) {}
+		virtual void onDocumentSelectionChange( const TextRange& ) {}
+		virtual void onDocumentLineCountChange( const size_t&, const size_t& ) {}
+		virtual void onDocumentLineChanged( const Int64& ) {}
+		virtual void onDocumentSaved( TextDocument* ) {}
+		virtual void onDocumentClosed( TextDocument* );
+		virtual void onDocumentDirtyOnFileSystem( TextDocument* ) {}
+		virtual void onDocumentMoved( TextDocument* ) {}
+		virtual void onDocumentReloaded( TextDocument* );
+
+	  protected:
+		AutoCompletePlugin* mPlugin;
+		TextDocument* mDoc;
+		bool mClosed{ false };
+	};
+
+	struct DocSymbol {
+		Uint32 lines{ 0 }; ///< Number of lines where the symbol is found
+		Uint64 scan{ 0 };  ///< Last line scan that found the symbol
+	};
+	typedef std::unordered_map<std::string, DocSymbol> DocSymbolsMap;
+
+	/** Refcounted set of the document symbols, with the symbols found in each line. */
+	struct DocSymbols {
+		DocSymbolsMap symbols;
+		std::vector<std::vector<DocSymbolsMap::value_type*>> lines;
+		Uint64 scan{ 0 };
+	};
+
 	struct DocCache {
-		Uint64 changeId{ static_cast<Uint64>( -1 ) };
+		Uint64 changeId{ static_cast<Uint64>( -1 ) }; ///< -1 if the index must be rebuilt
+		std::string langName; ///< The language where the document symbols were merged
+		DocSymbols index;
+		std::unique_ptr<DocumentClient> client;
+	};
+
+	struct LangSymbol {
+		size_t index{ 0 }; ///< Position in the symbols list
+		Uint32 lines{ 0 }; ///< Number of lines in all the documents with the symbol
+	};
+
+	struct LangCache {
 		SymbolsList symbols;
+		std::unordered_map<std::string, LangSymbol> index;
 	};
+
+	/** A document change waiting to be applied to the document symbols index. The changes are
+	 * queued by the main thread and applied by the pool, so editing never waits for the symbols
+	 * lock. */
+	struct DocChange {
+		enum class Type {
+			Text,		///< Lines were modified, added or removed
+			ChangeId,	///< The document change id changed without modifying the text
+			Invalidate	///< The index must be rebuilt
+		};
+		Type type{ Type::Text };
+		Int64 line{ 0 };		 ///< First modified line
+		Int64 linesRemoved{ 0 }; ///< Lines removed after the first modified line
+		Int64 linesCount{ 0 };	 ///< Document lines after the change
+		Uint64 changeId{ 0 };
+		std::vector<std::string> lines; ///< Text of the modified line and the added lines
+	};
+
 	std::unordered_map<TextDocument*, DocCache> mDocCache;
-	std::unordered_map<std::string, SymbolsList> mLangCache;
+	std::unordered_map<TextDocument*, std::vector<DocChange>> mDocChanges;
+	Mutex mDocChangesMutex;
+	bool mApplyingDocChanges{ false };
+	std::unordered_map<std::string, LangCache> mLangCache;
 
 	std::vector<Suggestion> mSuggestions;
 	Mutex mSuggestionsEditorMutex;
@@ -153,14 +230,39 @@ class AutoCompletePlugin : public Plugin {
 
 	void updateSuggestions( const std::string& symbol, UICodeEditor* editor );
 
-	SymbolsList getDocumentSymbols( TextDocument* );
+	DocSymbols getDocumentSymbols( TextDocument* );
+
+	void indexLine( DocSymbols& index, LangCache* lang, const Int64& line, const std::string& text,
+					LuaPattern& pattern );
+
+	void removeLineSymbols( DocSymbols& index, LangCache* lang, const Int64& line );
 
 	void updateDocCache( TextDocument* doc );
 
+	void removeDocCache( TextDocument* doc );
+
+	void onDocumentTextChanged( TextDocument* doc, const DocumentContentChange& change );
+
+	void onDocumentUndoRedo( TextDocument* doc );
+
+	void invalidateDocCache( TextDocument* doc );
+
+	void queueDocChange( TextDocument* doc, DocChange&& change );
+
+	void applyDocChanges();
+
+	void applyDocChange( DocCache& cache, const DocChange& change, LuaPattern& pattern );
+
+	static void addLangSymbol( LangCache& lang, const std::string& text, const Uint32& lines );
+
+	static void removeLangSymbol( LangCache& lang, const std::string& text, const Uint32& lines );
+
+	void removeTypedSymbol( SymbolsList& matches, const std::string& lang,
+							const std::string& symbol );
+
 	std::string getPartialSymbol( TextDocument* doc );
 
-	void runUpdateSuggestions( const std::string& symbol, const SymbolsList& symbols,
-							   UICodeEditor* editor );
+	void runUpdateSuggestions( const std::string& symbol, UICodeEditor* editor );
 
 	void updateLangCache( const std::string& langName );
 
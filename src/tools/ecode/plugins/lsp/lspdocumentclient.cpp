@@ -164,8 +164,8 @@ UISceneNode* LSPDocumentClient::getUISceneNode() {
 	return server->getManager()->getPluginManager()->getUISceneNode();
 }
 
-static std::string semanticTokenTypeToSyntaxType( const std::string& type,
-												  const SyntaxDefinition& ) {
+static SyntaxStyleType semanticTokenTypeToSyntaxType( const std::string& type,
+													  const SyntaxDefinition& ) {
 	switch ( String::hash( type ) ) {
 		case SemanticTokenTypes::Namespace:
 		case SemanticTokenTypes::Type:
@@ -174,40 +174,40 @@ static std::string semanticTokenTypeToSyntaxType( const std::string& type,
 		case SemanticTokenTypes::Interface:
 		case SemanticTokenTypes::Struct:
 		case SemanticTokenTypes::TypeParameter:
-			return "keyword2";
+			return SyntaxStyleTypes::Keyword2;
 		case SemanticTokenTypes::Parameter:
-			return "keyword3";
+			return SyntaxStyleTypes::Keyword3;
 		case SemanticTokenTypes::Variable:
-			return "symbol";
+			return SyntaxStyleTypes::Symbol;
 		case SemanticTokenTypes::Property:
-			return "symbol";
+			return SyntaxStyleTypes::Symbol;
 		case SemanticTokenTypes::EnumMember:
 		case SemanticTokenTypes::Event:
-			return "keyword2";
+			return SyntaxStyleTypes::Keyword2;
 		case SemanticTokenTypes::Function:
 		case SemanticTokenTypes::Method:
 		case SemanticTokenTypes::Member:
-			return "function";
+			return SyntaxStyleTypes::Function;
 		case SemanticTokenTypes::Macro:
-			return "keyword2";
+			return SyntaxStyleTypes::Keyword2;
 		case SemanticTokenTypes::Keyword:
 		case SemanticTokenTypes::Modifier:
-			return "keyword";
+			return SyntaxStyleTypes::Keyword;
 		case SemanticTokenTypes::Comment:
-			return "comment";
+			return SyntaxStyleTypes::Comment;
 		case SemanticTokenTypes::Str:
-			return "string";
+			return SyntaxStyleTypes::String;
 		case SemanticTokenTypes::Number:
 		case SemanticTokenTypes::Regexp:
-			return "number";
+			return SyntaxStyleTypes::Number;
 		case SemanticTokenTypes::Operator:
-			return "operator";
+			return SyntaxStyleTypes::Operator;
 		case SemanticTokenTypes::Decorator:
-			return "literal";
+			return SyntaxStyleTypes::Literal;
 		case SemanticTokenTypes::Unknown:
 			break;
 	};
-	return "normal";
+	return SyntaxStyleTypes::Normal;
 }
 
 void LSPDocumentClient::processTokens( const LSPSemanticTokensDelta& tokens ) {
@@ -1,6 +1,9 @@
 #include "projectdirectorytree.hpp"
 #include "ecode.hpp"
+#include "fuzzymatcher.hpp"
 #include <algorithm>
+#include <climits>
+#include <eepp/system/directorywalker.hpp>
 #include <eepp/system/filesystem.hpp>
 #include <limits>
 
@@ -40,41 +43,20 @@ void ProjectDirectoryTree::scan( const ProjectDirectoryTree::ScanCompleteEvent&
 			Lock l( mFilesMutex );
 			mRunning = true;
 			mIgnoreHidden = ignoreHidden;
-			mDirectories.push_back( mPath );
 
 			if ( !mAllowedMatcher && FileSystem::fileExists( mPath + PRJ_ALLOWED_PATH ) )
 				mAllowedMatcher = std::make_unique<GitIgnoreMatcher>( mPath, PRJ_ALLOWED_PATH );
 
+			std::vector<FileEntry> files;
 			if ( !acceptedPatterns.empty() ) {
-				std::vector<std::string> files;
-				std::vector<std::string> names;
 				std::vector<LuaPattern> patterns;
 				for ( auto& strPattern : acceptedPatterns )
 					patterns.emplace_back( LuaPattern( strPattern ) );
 				mAcceptedPatterns = patterns;
-				std::set<std::string> info;
-				getDirectoryFiles( files, names, mPath, info, false, mIgnoreMatcher,
-								   mAllowedMatcher.get() );
-				size_t namesCount = names.size();
-				bool found;
-				for ( size_t i = 0; i < namesCount; i++ ) {
-					found = false;
-					for ( auto& pattern : patterns ) {
-						if ( pattern.matches( names[i] ) ) {
-							found = true;
-							break;
-						}
-					}
-					if ( found ) {
-						mFiles.emplace_back( std::move( files[i] ) );
-						mNames.emplace_back( std::move( names[i] ) );
-					}
-				}
-			} else {
-				std::set<std::string> info;
-				getDirectoryFiles( mFiles, mNames, mPath, info, ignoreHidden, mIgnoreMatcher,
-								   mAllowedMatcher.get() );
 			}
+			getDirectoryFiles( files, mPath, mIgnoreMatcher, mAllowedMatcher.get() );
+			addFiles( files );
+			invalidateFilesSnapshot();
 			mIsReady = true;
 			mRunning = false;
 			mApp->getPluginManager()->subscribeMessages(
@@ -101,38 +83,52 @@ ProjectDirectoryTree::fuzzyMatchTree( const std::vector<std::string>& matches,
 	std::multimap<int, int, std::greater<int>> matchesMap;
 	std::vector<std::string> files;
 	std::vector<std::string> names;
+	std::string path;
 	for ( const auto& match : matches ) {
-		for ( size_t i = 0; i < mNames.size(); i++ ) {
-			int matchName = String::fuzzyMatch( mNames[i], match );
-			int matchPath = String::fuzzyMatch( mFiles[i], match );
+		for ( size_t i = 0; i < mFiles.size(); i++ ) {
+			path.assign( mDirectories[mFiles[i].dir] ).append( mFiles[i].name );
+			int matchName = String::fuzzyMatch( mFiles[i].name, match );
+			int matchPath = String::fuzzyMatch( path, match );
 			matchesMap.insert( { std::max( matchName, matchPath ), i } );
 		}
 	}
 	for ( auto& res : matchesMap ) {
 		if ( names.size() < max ) {
-			names.emplace_back( mNames[res.second] );
-			files.emplace_back( mFiles[res.second] );
+			names.emplace_back( mFiles[res.second].name );
+			files.emplace_back( getFilePath( mFiles[res.second] ) );
 		}
 	}
 	return std::make_shared<FileListModel>( files, names );
 }
 
-std::shared_ptr<FileListModel> ProjectDirectoryTree::fuzzyMatchTree( const std::string& match,
-																	 const size_t& max ) const {
-	Lock rl( mMatchingMutex );
-	std::multimap<int, int, std::greater<int>> matchesMap;
+std::shared_ptr<FileListModel>
+ProjectDirectoryTree::fuzzyMatchTree( const std::string& match, const size_t& max,
+									  const CancellationToken& token ) const {
+	// Matched without holding the tree locks, the pool threads that score the files could be
+	// waiting for them
+	auto snapshot = getFilesSnapshot();
+	const auto& snapshotFiles = snapshot->files;
+	const auto& snapshotDirs = snapshot->directories;
 	std::vector<std::string> files;
 	std::vector<std::string> names;
-	for ( size_t i = 0; i < mNames.size(); i++ ) {
-		int matchName = String::fuzzyMatch( mNames[i], match );
-		int matchPath = String::fuzzyMatch( mFiles[i], match );
-		matchesMap.insert( { std::max( matchName, matchPath ), i } );
-	}
-	for ( auto& res : matchesMap ) {
-		if ( names.size() < max ) {
-			names.emplace_back( mNames[res.second] );
-			files.emplace_back( mFiles[res.second] );
-		}
+	FuzzyMatcher matcher( match );
+	// The file name is part of its path, so the path contains all the characters of both
+	auto matches = matcher.match(
+		mPool.get(), snapshotFiles.size(),
+		[&]( size_t i ) {
+			// Reused by every thread to build the file paths without allocations
+			thread_local std::string path;
+			const FileEntry& file = snapshotFiles[i];
+			path.assign( snapshotDirs[file.dir] ).append( file.name );
+			if ( !matcher.mayMatch( path ) )
+				return INT_MIN;
+			return std::max( matcher.score( file.name ), matcher.score( path ) );
+		},
+		max, token );
+	for ( const auto& res : matches ) {
+		const FileEntry& file = snapshotFiles[res.index];
+		names.emplace_back( file.name );
+		files.emplace_back( snapshotDirs[file.dir] + file.name );
 	}
 	return std::make_shared<FileListModel>( files, names );
 }
@@ -143,10 +139,10 @@ std::shared_ptr<FileListModel> ProjectDirectoryTree::matchTree( const std::strin
 	std::vector<std::string> files;
 	std::vector<std::string> names;
 	std::string lowerMatch( String::toLower( match ) );
-	for ( size_t i = 0; i < mNames.size(); i++ ) {
-		if ( String::toLower( mNames[i] ).find( lowerMatch ) != std::string::npos ) {
-			names.emplace_back( mNames[i] );
-			files.emplace_back( mFiles[i] );
+	for ( size_t i = 0; i < mFiles.size(); i++ ) {
+		if ( String::toLower( mFiles[i].name ).find( lowerMatch ) != std::string::npos ) {
+			names.emplace_back( mFiles[i].name );
+			files.emplace_back( getFilePath( mFiles[i] ) );
 			if ( max == names.size() )
 				return std::make_shared<FileListModel>( files, names );
 		}
@@ -156,7 +152,19 @@ std::shared_ptr<FileListModel> ProjectDirectoryTree::matchTree( const std::strin
 
 void ProjectDirectoryTree::asyncFuzzyMatchTree( const std::string& match, const size_t& max,
 												ProjectDirectoryTree::MatchResultCb res ) const {
-	mPool->run( [&, match, max, res]() { res( fuzzyMatchTree( match, max ) ); } );
+	CancellationToken token;
+	{
+		Lock l( mMatchTokenMutex );
+		mMatchToken.cancel();
+		mMatchToken = token;
+	}
+	mPool->run(
+		[this, match, max, res, token]() {
+			auto model = fuzzyMatchTree( match, max, token );
+			if ( !token.isCancelled() )
+				res( model );
+		},
+		ThreadPool::Priority::High, token );
 }
 
 void ProjectDirectoryTree::asyncMatchTree( const std::string& match, const size_t& max,
@@ -167,15 +175,16 @@ void ProjectDirectoryTree::asyncMatchTree( const std::string& match, const size_
 std::shared_ptr<FileListModel>
 ProjectDirectoryTree::asModel( const size_t& max,
 							   const std::vector<CommandInfo>& prependCommands ) const {
-	if ( mNames.empty() )
+	Lock rl( mMatchingMutex );
+	if ( mFiles.empty() )
 		return std::make_shared<FileListModel>( std::vector<std::string>(),
 												std::vector<std::string>() );
-	size_t rmax = eemin( mNames.size(), max );
+	size_t rmax = eemin( mFiles.size(), max );
 	std::vector<std::string> files( rmax );
 	std::vector<std::string> names( rmax );
 	for ( size_t i = 0; i < rmax; i++ ) {
-		files[i] = mFiles[i];
-		names[i] = mNames[i];
+		files[i] = getFilePath( mFiles[i] );
+		names[i] = mFiles[i].name;
 	}
 	if ( !prependCommands.empty() ) {
 		int count = 0;
@@ -221,78 +230,279 @@ size_t ProjectDirectoryTree::getFilesCount() const {
 	return mFiles.size();
 }
 
-const std::vector<std::string>& ProjectDirectoryTree::getFiles() const {
-	return mFiles;
+std::vector<std::string> ProjectDirectoryTree::getFiles() const {
+	Lock rl( mMatchingMutex );
+	std::vector<std::string> files;
+	files.reserve( mFiles.size() );
+	for ( const auto& file : mFiles )
+		files.emplace_back( getFilePath( file ) );
+	return files;
 }
 
-const std::vector<std::string>& ProjectDirectoryTree::getDirectories() const {
-	return mDirectories;
+std::vector<std::string> ProjectDirectoryTree::getDirectories() const {
+	Lock rl( mMatchingMutex );
+	std::vector<std::string> directories;
+	directories.reserve( mDirectoryIds.size() );
+	for ( const auto& dir : mDirectories ) {
+		if ( !dir.empty() )
+			directories.emplace_back( dir );
+	}
+	return directories;
 }
 
 bool ProjectDirectoryTree::isFileInTree( const std::string& filePath ) const {
-	return std::find( mFiles.begin(), mFiles.end(), filePath ) != mFiles.end();
+	Lock rl( mMatchingMutex );
+	return findFileIndex( filePath ) != std::string::npos;
 }
 
 bool ProjectDirectoryTree::isDirInTree( const std::string& dirTree ) const {
 	std::string dir( FileSystem::fileRemoveFileName( dirTree ) );
 	FileSystem::dirAddSlashAtEnd( dir );
-	return std::find( mDirectories.begin(), mDirectories.end(), dir ) != mDirectories.end();
+	Lock rl( mMatchingMutex );
+	return mDirectoryIds.find( dir ) != mDirectoryIds.end();
 }
 
-void ProjectDirectoryTree::getDirectoryFiles(
-	std::vector<std::string>& files, std::vector<std::string>& names, std::string directory,
-	std::set<std::string> currentDirs, const bool& ignoreHidden,
-	IgnoreMatcherManager& ignoreMatcher, GitIgnoreMatcher* allowedMatcher ) {
-	if ( !mRunning )
-		return;
-	currentDirs.insert( directory );
-	std::vector<std::string> pathFiles =
-		FileSystem::filesGetInPath( directory, false, false, false );
-	for ( auto& file : pathFiles ) {
-		std::string fullpath( directory + file );
-		if ( ignoreMatcher.foundMatch() && ignoreMatcher.match( directory, file ) ) {
-			if ( !allowedMatcher )
-				continue;
-			std::string localPath;
-			if ( String::startsWith( directory, allowedMatcher->getPath() ) )
-				localPath = directory.substr( allowedMatcher->getPath().size() );
-			if ( !allowedMatcher->match( localPath + file ) )
-				continue;
+/** The ignore matcher of a .gitignore found while walking the tree, linked to the matchers of
+ * the parent directories. */
+struct DirectoryIgnoreMatcher {
+	std::shared_ptr<DirectoryIgnoreMatcher> parent;
+	std::unique_ptr<IgnoreMatcher> matcher;
+};
+
+static bool isIgnored( const IgnoreMatcherManager& ignoreMatcher,
+					   const DirectoryIgnoreMatcher* dirMatcher, const std::string& directory,
+					   const std::string& file, bool isDirectory ) {
+	if ( ignoreMatcher.foundMatch() &&
+		 ( isDirectory ? ignoreMatcher.matchDirectory( directory, file )
+					   : ignoreMatcher.match( directory, file ) ) )
+		return true;
+	for ( ; dirMatcher != nullptr; dirMatcher = dirMatcher->parent.get() ) {
+		if ( dirMatcher->matcher->matchPath( directory, file, isDirectory ) )
+			return true;
+	}
+	return false;
+}
+
+void ProjectDirectoryTree::getDirectoryFiles( std::vector<FileEntry>& files,
+											  const std::string& directory,
+											  const IgnoreMatcherManager& ignoreMatcher,
+											  GitIgnoreMatcher* allowedMatcher ) {
+	auto found = walkDirectory( directory, ignoreMatcher, allowedMatcher, mRunning );
+	addDirectoryFiles( found, files );
+}
+
+std::vector<ProjectDirectoryTree::DirectoryFiles>
+ProjectDirectoryTree::walkDirectory( const std::string& directory,
+									 const IgnoreMatcherManager& ignoreMatcher,
+									 GitIgnoreMatcher* allowedMatcher, const bool& running ) const {
+	if ( !running )
+		return {};
+
+	Mutex foundMutex;
+	std::vector<DirectoryFiles> found;
+
+	// The directories are walked in parallel, each one is filtered with the ignore matchers of its
+	// parent directories, that are shared with the walker directory data
+	DirectoryWalker::walk( mPool.get(), directory, [&]( DirectoryWalker::Directory& dir ) {
+		if ( !running ) {
+			dir.entries.clear();
+			return;
+		}
+
+		auto dirMatcher = std::static_pointer_cast<DirectoryIgnoreMatcher>( dir.data );
+		if ( dir.depth > 0 ) {
+			for ( const auto& entry : dir.entries ) {
+				if ( entry.name == ".gitignore" && !entry.isDirectory ) {
+					auto childMatcher = std::make_shared<DirectoryIgnoreMatcher>();
+					childMatcher->parent = dirMatcher;
+					childMatcher->matcher = std::make_unique<GitIgnoreMatcher>( dir.path );
+					dirMatcher = childMatcher;
+					dir.data = childMatcher;
+					break;
+				}
+			}
 		}
-		if ( FileSystem::isDirectory( fullpath ) ) {
-			fullpath += FileSystem::getOSSlash();
-			FileInfo dirInfo( fullpath, true );
-			if ( dirInfo.isLink() ) {
-				fullpath = dirInfo.linksTo();
-				FileSystem::dirAddSlashAtEnd( fullpath );
-				if ( currentDirs.find( fullpath ) == currentDirs.end() )
+
+		DirectoryFiles dirFiles{ dir.path, {} };
+		size_t dirs = 0;
+		for ( auto& entry : dir.entries ) {
+			// The subdirectories can't be pruned if the allowed matcher could allow part of them
+			bool pruneDirectory = entry.isDirectory && !allowedMatcher;
+			if ( isIgnored( ignoreMatcher, dirMatcher.get(), dir.path, entry.name,
+							pruneDirectory ) ) {
+				if ( !allowedMatcher )
 					continue;
-				if ( std::find( mDirectories.begin(), mDirectories.end(), fullpath ) !=
-					 mDirectories.end() )
+				std::string localPath;
+				if ( String::startsWith( dir.path, allowedMatcher->getPath() ) )
+					localPath = dir.path.substr( allowedMatcher->getPath().size() );
+				if ( !allowedMatcher->match( localPath + entry.name ) )
 					continue;
-				mDirectories.push_back( fullpath );
-			} else {
-				mDirectories.push_back( fullpath );
 			}
-			IgnoreMatcherManager dirMatcher( fullpath );
-			IgnoreMatcher* childMatch = nullptr;
-			if ( dirMatcher.foundMatch() ) {
-				childMatch = dirMatcher.popMatcher( 0 );
-				ignoreMatcher.addChild( childMatch );
+			if ( !entry.isDirectory ) {
+				dirFiles.names.emplace_back( std::move( entry.name ) );
+			} else if ( !entry.isLink ) {
+				// The linked directories are not walked
+				if ( &dir.entries[dirs] != &entry )
+					dir.entries[dirs] = std::move( entry );
+				dirs++;
 			}
-			getDirectoryFiles( files, names, fullpath, currentDirs, ignoreHidden, ignoreMatcher,
-							   allowedMatcher );
-			if ( childMatch ) {
-				ignoreMatcher.removeChild( childMatch );
-				eeSAFE_DELETE( childMatch );
+		}
+		dir.entries.resize( dirs );
+
+		Lock l( foundMutex );
+		found.emplace_back( std::move( dirFiles ) );
+	} );
+
+	// Sorted, so the file order doesn't depend on how the walk was split between threads
+	std::sort( found.begin(), found.end(),
+			   []( const DirectoryFiles& left, const DirectoryFiles& right ) {
+				   return left.path < right.path;
+			   } );
+
+	return found;
+}
+
+void ProjectDirectoryTree::addDirectoryFiles( std::vector<DirectoryFiles>& found,
+											  std::vector<FileEntry>& files ) {
+	for ( auto& dirFiles : found ) {
+		Uint32 dirId = addDirectory( dirFiles.path );
+		for ( auto& name : dirFiles.names )
+			files.push_back( { dirId, std::move( name ) } );
+	}
+}
+
+void ProjectDirectoryTree::addFiles( std::vector<FileEntry>& files ) {
+	rehashFiles( mFiles.size() + files.size() );
+	for ( auto& file : files ) {
+		bool found = mAcceptedPatterns.empty();
+		for ( auto& pattern : mAcceptedPatterns ) {
+			if ( pattern.matches( file.name ) ) {
+				found = true;
+				break;
 			}
-		} else {
-			files.emplace_back( fullpath );
-			names.emplace_back( file );
 		}
+		if ( found )
+			insertFile( std::move( file ) );
+	}
+}
+
+Uint32 ProjectDirectoryTree::addDirectory( const std::string& path ) {
+	auto it = mDirectoryIds.find( path );
+	if ( it != mDirectoryIds.end() )
+		return it->second;
+	Uint32 id;
+	if ( !mFreeDirectoryIds.empty() ) {
+		id = mFreeDirectoryIds.back();
+		mFreeDirectoryIds.pop_back();
+		mDirectories[id] = path;
+	} else {
+		id = static_cast<Uint32>( mDirectories.size() );
+		mDirectories.push_back( path );
+	}
+	mDirectoryIds[path] = id;
+	return id;
+}
+
+std::string ProjectDirectoryTree::getFilePath( const FileEntry& file ) const {
+	return mDirectories[file.dir] + file.name;
+}
+
+std::shared_ptr<const ProjectDirectoryTree::FilesSnapshot>
+ProjectDirectoryTree::getFilesSnapshot() const {
+	Lock rl( mMatchingMutex );
+	Lock l( mFilesSnapshotMutex );
+	if ( !mFilesSnapshot )
+		mFilesSnapshot = std::make_shared<FilesSnapshot>( FilesSnapshot{ mFiles, mDirectories } );
+	return mFilesSnapshot;
+}
+
+void ProjectDirectoryTree::invalidateFilesSnapshot() {
+	Lock l( mFilesSnapshotMutex );
+	mFilesSnapshot.reset();
+}
+
+static inline size_t fileHash( const Uint32& dir, const std::string& name ) {
+	size_t hash = std::hash<std::string>()( name );
+	return hash ^ ( dir + 0x9e3779b9 + ( hash << 6 ) + ( hash >> 2 ) );
+}
+
+size_t ProjectDirectoryTree::getFileSlot( const Uint32& dir, const std::string& name ) const {
+	// Returns the slot of the file, or the empty slot where it should be inserted. The table is
+	// never more than half full, so there's always an empty slot.
+	size_t mask = mFileSlots.size() - 1;
+	for ( size_t slot = fileHash( dir, name ) & mask;; slot = ( slot + 1 ) & mask ) {
+		Uint32 value = mFileSlots[slot];
+		if ( value == 0 )
+			return slot;
+		const FileEntry& file = mFiles[value - 1];
+		if ( file.dir == dir && file.name == name )
+			return slot;
+	}
+}
+
+bool ProjectDirectoryTree::insertFile( FileEntry&& file ) {
+	if ( mFileSlots.empty() )
+		rehashFiles( 1 );
+	size_t slot = getFileSlot( file.dir, file.name );
+	if ( mFileSlots[slot] != 0 )
+		return false;
+	mFiles.emplace_back( std::move( file ) );
+	if ( mFiles.size() * 2 > mFileSlots.size() ) {
+		rehashFiles();
+	} else {
+		mFileSlots[slot] = static_cast<Uint32>( mFiles.size() );
+	}
+	return true;
+}
+
+void ProjectDirectoryTree::indexFile( const Uint32& index ) {
+	mFileSlots[getFileSlot( mFiles[index].dir, mFiles[index].name )] = index + 1;
+}
+
+void ProjectDirectoryTree::unindexFile( const Uint32& index ) {
+	size_t mask = mFileSlots.size() - 1;
+	size_t slot = fileHash( mFiles[index].dir, mFiles[index].name ) & mask;
+	while ( mFileSlots[slot] != index + 1 ) {
+		if ( mFileSlots[slot] == 0 )
+			return;
+		slot = ( slot + 1 ) & mask;
+	}
+	// Move back the following entries of the probe sequence that can take the slot
+	for ( size_t next = ( slot + 1 ) & mask; mFileSlots[next] != 0; next = ( next + 1 ) & mask ) {
+		const FileEntry& file = mFiles[mFileSlots[next] - 1];
+		size_t ideal = fileHash( file.dir, file.name ) & mask;
+		if ( ( ( next - ideal ) & mask ) >= ( ( next - slot ) & mask ) ) {
+			mFileSlots[slot] = mFileSlots[next];
+			slot = next;
+		}
+	}
+	mFileSlots[slot] = 0;
+}
+
+void ProjectDirectoryTree::eraseFile( const size_t& index ) {
+	Uint32 last = static_cast<Uint32>( mFiles.size() - 1 );
+	unindexFile( index );
+	if ( index != last ) {
+		unindexFile( last );
+		mFiles[index] = std::move( mFiles[last] );
+		mFiles.pop_back();
+		indexFile( index );
+	} else {
+		mFiles.pop_back();
 	}
 }
 
+void ProjectDirectoryTree::rehashFiles( size_t expectedFiles ) {
+	size_t capacity = 16;
+	while ( capacity < std::max( expectedFiles, mFiles.size() ) * 3 )
+		capacity <<= 1;
+	if ( expectedFiles > 0 && capacity <= mFileSlots.size() )
+		return;
+	mFileSlots.assign( capacity, 0 );
+	for ( Uint32 i = 0; i < mFiles.size(); i++ )
+		indexFile( i );
+}
+
 void ProjectDirectoryTree::onChange( const ProjectDirectoryTree::Action& action,
 									 const FileInfo& file, const std::string& oldFilename ) {
 	if ( !file.isDirectory() && !isDirInTree( file.getFilepath() ) )
@@ -323,9 +533,12 @@ void ProjectDirectoryTree::tryAddFile( const FileInfo& file ) {
 			}
 		}
 		if ( foundPattern ) {
+			Lock rl( mMatchingMutex );
 			Lock l( mFilesMutex );
-			mFiles.emplace_back( file.getFilepath() );
-			mNames.emplace_back( file.getFileName() );
+			std::string dir( file.getDirectoryPath() );
+			FileSystem::dirAddSlashAtEnd( dir );
+			if ( insertFile( { addDirectory( dir ), file.getFileName() } ) )
+				invalidateFilesSnapshot();
 		}
 	}
 }
@@ -334,102 +547,113 @@ void ProjectDirectoryTree::addFile( const FileInfo& file ) {
 	if ( file.isDirectory() ) {
 		if ( !String::startsWith( file.getFilepath(), mPath ) || isDirInTree( file.getFilepath() ) )
 			return;
-		Lock l( mFilesMutex );
-		std::vector<std::string> files;
-		std::vector<std::string> names;
-		std::vector<LuaPattern> patterns;
-		std::set<std::string> info;
-		if ( !mAcceptedPatterns.empty() ) {
-			getDirectoryFiles( files, names, mPath, info, false, mIgnoreMatcher,
-							   mAllowedMatcher.get() );
-			size_t namesCount = names.size();
-			bool found;
-			for ( size_t i = 0; i < namesCount; i++ ) {
-				found = false;
-				for ( auto& pattern : patterns ) {
-					if ( pattern.matches( names[i] ) ) {
-						found = true;
-						break;
-					}
-				}
-				if ( found ) {
-					mFiles.emplace_back( std::move( files[i] ) );
-					mNames.emplace_back( std::move( names[i] ) );
-				}
-			}
-		} else {
-			getDirectoryFiles( mFiles, mNames, mPath, info, false, mIgnoreMatcher,
-							   mAllowedMatcher.get() );
+		GitIgnoreMatcher* allowedMatcher = nullptr;
+		{
+			Lock l( mFilesMutex );
+			allowedMatcher = mAllowedMatcher.get();
 		}
+		// Only the new directory is walked, the rest of the tree is already known. It's walked
+		// before taking the tree locks, the pool threads that help to walk it could be waiting
+		// for them.
+		IgnoreMatcherManager matcher( getIgnoreMatcherFromPath( file.getFilepath() ) );
+		bool running = true;
+		auto found = walkDirectory( file.getFilepath(), matcher, allowedMatcher, running );
+		Lock rl( mMatchingMutex );
+		Lock l( mFilesMutex );
+		std::vector<FileEntry> files;
+		addDirectoryFiles( found, files );
+		addFiles( files );
+		invalidateFilesSnapshot();
 	} else {
 		tryAddFile( file );
 	}
 }
 
 void ProjectDirectoryTree::moveFile( const FileInfo& file, const std::string& oldFilename ) {
-	Lock l( mFilesMutex );
 	if ( file.isDirectory() ) {
-		std::string dir( file.getDirectoryPath() );
-		FileSystem::dirRemoveSlashAtEnd( dir );
-		std::string parentDir( FileSystem::fileRemoveFileName( dir ) );
-		FileSystem::dirAddSlashAtEnd( parentDir );
-		std::string oldDir( parentDir + oldFilename );
-		FileSystem::dirAddSlashAtEnd( dir );
-		FileSystem::dirAddSlashAtEnd( oldDir );
-		std::vector<std::string> files;
-		std::vector<std::string> names;
-		for ( size_t i = 0; i < mFiles.size(); i++ ) {
-			if ( !String::startsWith( mFiles[i], oldDir ) ) {
-				files.emplace_back( mFiles[i] );
-				names.emplace_back( mNames[i] );
-			} else {
-				std::string newDir( dir + mFiles[i].substr( oldDir.size() ) );
-				files.emplace_back( newDir );
-				names.emplace_back( FileSystem::fileNameFromPath( newDir ) );
-			}
+		// An unknown directory is added as a new one, it's walked without holding the locks
+		if ( !moveDirectory( file, oldFilename ) )
+			addFile( file );
+		return;
+	}
+
+	Lock rl( mMatchingMutex );
+	Lock l( mFilesMutex );
+	invalidateFilesSnapshot();
+	std::string dir( file.getDirectoryPath() );
+	FileSystem::dirAddSlashAtEnd( dir );
+	size_t index = findFileIndex( dir + oldFilename );
+	if ( index != std::string::npos ) {
+		if ( findFileIndex( file.getFilepath() ) != std::string::npos ) {
+			// Replaced an existing file
+			eraseFile( index );
+			return;
 		}
-		mFiles = files;
-		mNames = names;
-		auto wasDirIt = std::find( mDirectories.begin(), mDirectories.end(), oldDir );
-		if ( wasDirIt != mDirectories.end() )
-			mDirectories.erase( wasDirIt );
-		mDirectories.emplace_back( std::move( dir ) );
+		unindexFile( index );
+		mFiles[index].dir = addDirectory( dir );
+		mFiles[index].name = file.getFileName();
+		indexFile( index );
 	} else {
-		std::string dir( file.getDirectoryPath() );
-		FileSystem::dirAddSlashAtEnd( dir );
-		size_t index = findFileIndex( dir + oldFilename );
-		if ( index != std::string::npos ) {
-			mFiles[index] = file.getFilepath();
-			mNames[index] = file.getFileName();
-		} else {
-			tryAddFile( file );
+		tryAddFile( file );
+	}
+}
+
+bool ProjectDirectoryTree::moveDirectory( const FileInfo& file, const std::string& oldFilename ) {
+	Lock rl( mMatchingMutex );
+	Lock l( mFilesMutex );
+	std::string dir( file.getDirectoryPath() );
+	FileSystem::dirRemoveSlashAtEnd( dir );
+	std::string parentDir( FileSystem::fileRemoveFileName( dir ) );
+	FileSystem::dirAddSlashAtEnd( parentDir );
+	std::string oldDir( parentDir + oldFilename );
+	FileSystem::dirAddSlashAtEnd( dir );
+	FileSystem::dirAddSlashAtEnd( oldDir );
+	if ( mDirectoryIds.find( oldDir ) == mDirectoryIds.end() )
+		return false;
+	invalidateFilesSnapshot();
+	// The directory and its subdirectories are renamed, the files keep their directory ids
+	std::vector<Uint32> renamed;
+	for ( Uint32 id = 0; id < mDirectories.size(); id++ ) {
+		std::string& path = mDirectories[id];
+		if ( !path.empty() && String::startsWith( path, oldDir ) ) {
+			mDirectoryIds.erase( path );
+			path = dir + path.substr( oldDir.size() );
+			renamed.push_back( id );
 		}
 	}
+	for ( const auto& id : renamed )
+		mDirectoryIds[mDirectories[id]] = id;
+	return true;
 }
 
 void ProjectDirectoryTree::removeFile( const FileInfo& file ) {
+	Lock rl( mMatchingMutex );
 	Lock l( mFilesMutex );
+	invalidateFilesSnapshot();
 	std::string removedDir( file.getFilepath() );
 	FileSystem::dirAddSlashAtEnd( removedDir );
-	auto wasDirIt = std::find( mDirectories.begin(), mDirectories.end(), removedDir );
-	if ( wasDirIt != mDirectories.end() ) {
-		std::vector<std::string> files;
-		std::vector<std::string> names;
-		for ( size_t i = 0; i < mFiles.size(); i++ ) {
-			if ( !String::startsWith( mFiles[i], removedDir ) ) {
-				files.emplace_back( mFiles[i] );
-				names.emplace_back( mNames[i] );
+	if ( mDirectoryIds.find( removedDir ) != mDirectoryIds.end() ) {
+		// Removes the directory, its subdirectories and their files in a single pass
+		std::vector<bool> removed( mDirectories.size(), false );
+		for ( Uint32 id = 0; id < mDirectories.size(); id++ ) {
+			std::string& path = mDirectories[id];
+			if ( !path.empty() && String::startsWith( path, removedDir ) ) {
+				mDirectoryIds.erase( path );
+				std::string().swap( path );
+				removed[id] = true;
+				mFreeDirectoryIds.push_back( id );
 			}
 		}
-		mFiles = files;
-		mNames = names;
-		mDirectories.erase( wasDirIt );
+		mFiles.erase( std::remove_if( mFiles.begin(), mFiles.end(),
+									  [&removed]( const FileEntry& entry ) {
+										  return removed[entry.dir];
+									  } ),
+					  mFiles.end() );
+		rehashFiles();
 	} else {
 		size_t index = findFileIndex( file.getFilepath() );
-		if ( index != std::string::npos ) {
-			mFiles.erase( mFiles.begin() + index );
-			mNames.erase( mNames.begin() + index );
-		}
+		if ( index != std::string::npos )
+			eraseFile( index );
 	}
 }
 
@@ -458,12 +682,15 @@ IgnoreMatcherManager ProjectDirectoryTree::getIgnoreMatcherFromPath( const std::
 	return matcher;
 }
 
-size_t ProjectDirectoryTree::findFileIndex( const std::string& path ) {
-	for ( size_t i = 0; i < mFiles.size(); i++ ) {
-		if ( mFiles[i] == path )
-			return i;
-	}
-	return std::string::npos;
+size_t ProjectDirectoryTree::findFileIndex( const std::string& path ) const {
+	size_t pos = path.find_last_of( FileSystem::getOSSlash() );
+	if ( pos == std::string::npos || mFileSlots.empty() )
+		return std::string::npos;
+	auto dir = mDirectoryIds.find( path.substr( 0, pos + 1 ) );
+	if ( dir == mDirectoryIds.end() )
+		return std::string::npos;
+	Uint32 value = mFileSlots[getFileSlot( dir->second, path.substr( pos + 1 ) )];
+	return value != 0 ? value - 1 : std::string::npos;
 }
 
 PluginRequestHandle ProjectDirectoryTree::processMessage( const PluginMessage& msg ) {
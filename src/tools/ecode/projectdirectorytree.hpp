@@ -15,6 +15,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 
 using namespace EE;
 using namespace EE::System;
@@ -111,11 +112,14 @@ class ProjectDirectoryTree {
 	std::shared_ptr<FileListModel> fuzzyMatchTree( const std::vector<std::string>& matches,
 												   const size_t& max ) const;
 
-	std::shared_ptr<FileListModel> fuzzyMatchTree( const std::string& match,
-												   const size_t& max ) const;
+	std::shared_ptr<FileListModel>
+	fuzzyMatchTree( const std::string& match, const size_t& max,
+					const CancellationToken& token = CancellationToken() ) const;
 
 	std::shared_ptr<FileListModel> matchTree( const std::string& match, const size_t& max ) const;
 
+	/** Matches in the thread pool. A new match cancels the previous one if it didn't finish,
+	 * its callback is not called. */
 	void asyncFuzzyMatchTree( const std::string& match, const size_t& max,
 							  MatchResultCb res ) const;
 
@@ -135,9 +139,11 @@ class ProjectDirectoryTree {
 
 	size_t getFilesCount() const;
 
-	const std::vector<std::string>& getFiles() const;
+	/** @return The full paths of the files. */
+	std::vector<std::string> getFiles() const;
 
-	const std::vector<std::string>& getDirectories() const;
+	/** @return The paths of the directories, with a trailing slash. */
+	std::vector<std::string> getDirectories() const;
 
 	bool isFileInTree( const std::string& filePath ) const;
 
@@ -148,11 +154,29 @@ class ProjectDirectoryTree {
 	const std::string& getPath() const { return mPath; }
 
   protected:
+	/** The files only keep their name and the id of their directory, the directory paths are
+	 * stored once. */
+	struct FileEntry {
+		Uint32 dir;
+		std::string name;
+	};
+
+	/** A copy of the files list, so the files can be matched without holding the tree locks. */
+	struct FilesSnapshot {
+		std::vector<FileEntry> files;
+		std::vector<std::string> directories;
+	};
+
 	std::string mPath;
 	std::shared_ptr<ThreadPool> mPool;
-	std::vector<std::string> mFiles;
-	std::vector<std::string> mNames;
+	std::vector<FileEntry> mFiles;
+	/** Open addressing hash table of the file indexes + 1, 0 is an empty slot. */
+	std::vector<Uint32> mFileSlots;
+	/** The directory paths by id, a removed directory is left empty until its id is reused. */
 	std::vector<std::string> mDirectories;
+	std::unordered_map<std::string, Uint32> mDirectoryIds;
+	/** The ids of the removed directories, reused by the new ones. */
+	std::vector<Uint32> mFreeDirectoryIds;
 	std::vector<LuaPattern> mAcceptedPatterns;
 	std::unique_ptr<GitIgnoreMatcher> mAllowedMatcher;
 	bool mRunning;
@@ -160,25 +184,72 @@ class ProjectDirectoryTree {
 	bool mIgnoreHidden;
 	mutable Mutex mFilesMutex;
 	mutable Mutex mMatchingMutex;
+	mutable Mutex mMatchTokenMutex;
+	mutable CancellationToken mMatchToken;
+	/** Built on the first match after the files change. */
+	mutable std::shared_ptr<const FilesSnapshot> mFilesSnapshot;
+	mutable Mutex mFilesSnapshotMutex;
 	IgnoreMatcherManager mIgnoreMatcher;
 	App* mApp{ nullptr };
 
-	void getDirectoryFiles( std::vector<std::string>& files, std::vector<std::string>& names,
-							std::string directory, std::set<std::string> currentDirs,
-							const bool& ignoreHidden, IgnoreMatcherManager& ignoreMatcher,
+	/** The files found in a directory while walking the tree. */
+	struct DirectoryFiles {
+		std::string path;
+		std::vector<std::string> names;
+	};
+
+	/** Walks the directory tree in the thread pool and appends its files. */
+	void getDirectoryFiles( std::vector<FileEntry>& files, const std::string& directory,
+							const IgnoreMatcherManager& ignoreMatcher,
 							GitIgnoreMatcher* allowedMatcher );
 
+	/** Walks the directory tree in the thread pool, it doesn't access the tree files so it must
+	 * be called without holding the tree locks. The walk stops when running is false.
+	 * @return The files of every directory, sorted by directory path. */
+	std::vector<DirectoryFiles> walkDirectory( const std::string& directory,
+											   const IgnoreMatcherManager& ignoreMatcher,
+											   GitIgnoreMatcher* allowedMatcher,
+											   const bool& running ) const;
+
+	/** Adds the directories found by walkDirectory and appends their files. */
+	void addDirectoryFiles( std::vector<DirectoryFiles>& found, std::vector<FileEntry>& files );
+
+	void addFiles( std::vector<FileEntry>& files );
+
+	Uint32 addDirectory( const std::string& path );
+
+	std::string getFilePath( const FileEntry& file ) const;
+
+	std::shared_ptr<const FilesSnapshot> getFilesSnapshot() const;
+
+	void invalidateFilesSnapshot();
+
+	size_t getFileSlot( const Uint32& dir, const std::string& name ) const;
+
+	bool insertFile( FileEntry&& file );
+
+	void indexFile( const Uint32& index );
+
+	void unindexFile( const Uint32& index );
+
+	void eraseFile( const size_t& index );
+
+	void rehashFiles( size_t expectedFiles = 0 );
+
 	void addFile( const FileInfo& file );
 
 	void tryAddFile( const FileInfo& file );
 
 	void moveFile( const FileInfo& file, const std::string& oldFilename );
 
+	/** @return False if the old directory is not in the tree. */
+	bool moveDirectory( const FileInfo& file, const std::string& oldFilename );
+
 	void removeFile( const FileInfo& file );
 
 	IgnoreMatcherManager getIgnoreMatcherFromPath( const std::string& path );
 
-	size_t findFileIndex( const std::string& path );
+	size_t findFileIndex( const std::string& path ) const;
 
 	PluginRequestHandle processMessage( const PluginMessage& msg );
 };
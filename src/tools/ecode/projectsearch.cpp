@@ -1,70 +1,278 @@
 #include "projectsearch.hpp"
+#include <cstring>
 #include <eepp/system/filesystem.hpp>
 #include <eepp/system/luapattern.hpp>
+#include <eepp/system/memorymappedfile.hpp>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ECODE_SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+#if defined( __AVX2__ )
+#define ECODE_SEARCH_AVX2
+#include <immintrin.h>
+#endif
+#ifdef EE_COMPILER_MSVC
+#include <intrin.h>
+#endif
 
 namespace ecode {
 
-static int countNewLines( const std::string& text, const size_t& start, const size_t& end ) {
-	const char* startPtr = text.c_str() + start;
-	const char* endPtr = text.c_str() + end;
+static inline int firstBitSet( Uint32 mask ) {
+#ifdef EE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanForward( &index, mask );
+	return static_cast<int>( index );
+#else
+	return __builtin_ctz( mask );
+#endif
+}
+
+static inline int lastBitSet( Uint32 mask ) {
+#ifdef EE_COMPILER_MSVC
+	unsigned long index;
+	_BitScanReverse( &index, mask );
+	return static_cast<int>( index );
+#else
+	return 31 - __builtin_clz( mask );
+#endif
+}
+
+static inline unsigned char foldCase( unsigned char c ) {
+	return c >= 'A' && c <= 'Z' ? c + ( 'a' - 'A' ) : c;
+}
+
+static size_t countNewLines( const char* startPtr, const char* endPtr ) {
 	size_t count = 0;
-	if ( startPtr != endPtr ) {
-		count = *startPtr == '\n' ? 1 : 0;
-		while ( ++startPtr && startPtr != endPtr ) {
-			if ( '\n' == *startPtr )
-				count++;
-		};
+#ifdef ECODE_SEARCH_AVX2
+	const __m256i nl256 = _mm256_set1_epi8( '\n' );
+	while ( endPtr - startPtr >= 32 ) {
+		// Every byte lane counts up to 255 matches before the lanes are summed.
+		__m256i acc = _mm256_setzero_si256();
+		for ( int i = 0; i < 255 && endPtr - startPtr >= 32; ++i, startPtr += 32 ) {
+			__m256i chunk = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( startPtr ) );
+			acc = _mm256_sub_epi8( acc, _mm256_cmpeq_epi8( chunk, nl256 ) );
+		}
+		__m256i sums = _mm256_sad_epu8( acc, _mm256_setzero_si256() );
+		count += _mm256_extract_epi64( sums, 0 ) + _mm256_extract_epi64( sums, 1 ) +
+				 _mm256_extract_epi64( sums, 2 ) + _mm256_extract_epi64( sums, 3 );
+	}
+#endif
+#ifdef ECODE_SEARCH_SSE2
+	const __m128i nl = _mm_set1_epi8( '\n' );
+	while ( endPtr - startPtr >= 16 ) {
+		__m128i acc = _mm_setzero_si128();
+		for ( int i = 0; i < 255 && endPtr - startPtr >= 16; ++i, startPtr += 16 ) {
+			__m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( startPtr ) );
+			acc = _mm_sub_epi8( acc, _mm_cmpeq_epi8( chunk, nl ) );
+		}
+		__m128i sums = _mm_sad_epu8( acc, _mm_setzero_si128() );
+		count += _mm_cvtsi128_si32( sums ) + _mm_cvtsi128_si32( _mm_srli_si128( sums, 8 ) );
 	}
+#endif
+	for ( ; startPtr < endPtr; ++startPtr )
+		count += *startPtr == '\n' ? 1 : 0;
 	return count;
 }
 
-static String textLine( const std::string& fileText, const size_t& fromPos, size_t& relCol ) {
-	const char* stringStartPtr = fileText.c_str();
-	const char* startPtr = fileText.c_str() + fromPos;
-	const char* endPtr = startPtr;
-	const char* nlStartPtr = startPtr;
-	while ( nlStartPtr != stringStartPtr && *nlStartPtr != '\n' )
-		--nlStartPtr;
-	if ( *nlStartPtr == '\n' )
-		nlStartPtr++;
-	while ( ++endPtr && *endPtr != '\0' && *endPtr != '\n' ) {
+/** @return The position of the last new line character before `endPtr`, or `startPtr` if there
+ * is none. */
+static const char* findLineStart( const char* startPtr, const char* endPtr ) {
+#ifdef ECODE_SEARCH_SSE2
+	const __m128i nl = _mm_set1_epi8( '\n' );
+	while ( endPtr - startPtr >= 16 ) {
+		__m128i chunk = _mm_loadu_si128( reinterpret_cast<const __m128i*>( endPtr - 16 ) );
+		Uint32 mask = _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, nl ) );
+		if ( mask )
+			return endPtr - 16 + lastBitSet( mask );
+		endPtr -= 16;
 	}
-	relCol =
-		String::utf8Length( fileText.substr( nlStartPtr - stringStartPtr, startPtr - nlStartPtr ) );
+#endif
+	while ( endPtr != startPtr && *( endPtr - 1 ) != '\n' )
+		--endPtr;
+	return endPtr != startPtr ? endPtr - 1 : startPtr;
+}
+
+static String textLine( const char* text, const size_t& size, const size_t& fromPos,
+						size_t& relCol ) {
+	const char* stringEndPtr = text + size;
+	const char* startPtr = text + fromPos;
+	const char* nlStartPtr = findLineStart( text, startPtr );
+	if ( *nlStartPtr == '\n' && nlStartPtr != startPtr )
+		nlStartPtr++;
+	const char* endPtr =
+		startPtr < stringEndPtr
+			? static_cast<const char*>( memchr( startPtr + 1, '\n', stringEndPtr - startPtr - 1 ) )
+			: nullptr;
+	if ( endPtr == nullptr )
+		endPtr = stringEndPtr;
+	relCol = String::utf8Length( std::string( nlStartPtr, startPtr - nlStartPtr ) );
 	// if the line to substract is massive we only get the fist kilobyte of that line, since the
 	// line is only shared for visual aid.
-	return fileText.substr( nlStartPtr - stringStartPtr,
-							endPtr - nlStartPtr > EE_1KB ? EE_1KB : endPtr - nlStartPtr );
+	return String( nlStartPtr, endPtr - nlStartPtr > EE_1KB ? EE_1KB : endPtr - nlStartPtr );
 }
 
+static bool isWholeWord( const char* text, const size_t& size, const size_t& start,
+						 const size_t& len ) {
+	return ( 0 == start || !std::isalnum( static_cast<unsigned char>( text[start - 1] ) ) ) &&
+		   ( start + len >= size || !std::isalnum( static_cast<unsigned char>( text[start + len] ) ) );
+}
+
+static bool equalsCaseFolded( const unsigned char* text, const unsigned char* lowerNeedle,
+							  size_t len ) {
+	for ( size_t i = 0; i < len; ++i ) {
+		if ( foldCase( text[i] ) != lowerNeedle[i] )
+			return false;
+	}
+	return true;
+}
+
+#ifdef ECODE_SEARCH_SSE2
+static inline __m128i foldCase128( const __m128i& chunk ) {
+	__m128i isUpper = _mm_and_si128( _mm_cmpgt_epi8( chunk, _mm_set1_epi8( 'A' - 1 ) ),
+									 _mm_cmplt_epi8( chunk, _mm_set1_epi8( 'Z' + 1 ) ) );
+	return _mm_or_si128( chunk, _mm_and_si128( isUpper, _mm_set1_epi8( 'a' - 'A' ) ) );
+}
+#endif
+
+#ifdef ECODE_SEARCH_AVX2
+static inline __m256i foldCase256( const __m256i& chunk ) {
+	__m256i isUpper = _mm256_and_si256( _mm256_cmpgt_epi8( chunk, _mm256_set1_epi8( 'A' - 1 ) ),
+										_mm256_cmpgt_epi8( _mm256_set1_epi8( 'Z' + 1 ), chunk ) );
+	return _mm256_or_si256( chunk, _mm256_and_si256( isUpper, _mm256_set1_epi8( 'a' - 'A' ) ) );
+}
+#endif
+
+/** Case insensitive search of an already lowercased needle. The haystack is folded while it's
+ * compared, so no lowercased copy of the haystack is needed.
+ * The vectorized path filters the candidate positions by the first and last needle characters,
+ * the scalar path is a case folding Horspool search. */
+static Int64 findCaseFolded( const char* haystack, const size_t& haystackLen,
+							 const std::string& lowerNeedle, const size_t& offset,
+							 const String::BMH::OccTable& occ ) {
+	const size_t needleLen = lowerNeedle.size();
+	if ( needleLen == 0 || offset + needleLen > haystackLen )
+		return -1;
+	const unsigned char* text = reinterpret_cast<const unsigned char*>( haystack );
+	const unsigned char* needle = reinterpret_cast<const unsigned char*>( lowerNeedle.c_str() );
+	const size_t last = needleLen - 1;
+	size_t pos = offset;
+#ifdef ECODE_SEARCH_AVX2
+	const __m256i first256 = _mm256_set1_epi8( needle[0] );
+	const __m256i last256 = _mm256_set1_epi8( needle[last] );
+	while ( pos + last + 32 <= haystackLen ) {
+		__m256i blockFirst =
+			foldCase256( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( text + pos ) ) );
+		__m256i blockLast = foldCase256(
+			_mm256_loadu_si256( reinterpret_cast<const __m256i*>( text + pos + last ) ) );
+		Uint32 mask = _mm256_movemask_epi8( _mm256_and_si256(
+			_mm256_cmpeq_epi8( blockFirst, first256 ), _mm256_cmpeq_epi8( blockLast, last256 ) ) );
+		while ( mask ) {
+			size_t candidate = pos + firstBitSet( mask );
+			if ( equalsCaseFolded( text + candidate + 1, needle + 1, needleLen - 1 ) )
+				return candidate;
+			mask &= mask - 1;
+		}
+		pos += 32;
+	}
+#endif
+#ifdef ECODE_SEARCH_SSE2
+	const __m128i first = _mm_set1_epi8( needle[0] );
+	const __m128i lastChar = _mm_set1_epi8( needle[last] );
+	while ( pos + last + 16 <= haystackLen ) {
+		__m128i blockFirst =
+			foldCase128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( text + pos ) ) );
+		__m128i blockLast =
+			foldCase128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( text + pos + last ) ) );
+		Uint32 mask = _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( blockFirst, first ),
+														_mm_cmpeq_epi8( blockLast, lastChar ) ) );
+		while ( mask ) {
+			size_t candidate = pos + firstBitSet( mask );
+			if ( equalsCaseFolded( text + candidate + 1, needle + 1, needleLen - 1 ) )
+				return candidate;
+			mask &= mask - 1;
+		}
+		pos += 16;
+	}
+#endif
+	while ( pos + needleLen <= haystackLen ) {
+		unsigned char c = foldCase( text[pos + last] );
+		if ( c == needle[last] && equalsCaseFolded( text + pos, needle, last ) )
+			return pos;
+		pos += occ[c];
+	}
+	return -1;
+}
+
+static Int64 findCaseSensitive( const char* haystack, const size_t& haystackLen,
+								const std::string& needle, const size_t& offset,
+								const String::BMH::OccTable& occ ) {
+	if ( offset >= haystackLen )
+		return -1;
+	size_t result = String::BMH::search(
+		reinterpret_cast<const unsigned char*>( haystack ) + offset, haystackLen - offset,
+		reinterpret_cast<const unsigned char*>( needle.c_str() ), needle.size(), occ );
+	return result == haystackLen - offset ? -1 : static_cast<Int64>( offset + result );
+}
+
+/** The contents of a file being searched. Files are memory mapped, so only the pages being
+ * scanned need to be resident and nothing is copied. If the file can't be mapped it's read into
+ * memory. */
+class SearchFile {
+  public:
+	explicit SearchFile( const std::string& path ) : mMappedFile( path ) {
+		if ( mMappedFile.isOpen() ) {
+			mData = mMappedFile.getData();
+			mSize = mMappedFile.getSize();
+		} else {
+			FileSystem::fileGet( path, mBuffer );
+			mData = mBuffer.c_str();
+			mSize = mBuffer.size();
+		}
+		if ( mData == nullptr )
+			mData = "";
+	}
+
+	const char* data() const { return mData; }
+
+	const size_t& size() const { return mSize; }
+
+	/** Same heuristic used by git: a NUL byte in the first 8000 bytes means that the file is
+	 * binary. */
+	bool isBinary() const { return memchr( mData, '\0', eemin<size_t>( mSize, 8000 ) ) != nullptr; }
+
+  protected:
+	MemoryMappedFile mMappedFile;
+	std::string mBuffer;
+	const char* mData{ nullptr };
+	size_t mSize{ 0 };
+};
+
 static std::vector<ProjectSearch::ResultData::Result>
 searchInFileHorspool( const std::string& file, const std::string& text, const bool& caseSensitive,
 					  const bool& wholeWord, const String::BMH::OccTable& occ ) {
 	std::vector<ProjectSearch::ResultData::Result> res;
-	std::string fileText;
+	SearchFile fileText( file );
+	if ( fileText.size() == 0 || fileText.isBinary() )
+		return res;
+	const char* data = fileText.data();
+	const size_t& size = fileText.size();
 	Int64 lSearchRes = 0;
 	Int64 searchRes = 0;
 	size_t totNl = 0;
-	FileSystem::fileGet( file, fileText );
-	std::string fileTextOriginal;
-
-	if ( !caseSensitive ) {
-		fileTextOriginal = fileText;
-		String::toLowerInPlace( fileText );
-	}
 
 	do {
-		searchRes = String::BMH::find( fileText, text, searchRes, occ );
+		searchRes = caseSensitive ? findCaseSensitive( data, size, text, searchRes, occ )
+								  : findCaseFolded( data, size, text, searchRes, occ );
 		if ( searchRes != -1 ) {
-			if ( wholeWord && !String::isWholeWord( fileText, text, searchRes ) ) {
+			if ( wholeWord && !isWholeWord( data, size, searchRes, text.size() ) ) {
 				lSearchRes = searchRes;
 				searchRes += text.size();
 				continue;
 			}
 			size_t relCol;
-			totNl += countNewLines( fileText, lSearchRes, searchRes );
-			String str(
-				textLine( caseSensitive ? fileText : fileTextOriginal, searchRes, relCol ) );
+			totNl += countNewLines( data + lSearchRes, data + searchRes );
+			String str( textLine( data, size, searchRes, relCol ) );
 			res.push_back( { str,
 							 { { (Int64)totNl, (Int64)relCol },
 							   { (Int64)totNl, (Int64)( relCol + String::utf8Length( text ) ) } },
@@ -81,31 +289,35 @@ searchInFileHorspool( const std::string& file, const std::string& text, const bo
 static std::vector<ProjectSearch::ResultData::Result>
 searchInFileLuaPattern( const std::string& file, const std::string& text, const bool& caseSensitive,
 						const bool& wholeWord ) {
-	std::string fileText;
-	FileSystem::fileGet( file, fileText );
-	LuaPattern pattern( text );
 	std::vector<ProjectSearch::ResultData::Result> res;
+	SearchFile fileText( file );
+	if ( fileText.size() == 0 || fileText.isBinary() )
+		return res;
+	LuaPattern pattern( text );
+	const char* data = fileText.data();
+	const size_t& size = fileText.size();
 	size_t totNl = 0;
 	bool matched = false;
 	Int64 searchRes = 0;
-	std::string fileTextOriginal;
+	std::string fileTextLower;
 
+	// Patterns can't fold the case while matching, so they match against a lowercased copy.
 	if ( !caseSensitive ) {
-		fileTextOriginal = fileText;
-		String::toLowerInPlace( fileText );
+		fileTextLower.assign( data, size );
+		String::toLowerInPlace( fileTextLower );
 	}
+	const char* searchData = caseSensitive ? data : fileTextLower.c_str();
 
 	do {
 		int start, end = 0;
-		if ( ( matched = pattern.find( fileText, start, end, searchRes ) ) ) {
-			if ( wholeWord &&
-				 !String::isWholeWord( fileText, fileText.substr( start, end - start ), start ) ) {
+		if ( ( matched = pattern.find( searchData, start, end, searchRes, size ) ) ) {
+			if ( wholeWord && !isWholeWord( searchData, size, start, end - start ) ) {
 				searchRes = end;
 				continue;
 			}
 			size_t relCol;
-			totNl += countNewLines( fileText, searchRes, start );
-			String str( textLine( caseSensitive ? fileText : fileTextOriginal, start, relCol ) );
+			totNl += countNewLines( data + searchRes, data + start );
+			String str( textLine( data, size, start, relCol ) );
 			int len = end - start;
 			res.push_back(
 				{ str,
@@ -119,10 +331,12 @@ searchInFileLuaPattern( const std::string& file, const std::string& text, const
 	return res;
 }
 
-void ProjectSearch::find( const std::vector<std::string> files, const std::string& string,
+void ProjectSearch::find( const std::vector<std::string> files, std::string string,
 						  ResultCb result, bool caseSensitive, bool wholeWord,
 						  const TextDocument::FindReplaceType& type ) {
 	Result res;
+	if ( !caseSensitive )
+		String::toLowerInPlace( string );
 	const auto occ =
 		type == TextDocument::FindReplaceType::Normal
 			? String::BMH::createOccTable( (const unsigned char*)string.c_str(), string.size() )
@@ -137,51 +351,51 @@ void ProjectSearch::find( const std::vector<std::string> files, const std::strin
 	result( res );
 }
 
-struct FindData {
-	Mutex resMutex;
-	Mutex countMutex;
-	int resCount{ 0 };
-	ProjectSearch::Result res;
-};
-
 void ProjectSearch::find( const std::vector<std::string> files, std::string string,
 						  std::shared_ptr<ThreadPool> pool, ResultCb result, bool caseSensitive,
-						  bool wholeWord, const TextDocument::FindReplaceType& type ) {
-	if ( files.empty() )
+						  bool wholeWord, const TextDocument::FindReplaceType& type,
+						  FileResultCb fileResult ) {
+	if ( files.empty() ) {
 		result( {} );
-	FindData* findData = eeNew( FindData, () );
-	findData->resCount = files.size();
+		return;
+	}
 	if ( !caseSensitive )
 		String::toLowerInPlace( string );
 	const auto occ =
 		type == TextDocument::FindReplaceType::Normal
 			? String::BMH::createOccTable( (const unsigned char*)string.c_str(), string.size() )
 			: std::vector<size_t>();
+	std::vector<Future<std::shared_ptr<ResultData>>> fileSearches;
+	fileSearches.reserve( files.size() );
 	for ( auto& file : files ) {
-		pool->run(
-			[findData, file, string, caseSensitive, wholeWord, occ, type] {
+		fileSearches.emplace_back( pool->async(
+			[file, string, caseSensitive, wholeWord, occ, type,
+			 fileResult]() -> std::shared_ptr<ResultData> {
 				auto fileRes =
 					type == TextDocument::FindReplaceType::Normal
 						? searchInFileHorspool( file, string, caseSensitive, wholeWord, occ )
 						: searchInFileLuaPattern( file, string, caseSensitive, wholeWord );
-				if ( !fileRes.empty() ) {
-					Lock l( findData->resMutex );
-					findData->res.push_back( { file, fileRes } );
-				}
+				if ( fileRes.empty() )
+					return nullptr;
+				if ( fileResult )
+					fileResult( { file, fileRes } );
+				return std::make_shared<ResultData>( ResultData{ file, std::move( fileRes ) } );
 			},
-			[result, findData]( const auto& ) {
-				int count;
-				{
-					Lock l( findData->countMutex );
-					findData->resCount--;
-					count = findData->resCount;
-				}
-				if ( count == 0 ) {
-					result( findData->res );
-					eeDelete( findData );
-				}
-			} );
+			ThreadPool::Priority::High ) );
 	}
+	whenAll( fileSearches )
+		.then( [result]( const std::vector<std::shared_ptr<ResultData>>& fileResults ) {
+			Result res;
+			for ( const auto& fileRes : fileResults )
+				if ( fileRes )
+					res.emplace_back( std::move( *fileRes ) );
+			result( res );
+		} );
+}
+
+void ProjectSearch::ResultModel::addResults( const Result& results ) {
+	mResult.insert( mResult.end(), results.begin(), results.end() );
+	onModelUpdate();
 }
 
 void ProjectSearch::ResultModel::removeLastNewLineCharacter() {
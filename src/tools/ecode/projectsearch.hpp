@@ -58,6 +58,7 @@ class ProjectSearch {
 
 	typedef std::vector<ResultData> Result;
 	typedef std::function<void( const Result& )> ResultCb;
+	typedef std::function<void( const ResultData& )> FileResultCb;
 
 	class ResultModel : public Model {
 	  public:
@@ -188,6 +189,10 @@ class ProjectSearch {
 
 		void removeLastNewLineCharacter();
 
+		/** Appends the results of more files. Used to display the results while the search is
+		 * still running. */
+		void addResults( const Result& results );
+
 		void setResultFromSymbolReference( bool ref ) { mResultFromSymbolReference = ref; }
 
 		bool isResultFromSymbolReference() const { return mResultFromSymbolReference; }
@@ -202,15 +207,19 @@ class ProjectSearch {
 	}
 
 	static void
-	find( const std::vector<std::string> files, const std::string& string, ResultCb result,
+	find( const std::vector<std::string> files, std::string string, ResultCb result,
 		  bool caseSensitive, bool wholeWord = false,
 		  const TextDocument::FindReplaceType& type = TextDocument::FindReplaceType::Normal );
 
+	/** Searches the files in the thread pool. `result` is called with all the results when every
+	 * file was searched. `fileResult`, if set, is called from the searching thread as soon as a
+	 * file with results is found. Binary files are skipped. */
 	static void
 	find( const std::vector<std::string> files, std::string string,
 		  std::shared_ptr<ThreadPool> pool, ResultCb result, bool caseSensitive,
 		  bool wholeWord = false,
-		  const TextDocument::FindReplaceType& type = TextDocument::FindReplaceType::Normal );
+		  const TextDocument::FindReplaceType& type = TextDocument::FindReplaceType::Normal,
+		  FileResultCb fileResult = nullptr );
 };
 
 } // namespace ecode
@@ -0,0 +1,482 @@
+#include "projectsearchindex.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <eepp/system/fileinfo.hpp>
+#include <eepp/system/filesystem.hpp>
+#include <eepp/system/lock.hpp>
+#include <eepp/system/memorymappedfile.hpp>
+#include <limits>
+
+#define PROJECT_SEARCH_INDEX_MAGIC "ECTI"
+#define PROJECT_SEARCH_INDEX_VERSION 1
+#define PROJECT_SEARCH_INDEX_BATCH_SIZE 256
+#define PROJECT_SEARCH_INDEX_MAX_FILE_SIZE ( EE_1MB * 4 )
+#define PROJECT_SEARCH_INDEX_COMPACT_MIN_REMOVED 1024
+
+namespace ecode {
+
+static inline Uint8 foldByte( Uint8 c ) {
+	return c >= 'A' && c <= 'Z' ? c + 32 : c;
+}
+
+static inline Uint32 makeTrigram( Uint8 a, Uint8 b, Uint8 c ) {
+	return ( (Uint32)foldByte( a ) << 16 ) | ( (Uint32)foldByte( b ) << 8 ) | foldByte( c );
+}
+
+static std::vector<Uint32> extractTrigrams( const char* data, const size_t& size ) {
+	std::vector<Uint32> trigrams;
+	if ( size < 3 )
+		return trigrams;
+	const Uint8* bytes = reinterpret_cast<const Uint8*>( data );
+	trigrams.reserve( size - 2 );
+	for ( size_t i = 0; i + 2 < size; ++i )
+		trigrams.push_back( makeTrigram( bytes[i], bytes[i + 1], bytes[i + 2] ) );
+	std::sort( trigrams.begin(), trigrams.end() );
+	trigrams.erase( std::unique( trigrams.begin(), trigrams.end() ), trigrams.end() );
+	return trigrams;
+}
+
+static bool isBinaryData( const char* data, const size_t& size ) {
+	// Same heuristic used by the project search: a NUL byte in the first 8000 bytes.
+	return memchr( data, '\0', eemin<size_t>( size, 8000 ) ) != nullptr;
+}
+
+static void writeVarInt( std::string& out, Uint64 value ) {
+	while ( value >= 0x80 ) {
+		out.push_back( static_cast<char>( ( value & 0x7F ) | 0x80 ) );
+		value >>= 7;
+	}
+	out.push_back( static_cast<char>( value ) );
+}
+
+static bool readVarInt( const std::string& in, size_t& pos, Uint64& value ) {
+	value = 0;
+	for ( int shift = 0; shift < 64 && pos < in.size(); shift += 7 ) {
+		Uint8 byte = static_cast<Uint8>( in[pos++] );
+		value |= (Uint64)( byte & 0x7F ) << shift;
+		if ( !( byte & 0x80 ) )
+			return true;
+	}
+	return false;
+}
+
+ProjectSearchIndex::ProjectSearchIndex( const std::string& indexPath,
+										std::shared_ptr<ThreadPool> pool ) :
+	mIndexPath( indexPath ), mPool( pool ) {}
+
+ProjectSearchIndex::~ProjectSearchIndex() {
+	Lock l( mMutex );
+	if ( mLoaded && mDirty )
+		save();
+}
+
+void ProjectSearchIndex::close() {
+	mClosing = true;
+}
+
+void ProjectSearchIndex::runJob( const std::function<void()>& job ) {
+	auto pool = mPool.lock();
+	if ( !pool )
+		return;
+	// Every job keeps the index alive, so closing the project never waits for the workers.
+	std::shared_ptr<ProjectSearchIndex> self( shared_from_this() );
+	pool->run(
+		[self, job] {
+			if ( !self->mClosing )
+				job();
+		},
+		ThreadPool::Priority::Low );
+}
+
+bool ProjectSearchIndex::isReady() const {
+	return mReady;
+}
+
+void ProjectSearchIndex::build( const std::vector<std::string>& files ) {
+	runJob( [this, files] {
+		std::vector<std::string> outdated;
+		{
+			Lock l( mMutex );
+			load();
+			mLoaded = true;
+
+			std::unordered_set<std::string> projectFiles( files.begin(), files.end() );
+			for ( const auto& file : mFileIds ) {
+				if ( projectFiles.find( file.first ) == projectFiles.end() &&
+					 mFiles[file.second].state != FileState::Removed ) {
+					mFiles[file.second].state = FileState::Removed;
+					mRemovedCount++;
+					mDirty = true;
+				}
+			}
+
+			for ( const auto& path : files ) {
+				auto it = mFileIds.find( path );
+				if ( it != mFileIds.end() ) {
+					const FileEntry& entry = mFiles[it->second];
+					if ( entry.state != FileState::Pending && entry.state != FileState::Removed ) {
+						FileInfo info( path );
+						if ( info.getModificationTime() == entry.modified &&
+							 info.getSize() == entry.size )
+							continue;
+					}
+				}
+				outdated.push_back( path );
+			}
+		}
+
+		if ( outdated.empty() ) {
+			mReady = true;
+			return;
+		}
+
+		size_t batches = ( outdated.size() + PROJECT_SEARCH_INDEX_BATCH_SIZE - 1 ) /
+						 PROJECT_SEARCH_INDEX_BATCH_SIZE;
+		auto remaining = std::make_shared<std::atomic<size_t>>( batches );
+		for ( size_t i = 0; i < outdated.size(); i += PROJECT_SEARCH_INDEX_BATCH_SIZE ) {
+			std::vector<std::string> batch(
+				outdated.begin() + i,
+				outdated.begin() + eemin<size_t>( outdated.size(),
+												  i + PROJECT_SEARCH_INDEX_BATCH_SIZE ) );
+			runJob( [this, batch, remaining] {
+				indexFiles( batch );
+				if ( --( *remaining ) == 0 ) {
+					Lock l( mMutex );
+					compact();
+					save();
+					mReady = true;
+				}
+			} );
+		}
+	} );
+}
+
+void ProjectSearchIndex::indexFiles( const std::vector<std::string>& paths ) {
+	for ( const auto& path : paths ) {
+		if ( mClosing )
+			return;
+
+		FileInfo info( path );
+		if ( !info.exists() || !info.isRegularFile() ) {
+			removeEntry( path );
+			continue;
+		}
+
+		FileEntry entry;
+		entry.path = path;
+		entry.modified = info.getModificationTime();
+		entry.size = info.getSize();
+		std::vector<Uint32> trigrams;
+
+		if ( entry.size > PROJECT_SEARCH_INDEX_MAX_FILE_SIZE ) {
+			entry.state = FileState::Unindexed;
+		} else {
+			MemoryMappedFile file( path );
+			const char* data = file.getData();
+			size_t size = file.getSize();
+			std::string buffer;
+			if ( !file.isOpen() ) {
+				FileSystem::fileGet( path, buffer );
+				data = buffer.c_str();
+				size = buffer.size();
+			}
+			if ( data != nullptr && isBinaryData( data, size ) ) {
+				entry.state = FileState::Binary;
+			} else {
+				entry.state = FileState::Indexed;
+				if ( data != nullptr )
+					trigrams = extractTrigrams( data, size );
+			}
+		}
+
+		Lock l( mMutex );
+		addEntry( std::move( entry ), trigrams );
+	}
+}
+
+Uint32 ProjectSearchIndex::addEntry( FileEntry&& entry, const std::vector<Uint32>& trigrams ) {
+	auto it = mFileIds.find( entry.path );
+	if ( it != mFileIds.end() && mFiles[it->second].state != FileState::Removed ) {
+		// The posting lists are append only, the old entry ids are discarded on compaction.
+		mFiles[it->second].state = FileState::Removed;
+		mRemovedCount++;
+	}
+	Uint32 id = static_cast<Uint32>( mFiles.size() );
+	mFileIds[entry.path] = id;
+	mFiles.emplace_back( std::move( entry ) );
+	for ( const auto& trigram : trigrams )
+		mPostings[trigram].push_back( id );
+	mDirty = true;
+	return id;
+}
+
+void ProjectSearchIndex::removeEntry( const std::string& path ) {
+	Lock l( mMutex );
+	auto it = mFileIds.find( path );
+	if ( it != mFileIds.end() )
+		removeEntry( it );
+}
+
+ProjectSearchIndex::FileIdsMap::iterator
+ProjectSearchIndex::removeEntry( ProjectSearchIndex::FileIdsMap::iterator it ) {
+	if ( mFiles[it->second].state != FileState::Removed )
+		mRemovedCount++;
+	mFiles[it->second].state = FileState::Removed;
+	mDirty = true;
+	return mFileIds.erase( it );
+}
+
+void ProjectSearchIndex::onFileChanged( const std::string& path ) {
+	Lock l( mMutex );
+	auto it = mFileIds.find( path );
+	if ( it != mFileIds.end() && mFiles[it->second].state != FileState::Removed )
+		mFiles[it->second].state = FileState::Pending;
+	mChangedFiles.insert( path );
+	if ( !mUpdateScheduled ) {
+		mUpdateScheduled = true;
+		runJob( [this] { updateChangedFiles(); } );
+	}
+}
+
+void ProjectSearchIndex::onFileRemoved( const std::string& path ) {
+	Lock l( mMutex );
+	mChangedFiles.erase( path );
+	auto it = mFileIds.find( path );
+	if ( it != mFileIds.end() ) {
+		removeEntry( it );
+		return;
+	}
+	// It's not a known file, so it was a directory: its files are a contiguous range of the
+	// sorted paths
+	std::string dirPath( path );
+	FileSystem::dirAddSlashAtEnd( dirPath );
+	for ( it = mFileIds.lower_bound( dirPath );
+		  it != mFileIds.end() && String::startsWith( it->first, dirPath ); )
+		it = removeEntry( it );
+}
+
+void ProjectSearchIndex::updateChangedFiles() {
+	std::vector<std::string> paths;
+	{
+		Lock l( mMutex );
+		paths.assign( mChangedFiles.begin(), mChangedFiles.end() );
+		mChangedFiles.clear();
+		mUpdateScheduled = false;
+	}
+	indexFiles( paths );
+	Lock l( mMutex );
+	compact();
+}
+
+void ProjectSearchIndex::compact() {
+	if ( mRemovedCount < PROJECT_SEARCH_INDEX_COMPACT_MIN_REMOVED ||
+		 mRemovedCount * 2 < mFiles.size() )
+		return;
+
+	static constexpr Uint32 REMOVED_ID = std::numeric_limits<Uint32>::max();
+	std::vector<Uint32> remap( mFiles.size(), REMOVED_ID );
+	std::vector<FileEntry> files;
+	files.reserve( mFiles.size() - mRemovedCount );
+	for ( size_t i = 0; i < mFiles.size(); ++i ) {
+		if ( mFiles[i].state != FileState::Removed ) {
+			remap[i] = static_cast<Uint32>( files.size() );
+			files.emplace_back( std::move( mFiles[i] ) );
+		}
+	}
+
+	for ( auto it = mPostings.begin(); it != mPostings.end(); ) {
+		auto& ids = it->second;
+		size_t count = 0;
+		for ( const auto& id : ids )
+			if ( remap[id] != REMOVED_ID )
+				ids[count++] = remap[id];
+		if ( count == 0 ) {
+			it = mPostings.erase( it );
+		} else {
+			ids.resize( count );
+			ids.shrink_to_fit();
+			++it;
+		}
+	}
+
+	mFileIds.clear();
+	for ( size_t i = 0; i < files.size(); ++i )
+		mFileIds[files[i].path] = static_cast<Uint32>( i );
+	mFiles = std::move( files );
+	mRemovedCount = 0;
+	mDirty = true;
+}
+
+std::vector<std::string>
+ProjectSearchIndex::filterCandidates( const std::vector<std::string>& files,
+									  const std::string& text ) const {
+	if ( !mReady || text.size() < 3 )
+		return files;
+
+	std::vector<Uint32> trigrams( extractTrigrams( text.c_str(), text.size() ) );
+
+	Lock l( mMutex );
+	std::vector<const std::vector<Uint32>*> lists;
+	lists.reserve( trigrams.size() );
+	bool hasMatches = true;
+	for ( const auto& trigram : trigrams ) {
+		auto it = mPostings.find( trigram );
+		if ( it == mPostings.end() ) {
+			hasMatches = false;
+			break;
+		}
+		lists.push_back( &it->second );
+	}
+
+	std::vector<Uint32> ids;
+	if ( hasMatches && !lists.empty() ) {
+		std::sort( lists.begin(), lists.end(),
+				   []( const auto* a, const auto* b ) { return a->size() < b->size(); } );
+		ids = *lists[0];
+		std::vector<Uint32> tmp;
+		for ( size_t i = 1; i < lists.size() && !ids.empty(); ++i ) {
+			tmp.clear();
+			std::set_intersection( ids.begin(), ids.end(), lists[i]->begin(), lists[i]->end(),
+								   std::back_inserter( tmp ) );
+			ids.swap( tmp );
+		}
+	}
+
+	std::vector<std::string> candidates;
+	for ( const auto& file : files ) {
+		auto it = mFileIds.find( file );
+		if ( it == mFileIds.end() ) {
+			candidates.push_back( file );
+			continue;
+		}
+		switch ( mFiles[it->second].state ) {
+			case FileState::Indexed:
+				if ( std::binary_search( ids.begin(), ids.end(), it->second ) )
+					candidates.push_back( file );
+				break;
+			case FileState::Binary:
+				break;
+			default:
+				candidates.push_back( file );
+				break;
+		}
+	}
+	return candidates;
+}
+
+bool ProjectSearchIndex::load() {
+	std::string data;
+	if ( !FileSystem::fileExists( mIndexPath ) || !FileSystem::fileGet( mIndexPath, data ) )
+		return false;
+
+	size_t pos = strlen( PROJECT_SEARCH_INDEX_MAGIC );
+	Uint64 version = 0;
+	Uint64 filesCount = 0;
+	if ( data.compare( 0, pos, PROJECT_SEARCH_INDEX_MAGIC ) != 0 ||
+		 !readVarInt( data, pos, version ) || version != PROJECT_SEARCH_INDEX_VERSION ||
+		 !readVarInt( data, pos, filesCount ) || filesCount > data.size() )
+		return false;
+
+	std::vector<FileEntry> files;
+	FileIdsMap fileIds;
+	std::unordered_map<Uint32, std::vector<Uint32>> postings;
+	files.reserve( filesCount );
+
+	for ( Uint64 i = 0; i < filesCount; ++i ) {
+		FileEntry entry;
+		Uint64 pathSize = 0;
+		Uint64 state = 0;
+		if ( !readVarInt( data, pos, pathSize ) || pathSize > data.size() - pos )
+			return false;
+		entry.path = data.substr( pos, pathSize );
+		pos += pathSize;
+		if ( !readVarInt( data, pos, entry.modified ) || !readVarInt( data, pos, entry.size ) ||
+			 !readVarInt( data, pos, state ) || state > (Uint64)FileState::Binary )
+			return false;
+		entry.state = static_cast<FileState>( state );
+		fileIds[entry.path] = static_cast<Uint32>( files.size() );
+		files.emplace_back( std::move( entry ) );
+	}
+
+	Uint64 postingsCount = 0;
+	if ( !readVarInt( data, pos, postingsCount ) )
+		return false;
+
+	for ( Uint64 i = 0; i < postingsCount; ++i ) {
+		Uint64 trigram = 0;
+		Uint64 idsCount = 0;
+		if ( !readVarInt( data, pos, trigram ) || !readVarInt( data, pos, idsCount ) ||
+			 idsCount > files.size() )
+			return false;
+		auto& ids = postings[static_cast<Uint32>( trigram )];
+		ids.reserve( idsCount );
+		Uint64 id = 0;
+		for ( Uint64 n = 0; n < idsCount; ++n ) {
+			Uint64 delta = 0;
+			if ( !readVarInt( data, pos, delta ) )
+				return false;
+			id += delta;
+			if ( id >= files.size() )
+				return false;
+			ids.push_back( static_cast<Uint32>( id ) );
+		}
+	}
+
+	mFiles = std::move( files );
+	mFileIds = std::move( fileIds );
+	mPostings = std::move( postings );
+	mRemovedCount = 0;
+	mDirty = false;
+	return true;
+}
+
+bool ProjectSearchIndex::save() {
+	// Only live entries are persisted, so the ids are remapped to their position in the file.
+	std::vector<Uint32> remap( mFiles.size(), 0 );
+	std::string data( PROJECT_SEARCH_INDEX_MAGIC );
+	writeVarInt( data, PROJECT_SEARCH_INDEX_VERSION );
+	writeVarInt( data, mFiles.size() - mRemovedCount );
+	Uint32 count = 0;
+	for ( size_t i = 0; i < mFiles.size(); ++i ) {
+		const FileEntry& entry = mFiles[i];
+		if ( entry.state == FileState::Removed )
+			continue;
+		remap[i] = count++;
+		writeVarInt( data, entry.path.size() );
+		data.append( entry.path );
+		writeVarInt( data, entry.modified );
+		writeVarInt( data, entry.size );
+		writeVarInt( data, (Uint64)entry.state );
+	}
+
+	writeVarInt( data, mPostings.size() );
+	std::vector<Uint32> ids;
+	for ( const auto& posting : mPostings ) {
+		ids.clear();
+		for ( const auto& id : posting.second )
+			if ( mFiles[id].state != FileState::Removed )
+				ids.push_back( remap[id] );
+		writeVarInt( data, posting.first );
+		writeVarInt( data, ids.size() );
+		Uint32 last = 0;
+		for ( const auto& id : ids ) {
+			writeVarInt( data, id - last );
+			last = id;
+		}
+	}
+
+	std::string tmpPath( mIndexPath + ".tmp" );
+	if ( !FileSystem::fileWrite( tmpPath, data ) )
+		return false;
+	if ( FileSystem::fileExists( mIndexPath ) )
+		FileSystem::fileRemove( mIndexPath );
+	if ( std::rename( tmpPath.c_str(), mIndexPath.c_str() ) != 0 ) {
+		FileSystem::fileRemove( tmpPath );
+		return false;
+	}
+	mDirty = false;
+	return true;
+}
+
+} // namespace ecode
@@ -0,0 +1,115 @@
+#ifndef ECODE_PROJECTSEARCHINDEX_HPP
+#define ECODE_PROJECTSEARCHINDEX_HPP
+
+#include <atomic>
+#include <eepp/system/mutex.hpp>
+#include <eepp/system/threadpool.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace EE;
+using namespace EE::System;
+
+namespace ecode {
+
+/** Trigram index of the files of a project folder, used to narrow the files that the global
+ * search needs to scan.
+ * Every indexed file keeps the set of trigrams (three consecutive bytes, ASCII lowercased) that
+ * it contains. A file can only contain a literal search string if it contains all the trigrams
+ * of the string, so the candidates are the intersection of the posting lists of the string
+ * trigrams. Lowercasing makes the index valid for case sensitive and insensitive searches.
+ * The index is persisted to disk and validated against the files modification time and size
+ * when the project is opened again, so only the files that changed are indexed again.
+ * Files that were not indexed yet, or that changed since they were indexed, are always
+ * candidates, so the index never hides a match. */
+class ProjectSearchIndex : public std::enable_shared_from_this<ProjectSearchIndex> {
+  public:
+	ProjectSearchIndex( const std::string& indexPath, std::shared_ptr<ThreadPool> pool );
+
+	/** Saves the index if it was modified since it was loaded. */
+	~ProjectSearchIndex();
+
+	/** Loads the persisted index and updates it in the background with the project files. */
+	void build( const std::vector<std::string>& files );
+
+	/** @return True once the initial build finished. */
+	bool isReady() const;
+
+	/** Marks the file as modified and indexes it again in the background. */
+	void onFileChanged( const std::string& path );
+
+	/** Removes the file, or all the files of the directory, from the index. */
+	void onFileRemoved( const std::string& path );
+
+	/** @return The subset of `files` that might contain `text`. */
+	std::vector<std::string> filterCandidates( const std::vector<std::string>& files,
+											   const std::string& text ) const;
+
+	/** Stops the pending background jobs. The index is released once the running ones end. */
+	void close();
+
+  protected:
+	enum class FileState : Uint8 {
+		/// Its trigrams are in the posting lists
+		Indexed,
+		/// Not indexed yet, or modified since it was indexed
+		Pending,
+		/// Too large to be indexed, always a candidate
+		Unindexed,
+		/// Binary file, the search skips it
+		Binary,
+		/// Removed or replaced by a newer entry
+		Removed
+	};
+
+	struct FileEntry {
+		std::string path;
+		Uint64 modified{ 0 };
+		Uint64 size{ 0 };
+		FileState state{ FileState::Pending };
+	};
+
+	/** The file ids by path. Sorted, so the files of a directory are a contiguous range. */
+	typedef std::map<std::string, Uint32> FileIdsMap;
+
+	std::string mIndexPath;
+	std::weak_ptr<ThreadPool> mPool;
+	mutable Mutex mMutex;
+	std::vector<FileEntry> mFiles;
+	FileIdsMap mFileIds;
+	std::unordered_map<Uint32, std::vector<Uint32>> mPostings;
+	std::unordered_set<std::string> mChangedFiles;
+	size_t mRemovedCount{ 0 };
+	bool mUpdateScheduled{ false };
+	bool mLoaded{ false };
+	bool mDirty{ false };
+	std::atomic<bool> mReady{ false };
+	std::atomic<bool> mClosing{ false };
+
+	void runJob( const std::function<void()>& job );
+
+	void indexFiles( const std::vector<std::string>& paths );
+
+	void updateChangedFiles();
+
+	Uint32 addEntry( FileEntry&& entry, const std::vector<Uint32>& trigrams );
+
+	void removeEntry( const std::string& path );
+
+	/** @return The iterator following the removed entry. */
+	FileIdsMap::iterator removeEntry( FileIdsMap::iterator it );
+
+	void compact();
+
+	bool load();
+
+	bool save();
+};
+
+} // namespace ecode
+
+#endif // ECODE_PROJECTSEARCHINDEX_HPP